@@ -2,15 +2,12 @@
 
 namespace lake {
 
-ASTNode::ASTNode(size_t lineIn, size_t colIn){
-	this->line = lineIn;
-	this->col = colIn;
+ASTNode::ASTNode(Pos posIn){
+	this->myPos = posIn;
 }
 void ASTNode::doIndent(std::ostream& out, int indent){
 	for (int k = 0 ; k < indent; k++){ out << " "; }
 }
-size_t ASTNode::getLine(){ return line; }
-size_t ASTNode::getCol(){ return col; }
 std::string ASTNode::getPosition(){
 	std::string res = "";
 	res += std::to_string(getLine());
@@ -20,14 +17,14 @@ std::string ASTNode::getPosition(){
 }
 
 IdNode::IdNode(IDToken * token)
-: ExpNode(token->_line, token->_column), 
+: ExpNode(token->_pos), 
   myStrVal(token->value()),
   mySymbol(NULL){ }
 
 std::string IdNode::getString(){ return myStrVal; }
 
-DeclNode::DeclNode(size_t lIn, size_t cIn, IdNode * idIn)
-: ASTNode(lIn, cIn), myID(idIn){ }
+DeclNode::DeclNode(Pos posIn, IdNode * idIn)
+: ASTNode(posIn), myID(idIn){ }
 
 std::string DeclNode::getDeclaredName(){
 	return myID->getString();
@@ -38,16 +35,164 @@ IdNode * DeclNode::getDeclaredID(){
 }
 
 ProgramNode::ProgramNode(DeclListNode * declListIn)
-: ASTNode(0,0), myDeclList(declListIn){ }
+: ASTNode(NO_POS), myDeclList(declListIn){ }
 
-TypeNode::TypeNode(size_t lnIn, size_t colIn)
-: ASTNode(lnIn, colIn){}
+TypeNode::TypeNode(Pos posIn)
+: ASTNode(posIn){}
 
 void TypeNode::setPtrDepth(size_t depth){
 	myPtrDepth = depth;
 }
 
-DerefNode::DerefNode(size_t lnIn, size_t colIn, ExpNode * tgt)
-: ExpNode(lnIn, colIn), myTgt(tgt){ }
+DerefNode::DerefNode(Pos posIn, ExpNode * tgt)
+: ExpNode(posIn), myTgt(tgt){ }
+
+void ProgramNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myDeclList);
+}
+
+void DeclListNode::getChildren(std::vector<ASTNode *>& children){
+	children.insert(children.end(), myDecls->begin(), myDecls->end());
+}
+
+void VarDeclListNode::getChildren(std::vector<ASTNode *>& children){
+	children.insert(children.end(), myDecls->begin(), myDecls->end());
+}
+
+void FormalsListNode::getChildren(std::vector<ASTNode *>& children){
+	children.insert(children.end(), myFormals->begin(), myFormals->end());
+}
+
+void ExpListNode::getChildren(std::vector<ASTNode *>& children){
+	children.insert(children.end(), myExps->begin(), myExps->end());
+}
+
+void StmtListNode::getChildren(std::vector<ASTNode *>& children){
+	children.insert(children.end(), myStmts->begin(), myStmts->end());
+}
+
+void VarDeclNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myType);
+	children.push_back(myID);
+}
+
+void FormalDeclNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myType);
+	children.push_back(myID);
+}
+
+void FnDeclNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myRetAST);
+	children.push_back(myID);
+	children.push_back(myFormals);
+	children.push_back(myBody);
+}
+
+void FnBodyNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myVarDecls);
+	children.push_back(myStmtList);
+}
+
+void AssignStmtNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myAssign);
+}
+
+void PostIncStmtNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myExp);
+}
+
+void PostDecStmtNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myExp);
+}
+
+void ReadStmtNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myExp);
+}
+
+void WriteStmtNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myExp);
+}
+
+void IfStmtNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myExp);
+	children.push_back(myDecls);
+	children.push_back(myStmts);
+}
+
+void IfElseStmtNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myExp);
+	children.push_back(myDeclsT);
+	children.push_back(myStmtsT);
+	children.push_back(myDeclsF);
+	children.push_back(myStmtsF);
+}
+
+void WhileStmtNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myExp);
+	children.push_back(myDecls);
+	children.push_back(myStmts);
+}
+
+void CallStmtNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myCallExp);
+}
+
+void ReturnStmtNode::getChildren(std::vector<ASTNode *>& children){
+	if (myExp != nullptr){ children.push_back(myExp); }
+}
+
+void DerefNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myTgt);
+}
+
+void AssignNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myTgt);
+	children.push_back(mySrc);
+}
+
+void CallExpNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myId);
+	children.push_back(myExpList);
+}
+
+void UnaryExpNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myExp);
+}
+
+void BinaryExpNode::getChildren(std::vector<ASTNode *>& children){
+	children.push_back(myExp1);
+	children.push_back(myExp2);
+}
+
+void ChainExpNode::getChildren(std::vector<ASTNode *>& children){
+	children.insert(children.end(), myExps.begin(), myExps.end());
+}
+
+//The left operand of the k'th operator is the first operand
+// when k is 1, and otherwise the (implicit) node for the
+// operator before it
+size_t ChainExpNode::leftLine(size_t k){
+	if (k == 1){ return myExps[0]->getLine(); }
+	return opLine(k - 1);
+}
+
+size_t ChainExpNode::leftCol(size_t k){
+	if (k == 1){ return myExps[0]->getCol(); }
+	return opCol(k - 1);
+}
+
+void deleteAST(ASTNode * root){
+	//Node destructors only free the containers they own,
+	// never their children, so the order nodes are
+	// deleted in doesn't matter
+	std::vector<ASTNode *> work;
+	work.push_back(root);
+	while (!work.empty()){
+		ASTNode * node = work.back();
+		work.pop_back();
+		node->getChildren(work);
+		delete node;
+	}
+}
 
 } //End namespace lake
@@ -1,17 +1,23 @@
 #ifndef TEENC_AST_HPP
 #define TEENC_AST_HPP
 
+#include <cstdint>
 #include <ostream>
 #include <sstream>
 #include <string.h>
 #include <list>
+#include <vector>
 #include "err.hpp"
+#include "source_map.hpp"
 #include "tokens.hpp"
 #include "types.hpp"
 
 namespace lake {
 
 class TypeAnalysis;
+class NameAnalysis;
+class Lowering;
+class Evaluator;
 
 class SymbolTable;
 class SemSymbol;
@@ -32,27 +38,74 @@ class IdNode;
 
 class ASTNode{
 public:
-	ASTNode(size_t lineIn, size_t colIn);
-	virtual void unparse(std::ostream&, int) = 0;
-	virtual bool nameAnalysis(SymbolTable *) = 0;
-	//Note that there is no ASTNode::typeAnalysis. To allow
-	// for different function signatures, you may want to 
-	// implement type analysis per-subclass without overrides
+	ASTNode(Pos posIn);
+	virtual ~ASTNode(){ }
+	//Each pass is a walk() over the tree (see walker.hpp) that
+	// calls the hooks below on every node, so that no pass
+	// recurses on the C++ stack
+	void unparse(std::ostream& out, int indent);
+	bool nameAnalysis(SymbolTable * symTab);
+	void typeAnalysis(TypeAnalysis * ta);
+	void lower(Lowering * lw);
+
+	//Unparse hooks. indent is handed down to the children,
+	// unless unparseBetween changes it
+	virtual bool unparsePre(std::ostream& out, int indent){ 
+		return true; 
+	}
+	virtual bool unparseBetween(std::ostream& out, int indent, 
+		size_t i, int& childIndent){ return true; }
+	virtual void unparsePost(std::ostream& out, int indent){ }
+
+	//Name analysis hooks. A node that finds a name error
+	// reports it and calls na.fail()
+	virtual bool namePre(NameAnalysis& na){ return true; }
+	virtual bool nameBetween(NameAnalysis& na, size_t i){ 
+		return true; 
+	}
+	virtual void namePost(NameAnalysis& na){ }
+
+	//Type analysis hooks. Most nodes only need typePost,
+	// where the types of their children are available
+	virtual bool typePre(TypeAnalysis * ta){ return true; }
+	virtual bool typeBetween(TypeAnalysis * ta, size_t i){ 
+		return true; 
+	}
+	virtual void typePost(TypeAnalysis * ta);
+
+	//Lowering hooks. An expression pushes its value onto the
+	// Lowering's operand stack when it is done
+	virtual bool lowerPre(Lowering * lw){ return true; }
+	virtual bool lowerBetween(Lowering * lw, size_t i){ 
+		return true; 
+	}
+	virtual void lowerPost(Lowering * lw){ }
+
 	void doIndent(std::ostream&, int);
-	virtual size_t getLine();
-	virtual size_t getCol();
+	//Appends the nodes directly owned by this node, in
+	// source order. Leaves have none.
+	virtual void getChildren(std::vector<ASTNode *>& children){ }
+	Pos getPos(){ return myPos; }
+	size_t getLine(){ return SourceMap::line(myPos); }
+	size_t getCol(){ return SourceMap::col(myPos); }
 	virtual std::string getPosition();
+protected:
+	void setPosition(Pos posIn){
+		myPos = posIn;
+	}
 private:
-	size_t line;
-	size_t col;
+	Pos myPos;
 };
 
 class ProgramNode : public ASTNode{
 public:
 	ProgramNode(DeclListNode *);
-	void unparse(std::ostream&, int) override;
-	virtual bool nameAnalysis(SymbolTable *) override;
-	virtual void typeAnalysis(TypeAnalysis * ta);
+	bool namePre(NameAnalysis& na) override;
+	void namePost(NameAnalysis& na) override;
+	bool typePre(TypeAnalysis * ta) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	DeclListNode * getDeclList(){ return myDeclList; }
 	virtual ~ProgramNode(){ }
 private:
 	DeclListNode * myDeclList;
@@ -60,11 +113,10 @@ private:
 
 class TypeNode : public ASTNode{
 public:
-	TypeNode(size_t lineIn, size_t colIn);
-	void unparse(std::ostream&, int) override = 0;
+	TypeNode(Pos posIn);
+	bool namePre(NameAnalysis& na) override;
 	virtual const DataType * getDataType() = 0;
 	virtual std::string getTypeString();
-	virtual bool nameAnalysis(SymbolTable *) override;
 	virtual void setPtrDepth(size_t depth); 
 	virtual size_t getPtrDepth(){ return myPtrDepth; }
 	virtual void printIndirection(std::ostream& out);
@@ -76,12 +128,13 @@ private:
 class DeclListNode : public ASTNode{
 public:
 	DeclListNode(std::list<DeclNode *> * decls) 
-	: ASTNode(0,0){
+	: ASTNode(NO_POS){
         	myDecls = decls;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	virtual bool nameAnalysis(SymbolTable * symTab) override;
-	virtual void typeAnalysis(TypeAnalysis * ta);
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	std::list<DeclNode *> * getDecls(){ return myDecls; }
+	~DeclListNode(){ delete myDecls; }
 private:
 	std::list<DeclNode *> * myDecls;
 };
@@ -89,27 +142,32 @@ private:
 class VarDeclListNode : public ASTNode{
 public: 
 	VarDeclListNode(std::list<VarDeclNode *> * decls) 
-	: ASTNode(0, 0), myDecls(decls){ }
-	virtual void unparse(std::ostream&, int);
-	virtual bool nameAnalysis(SymbolTable *);
+	: ASTNode(NO_POS), myDecls(decls){ }
+	void getChildren(std::vector<ASTNode *>& children) override;
+	~VarDeclListNode(){ delete myDecls; }
 private:
 	std::list<VarDeclNode *> * myDecls;
 };
 
 class ExpNode : public ASTNode{
 public:
-	ExpNode(size_t lIn, size_t cIn) : ASTNode(lIn, cIn){ }
-	virtual void unparse(std::ostream& out, int indent) override = 0;
-	virtual bool nameAnalysis(SymbolTable * symTab) override = 0;
-	virtual void typeAnalysis(TypeAnalysis * ta);
+	ExpNode(Pos posIn) : ASTNode(posIn){ }
+	//Evaluator hooks (see eval.hpp). Only expressions that name
+	// a location, variables and dereferences, have an evalLoc.
+	virtual int64_t eval(Evaluator * ev) = 0;
+	virtual int64_t * evalLoc(Evaluator * ev);
 };
 
 class DerefNode : public ExpNode {
 public:
-	DerefNode(size_t line, size_t column, ExpNode *);
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable *) override;
-	virtual void typeAnalysis(TypeAnalysis * ta);
+	DerefNode(Pos posIn, ExpNode *);
+	bool unparsePre(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	bool lowerPre(Lowering * lw) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
+	int64_t * evalLoc(Evaluator * ev) override;
 private:
 	ExpNode * myTgt;
 };
@@ -117,12 +175,16 @@ private:
 class IdNode : public ExpNode{
 public:
 	IdNode(IDToken * token);
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
+	bool unparsePre(std::ostream& out, int indent) override;
+	void namePost(NameAnalysis& na) override;
+	void typePost(TypeAnalysis * ta) override;
 	virtual std::string getString();
 	void attachSymbol(SemSymbol * symbolIn);
 	SemSymbol * getSymbol();
-	virtual void typeAnalysis(TypeAnalysis * ta);
+	bool resolveName(SymbolTable * symTab);
+	bool lowerPre(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
+	int64_t * evalLoc(Evaluator * ev) override;
 private:
 	std::string myStrVal;
 	SemSymbol * mySymbol;
@@ -132,19 +194,16 @@ private:
 
 class StmtNode : public ASTNode{
 public:
-	StmtNode(size_t lIn, size_t cIn) : ASTNode(lIn, cIn){ }
-	virtual void unparse(std::ostream& out, int indent) override = 0;
-	virtual void typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType);
+	StmtNode(Pos posIn) : ASTNode(posIn){ }
+	virtual void exec(Evaluator * ev) = 0;
 };
 
 class DeclNode : public ASTNode{
 public:
-	DeclNode(size_t l, size_t c, IdNode *); 
-	void unparse(std::ostream& out, int indent) override =0;
+	DeclNode(Pos posIn, IdNode *); 
 	virtual const DataType * getDeclaredType() const = 0;
 	std::string getDeclaredName();
 	IdNode * getDeclaredID();
-	virtual void typeAnalysis(TypeAnalysis * ta);
 protected:
 	IdNode * myID;
 };
@@ -152,12 +211,14 @@ protected:
 class FormalDeclNode : public DeclNode{
 public:
 	FormalDeclNode(TypeNode * type, IdNode * id) 
-	: DeclNode(id->getLine(), id->getCol(), id), myType(type){ }
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
+	: DeclNode(id->getPos(), id), myType(type){ }
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool namePre(NameAnalysis& na) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
 	virtual TypeNode * getTypeNode() { return myType; }
 	virtual const DataType * getDeclaredType() const { 
 		return myType->getDataType(); }
+	bool lowerPre(Lowering * lw) override;
 private:
 	TypeNode * myType;
 };
@@ -166,7 +227,7 @@ private:
 class FormalsListNode : public ASTNode{
 public:
 	FormalsListNode(std::list<FormalDeclNode *>* formalsIn)
-	: ASTNode(0, 0){
+	: ASTNode(NO_POS){
 		myFormals = formalsIn;
 		auto eltTypeList = new std::list<const DataType *>();
 		for (auto elt : *formalsIn){
@@ -174,8 +235,10 @@ public:
 		}
 		myDataType = new TupleType(eltTypeList);
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	~FormalsListNode(){ delete myFormals; }
 	std::list<FormalDeclNode *> * getDecls(){ return myFormals; }
 	TupleType * getDeclaredType(){ return myDataType; }
 private:
@@ -186,12 +249,14 @@ private:
 class ExpListNode : public ASTNode{
 public:
 	ExpListNode(std::list<ExpNode *> * exps) 
-	: ASTNode(0,0){
+	: ASTNode(NO_POS){
 		myExps = exps;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	void typeAnalysis(TypeAnalysis* ta);
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	~ExpListNode(){ delete myExps; }
 	size_t size(){ return myExps->size(); }
 	std::list<ExpNode *> * getList(){ return myExps; }
 private:
@@ -201,26 +266,33 @@ private:
 class StmtListNode : public ASTNode{
 public:
 	StmtListNode(std::list<StmtNode *> * stmtsIn) 
-	: ASTNode(0,0){
+	: ASTNode(NO_POS){
 		myStmts = stmtsIn;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	virtual bool nameAnalysis(SymbolTable * symTab) override;
-	virtual void typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType);
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	~StmtListNode(){ delete myStmts; }
+	void exec(Evaluator * ev);
 private:
 	std::list<StmtNode *> * myStmts;
 };
 
 class FnBodyNode : public ASTNode{
 public:
-	FnBodyNode(size_t lIn, size_t cIn, VarDeclListNode * decls, StmtListNode * stmts) 
-	: ASTNode(lIn, cIn){
+	FnBodyNode(Pos posIn, VarDeclListNode * decls, StmtListNode * stmts) 
+	: ASTNode(posIn){
 		myStmtList = stmts;
 		myVarDecls = decls;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	virtual void typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType);
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	bool typePre(TypeAnalysis * ta) override;
+	bool typeBetween(TypeAnalysis * ta, size_t i) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	void exec(Evaluator * ev);
 private:
 	StmtListNode * myStmtList;
 	VarDeclListNode * myVarDecls;
@@ -234,7 +306,7 @@ public:
 		IdNode * id, 
 		FormalsListNode * formals, 
 		FnBodyNode * fnBody) 
-		: DeclNode(retASTNode->getLine(),retASTNode->getCol(), id)
+		: DeclNode(retASTNode->getPos(), id)
 	{
 		myFormals = formals;
 		myBody = fnBody;
@@ -247,9 +319,20 @@ public:
 	virtual const DataType * getDeclaredType() const override {
 		return myType;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	virtual void typeAnalysis(TypeAnalysis * ta);
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	bool namePre(NameAnalysis& na) override;
+	bool nameBetween(NameAnalysis& na, size_t i) override;
+	void namePost(NameAnalysis& na) override;
+	bool typePre(TypeAnalysis * ta) override;
+	bool typeBetween(TypeAnalysis * ta, size_t i) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	bool nameAnalysisHeader(SymbolTable * symTab);
+	bool lowerPre(Lowering * lw) override;
+	bool lowerBetween(Lowering * lw, size_t i) override;
+	void lowerPost(Lowering * lw) override;
 private:
 	FormalsListNode * myFormals;
 	FnBodyNode * myBody;
@@ -262,42 +345,38 @@ private:
 
 class IntNode : public TypeNode{
 public:
-	IntNode(size_t lIn, size_t cIn) 
-	: TypeNode(lIn, cIn){}
-	void unparse(std::ostream& out, int indent) override;
+	IntNode(Pos posIn) 
+	: TypeNode(posIn){}
+	bool unparsePre(std::ostream& out, int indent) override;
 	virtual const DataType * getDataType() override;
 };
 
 class BoolNode : public TypeNode{
 public:
-	BoolNode(size_t lIn, size_t cIn) 
-	: TypeNode(lIn, cIn) { }
-	void unparse(std::ostream& out, int indent) override;
+	BoolNode(Pos posIn) 
+	: TypeNode(posIn) { }
+	bool unparsePre(std::ostream& out, int indent) override;
 	virtual const DataType * getDataType() override;
 };
 
 class VoidNode : public TypeNode{
 public:
-	VoidNode(size_t lIn, size_t cIn) 
-	: TypeNode(lIn, cIn){}
+	VoidNode(Pos posIn) 
+	: TypeNode(posIn){}
 	virtual const DataType * getDataType() override;
-	void unparse(std::ostream& out, int indent) override;
+	bool unparsePre(std::ostream& out, int indent) override;
 };
 
 class IntLitNode : public ExpNode{
 public:
 	IntLitNode(IntLitToken * token)
-	: ExpNode(token->_line, token->_column){
+	: ExpNode(token->_pos){
 		myInt = token->value();
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override { 
-		if (symTab == nullptr) { 
-			throw InternalError("null symtab");
-		}
-		return true; 
-	}
-	virtual void typeAnalysis(TypeAnalysis * ta);
+	bool unparsePre(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	bool lowerPre(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 private:
 	int myInt;
 };
@@ -305,13 +384,13 @@ private:
 class StrLitNode : public ExpNode{
 public:
 	StrLitNode(StringLitToken * token)
-	: ExpNode(token->_line, token->_column){
+	: ExpNode(token->_pos){
 		myString = token->value();
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable *) override { 
-		return true; 
-	}
+	bool unparsePre(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	bool lowerPre(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 private:
 	 std::string myString;
 };
@@ -319,37 +398,37 @@ private:
 
 class TrueNode : public ExpNode{
 public:
-	TrueNode(size_t lIn, size_t cIn): ExpNode(lIn, cIn){ }
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable *) override { 
-		return true; 
-	}
-	void typeAnalysis(TypeAnalysis * ta) override;
+	TrueNode(Pos posIn): ExpNode(posIn){ }
+	bool unparsePre(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	bool lowerPre(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 };
 
 class FalseNode : public ExpNode{
 public:
-	FalseNode(size_t lIn, size_t cIn): ExpNode(lIn, cIn){ }
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override { 
-		if (symTab == nullptr) { 
-			throw InternalError("null symTab"); 
-		}
-		return true; 
-	}
-	void typeAnalysis(TypeAnalysis * ta) override;
+	FalseNode(Pos posIn): ExpNode(posIn){ }
+	bool unparsePre(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	bool lowerPre(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 };
 
 class AssignNode : public ExpNode{
 public:
-	AssignNode(size_t lIn, size_t cIn, ExpNode * tgt, ExpNode * src)
-	: ExpNode(lIn, cIn){
+	AssignNode(Pos posIn, ExpNode * tgt, ExpNode * src)
+	: ExpNode(posIn){
 		myTgt = tgt;
 		mySrc = src;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	virtual void typeAnalysis(TypeAnalysis * ta) override;
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	bool lowerBetween(Lowering * lw, size_t i) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 private:
 	ExpNode * myTgt;
 	ExpNode * mySrc;
@@ -358,26 +437,43 @@ private:
 class CallExpNode : public ExpNode{
 public:
 	CallExpNode(IdNode * id, ExpListNode * expList)
-	: ExpNode(id->getLine(), id->getCol()){
+	: ExpNode(id->getPos()), myFolded(false), myFoldedVal(0){
 		myId = id;
 		myExpList = expList;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	void typeAnalysis(TypeAnalysis * ta) override;
+	IdNode * getCallee(){ return myId; }
+	ExpListNode * getArgs(){ return myExpList; }
+	//Stand in the call's value, worked out at compile time, for
+	// the call itself (see foldConstantCalls). A folded call is
+	// lowered and evaluated as just that constant.
+	void fold(int64_t val){
+		myFolded = true;
+		myFoldedVal = val;
+	}
+	bool isFolded() const { return myFolded; }
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	bool lowerBetween(Lowering * lw, size_t i) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 private:
 	IdNode * myId;
 	ExpListNode * myExpList;
+	bool myFolded;
+	int64_t myFoldedVal;
 };
 
 class UnaryExpNode : public ExpNode {
 public:
-	UnaryExpNode(size_t lIn, size_t cIn, ExpNode * expIn) 
-	: ExpNode(lIn, cIn){
+	UnaryExpNode(Pos posIn, ExpNode * expIn) 
+	: ExpNode(posIn){
 		this->myExp = expIn;
 	}
-	virtual void unparse(std::ostream& out, int indent) override = 0;
-	virtual bool nameAnalysis(SymbolTable * symTab) override = 0;
+	void getChildren(std::vector<ASTNode *>& children) override;
 protected:
 	ExpNode * myExp;
 };
@@ -385,157 +481,266 @@ protected:
 class UnaryMinusNode : public UnaryExpNode{
 public:
 	UnaryMinusNode(ExpNode * exp)
-	: UnaryExpNode(exp->getLine(), exp->getCol(), exp){ }
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	void typeAnalysis(TypeAnalysis * ta) override;
+	: UnaryExpNode(exp->getPos(), exp){ }
+	bool unparsePre(std::ostream& out, int indent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 };
 
 class NotNode : public UnaryExpNode{
 public:
-	NotNode(size_t lIn, size_t cIn, ExpNode * exp)
-	: UnaryExpNode(lIn, cIn, exp){ }
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	void typeAnalysis(TypeAnalysis * ta) override;
+	NotNode(Pos posIn, ExpNode * exp)
+	: UnaryExpNode(posIn, exp){ }
+	bool unparsePre(std::ostream& out, int indent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	bool lowerPre(Lowering * lw) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 };
 
 class BinaryExpNode : public ExpNode{
 public:
 	BinaryExpNode(
-		size_t lIn, size_t cIn, 
+		Pos posIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: ExpNode(lIn, cIn) {
+	: ExpNode(posIn) {
 		this->myExp1 = exp1;
 		this->myExp2 = exp2;
 	}
-	virtual void unparse(std::ostream& out, int indent)
-		override;
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
 	virtual std::string myOp() = 0;
-	bool nameAnalysis(SymbolTable * symTab) override;
 protected:
 	ExpNode * myExp1;
 	ExpNode * myExp2;
 };
 
-class PlusNode : public BinaryExpNode{
+//A run of the same associative operator, such as a+b+c+d. The
+// parser would otherwise build a left spine of binary nodes,
+// one per operator. Instead, the operands are kept in one
+// array, and everything else behaves as if the spine existed:
+// the node's position is that of the last operator, unparse
+// prints the spine's parentheses, and type analysis checks
+// one operator at a time, left to right, reporting the same
+// errors at the same positions.
+class ChainExpNode : public ExpNode{
 public:
-	PlusNode(size_t lIn, size_t cIn, 
+	ChainExpNode(Pos posIn, 
+		ExpNode * exp1, ExpNode * exp2)
+	: ExpNode(posIn){
+		myExps.push_back(exp1);
+		myExps.push_back(exp2);
+		myOpPositions.push_back(posIn);
+	}
+	//Make lhs OP rhs, where lhs may already be a chain of OP
+	template <typename Chain>
+	static ExpNode * extend(Pos posIn, 
+		ExpNode * lhs, ExpNode * rhs){
+		Chain * chain = dynamic_cast<Chain *>(lhs);
+		if (chain == nullptr){ 
+			return new Chain(posIn, lhs, rhs);
+		}
+		chain->myExps.push_back(rhs);
+		chain->myOpPositions.push_back(posIn);
+		chain->setPosition(posIn);
+		return chain;
+	}
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	bool typeBetween(TypeAnalysis * ta, size_t i) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	virtual std::string myOp() = 0;
+	size_t numOperands(){ return myExps.size(); }
+	ExpNode * getOperand(size_t i){ return myExps[i]; }
+	bool lowerBetween(Lowering * lw, size_t i) override;
+	void lowerPost(Lowering * lw) override;
+protected:
+	//Type check the k'th operator (counting from 1), whose
+	// operands are everything to its left and myExps[k].
+	// The result is recorded as the type of this node, which
+	// is what the next operator sees as its left operand.
+	virtual void typeOperator(TypeAnalysis * ta, size_t k) = 0;
+	//Combine the two values on top of the operand stack
+	virtual void lowerOperator(Lowering * lw);
+	const DataType * leftType(TypeAnalysis * ta, size_t k);
+	size_t leftLine(size_t k);
+	size_t leftCol(size_t k);
+	size_t opLine(size_t k){ 
+		return SourceMap::line(myOpPositions[k-1]); 
+	}
+	size_t opCol(size_t k){ 
+		return SourceMap::col(myOpPositions[k-1]); 
+	}
+
+	std::vector<ExpNode *> myExps;
+private:
+	std::vector<Pos> myOpPositions;
+};
+
+class PlusNode : public ChainExpNode{
+public:
+	PlusNode(Pos posIn, 
 		ExpNode * exp1, ExpNode * exp2) 
-	: BinaryExpNode(lIn, cIn, exp1, exp2) { }
+	: ChainExpNode(posIn, exp1, exp2) { }
 	virtual std::string myOp() override { return "+"; }
-	void typeAnalysis(TypeAnalysis * ta) override; 
+	int64_t eval(Evaluator * ev) override;
+protected:
+	void typeOperator(TypeAnalysis * ta, size_t k) override;
+	void lowerOperator(Lowering * lw) override;
 };
 
 class MinusNode : public BinaryExpNode{
 public:
-	MinusNode(size_t lIn, size_t cIn, 
+	MinusNode(Pos posIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lIn, cIn, exp1, exp2){ }
+	: BinaryExpNode(posIn, exp1, exp2){ }
 	virtual std::string myOp() override { return "-"; } 
-	void typeAnalysis(TypeAnalysis * ta) override;
+	void typePost(TypeAnalysis * ta) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 };
 
-class TimesNode : public BinaryExpNode{
+class TimesNode : public ChainExpNode{
 public:
-	TimesNode(size_t lIn, size_t cIn,
-		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lIn, cIn, exp1, exp2){ }
-	virtual std::string myOp() override { return "*"; } 
-	void typeAnalysis(TypeAnalysis * ta) override;
+	TimesNode(Pos posIn, 
+		ExpNode * exp1, ExpNode * exp2) 
+	: ChainExpNode(posIn, exp1, exp2) { }
+	virtual std::string myOp() override { return "*"; }
+	int64_t eval(Evaluator * ev) override;
+protected:
+	void typeOperator(TypeAnalysis * ta, size_t k) override;
+	void lowerOperator(Lowering * lw) override;
 };
 
 class DivideNode : public BinaryExpNode{
 public:
-	DivideNode(size_t lIn, size_t cIn,
+	DivideNode(Pos posIn,
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lIn, cIn, exp1, exp2){ }
+	: BinaryExpNode(posIn, exp1, exp2){ }
 	virtual std::string myOp() override { return "/"; } 
-	void typeAnalysis(TypeAnalysis * ta) override;
+	void typePost(TypeAnalysis * ta) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 };
 
-class AndNode : public BinaryExpNode{
+class AndNode : public ChainExpNode{
 public:
-	AndNode(size_t lIn, size_t cIn, 
-		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lIn, cIn, exp1, exp2){ }
-	virtual std::string myOp() override { return " and "; } 
-	void typeAnalysis(TypeAnalysis * ta) override;
+	AndNode(Pos posIn, 
+		ExpNode * exp1, ExpNode * exp2) 
+	: ChainExpNode(posIn, exp1, exp2) { }
+	virtual std::string myOp() override { return " and "; }
+	bool lowerPre(Lowering * lw) override;
+	bool lowerBetween(Lowering * lw, size_t i) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
+protected:
+	void typeOperator(TypeAnalysis * ta, size_t k) override;
 };
 
-class OrNode : public BinaryExpNode{
+class OrNode : public ChainExpNode{
 public:
-	OrNode(size_t lIn, size_t cIn, 
-		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lIn, cIn, exp1, exp2){ }
-	virtual std::string myOp() override { return " or "; } 
-	void typeAnalysis(TypeAnalysis * ta) override;
+	OrNode(Pos posIn, 
+		ExpNode * exp1, ExpNode * exp2) 
+	: ChainExpNode(posIn, exp1, exp2) { }
+	virtual std::string myOp() override { return " or "; }
+	bool lowerPre(Lowering * lw) override;
+	bool lowerBetween(Lowering * lw, size_t i) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
+protected:
+	void typeOperator(TypeAnalysis * ta, size_t k) override;
 };
 
 class EqualsNode : public BinaryExpNode{
 public:
-	EqualsNode(size_t lineIn, size_t colIn, 
+	EqualsNode(Pos posIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
+	: BinaryExpNode(posIn, exp1, exp2){ }
 	virtual std::string myOp() override { return "=="; } 
-	void typeAnalysis(TypeAnalysis * ta) override;
+	void typePost(TypeAnalysis * ta) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 };
 
 class NotEqualsNode : public BinaryExpNode{
 public:
-	NotEqualsNode(size_t lineIn, size_t colIn, 
+	NotEqualsNode(Pos posIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
+	: BinaryExpNode(posIn, exp1, exp2){ }
 	virtual std::string myOp() override { return "!="; } 
-	void typeAnalysis(TypeAnalysis * ta) override;
+	void typePost(TypeAnalysis * ta) override;
 	
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 };
 
 class LessNode : public BinaryExpNode{
 public:
-	LessNode(size_t lineIn, size_t colIn, 
+	LessNode(Pos posIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
+	: BinaryExpNode(posIn, exp1, exp2){ }
 	virtual std::string myOp() override { return "<"; } 
-	void typeAnalysis(TypeAnalysis * ta) override;
+	void typePost(TypeAnalysis * ta) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 };
 
 class GreaterNode : public BinaryExpNode{
 public:
-	GreaterNode(size_t lineIn, size_t colIn, 
+	GreaterNode(Pos posIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
+	: BinaryExpNode(posIn, exp1, exp2){ }
 	virtual std::string myOp() override { return ">"; } 
-	void typeAnalysis(TypeAnalysis * ta) override;
+	void typePost(TypeAnalysis * ta) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 };
 
 class LessEqNode : public BinaryExpNode{
 public:
-	LessEqNode(size_t lineIn, size_t colIn, 
+	LessEqNode(Pos posIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
+	: BinaryExpNode(posIn, exp1, exp2){ }
 	virtual std::string myOp() override { return "<="; } 
-	void typeAnalysis(TypeAnalysis * ta) override;
+	void typePost(TypeAnalysis * ta) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 };
 
 class GreaterEqNode : public BinaryExpNode{
 public:
-	GreaterEqNode(size_t lineIn, size_t colIn, 
+	GreaterEqNode(Pos posIn, 
 		ExpNode * exp1, ExpNode * exp2)
-	: BinaryExpNode(lineIn, colIn, exp1, exp2){ }
+	: BinaryExpNode(posIn, exp1, exp2){ }
 	virtual std::string myOp() override { return ">="; } 
-	void typeAnalysis(TypeAnalysis * ta) override;
+	void typePost(TypeAnalysis * ta) override;
+	void lowerPost(Lowering * lw) override;
+	int64_t eval(Evaluator * ev) override;
 };
 
 class AssignStmtNode : public StmtNode{
 public:
 	AssignStmtNode(AssignNode * assignment)
-	: StmtNode(assignment->getLine(), assignment->getCol()){
+	: StmtNode(assignment->getPos()){
 		myAssign = assignment;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	virtual void typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType);
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	void lowerPost(Lowering * lw) override;
+	void exec(Evaluator * ev) override;
 private:
 	AssignNode * myAssign;
 };
@@ -543,15 +748,21 @@ private:
 class PostIncStmtNode : public StmtNode{
 public:
 	PostIncStmtNode(ExpNode * exp)
-	: StmtNode(exp->getLine(), exp->getCol()){
-		if (exp->getLine() == 0){
+	: StmtNode(exp->getPos()){
+		if (exp->getPos() == NO_POS){
 			throw InternalError("0 pos");
 		}	
 		myExp = exp;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	void typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType) override;
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	bool lowerPre(Lowering * lw) override;
+	void lowerPost(Lowering * lw) override;
+	void exec(Evaluator * ev) override;
 private:
 	ExpNode * myExp;
 };
@@ -559,12 +770,18 @@ private:
 class PostDecStmtNode : public StmtNode{
 public:
 	PostDecStmtNode(ExpNode * exp)
-	: StmtNode(exp->getLine(), exp->getCol()){
+	: StmtNode(exp->getPos()){
 		myExp = exp;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	void typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType) override;
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	bool lowerPre(Lowering * lw) override;
+	void lowerPost(Lowering * lw) override;
+	void exec(Evaluator * ev) override;
 private:
 	ExpNode * myExp;
 };
@@ -572,12 +789,18 @@ private:
 class ReadStmtNode : public StmtNode{
 public:
 	ReadStmtNode(ExpNode * exp)
-	: StmtNode(exp->getLine(), exp->getCol()){
+	: StmtNode(exp->getPos()){
 		myExp = exp;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	void typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType) override;
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	bool lowerPre(Lowering * lw) override;
+	void lowerPost(Lowering * lw) override;
+	void exec(Evaluator * ev) override;
 private:
 	ExpNode * myExp;
 };
@@ -585,27 +808,41 @@ private:
 class WriteStmtNode : public StmtNode{
 public:
 	WriteStmtNode(ExpNode * exp)
-	: StmtNode(exp->getLine(), exp->getCol()){
+	: StmtNode(exp->getPos()){
 		myExp = exp;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	void typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType) override;
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	void lowerPost(Lowering * lw) override;
+	void exec(Evaluator * ev) override;
 private:
 	ExpNode * myExp;
 };
 
 class IfStmtNode : public StmtNode{
 public:
-	IfStmtNode(size_t lineIn, size_t colIn, ExpNode * exp, VarDeclListNode * decls, StmtListNode * stmts)
-	: StmtNode(lineIn, colIn){
+	IfStmtNode(Pos posIn, ExpNode * exp, VarDeclListNode * decls, StmtListNode * stmts)
+	: StmtNode(posIn){
 		myExp = exp;
 		myStmts = stmts;
 		myDecls = decls;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	void typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType) override;
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	bool nameBetween(NameAnalysis& na, size_t i) override;
+	void namePost(NameAnalysis& na) override;
+	bool typeBetween(TypeAnalysis * ta, size_t i) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	bool lowerBetween(Lowering * lw, size_t i) override;
+	void lowerPost(Lowering * lw) override;
+	void exec(Evaluator * ev) override;
 private:
 	ExpNode * myExp;
 	VarDeclListNode * myDecls;
@@ -615,16 +852,25 @@ private:
 class IfElseStmtNode : public StmtNode{
 public:
 	IfElseStmtNode(ExpNode * exp, VarDeclListNode * declsT, StmtListNode * stmtsT, VarDeclListNode * declsF, StmtListNode * stmtsF)
-	: StmtNode(exp->getLine(), exp->getCol()){
+	: StmtNode(exp->getPos()){
 		myExp = exp;
 		myDeclsT = declsT;
 		myStmtsT = stmtsT;
 		myDeclsF = declsF;
 		myStmtsF = stmtsF;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	void typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType) override;
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	bool nameBetween(NameAnalysis& na, size_t i) override;
+	void namePost(NameAnalysis& na) override;
+	bool typeBetween(TypeAnalysis * ta, size_t i) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	bool lowerBetween(Lowering * lw, size_t i) override;
+	void lowerPost(Lowering * lw) override;
+	void exec(Evaluator * ev) override;
 private:
 	ExpNode * myExp;
 	VarDeclListNode * myDeclsT;
@@ -635,15 +881,27 @@ private:
 
 class WhileStmtNode : public StmtNode{
 public:
-	WhileStmtNode(size_t lineIn, size_t colIn, ExpNode * exp, VarDeclListNode * decls, StmtListNode * stmts)
-	: StmtNode(lineIn, colIn){
+	WhileStmtNode(Pos posIn, ExpNode * exp, VarDeclListNode * decls, StmtListNode * stmts)
+	: StmtNode(posIn){
 		myExp = exp;
 		myDecls = decls;
 		myStmts = stmts;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	void typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType) override;
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	bool namePre(NameAnalysis& na) override;
+	bool nameBetween(NameAnalysis& na, size_t i) override;
+	void namePost(NameAnalysis& na) override;
+	bool typePre(TypeAnalysis * ta) override;
+	bool typeBetween(TypeAnalysis * ta, size_t i) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	bool lowerPre(Lowering * lw) override;
+	bool lowerBetween(Lowering * lw, size_t i) override;
+	void lowerPost(Lowering * lw) override;
+	void exec(Evaluator * ev) override;
 private:
 	ExpNode * myExp;
 	VarDeclListNode * myDecls;
@@ -653,25 +911,35 @@ private:
 class CallStmtNode : public StmtNode{
 public:
 	CallStmtNode(CallExpNode * callExp)
-	: StmtNode(callExp->getLine(), callExp->getCol()){
+	: StmtNode(callExp->getPos()){
 		myCallExp = callExp;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	void typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType) override;
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	void lowerPost(Lowering * lw) override;
+	void exec(Evaluator * ev) override;
 private:
 	CallExpNode * myCallExp;
 };
 
 class ReturnStmtNode : public StmtNode{
 public:
-	ReturnStmtNode(size_t lineIn, size_t colIn, ExpNode * exp)
-	: StmtNode(lineIn, colIn){
+	ReturnStmtNode(Pos posIn, ExpNode * exp)
+	: StmtNode(posIn){
 		myExp = exp;
 	}
-	void unparse(std::ostream& out, int indent) override;
-	bool nameAnalysis(SymbolTable * symTab) override;
-	void typeAnalysis(TypeAnalysis * t, TypeNode* fnRetType) override;
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool unparseBetween(std::ostream& out, int indent, size_t i,
+		int& childIndent) override;
+	void unparsePost(std::ostream& out, int indent) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
+	void lowerPost(Lowering * lw) override;
+	void exec(Evaluator * ev) override;
 private:
 	ExpNode * myExp;
 };
@@ -679,13 +947,16 @@ private:
 class VarDeclNode : public DeclNode{
 public:
 	VarDeclNode(TypeNode * type, IdNode * id) 
-	: DeclNode(id->getLine(), id->getCol(), id), myType(type){ }
-	void unparse(std::ostream& out, int indent) override;
+	: DeclNode(id->getPos(), id), myType(type){ }
+	bool unparsePre(std::ostream& out, int indent) override;
+	bool namePre(NameAnalysis& na) override;
+	bool typePre(TypeAnalysis * ta) override;
+	void typePost(TypeAnalysis * ta) override;
+	void getChildren(std::vector<ASTNode *>& children) override;
 	virtual const DataType * getDeclaredType() const { 
 		return myType->getDataType(); }
-	bool nameAnalysis(SymbolTable * symTab) override;
-	virtual void typeAnalysis(TypeAnalysis * ta);
 	virtual TypeNode * getTypeNode() { return myType; } 
+	bool lowerPre(Lowering * lw) override;
 private:
 	TypeNode * myType;
 	//Note that VarDeclNode does not have it's own 
@@ -693,6 +964,20 @@ private:
 	
 };
 
+//Frees an entire subtree. The tree is walked with an explicit
+// stack, so the depth of the tree does not matter. Types and
+// symbols are not owned by the tree and are left alone.
+void deleteAST(ASTNode * root);
+
+//Receives top-level declarations one at a time, as soon as the
+// parser has reduced them, instead of having them collected
+// into the ProgramNode. The sink takes ownership of the decl.
+class DeclSink{
+public:
+	virtual ~DeclSink(){ }
+	virtual void consume(DeclNode * decl) = 0;
+};
+
 } //End namespace TEENC
 
 #endif
@@ -0,0 +1,514 @@
+#include <algorithm>
+#include "vm.hpp"
+#include "ssa.hpp"
+
+namespace lake{
+
+static VMOp vmOp(IRInstr::Op op, bool immB){
+	uint32_t base = static_cast<uint32_t>(immB ? VMOp::ADDK : VMOp::ADD);
+	return static_cast<VMOp>(base + (op - IRInstr::ADD));
+}
+
+//The compare-and-branch for a comparison
+static VMOp vmBranchOp(IRInstr::Op op, bool immB){
+	uint32_t base = static_cast<uint32_t>(immB ? VMOp::JEQK : VMOp::JEQ);
+	return static_cast<VMOp>(base + (op - IRInstr::EQ));
+}
+
+//The comparison that holds exactly when op doesn't
+static IRInstr::Op negated(IRInstr::Op op){
+	switch (op){
+	case IRInstr::EQ: return IRInstr::NE;
+	case IRInstr::NE: return IRInstr::EQ;
+	case IRInstr::LT: return IRInstr::GE;
+	case IRInstr::GE: return IRInstr::LT;
+	case IRInstr::GT: return IRInstr::LE;
+	case IRInstr::LE: return IRInstr::GT;
+	default: return op;
+	}
+}
+
+//a < b is b > a, and so on
+static IRInstr::Op swapped(IRInstr::Op op){
+	switch (op){
+	case IRInstr::LT: return IRInstr::GT;
+	case IRInstr::GT: return IRInstr::LT;
+	case IRInstr::LE: return IRInstr::GE;
+	case IRInstr::GE: return IRInstr::LE;
+	default: return op;
+	}
+}
+
+static bool isImm32(const Operand& op){
+	return op.isImm() && op.getImm() >= INT32_MIN && op.getImm() <= INT32_MAX;
+}
+
+//Compiles one function. Immediates that an instruction can't
+// take in place are loaded into scratch registers, which follow
+// the IR's registers in the frame.
+class BytecodeGen{
+public:
+	BytecodeGen(Bytecode * bcIn, IRFunction * fnIn)
+	: bc(bcIn), fn(fnIn){ }
+	VMFunction compile();
+private:
+	void word(uint32_t w){ bc->code.push_back(w); }
+	void op(VMOp o){ word(static_cast<uint32_t>(o)); }
+	//The register holding op, loading an immediate into scratch
+	// register #scratch first
+	uint32_t reg(const Operand& operand, uint32_t scratch);
+	void jumpTo(IRBlock * target){
+		fixups.push_back({bc->code.size(), target->id});
+		word(0);
+	}
+	void binary(IRInstr * instr);
+	//A comparison that only the branch after it uses becomes a
+	// compare-and-branch (and maybe a jump) instead
+	void compareBranch(IRInstr * instr, IRInstr * br, IRBlock * next);
+	//The registers holding a call's arguments
+	std::vector<uint32_t> callArgs(IRInstr * instr);
+	void genInstr(IRInstr * instr, IRBlock * next);
+
+	Bytecode * bc;
+	IRFunction * fn;
+	std::vector<uint32_t> regMap;
+	uint32_t firstScratch;
+	uint32_t discard;
+	std::vector<std::pair<size_t, uint32_t>> fixups;
+	HashMap<IRInstr *, bool> fused;
+};
+
+uint32_t BytecodeGen::reg(const Operand& operand, uint32_t scratch){
+	if (operand.isReg()){ return regMap[operand.getReg()]; }
+	uint64_t v = static_cast<uint64_t>(operand.getImm());
+	op(VMOp::LOADK);
+	word(firstScratch + scratch);
+	word(static_cast<uint32_t>(v));
+	word(static_cast<uint32_t>(v >> 32));
+	return firstScratch + scratch;
+}
+
+std::vector<uint32_t> BytecodeGen::callArgs(IRInstr * instr){
+	std::vector<uint32_t> args;
+	uint32_t scratch = 0;
+	for (uint32_t i = 0; i < instr->numArgs; i++){
+		if (instr->args[i].isImm()){
+			args.push_back(reg(instr->args[i], scratch++));
+		} else {
+			args.push_back(regMap[instr->args[i].getReg()]);
+		}
+	}
+	return args;
+}
+
+void BytecodeGen::binary(IRInstr * instr){
+	IRInstr::Op irOp = instr->op;
+	Operand a = instr->a;
+	Operand b = instr->b;
+	//Only the right operand can be an immediate in place
+	bool swappable = irOp == IRInstr::ADD || irOp == IRInstr::MUL
+		|| irOp == IRInstr::EQ || irOp == IRInstr::NE
+		|| swapped(irOp) != irOp;
+	if (a.isImm() && b.isReg() && swappable){
+		std::swap(a, b);
+		irOp = swapped(irOp);
+	}
+	uint32_t ra = reg(a, 0);
+	if (isImm32(b)){
+		op(vmOp(irOp, true));
+		word(regMap[instr->dst]);
+		word(ra);
+		word(static_cast<uint32_t>(b.getImm()));
+		return;
+	}
+	uint32_t rb = reg(b, 1);
+	op(vmOp(irOp, false));
+	word(regMap[instr->dst]);
+	word(ra);
+	word(rb);
+}
+
+void BytecodeGen::compareBranch(IRInstr * instr, IRInstr * br,
+	IRBlock * next){
+	IRInstr::Op irOp = instr->op;
+	IRBlock * target = br->targets[0];
+	IRBlock * other = br->targets[1];
+	if (target == next){
+		irOp = negated(irOp);
+		std::swap(target, other);
+	}
+	Operand a = instr->a;
+	Operand b = instr->b;
+	if (a.isImm() && b.isReg()){
+		std::swap(a, b);
+		irOp = swapped(irOp);
+	}
+	uint32_t ra = reg(a, 0);
+	if (isImm32(b)){
+		op(vmBranchOp(irOp, true));
+		word(ra);
+		word(static_cast<uint32_t>(b.getImm()));
+	} else {
+		uint32_t rb = reg(b, 1);
+		op(vmBranchOp(irOp, false));
+		word(ra);
+		word(rb);
+	}
+	jumpTo(target);
+	if (other != next){
+		op(VMOp::JMP);
+		jumpTo(other);
+	}
+}
+
+void BytecodeGen::genInstr(IRInstr * instr, IRBlock * next){
+	uint32_t dst = instr->dst == NO_REG ? discard : regMap[instr->dst];
+	switch (instr->op){
+	case IRInstr::COPY:
+		if (instr->a.isImm()){
+			uint64_t v = static_cast<uint64_t>(instr->a.getImm());
+			op(VMOp::LOADK);
+			word(dst);
+			word(static_cast<uint32_t>(v));
+			word(static_cast<uint32_t>(v >> 32));
+		} else {
+			op(VMOp::MOV);
+			word(dst);
+			word(regMap[instr->a.getReg()]);
+		}
+		return;
+	case IRInstr::ADD: case IRInstr::SUB: case IRInstr::MUL:
+	case IRInstr::DIV:
+		binary(instr);
+		return;
+	case IRInstr::EQ: case IRInstr::NE: case IRInstr::LT:
+	case IRInstr::GT: case IRInstr::LE: case IRInstr::GE:
+		if (fused.count(instr) != 0){
+			compareBranch(instr, instr->next, next);
+		} else {
+			binary(instr);
+		}
+		return;
+	case IRInstr::NEG: case IRInstr::NOT: {
+		uint32_t a = reg(instr->a, 0);
+		op(instr->op == IRInstr::NEG ? VMOp::NEG : VMOp::NOT);
+		word(dst);
+		word(a);
+		return;
+	}
+	case IRInstr::LOADG:
+		op(VMOp::LOADG);
+		word(dst);
+		word(instr->index + 1);
+		return;
+	case IRInstr::STOREG: {
+		uint32_t a = reg(instr->a, 0);
+		op(VMOp::STOREG);
+		word(instr->index + 1);
+		word(a);
+		return;
+	}
+	case IRInstr::LOAD: {
+		uint32_t a = reg(instr->a, 0);
+		op(VMOp::LOAD);
+		word(dst);
+		word(a);
+		return;
+	}
+	case IRInstr::STORE: {
+		uint32_t a = reg(instr->a, 0);
+		uint32_t b = reg(instr->b, 1);
+		op(VMOp::STORE);
+		word(a);
+		word(b);
+		return;
+	}
+	case IRInstr::LOADT: {
+		uint32_t a = reg(instr->a, 0);
+		op(VMOp::LOADT);
+		word(dst);
+		word(bc->tableAt[instr->index]);
+		word(a);
+		return;
+	}
+	case IRInstr::STORET: {
+		uint32_t a = reg(instr->a, 0);
+		uint32_t b = reg(instr->b, 1);
+		op(VMOp::STORET);
+		word(bc->tableAt[instr->index]);
+		word(a);
+		word(b);
+		return;
+	}
+	case IRInstr::CALL: {
+		std::vector<uint32_t> args = callArgs(instr);
+		//A call that is the last thing the function does reuses
+		// its frame, and the callee returns to our caller
+		if (instr->isTailCall()){
+			op(VMOp::TAILCALL);
+		} else {
+			op(VMOp::CALL);
+			word(dst);
+		}
+		word(instr->index);
+		word(instr->numArgs);
+		for (uint32_t a : args){ word(a); }
+		return;
+	}
+	case IRInstr::READ_INT: case IRInstr::READ_BOOL:
+		op(instr->op == IRInstr::READ_INT ?
+			VMOp::READ_INT : VMOp::READ_BOOL);
+		word(dst);
+		return;
+	case IRInstr::WRITE_INT: case IRInstr::WRITE_BOOL: {
+		uint32_t a = reg(instr->a, 0);
+		op(instr->op == IRInstr::WRITE_INT ?
+			VMOp::WRITE_INT : VMOp::WRITE_BOOL);
+		word(a);
+		return;
+	}
+	case IRInstr::WRITE_STR:
+		//Lake has no string variables, so a string is always
+		// written straight from its literal
+		if (!instr->a.isImm()){
+			throw new InternalError("String written from a register");
+		}
+		op(VMOp::WRITE_STR);
+		word(static_cast<uint32_t>(instr->a.getImm()));
+		return;
+	case IRInstr::PHI:
+		throw new InternalError("Phi left in bytecode generation");
+	case IRInstr::JMP:
+		if (instr->targets[0] != next){
+			op(VMOp::JMP);
+			jumpTo(instr->targets[0]);
+		}
+		return;
+	case IRInstr::BR: {
+		if (fused.count(instr->prev) != 0){ return; }
+		IRBlock * ifTrue = instr->targets[0];
+		IRBlock * ifFalse = instr->targets[1];
+		if (instr->a.isImm()){
+			IRBlock * target = instr->a.getImm() != 0 ? ifTrue : ifFalse;
+			if (target != next){
+				op(VMOp::JMP);
+				jumpTo(target);
+			}
+			return;
+		}
+		uint32_t cond = regMap[instr->a.getReg()];
+		if (ifTrue == next){
+			op(VMOp::JZ);
+			word(cond);
+			jumpTo(ifFalse);
+			return;
+		}
+		op(VMOp::JNZ);
+		word(cond);
+		jumpTo(ifTrue);
+		if (ifFalse != next){
+			op(VMOp::JMP);
+			jumpTo(ifFalse);
+		}
+		return;
+	}
+	case IRInstr::RET:
+		if (instr->a.isNone()){
+			op(VMOp::RET0);
+		} else {
+			uint32_t a = reg(instr->a, 0);
+			op(VMOp::RET);
+			word(a);
+		}
+		return;
+	}
+}
+
+VMFunction BytecodeGen::compile(){
+	if (fn->ssa){ leaveSSA(fn); }
+	fused = fn->fusibleCompares();
+	//Parameters come first, where the caller puts the arguments
+	uint32_t numRegs = static_cast<uint32_t>(fn->numRegs());
+	regMap.assign(numRegs, UINT32_MAX);
+	uint32_t next = 0;
+	for (Reg param : fn->params){ regMap[param] = next++; }
+	for (Reg r = 0; r < numRegs; r++){
+		if (regMap[r] == UINT32_MAX){ regMap[r] = next++; }
+	}
+	//Enough scratch for two operands, or every argument of a call
+	uint32_t numScratch = 2;
+	for (IRBlock * block : fn->blocks){
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			numScratch = std::max(numScratch, instr->numArgs);
+		}
+	}
+	firstScratch = numRegs;
+	discard = numRegs + numScratch;
+
+	VMFunction res;
+	res.name = fn->name;
+	res.entry = static_cast<uint32_t>(bc->code.size());
+	res.numParams = static_cast<uint32_t>(fn->params.size());
+	res.frameSize = discard + 1;
+	std::vector<uint32_t> blockAt(fn->blocks.size());
+	for (size_t i = 0; i < fn->blocks.size(); i++){
+		IRBlock * block = fn->blocks[i];
+		IRBlock * nextBlock = i + 1 < fn->blocks.size() ?
+			fn->blocks[i + 1] : nullptr;
+		blockAt[block->id] = static_cast<uint32_t>(bc->code.size());
+		bool left = false;
+		for (IRInstr * instr = block->first; instr != nullptr && !left;
+			instr = instr->next){
+			genInstr(instr, nextBlock);
+			left = instr->isTailCall();
+		}
+		//Lowering ends every block with a terminator, but a
+		// function can still run off its last block
+		if (!left && block->terminator() == nullptr){
+			op(VMOp::RET0);
+		}
+	}
+	for (auto& fixup : fixups){
+		bc->code[fixup.first] = blockAt[fixup.second];
+	}
+	return res;
+}
+
+Bytecode * compileBytecode(IRProgram * prog){
+	Bytecode * bc = new Bytecode();
+	bc->strings = prog->strings;
+	bc->globals = prog->globals;
+	bc->tables = prog->tables;
+	bc->memorySize = prog->globals.size() + 1;
+	for (const IRProgram::Table& table : prog->tables){
+		bc->tableAt.push_back(static_cast<uint32_t>(bc->memorySize));
+		bc->memorySize += table.words;
+	}
+	bc->mainFn = UINT32_MAX;
+	for (IRFunction * fn : prog->functions){
+		if (fn->name == "main"){
+			bc->mainFn = static_cast<uint32_t>(bc->functions.size());
+		}
+		BytecodeGen gen(bc, fn);
+		bc->functions.push_back(gen.compile());
+	}
+	if (bc->mainFn == UINT32_MAX){
+		delete bc;
+		throw new InternalError("No main function to run");
+	}
+	return bc;
+}
+
+static const char * vmOpName(VMOp op){
+	static const char * const names[] = {
+		"mov", "loadk",
+		"add", "sub", "mul", "div", "eq", "ne", "lt", "gt", "le", "ge",
+		"addk", "subk", "mulk", "divk", "eqk", "nek", "ltk", "gtk",
+		"lek", "gek",
+		"neg", "not", "loadg", "storeg", "load", "store", "loadt",
+		"storet", "call",
+		"tailcall", "ret", "ret0", "read_int", "read_bool", "write_int",
+		"write_bool", "write_str", "jmp", "jnz", "jz",
+		"jeq", "jne", "jlt", "jgt", "jle", "jge",
+		"jeqk", "jnek", "jltk", "jgtk", "jlek", "jgek"
+	};
+	static_assert(sizeof(names) / sizeof(names[0])
+		== static_cast<size_t>(VMOp::NUM_OPS), "a name for every op");
+	return names[static_cast<uint32_t>(op)];
+}
+
+//How each op's operand words read: r a register, k a 32-bit
+// immediate, q a 64-bit one (two words), g a memory word, s a
+// string, t a code offset. Calls are done by hand.
+static const char * vmOpFormat(VMOp op){
+	switch (op){
+	case VMOp::MOV: case VMOp::NEG: case VMOp::NOT:
+	case VMOp::LOAD: case VMOp::STORE:
+		return "rr";
+	case VMOp::LOADK: return "rq";
+	case VMOp::LOADG: return "rg";
+	case VMOp::STOREG: return "gr";
+	case VMOp::LOADT: return "rgr";
+	case VMOp::STORET: return "grr";
+	case VMOp::RET: case VMOp::READ_INT: case VMOp::READ_BOOL:
+	case VMOp::WRITE_INT: case VMOp::WRITE_BOOL:
+		return "r";
+	case VMOp::WRITE_STR: return "s";
+	case VMOp::JMP: return "t";
+	case VMOp::JNZ: case VMOp::JZ: return "rt";
+	case VMOp::JEQ: case VMOp::JNE: case VMOp::JLT: case VMOp::JGT:
+	case VMOp::JLE: case VMOp::JGE:
+		return "rrt";
+	case VMOp::JEQK: case VMOp::JNEK: case VMOp::JLTK: case VMOp::JGTK:
+	case VMOp::JLEK: case VMOp::JGEK:
+		return "rkt";
+	case VMOp::RET0: case VMOp::CALL: case VMOp::TAILCALL:
+	case VMOp::NUM_OPS:
+		return "";
+	default:
+		break;
+	}
+	return op >= VMOp::ADDK ? "rrk" : "rrr";
+}
+
+void Bytecode::dump(std::ostream& out) const {
+	out << "globals:";
+	for (size_t i = 0; i < globals.size(); i++){
+		out << " [" << i + 1 << "] " << globals[i];
+	}
+	out << "\n";
+	if (!tables.empty()){
+		out << "tables:";
+		for (size_t i = 0; i < tables.size(); i++){
+			out << " [" << tableAt[i] << "] " << tables[i].name
+				<< " (" << tables[i].words << " words)";
+		}
+		out << "\n";
+	}
+	for (size_t f = 0; f < functions.size(); f++){
+		const VMFunction& fn = functions[f];
+		size_t end = f + 1 < functions.size() ?
+			functions[f + 1].entry : code.size();
+		out << "\n" << fn.name << " (" << fn.numParams
+			<< " params, frame of " << fn.frameSize << "):\n";
+		size_t pc = fn.entry;
+		while (pc < end){
+			VMOp op = static_cast<VMOp>(code[pc]);
+			out << "  " << pc << ": " << vmOpName(op);
+			size_t at = pc + 1;
+			const char * sep = " ";
+			if (op == VMOp::CALL || op == VMOp::TAILCALL){
+				if (op == VMOp::CALL){ out << " r" << code[at++] << ","; }
+				out << " " << functions[code[at]].name << "(";
+				uint32_t n = code[at + 1];
+				for (uint32_t i = 0; i < n; i++){
+					out << (i == 0 ? "" : ", ") << "r" << code[at + 2 + i];
+				}
+				out << ")\n";
+				pc = at + 2 + n;
+				continue;
+			}
+			for (const char * f = vmOpFormat(op); *f != '\0'; f++){
+				out << sep;
+				sep = ", ";
+				uint32_t w = code[at++];
+				switch (*f){
+				case 'r': out << "r" << w; break;
+				case 'k': out << static_cast<int32_t>(w); break;
+				case 'q':
+					out << static_cast<int64_t>(
+						static_cast<uint64_t>(code[at++]) << 32 | w);
+					break;
+				case 'g': out << "[" << w << "]"; break;
+				case 's': out << "str" << w; break;
+				case 't': out << "@" << w; break;
+				}
+			}
+			out << "\n";
+			pc = at;
+		}
+	}
+}
+
+}
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <set>
+#include <thread>
+#include "callgraph.hpp"
+#include "walker.hpp"
+
+namespace lake{
+
+namespace {
+class CallGraphBuilder : public ASTVisitor{
+public:
+	CallGraphBuilder(CallGraph * graphIn)
+	: graph(graphIn), cur(UINT32_MAX){ }
+	bool pre(ASTNode * node, int ctx) override{
+		if (FnDeclNode * decl = dynamic_cast<FnDeclNode *>(node)){
+			cur = graph->addFunction(decl);
+		} else if (CallExpNode * call = dynamic_cast<CallExpNode *>(node)){
+			if (cur != UINT32_MAX){
+				graph->addCall(cur, call->getCallee()->getSymbol());
+			}
+		} else if (dynamic_cast<VarDeclNode *>(node) != nullptr){
+			return false;
+		}
+		return true;
+	}
+	void post(ASTNode * node, int ctx) override{
+		if (dynamic_cast<FnDeclNode *>(node) != nullptr){
+			cur = UINT32_MAX;
+		}
+	}
+private:
+	CallGraph * graph;
+	uint32_t cur;
+};
+}
+
+CallGraph::CallGraph(ProgramNode * root){
+	CallGraphBuilder builder(this);
+	walk(root, builder);
+}
+
+uint32_t CallGraph::addFunction(FnDeclNode * decl){
+	uint32_t res = static_cast<uint32_t>(decls.size());
+	decls.push_back(decl);
+	calls.emplace_back();
+	SemSymbol * sym = decl->getDeclaredID()->getSymbol();
+	if (sym != nullptr){ ids[sym] = res; }
+	return res;
+}
+
+//Functions can only call themselves and functions declared
+// before them, which already have their numbers
+void CallGraph::addCall(uint32_t caller, SemSymbol * callee){
+	auto found = ids.find(callee);
+	if (found == ids.end()){ return; }
+	std::vector<uint32_t>& out = calls[caller];
+	if (std::find(out.begin(), out.end(), found->second) == out.end()){
+		out.push_back(found->second);
+	}
+}
+
+uint32_t CallGraph::find(const std::string& name) const {
+	for (uint32_t f = 0; f < decls.size(); f++){
+		SemSymbol * sym = symbol(f);
+		if (sym != nullptr && sym->getName() == name){ return f; }
+	}
+	return UINT32_MAX;
+}
+
+uint32_t CallGraph::number(SemSymbol * sym) const {
+	auto found = ids.find(sym);
+	return found == ids.end() ? UINT32_MAX : found->second;
+}
+
+std::vector<bool> CallGraph::reachableFrom(uint32_t f) const {
+	std::vector<bool> seen(decls.size(), false);
+	std::vector<uint32_t> work = {f};
+	seen[f] = true;
+	while (!work.empty()){
+		uint32_t g = work.back();
+		work.pop_back();
+		for (uint32_t h : calls[g]){
+			if (!seen[h]){
+				seen[h] = true;
+				work.push_back(h);
+			}
+		}
+	}
+	return seen;
+}
+
+//Tarjan's algorithm, with its own stack of the calls being
+// followed rather than recursion. A component is finished (and
+// so added) only after everything it calls is.
+std::vector<std::vector<uint32_t>> CallGraph::components() const {
+	std::vector<uint32_t> index(decls.size(), UINT32_MAX);
+	std::vector<uint32_t> low(decls.size(), 0);
+	std::vector<bool> onStack(decls.size(), false);
+	std::vector<uint32_t> stack;
+	//Each function being followed, and how many of its callees
+	// have been
+	std::vector<std::pair<uint32_t, size_t>> frames;
+	std::vector<std::vector<uint32_t>> res;
+	uint32_t next = 0;
+	auto enter = [&](uint32_t f){
+		index[f] = next;
+		low[f] = next;
+		next++;
+		stack.push_back(f);
+		onStack[f] = true;
+		frames.push_back({f, 0});
+	};
+	for (uint32_t root = 0; root < decls.size(); root++){
+		if (index[root] != UINT32_MAX){ continue; }
+		enter(root);
+		while (!frames.empty()){
+			uint32_t f = frames.back().first;
+			size_t i = frames.back().second;
+			if (i < calls[f].size()){
+				frames.back().second++;
+				uint32_t g = calls[f][i];
+				if (index[g] == UINT32_MAX){
+					enter(g);
+				} else if (onStack[g]){
+					low[f] = std::min(low[f], index[g]);
+				}
+				continue;
+			}
+			frames.pop_back();
+			if (!frames.empty()){
+				uint32_t caller = frames.back().first;
+				low[caller] = std::min(low[caller], low[f]);
+			}
+			if (low[f] != index[f]){ continue; }
+			std::vector<uint32_t> comp;
+			uint32_t g;
+			do {
+				g = stack.back();
+				stack.pop_back();
+				onStack[g] = false;
+				comp.push_back(g);
+			} while (g != f);
+			std::sort(comp.begin(), comp.end());
+			res.push_back(comp);
+		}
+	}
+	return res;
+}
+
+std::vector<std::string> pruneUnreachable(ProgramNode * root){
+	std::vector<std::string> pruned;
+	CallGraph graph(root);
+	uint32_t main = graph.find("main");
+	if (main == UINT32_MAX){ return pruned; }
+	std::vector<bool> live = graph.reachableFrom(main);
+	HashMap<DeclNode *, bool> dead;
+	for (uint32_t f = 0; f < graph.size(); f++){
+		if (live[f]){ continue; }
+		pruned.push_back(graph.symbol(f)->getName());
+		dead[graph.decl(f)] = true;
+	}
+	std::list<DeclNode *> * decls = root->getDeclList()->getDecls();
+	decls->remove_if([&](DeclNode * decl){
+		return dead.count(decl) != 0;
+	});
+	for (auto entry : dead){ deleteAST(entry.first); }
+	return pruned;
+}
+
+//Each thread takes the lowest numbered component that is ready,
+// and once it is done, makes ready the callers that were only
+// waiting on it
+void forEachBottomUp(const CallGraph& graph, unsigned threads,
+	const std::function<void(uint32_t, const std::vector<uint32_t>&)>&
+	work){
+	std::vector<std::vector<uint32_t>> comps = graph.components();
+	uint32_t n = static_cast<uint32_t>(comps.size());
+	if (threads > n){ threads = n; }
+	if (threads <= 1){
+		for (uint32_t c = 0; c < n; c++){ work(c, comps[c]); }
+		return;
+	}
+	std::vector<uint32_t> compOf(graph.size());
+	for (uint32_t c = 0; c < n; c++){
+		for (uint32_t f : comps[c]){ compOf[f] = c; }
+	}
+	//How many components each one is still waiting on, and the
+	// ones waiting on it
+	std::vector<uint32_t> waiting(n, 0);
+	std::vector<std::vector<uint32_t>> callers(n);
+	for (uint32_t c = 0; c < n; c++){
+		for (uint32_t f : comps[c]){
+			for (uint32_t g : graph.callees(f)){
+				uint32_t d = compOf[g];
+				if (d == c){ continue; }
+				if (!callers[d].empty() && callers[d].back() == c){
+					continue;
+				}
+				callers[d].push_back(c);
+				waiting[c]++;
+			}
+		}
+	}
+
+	std::mutex lock;
+	std::condition_variable changed;
+	std::set<uint32_t> ready;
+	for (uint32_t c = 0; c < n; c++){
+		if (waiting[c] == 0){ ready.insert(c); }
+	}
+	uint32_t done = 0;
+	uint32_t failedAt = n;
+	std::exception_ptr error;
+	auto run = [&](){
+		std::unique_lock<std::mutex> held(lock);
+		while (true){
+			changed.wait(held, [&](){
+				return !ready.empty() || done == n || error != nullptr;
+			});
+			if (done == n || error != nullptr){ return; }
+			uint32_t c = *ready.begin();
+			ready.erase(ready.begin());
+			held.unlock();
+			std::exception_ptr thrown;
+			try {
+				work(c, comps[c]);
+			} catch (...){
+				thrown = std::current_exception();
+			}
+			held.lock();
+			if (thrown != nullptr){
+				if (c < failedAt){
+					failedAt = c;
+					error = thrown;
+				}
+			} else {
+				for (uint32_t d : callers[c]){
+					if (--waiting[d] == 0){ ready.insert(d); }
+				}
+			}
+			done++;
+			changed.notify_all();
+		}
+	};
+	std::vector<std::thread> pool;
+	for (unsigned t = 1; t < threads; t++){
+		pool.emplace_back(run);
+	}
+	run();
+	for (std::thread& thread : pool){ thread.join(); }
+	if (error != nullptr){ std::rethrow_exception(error); }
+}
+
+}
@@ -0,0 +1,75 @@
+#ifndef LAKE_CALLGRAPH_HPP
+#define LAKE_CALLGRAPH_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "symbol_table.hpp"
+
+namespace lake{
+
+//Which functions of a name-checked program call which. Functions
+// are numbered in declaration order, and each one's callees are
+// the functions its body has a call to, in the order the calls
+// first appear, wherever they are in the body.
+class CallGraph{
+public:
+	CallGraph(ProgramNode * root);
+	size_t size() const { return decls.size(); }
+	FnDeclNode * decl(uint32_t f) const { return decls[f]; }
+	SemSymbol * symbol(uint32_t f) const {
+		return decls[f]->getDeclaredID()->getSymbol();
+	}
+	const std::vector<uint32_t>& callees(uint32_t f) const {
+		return calls[f];
+	}
+	//The number of the function called name, or UINT32_MAX
+	uint32_t find(const std::string& name) const;
+	//The number of the function sym is, or UINT32_MAX
+	uint32_t number(SemSymbol * sym) const;
+	//Which functions a call of f may end up running, f included
+	std::vector<bool> reachableFrom(uint32_t f) const;
+	//The strongly connected components, each a set of functions
+	// that can all call each other, bottom up: every component
+	// comes after the ones its functions call. Lake only lets a
+	// function call itself and the ones declared before it, so
+	// each component is one function, and they come in
+	// declaration order.
+	std::vector<std::vector<uint32_t>> components() const;
+
+	//Builder methods
+	uint32_t addFunction(FnDeclNode * decl);
+	void addCall(uint32_t caller, SemSymbol * callee);
+private:
+	std::vector<FnDeclNode *> decls;
+	std::vector<std::vector<uint32_t>> calls;
+	HashMap<SemSymbol *, uint32_t> ids;
+};
+
+//Take the functions main can never reach out of a name-checked
+// program, so that nothing after (type analysis included) sees
+// them, and return their names in declaration order. Globals stay.
+// A program without a main is left alone.
+std::vector<std::string> pruneUnreachable(ProgramNode * root);
+
+//Run work once on each of graph's components, with its number in
+// components() and its functions, on up to threads threads at a
+// time. A component is only started once every component it calls
+// is done, and then sees everything work did for those. Components
+// that don't depend on each other may run at the same time, in any
+// order, so work should only write what belongs to its own
+// component, and leave putting that together to the caller, in
+// component order, which keeps the outcome the same however the
+// threads ran. With threads at 0 or 1 the components simply run
+// one after another, in order. If work throws, no more components
+// are started, and what the lowest numbered component threw is
+// thrown again once the running ones finish.
+void forEachBottomUp(const CallGraph& graph, unsigned threads,
+	const std::function<void(uint32_t, const std::vector<uint32_t>&)>&
+	work);
+
+}
+
+#endif
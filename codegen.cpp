@@ -0,0 +1,611 @@
+#include <algorithm>
+#include "x86.hpp"
+#include "ssa.hpp"
+
+namespace lake{
+
+//The System V registers for the first six arguments
+static const X86Reg ARG_REGS[6] = { RDI, RSI, RDX, RCX, R8, R9 };
+
+//The runtime entry points, in the order genX86 declares them
+enum RuntimeFn{
+	RT_READ_INT, RT_READ_BOOL, RT_WRITE_INT, RT_WRITE_BOOL,
+	RT_WRITE_STR
+};
+
+//Instruction selection for one function. Each IR register lives
+// where the allocation puts it, a machine register or a stack
+// slot. rax, rcx and rdx are never allocated, so they are free
+// as scratch inside any one IR instruction.
+class X86Gen{
+public:
+	X86Gen(X86Module * modIn, const std::vector<uint32_t>& fnSymsIn,
+		const std::vector<uint32_t>& globalSymsIn,
+		const std::vector<uint32_t>& tableSymsIn,
+		const std::vector<uint32_t>& stringSymsIn,
+		const std::vector<size_t>& stringLensIn,
+		const std::vector<uint32_t>& runtimeIn)
+	: mod(modIn), fnSyms(fnSymsIn), globalSyms(globalSymsIn),
+	  tableSyms(tableSymsIn), stringSyms(stringSymsIn), stringLens(stringLensIn),
+	  runtime(runtimeIn), fn(nullptr), out(nullptr), alloc(nullptr){ }
+	void genFunction(IRFunction * fn, X86Symbol * sym,
+		const X86Alloc * alloc);
+private:
+	void emit(X86Instr::Op op, X86Operand dst = X86Operand(),
+		X86Operand src = X86Operand()){
+		out->code.push_back(X86Instr(op, dst, src));
+	}
+	void emitBranch(X86Instr::Op op, X86Cond cond, uint32_t target){
+		X86Instr instr(op);
+		instr.cond = cond;
+		instr.target = target;
+		out->code.push_back(instr);
+	}
+	void emitCall(uint32_t symbol){
+		X86Instr instr(X86Instr::CALL);
+		instr.target = symbol;
+		out->code.push_back(instr);
+	}
+	//Where register r lives
+	X86Operand home(Reg r);
+	X86Operand operand(const Operand& op){
+		if (op.isImm()){ return X86Operand::imm(op.getImm()); }
+		return home(op.getReg());
+	}
+	//Copy src to dst, through scratch if both are in memory
+	void move(X86Operand dst, X86Operand src, X86Reg scratch = RAX);
+	void load(X86Reg r, const Operand& op){
+		move(X86Operand::reg(r), operand(op));
+	}
+	//An operand for src of a two-operand instruction: memory and
+	// 32-bit immediates are fine, but wider immediates have to
+	// go through scratch
+	X86Operand source(const Operand& op, X86Reg scratch);
+	//Make each dst hold its src all at once, as if every src were
+	// read before any dst is written. Only register destinations
+	// can be sources of other moves.
+	void parallelMove(std::vector<std::pair<X86Operand, X86Operand>> moves);
+	void genArith(IRInstr * instr);
+	//Set the flags for a comparison
+	void genCompare(IRInstr * instr);
+	//Go to ifTrue if cond holds, and to ifFalse otherwise
+	void genCondBranch(X86Cond cond, IRBlock * ifTrue, IRBlock * ifFalse,
+		IRBlock * next);
+	void genInstr(IRInstr * instr, IRBlock * next);
+	void genCall(IRInstr * instr);
+	//Whether instr is a call to leave this function by, with a
+	// jump instead of a call and a return
+	bool canJumpTo(IRInstr * instr);
+	void genTailCall(IRInstr * instr);
+	void popFrame();
+	void genEpilogue();
+
+	X86Module * mod;
+	const std::vector<uint32_t>& fnSyms;
+	const std::vector<uint32_t>& globalSyms;
+	const std::vector<uint32_t>& tableSyms;
+	const std::vector<uint32_t>& stringSyms;
+	const std::vector<size_t>& stringLens;
+	const std::vector<uint32_t>& runtime;
+	IRFunction * fn;
+	X86Symbol * out;
+	const X86Alloc * alloc;
+	//The comparisons that jump rather than set their register
+	HashMap<IRInstr *, bool> fused;
+};
+
+X86Operand X86Gen::home(Reg r){
+	const X86Alloc::Home& h = alloc->homes[r];
+	switch (h.kind){
+	case X86Alloc::REG:
+		return X86Operand::reg(h.reg);
+	case X86Alloc::SLOT: {
+		//Slots sit below the saved registers
+		int32_t index = static_cast<int32_t>(alloc->saved.size() + h.slot);
+		return X86Operand::mem(RBP, -8 * (index + 1));
+	}
+	case X86Alloc::NONE:
+		break;
+	}
+	throw new InternalError("Register without a home");
+}
+
+void X86Gen::move(X86Operand dst, X86Operand src, X86Reg scratch){
+	if (dst == src){ return; }
+	bool viaReg = dst.isMem() && (src.isMem()
+		|| (src.isImm() && !src.isImm32()));
+	if (viaReg){
+		emit(X86Instr::MOV, X86Operand::reg(scratch), src);
+		src = X86Operand::reg(scratch);
+	}
+	emit(X86Instr::MOV, dst, src);
+}
+
+X86Operand X86Gen::source(const Operand& op, X86Reg scratch){
+	X86Operand res = operand(op);
+	if (res.isImm() && !res.isImm32()){
+		move(X86Operand::reg(scratch), res);
+		return X86Operand::reg(scratch);
+	}
+	return res;
+}
+
+void X86Gen::parallelMove(
+	std::vector<std::pair<X86Operand, X86Operand>> moves){
+	size_t kept = 0;
+	for (auto& m : moves){
+		if (m.first != m.second){ moves[kept++] = m; }
+	}
+	moves.resize(kept);
+	//Nothing reads a slot being filled, so those moves can go
+	// first, while rax is still free to carry them
+	std::stable_partition(moves.begin(), moves.end(),
+		[](const std::pair<X86Operand, X86Operand>& m){
+			return m.first.isMem();
+		});
+	while (!moves.empty()){
+		bool progress = false;
+		for (size_t i = 0; i < moves.size(); i++){
+			bool blocked = false;
+			for (size_t j = 0; j < moves.size(); j++){
+				if (j != i && moves[j].second == moves[i].first){
+					blocked = true;
+					break;
+				}
+			}
+			if (blocked){ continue; }
+			move(moves[i].first, moves[i].second);
+			moves.erase(moves.begin() + static_cast<long>(i));
+			progress = true;
+			break;
+		}
+		if (progress){ continue; }
+		//Every destination is still needed, so the moves form
+		// cycles. Set one destination's value aside in rax.
+		X86Operand busy = moves[0].first;
+		emit(X86Instr::MOV, X86Operand::reg(RAX), busy);
+		for (auto& m : moves){
+			if (m.second == busy){ m.second = X86Operand::reg(RAX); }
+		}
+	}
+}
+
+static X86Cond condFor(IRInstr::Op op){
+	switch (op){
+	case IRInstr::EQ: return CC_E;
+	case IRInstr::NE: return CC_NE;
+	case IRInstr::LT: return CC_L;
+	case IRInstr::GT: return CC_G;
+	case IRInstr::LE: return CC_LE;
+	case IRInstr::GE: return CC_GE;
+	default:
+		throw new InternalError("Not a comparison");
+	}
+}
+
+//Conditions come in pairs that differ in the lowest bit
+static X86Cond negate(X86Cond cond){
+	return static_cast<X86Cond>(cond ^ 1);
+}
+
+void X86Gen::popFrame(){
+	if (alloc->saved.empty()){
+		emit(X86Instr::MOV, X86Operand::reg(RSP), X86Operand::reg(RBP));
+	} else {
+		int32_t savedBytes = 8 * static_cast<int32_t>(alloc->saved.size());
+		emit(X86Instr::LEA, X86Operand::reg(RSP),
+			X86Operand::mem(RBP, -savedBytes));
+		for (size_t i = alloc->saved.size(); i > 0; i--){
+			emit(X86Instr::POP, X86Operand::reg(alloc->saved[i - 1]));
+		}
+	}
+	emit(X86Instr::POP, X86Operand::reg(RBP));
+}
+
+void X86Gen::genEpilogue(){
+	popFrame();
+	emit(X86Instr::RET);
+}
+
+//Arguments on the stack would have to go where our caller put
+// ours, so only calls that pass them all in registers qualify.
+// A void main has to return 0 itself.
+bool X86Gen::canJumpTo(IRInstr * instr){
+	return instr->isTailCall() && instr->numArgs <= 6
+		&& (fn->returnsValue || fn->name != "main");
+}
+
+//The arguments are all read (from this frame) before it is
+// popped, and the callee then returns to our caller
+void X86Gen::genTailCall(IRInstr * instr){
+	std::vector<std::pair<X86Operand, X86Operand>> moves;
+	for (uint32_t i = 0; i < instr->numArgs; i++){
+		moves.push_back({X86Operand::reg(ARG_REGS[i]),
+			operand(instr->args[i])});
+	}
+	parallelMove(moves);
+	popFrame();
+	X86Instr jmp(X86Instr::TAILJMP);
+	jmp.target = fnSyms[instr->index];
+	out->code.push_back(jmp);
+}
+
+void X86Gen::genCall(IRInstr * instr){
+	uint32_t numStack = instr->numArgs > 6 ? instr->numArgs - 6 : 0;
+	//Keep the stack 16-byte aligned at the call
+	int32_t pad = numStack % 2 == 1 ? 8 : 0;
+	if (pad != 0){
+		emit(X86Instr::SUB, X86Operand::reg(RSP), X86Operand::imm(pad));
+	}
+	for (uint32_t i = instr->numArgs; i > 6; i--){
+		emit(X86Instr::PUSH, X86Operand(), source(instr->args[i - 1], RAX));
+	}
+	std::vector<std::pair<X86Operand, X86Operand>> moves;
+	for (uint32_t i = 0; i < instr->numArgs && i < 6; i++){
+		moves.push_back({X86Operand::reg(ARG_REGS[i]),
+			operand(instr->args[i])});
+	}
+	parallelMove(moves);
+	emitCall(fnSyms[instr->index]);
+	int32_t popped = 8 * static_cast<int32_t>(numStack) + pad;
+	if (popped != 0){
+		emit(X86Instr::ADD, X86Operand::reg(RSP),
+			X86Operand::imm(popped));
+	}
+	if (instr->dst != NO_REG && alloc->homes[instr->dst].kind
+		!= X86Alloc::NONE){
+		move(home(instr->dst), X86Operand::reg(RAX));
+	}
+}
+
+//dst = a op b for add, sub and mul, computing in place when dst
+// is a register
+void X86Gen::genArith(IRInstr * instr){
+	X86Operand rax = X86Operand::reg(RAX);
+	X86Operand rcx = X86Operand::reg(RCX);
+	X86Instr::Op op = instr->op == IRInstr::ADD ? X86Instr::ADD
+		: instr->op == IRInstr::SUB ? X86Instr::SUB
+		: X86Instr::IMUL;
+	bool commutes = op != X86Instr::SUB;
+	X86Operand dst = home(instr->dst);
+	X86Operand a = operand(instr->a);
+	X86Operand b = operand(instr->b);
+	if (commutes && (a.isImm() || b == dst) && !b.isImm()){
+		std::swap(a, b);
+	}
+	//imul only multiplies by a register or memory here
+	if (b.isImm() && (op == X86Instr::IMUL || !b.isImm32())){
+		move(rcx, b);
+		b = rcx;
+	}
+	X86Operand acc = dst.isReg() && b != dst ? dst : rax;
+	move(acc, a);
+	emit(op, acc, b);
+	move(dst, acc);
+}
+
+void X86Gen::genCompare(IRInstr * instr){
+	X86Operand a = operand(instr->a);
+	X86Operand b = source(instr->b, RCX);
+	if (a.isImm() || (a.isMem() && b.isMem())){
+		move(X86Operand::reg(RAX), a);
+		a = X86Operand::reg(RAX);
+	}
+	emit(X86Instr::CMP, a, b);
+}
+
+void X86Gen::genCondBranch(X86Cond cond, IRBlock * ifTrue,
+	IRBlock * ifFalse, IRBlock * next){
+	if (ifTrue == next){
+		emitBranch(X86Instr::JCC, negate(cond), ifFalse->id);
+		return;
+	}
+	emitBranch(X86Instr::JCC, cond, ifTrue->id);
+	if (ifFalse != next){
+		emitBranch(X86Instr::JMP, CC_E, ifFalse->id);
+	}
+}
+
+void X86Gen::genInstr(IRInstr * instr, IRBlock * next){
+	X86Operand rax = X86Operand::reg(RAX);
+	X86Operand rcx = X86Operand::reg(RCX);
+	//Dead results of instructions kept for their side effects
+	// have nowhere to go
+	bool hasHome = instr->dst != NO_REG
+		&& alloc->homes[instr->dst].kind != X86Alloc::NONE;
+	switch (instr->op){
+	case IRInstr::COPY:
+		move(home(instr->dst), operand(instr->a));
+		return;
+	case IRInstr::ADD: case IRInstr::SUB: case IRInstr::MUL:
+		genArith(instr);
+		return;
+	case IRInstr::DIV: {
+		load(RAX, instr->a);
+		emit(X86Instr::CQO);
+		X86Operand b = operand(instr->b);
+		if (b.isImm()){
+			move(rcx, b);
+			b = rcx;
+		}
+		emit(X86Instr::IDIV, X86Operand(), b);
+		if (hasHome){ move(home(instr->dst), rax); }
+		return;
+	}
+	case IRInstr::EQ: case IRInstr::NE: case IRInstr::LT:
+	case IRInstr::GT: case IRInstr::LE: case IRInstr::GE: {
+		genCompare(instr);
+		//A comparison only a branch uses is that branch
+		if (fused.count(instr) != 0){
+			IRInstr * br = instr->next;
+			genCondBranch(condFor(instr->op), br->targets[0],
+				br->targets[1], next);
+			return;
+		}
+		X86Operand dst = home(instr->dst);
+		X86Operand flag = dst.isReg() ? dst : rax;
+		X86Instr set(X86Instr::SETCC, flag);
+		set.cond = condFor(instr->op);
+		out->code.push_back(set);
+		move(dst, flag);
+		return;
+	}
+	case IRInstr::NEG: case IRInstr::NOT: {
+		X86Operand dst = home(instr->dst);
+		move(dst, operand(instr->a));
+		if (instr->op == IRInstr::NEG){
+			emit(X86Instr::NEG, dst);
+		} else {
+			emit(X86Instr::XOR, dst, X86Operand::imm(1));
+		}
+		return;
+	}
+	case IRInstr::LOADG:
+		move(home(instr->dst), X86Operand::sym(globalSyms[instr->index]));
+		return;
+	case IRInstr::STOREG:
+		move(X86Operand::sym(globalSyms[instr->index]),
+			operand(instr->a));
+		return;
+	case IRInstr::LOAD: {
+		X86Operand addr = operand(instr->a);
+		if (!addr.isReg()){
+			move(rax, addr);
+			addr = rax;
+		}
+		move(home(instr->dst), X86Operand::mem(addr.getReg(), 0));
+		return;
+	}
+	case IRInstr::STORE: {
+		X86Operand addr = operand(instr->a);
+		if (!addr.isReg()){
+			move(rax, addr);
+			addr = rax;
+		}
+		X86Operand val = operand(instr->b);
+		if (val.isMem() || (val.isImm() && !val.isImm32())){
+			move(rcx, val);
+			val = rcx;
+		}
+		move(X86Operand::mem(addr.getReg(), 0), val);
+		return;
+	}
+	case IRInstr::LOADT: case IRInstr::STORET: {
+		//rax = the table plus 8 times the index, with the index
+		// doubled three times over in rcx
+		load(RCX, instr->a);
+		for (int i = 0; i < 3; i++){
+			emit(X86Instr::ADD, rcx, rcx);
+		}
+		emit(X86Instr::LEA, rax,
+			X86Operand::sym(tableSyms[instr->index]));
+		emit(X86Instr::ADD, rax, rcx);
+		if (instr->op == IRInstr::LOADT){
+			move(home(instr->dst), X86Operand::mem(RAX, 0));
+			return;
+		}
+		X86Operand val = operand(instr->b);
+		if (val.isMem() || (val.isImm() && !val.isImm32())){
+			move(rcx, val);
+			val = rcx;
+		}
+		move(X86Operand::mem(RAX, 0), val);
+		return;
+	}
+	case IRInstr::CALL:
+		genCall(instr);
+		return;
+	case IRInstr::READ_INT: case IRInstr::READ_BOOL:
+		emitCall(runtime[instr->op == IRInstr::READ_INT ?
+			RT_READ_INT : RT_READ_BOOL]);
+		if (hasHome){ move(home(instr->dst), rax); }
+		return;
+	case IRInstr::WRITE_INT: case IRInstr::WRITE_BOOL:
+		load(RDI, instr->a);
+		emitCall(runtime[instr->op == IRInstr::WRITE_INT ?
+			RT_WRITE_INT : RT_WRITE_BOOL]);
+		return;
+	case IRInstr::WRITE_STR: {
+		//Lake has no string variables, so a string is always
+		// written straight from its literal
+		if (!instr->a.isImm()){
+			throw new InternalError("String written from a register");
+		}
+		size_t str = static_cast<size_t>(instr->a.getImm());
+		emit(X86Instr::LEA, X86Operand::reg(RDI),
+			X86Operand::sym(stringSyms[str]));
+		emit(X86Instr::MOV, X86Operand::reg(RSI),
+			X86Operand::imm(static_cast<int64_t>(stringLens[str])));
+		emitCall(runtime[RT_WRITE_STR]);
+		return;
+	}
+	case IRInstr::PHI:
+		throw new InternalError("Phi left in code generation");
+	case IRInstr::JMP:
+		if (instr->targets[0] != next){
+			emitBranch(X86Instr::JMP, CC_E, instr->targets[0]->id);
+		}
+		return;
+	case IRInstr::BR: {
+		if (fused.count(instr->prev) != 0){ return; }
+		X86Operand cond = operand(instr->a);
+		if (cond.isReg()){
+			emit(X86Instr::TEST, cond, cond);
+		} else {
+			if (cond.isImm()){
+				move(rax, cond);
+				cond = rax;
+			}
+			emit(X86Instr::CMP, cond, X86Operand::imm(0));
+		}
+		genCondBranch(CC_NE, instr->targets[0], instr->targets[1], next);
+		return;
+	}
+	case IRInstr::RET:
+		if (!instr->a.isNone()){
+			load(RAX, instr->a);
+		} else if (fn->name == "main"){
+			//A void main still exits cleanly
+			emit(X86Instr::XOR, rax, rax);
+		}
+		genEpilogue();
+		return;
+	}
+}
+
+void X86Gen::genFunction(IRFunction * fnIn, X86Symbol * sym,
+	const X86Alloc * allocIn){
+	fn = fnIn;
+	out = sym;
+	alloc = allocIn;
+	fused = fn->fusibleCompares();
+	out->numLabels = static_cast<uint32_t>(fn->blocks.size());
+
+	emit(X86Instr::PUSH, X86Operand(), X86Operand::reg(RBP));
+	emit(X86Instr::MOV, X86Operand::reg(RBP), X86Operand::reg(RSP));
+	for (X86Reg r : alloc->saved){
+		emit(X86Instr::PUSH, X86Operand(), X86Operand::reg(r));
+	}
+	//Keep rsp 16-byte aligned below the saved registers and slots
+	int32_t used = 8 * static_cast<int32_t>(alloc->saved.size()
+		+ alloc->numSlots);
+	int32_t frame = (used + 15) / 16 * 16
+		- 8 * static_cast<int32_t>(alloc->saved.size());
+	if (frame != 0){
+		emit(X86Instr::SUB, X86Operand::reg(RSP), X86Operand::imm(frame));
+	}
+	std::vector<std::pair<X86Operand, X86Operand>> moves;
+	for (size_t i = 0; i < fn->params.size(); i++){
+		if (alloc->homes[fn->params[i]].kind == X86Alloc::NONE){
+			continue;
+		}
+		X86Operand from = i < 6 ? X86Operand::reg(ARG_REGS[i])
+			: X86Operand::mem(RBP, 16 + 8 * static_cast<int32_t>(i - 6));
+		moves.push_back({home(fn->params[i]), from});
+	}
+	parallelMove(moves);
+
+	for (size_t i = 0; i < fn->blocks.size(); i++){
+		IRBlock * block = fn->blocks[i];
+		IRBlock * next = i + 1 < fn->blocks.size() ?
+			fn->blocks[i + 1] : nullptr;
+		emitBranch(X86Instr::LABEL, CC_E, block->id);
+		bool left = false;
+		for (IRInstr * instr = block->first; instr != nullptr && !left;
+			instr = instr->next){
+			if (canJumpTo(instr)){
+				genTailCall(instr);
+				left = true;
+			} else {
+				genInstr(instr, next);
+			}
+		}
+		//Lowering ends every block with a terminator, but a
+		// function can still run off its last block
+		if (!left && block->terminator() == nullptr){
+			if (fn->name == "main"){
+				emit(X86Instr::XOR, X86Operand::reg(RAX),
+					X86Operand::reg(RAX));
+			}
+			genEpilogue();
+		}
+	}
+}
+
+//How many instructions touch the stack frame: slot accesses, and
+// the pushes and pops that save registers
+static size_t stackAccesses(const X86Symbol& sym){
+	size_t res = 0;
+	for (const X86Instr& instr : sym.code){
+		bool frame = (instr.dst.kind() == X86Operand::MEM
+			&& instr.dst.getReg() == RBP)
+			|| (instr.src.kind() == X86Operand::MEM
+			&& instr.src.getReg() == RBP);
+		bool saveRestore = (instr.op == X86Instr::PUSH
+			|| instr.op == X86Instr::POP)
+			&& (instr.src.isReg() || instr.dst.isReg());
+		if (frame || saveRestore){ res++; }
+	}
+	return res;
+}
+
+X86Module * genX86(IRProgram * prog, bool allocate, OptReport * report){
+	X86Module * mod = new X86Module();
+	std::vector<uint32_t> runtime;
+	for (const char * name : {"lakert_read_int", "lakert_read_bool",
+		"lakert_write_int", "lakert_write_bool", "lakert_write_str"}){
+		runtime.push_back(mod->addSymbol(name, X86Symbol::EXTERN, true));
+	}
+	std::vector<uint32_t> fnSyms;
+	for (IRFunction * fn : prog->functions){
+		fnSyms.push_back(mod->addSymbol("lake_" + fn->name,
+			X86Symbol::TEXT, fn->name == "main"));
+	}
+	std::vector<uint32_t> globalSyms;
+	for (const std::string& global : prog->globals){
+		uint32_t sym = mod->addSymbol("lakeg_" + global,
+			X86Symbol::BSS, false);
+		mod->symbols[sym].size = 8;
+		globalSyms.push_back(sym);
+	}
+	std::vector<uint32_t> tableSyms;
+	for (const IRProgram::Table& table : prog->tables){
+		uint32_t sym = mod->addSymbol("laket_" + table.name,
+			X86Symbol::BSS, false);
+		mod->symbols[sym].size = 8 * size_t{table.words};
+		tableSyms.push_back(sym);
+	}
+	std::vector<uint32_t> stringSyms;
+	std::vector<size_t> stringLens;
+	for (size_t i = 0; i < prog->strings.size(); i++){
+		uint32_t sym = mod->addSymbol(".Lstr" + std::to_string(i),
+			X86Symbol::RODATA, false);
+		mod->symbols[sym].data = prog->strings[i];
+		stringSyms.push_back(sym);
+		stringLens.push_back(prog->strings[i].size());
+	}
+	X86Gen gen(mod, fnSyms, globalSyms, tableSyms, stringSyms, stringLens,
+		runtime);
+	for (size_t i = 0; i < prog->functions.size(); i++){
+		IRFunction * fn = prog->functions[i];
+		if (fn->ssa){ leaveSSA(fn); }
+		X86Alloc alloc = allocate ? allocateRegisters(fn)
+			: naiveAllocation(fn);
+		X86Symbol& sym = mod->symbols[fnSyms[i]];
+		gen.genFunction(fn, &sym, &alloc);
+		if (report != nullptr){
+			report->add("codegen", "instructions", sym.code.size());
+			report->add("codegen", "stack accesses", stackAccesses(sym));
+			report->add("codegen", "registers spilled", alloc.spilled);
+			report->add("codegen", "copies coalesced", alloc.coalesced);
+			report->add("codegen", "tail calls made jumps",
+				static_cast<size_t>(std::count_if(sym.code.begin(),
+				sym.code.end(), [](const X86Instr& instr){
+					return instr.op == X86Instr::TAILJMP;
+				})));
+		}
+	}
+	return mod;
+}
+
+}
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <map>
+#include "consteval.hpp"
+#include "eval.hpp"
+#include "walker.hpp"
+
+namespace lake{
+
+//Calls and loop iterations any one call may take, and how deep
+// its calls may nest
+static const size_t CALL_STEPS = 100000;
+static const size_t CALL_DEPTH = 1000;
+//Calls and loop iterations all the calls together may take
+static const size_t TOTAL_STEPS = 10000000;
+
+//Whether exp's value is known without running anything
+static bool isConstant(ExpNode * exp){
+	if (dynamic_cast<IntLitNode *>(exp) != nullptr
+		|| dynamic_cast<TrueNode *>(exp) != nullptr
+		|| dynamic_cast<FalseNode *>(exp) != nullptr){
+		return true;
+	}
+	if (CallExpNode * call = dynamic_cast<CallExpNode *>(exp)){
+		return call->isFolded();
+	}
+	if (UnaryMinusNode * neg = dynamic_cast<UnaryMinusNode *>(exp)){
+		std::vector<ASTNode *> children;
+		neg->getChildren(children);
+		return isConstant(static_cast<ExpNode *>(children[0]));
+	}
+	return false;
+}
+
+namespace {
+//Calls are folded on the way out, so that the arguments have
+// already been folded themselves when their call is looked at
+class CallFolder : public ASTVisitor{
+public:
+	CallFolder(ProgramNode * root, TypeAnalysis * ta,
+		const std::vector<std::string>& pure)
+	: ev(root, ta), stepsLeft(TOTAL_STEPS), folded(0){
+		for (const std::string& name : pure){
+			pureNames[name] = true;
+		}
+	}
+	void post(ASTNode * node, int ctx) override{
+		CallExpNode * call = dynamic_cast<CallExpNode *>(node);
+		if (call == nullptr || call->isFolded()){ return; }
+		SemSymbol * fnSym = call->getCallee()->getSymbol();
+		if (fnSym == nullptr
+			|| pureNames.find(fnSym->getName()) == pureNames.end()){
+			return;
+		}
+		std::vector<int64_t> args;
+		for (ExpNode * arg : *call->getArgs()->getList()){
+			if (!isConstant(arg)){ return; }
+			args.push_back(arg->eval(&ev));
+		}
+
+		//The same call gives the same result, or runs out again
+		auto key = std::make_pair(fnSym, args);
+		auto found = results.find(key);
+		if (found == results.end()){
+			if (stepsLeft == 0){ return; }
+			Result res = {false, 0};
+			size_t budget = std::min(CALL_STEPS, stepsLeft);
+			size_t steps = budget;
+			try {
+				res.val = ev.callBounded(fnSym, args, steps, CALL_DEPTH);
+				res.known = true;
+			} catch (RuntimeError * e){
+				delete e;
+			}
+			stepsLeft -= budget - steps;
+			found = results.insert({key, res}).first;
+		}
+		if (found->second.known){
+			call->fold(found->second.val);
+			folded++;
+		}
+	}
+
+	size_t numFolded() const { return folded; }
+private:
+	struct Result{
+		bool known;
+		int64_t val;
+	};
+
+	Evaluator ev;
+	HashMap<std::string, bool> pureNames;
+	std::map<std::pair<SemSymbol *, std::vector<int64_t>>, Result>
+		results;
+	size_t stepsLeft;
+	size_t folded;
+};
+}
+
+size_t foldConstantCalls(ProgramNode * root, TypeAnalysis * ta,
+	const std::vector<std::string>& pure){
+	if (pure.empty()){ return 0; }
+	CallFolder folder(root, ta, pure);
+	walk(root, folder);
+	return folder.numFolded();
+}
+
+}
@@ -0,0 +1,23 @@
+#ifndef LAKE_CONSTEVAL_HPP
+#define LAKE_CONSTEVAL_HPP
+
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "types.hpp"
+
+namespace lake{
+
+//Work out each call to one of the pure functions named (see
+// findPureFunctions) whose arguments are all literals, or calls
+// folded already, at compile time, and fold it into its result.
+// Every call is run by the AST evaluator on a budget of calls and
+// loop iterations, and of nesting; one that runs out, or stops
+// with a runtime error, is left to happen when the program runs.
+// Returns how many calls were folded.
+size_t foldConstantCalls(ProgramNode * root, TypeAnalysis * ta,
+	const std::vector<std::string>& pure);
+
+}
+
+#endif
@@ -0,0 +1,280 @@
+#include <algorithm>
+#include "opt.hpp"
+
+namespace lake{
+
+//What a copy (or a phi whose inputs all agree) can be replaced
+// by, following chains of copies to their source
+static Operand copySource(const std::vector<IRInstr *>& defs,
+	Operand op){
+	while (op.isReg()){
+		IRInstr * def = defs[op.getReg()];
+		if (def == nullptr){ return op; }
+		if (def->op == IRInstr::COPY){
+			op = def->a;
+			continue;
+		}
+		if (def->op != IRInstr::PHI){ return op; }
+		//A phi that only ever passes on one value (or itself,
+		// around a loop) is a copy of that value
+		Operand same;
+		bool agree = true;
+		for (uint32_t i = 0; i < def->numArgs && agree; i++){
+			Operand arg = def->args[i];
+			if (arg == Operand::reg(def->dst)){ continue; }
+			if (same.isNone()){
+				same = arg;
+			} else if (arg != same){
+				agree = false;
+			}
+		}
+		if (!agree || same.isNone()){ return op; }
+		op = same;
+	}
+	return op;
+}
+
+void runDCE(IRFunction * fn, OptReport& report){
+	if (!fn->ssa){
+		throw new InternalError("DCE needs SSA form");
+	}
+	std::vector<IRInstr *> defs(fn->numRegs(), nullptr);
+	for (IRBlock * block : fn->blocks){
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			if (instr->dst != NO_REG){ defs[instr->dst] = instr; }
+		}
+	}
+
+	//Read through copies, so that the copies themselves die
+	size_t propagated = 0;
+	for (IRBlock * block : fn->blocks){
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			instr->forEachUse([&](Operand& use){
+				Operand src = copySource(defs, use);
+				if (src != use){
+					use = src;
+					propagated++;
+				}
+			});
+		}
+	}
+
+	//Anything with an effect is live, as is everything that
+	// computes a value a live instruction reads
+	std::vector<bool> live(fn->numRegs(), false);
+	std::vector<IRInstr *> work;
+	for (IRBlock * block : fn->blocks){
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			if (!instr->hasSideEffects()){ continue; }
+			if (instr->dst != NO_REG){ live[instr->dst] = true; }
+			work.push_back(instr);
+		}
+	}
+	while (!work.empty()){
+		IRInstr * instr = work.back();
+		work.pop_back();
+		instr->forEachUse([&](Operand& use){
+			Reg r = use.getReg();
+			if (live[r] || defs[r] == nullptr){ return; }
+			live[r] = true;
+			work.push_back(defs[r]);
+		});
+	}
+
+	size_t removed = 0;
+	for (IRBlock * block : fn->blocks){
+		IRInstr * next;
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = next){
+			next = instr->next;
+			if (instr->hasSideEffects()){ continue; }
+			if (instr->dst != NO_REG && live[instr->dst]){ continue; }
+			block->remove(instr);
+			removed++;
+		}
+	}
+	report.add("dce", "uses read through copies", propagated);
+	report.add("dce", "instructions removed", removed);
+}
+
+static void eraseBlock(std::vector<IRBlock *>& list, IRBlock * block){
+	list.erase(std::remove(list.begin(), list.end(), block), list.end());
+}
+
+static void replaceBlock(std::vector<IRBlock *>& list,
+	IRBlock * from, IRBlock * to){
+	if (std::find(list.begin(), list.end(), to) != list.end()){
+		eraseBlock(list, from);
+		return;
+	}
+	for (IRBlock *& block : list){
+		if (block == from){ block = to; }
+	}
+}
+
+static bool hasPhis(const IRBlock * block){
+	return block->first != nullptr && block->first->op == IRInstr::PHI;
+}
+
+//Branches that go the same way either way, or on a constant,
+// become jumps
+static size_t foldBranches(IRFunction * fn){
+	size_t folded = 0;
+	for (IRBlock * block : fn->blocks){
+		IRInstr * term = block->terminator();
+		if (term == nullptr || term->op != IRInstr::BR){ continue; }
+		if (term->targets[0] == term->targets[1]){
+			term->op = IRInstr::JMP;
+		} else if (term->a.isImm()){
+			int taken = term->a.getImm() != 0 ? 0 : 1;
+			term->targets[1 - taken]->removePhiInputs(block);
+			term->targets[0] = term->targets[taken];
+			term->op = IRInstr::JMP;
+		} else {
+			continue;
+		}
+		term->a = Operand();
+		term->targets[1] = nullptr;
+		folded++;
+	}
+	return folded;
+}
+
+//Fold succ, whose only way in is a jump from block, into block
+static void mergeInto(IRBlock * block, IRBlock * succ){
+	block->remove(block->last);
+	IRInstr * next;
+	for (IRInstr * instr = succ->first; instr != nullptr; instr = next){
+		next = instr->next;
+		succ->remove(instr);
+		if (instr->op == IRInstr::PHI){
+			instr->makeCopy(instr->args[0]);
+		}
+		block->append(instr);
+	}
+	for (IRBlock * after : succ->succs){
+		for (IRInstr * phi = after->first;
+			phi != nullptr && phi->op == IRInstr::PHI; phi = phi->next){
+			for (uint32_t i = 0; i < phi->numArgs; i++){
+				if (phi->blocks[i] == succ){ phi->blocks[i] = block; }
+			}
+		}
+		replaceBlock(after->preds, succ, block);
+	}
+	block->succs = succ->succs;
+	succ->preds.clear();
+	succ->succs.clear();
+}
+
+//Send block's predecessors straight to where its lone jump goes.
+// Returns how many were moved.
+static size_t threadJump(IRFunction * fn, IRBlock * block){
+	IRBlock * target = block->first->targets[0];
+	bool targetPhis = hasPhis(target);
+	size_t moved = 0;
+	std::vector<IRBlock *> preds = block->preds;
+	for (IRBlock * pred : preds){
+		//A phi can't tell two edges from the same block apart
+		if (targetPhis && std::find(target->preds.begin(),
+			target->preds.end(), pred) != target->preds.end()){
+			continue;
+		}
+		IRInstr * term = pred->last;
+		for (IRBlock *& t : term->targets){
+			if (t == block){ t = target; }
+		}
+		for (IRInstr * phi = target->first;
+			phi != nullptr && phi->op == IRInstr::PHI; phi = phi->next){
+			for (uint32_t i = 0; i < phi->numArgs; i++){
+				if (phi->blocks[i] == block){
+					fn->addArg(phi, phi->args[i], pred);
+					break;
+				}
+			}
+		}
+		eraseBlock(block->preds, pred);
+		replaceBlock(pred->succs, block, target);
+		if (std::find(target->preds.begin(), target->preds.end(),
+			pred) == target->preds.end()){
+			target->preds.push_back(pred);
+		}
+		moved++;
+	}
+	if (block->preds.empty()){
+		target->removePhiInputs(block);
+		eraseBlock(target->preds, block);
+		block->succs.clear();
+	}
+	return moved;
+}
+
+void simplifyCFG(IRFunction * fn, OptReport& report){
+	if (fn->blocks.empty()){ return; }
+	size_t numBlocks = fn->blocks.size();
+	size_t branches = foldBranches(fn);
+	fn->rebuildEdges();
+	fn->removeUnreachableBlocks();
+	size_t unreachable = numBlocks - fn->blocks.size();
+	size_t merged = 0;
+	size_t threaded = 0;
+	IRBlock * entry = fn->blocks[0];
+	bool changed = true;
+	while (changed){
+		changed = false;
+		for (IRBlock * block : fn->blocks){
+			if (block != entry && block->preds.empty()){ continue; }
+			IRInstr * term = block->terminator();
+			while (term != nullptr && term->op == IRInstr::JMP){
+				IRBlock * succ = term->targets[0];
+				if (succ == block || succ == entry
+					|| succ->preds.size() != 1){
+					break;
+				}
+				mergeInto(block, succ);
+				merged++;
+				changed = true;
+				term = block->terminator();
+			}
+		}
+		for (IRBlock * block : fn->blocks){
+			if (block == entry || block->preds.empty()){ continue; }
+			if (block->first == nullptr
+				|| block->first->op != IRInstr::JMP
+				|| block->first->targets[0] == block){
+				continue;
+			}
+			size_t moved = threadJump(fn, block);
+			threaded += moved;
+			changed = changed || moved > 0;
+		}
+		size_t folded = foldBranches(fn);
+		branches += folded;
+		changed = changed || folded > 0;
+		//Drop the blocks that were merged away or bypassed
+		std::vector<IRBlock *> kept;
+		for (IRBlock * block : fn->blocks){
+			if (block == entry || !block->preds.empty()){
+				kept.push_back(block);
+			} else {
+				block->id = UINT32_MAX;
+			}
+		}
+		fn->blocks.clear();
+		for (IRBlock * block : kept){
+			fn->placeBlock(block);
+		}
+		if (folded > 0){
+			fn->rebuildEdges();
+			fn->removeUnreachableBlocks();
+		}
+	}
+	report.add("cfg", "branches made jumps", branches);
+	report.add("cfg", "unreachable blocks removed", unreachable);
+	report.add("cfg", "blocks merged", merged);
+	report.add("cfg", "jumps threaded", threaded);
+}
+
+}
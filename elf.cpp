@@ -0,0 +1,242 @@
+#include <cstring>
+#include "x86.hpp"
+
+namespace lake{
+
+//Constants from the System V ELF and x86-64 psABI specifications
+enum : uint32_t {
+	SHT_PROGBITS = 1, SHT_SYMTAB = 2, SHT_STRTAB = 3, SHT_RELA = 4,
+	SHT_NOBITS = 8
+};
+enum : uint64_t {
+	SHF_WRITE = 0x1, SHF_ALLOC = 0x2, SHF_EXECINSTR = 0x4,
+	SHF_INFO_LINK = 0x40
+};
+enum : uint8_t {
+	STB_LOCAL = 0, STB_GLOBAL = 1,
+	STT_NOTYPE = 0, STT_OBJECT = 1, STT_FUNC = 2, STT_SECTION = 3
+};
+enum : uint32_t { R_X86_64_PC32 = 2, R_X86_64_PLT32 = 4 };
+
+//The sections of the object, in order after the null section
+enum ElfSection : uint16_t {
+	SEC_TEXT = 1, SEC_RODATA, SEC_BSS, SEC_NOTE, SEC_SYMTAB, SEC_STRTAB,
+	SEC_RELA, SEC_SHSTRTAB, NUM_SECTIONS
+};
+
+//Little-endian bytes for the object file
+class ElfBuffer{
+public:
+	void u8(uint8_t v){ bytes.push_back(v); }
+	void u16(uint16_t v){ put(v, 2); }
+	void u32(uint32_t v){ put(v, 4); }
+	void u64(uint64_t v){ put(v, 8); }
+	void append(const std::vector<uint8_t>& more){
+		bytes.insert(bytes.end(), more.begin(), more.end());
+	}
+	void align(size_t to){
+		while (bytes.size() % to != 0){ bytes.push_back(0); }
+	}
+	size_t size() const { return bytes.size(); }
+	std::vector<uint8_t> bytes;
+private:
+	void put(uint64_t v, size_t n){
+		for (size_t i = 0; i < n; i++){
+			bytes.push_back(static_cast<uint8_t>(v >> (8 * i)));
+		}
+	}
+};
+
+//A string table, which starts with the empty string
+class ElfStrings{
+public:
+	ElfStrings(){ bytes.push_back(0); }
+	uint32_t add(const std::string& str){
+		uint32_t res = static_cast<uint32_t>(bytes.size());
+		bytes.insert(bytes.end(), str.begin(), str.end());
+		bytes.push_back(0);
+		return res;
+	}
+	std::vector<uint8_t> bytes;
+};
+
+static void elfSymbol(ElfBuffer& out, uint32_t name, uint8_t bind,
+	uint8_t type, uint16_t section, uint64_t value, uint64_t size){
+	out.u32(name);
+	out.u8(static_cast<uint8_t>((bind << 4) | type));
+	out.u8(0);
+	out.u16(section);
+	out.u64(value);
+	out.u64(size);
+}
+
+struct ElfSectionHeader{
+	uint32_t name;
+	uint32_t type;
+	uint64_t flags;
+	uint64_t offset;
+	uint64_t size;
+	uint32_t link;
+	uint32_t info;
+	uint64_t align;
+	uint64_t entsize;
+};
+
+void X86Module::writeObject(std::ostream& out) const {
+	X86Code code = encode();
+
+	std::vector<uint8_t> rodata;
+	uint64_t bssSize = 0;
+	std::vector<uint64_t> dataAt(symbols.size(), 0);
+	for (uint32_t i = 0; i < symbols.size(); i++){
+		const X86Symbol& sym = symbols[i];
+		if (sym.kind == X86Symbol::RODATA){
+			dataAt[i] = rodata.size();
+			rodata.insert(rodata.end(), sym.data.begin(), sym.data.end());
+		} else if (sym.kind == X86Symbol::BSS){
+			bssSize = (bssSize + 7) / 8 * 8;
+			dataAt[i] = bssSize;
+			bssSize += sym.size;
+		}
+	}
+
+	//Locals come first in the symbol table: the sections, then
+	// the module's own functions and globals. Strings are reached
+	// through the .rodata section symbol, as as does for .L labels.
+	ElfStrings strtab;
+	ElfBuffer symtab;
+	elfSymbol(symtab, 0, STB_LOCAL, STT_NOTYPE, 0, 0, 0);
+	for (uint16_t sec : {SEC_TEXT, SEC_RODATA, SEC_BSS}){
+		elfSymbol(symtab, 0, STB_LOCAL, STT_SECTION, sec, 0, 0);
+	}
+	uint32_t rodataSym = 2;
+	uint32_t numElfSyms = 4;
+	std::vector<uint32_t> elfIndex(symbols.size(), 0);
+	auto addSymbol = [&](uint32_t i){
+		const X86Symbol& sym = symbols[i];
+		uint32_t name = strtab.add(sym.name);
+		uint8_t bind = sym.global ? STB_GLOBAL : STB_LOCAL;
+		if (sym.kind == X86Symbol::TEXT){
+			uint64_t end = i + 1 < symbols.size()
+				&& symbols[i + 1].kind == X86Symbol::TEXT ?
+				code.offsets[i + 1] : code.bytes.size();
+			elfSymbol(symtab, name, bind, STT_FUNC, SEC_TEXT,
+				code.offsets[i], end - code.offsets[i]);
+		} else if (sym.kind == X86Symbol::BSS){
+			elfSymbol(symtab, name, bind, STT_OBJECT, SEC_BSS,
+				dataAt[i], sym.size);
+		} else {
+			elfSymbol(symtab, name, bind, STT_NOTYPE, 0, 0, 0);
+		}
+		elfIndex[i] = numElfSyms++;
+	};
+	for (uint32_t i = 0; i < symbols.size(); i++){
+		if (!symbols[i].global && symbols[i].kind != X86Symbol::RODATA){
+			addSymbol(i);
+		}
+	}
+	uint32_t firstGlobal = numElfSyms;
+	for (uint32_t i = 0; i < symbols.size(); i++){
+		if (symbols[i].global){ addSymbol(i); }
+	}
+
+	ElfBuffer rela;
+	for (const X86Code::Reloc& reloc : code.relocs){
+		const X86Symbol& sym = symbols[reloc.symbol];
+		uint64_t target = elfIndex[reloc.symbol];
+		int64_t addend = reloc.addend;
+		if (sym.kind == X86Symbol::RODATA){
+			target = rodataSym;
+			addend += static_cast<int64_t>(dataAt[reloc.symbol]);
+		}
+		uint32_t type = reloc.call ? R_X86_64_PLT32 : R_X86_64_PC32;
+		rela.u64(reloc.offset);
+		rela.u64(target << 32 | type);
+		rela.u64(static_cast<uint64_t>(addend));
+	}
+
+	ElfStrings shstrtab;
+	ElfSectionHeader headers[NUM_SECTIONS];
+	std::memset(headers, 0, sizeof(headers));
+	auto section = [&](ElfSection sec, const char * name, uint32_t type,
+		uint64_t flags, uint64_t align){
+		headers[sec].name = shstrtab.add(name);
+		headers[sec].type = type;
+		headers[sec].flags = flags;
+		headers[sec].align = align;
+	};
+	section(SEC_TEXT, ".text", SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, 16);
+	section(SEC_RODATA, ".rodata", SHT_PROGBITS, SHF_ALLOC, 1);
+	section(SEC_BSS, ".bss", SHT_NOBITS, SHF_ALLOC | SHF_WRITE, 8);
+	section(SEC_NOTE, ".note.GNU-stack", SHT_PROGBITS, 0, 1);
+	section(SEC_SYMTAB, ".symtab", SHT_SYMTAB, 0, 8);
+	section(SEC_STRTAB, ".strtab", SHT_STRTAB, 0, 1);
+	section(SEC_RELA, ".rela.text", SHT_RELA, SHF_INFO_LINK, 8);
+	section(SEC_SHSTRTAB, ".shstrtab", SHT_STRTAB, 0, 1);
+	headers[SEC_SYMTAB].link = SEC_STRTAB;
+	headers[SEC_SYMTAB].info = firstGlobal;
+	headers[SEC_SYMTAB].entsize = 24;
+	headers[SEC_RELA].link = SEC_SYMTAB;
+	headers[SEC_RELA].info = SEC_TEXT;
+	headers[SEC_RELA].entsize = 24;
+
+	//The file header, then each section's contents, then the
+	// section headers
+	ElfBuffer file;
+	file.bytes.resize(64);
+	auto place = [&](ElfSection sec, const std::vector<uint8_t>& data){
+		file.align(headers[sec].align);
+		headers[sec].offset = file.size();
+		headers[sec].size = data.size();
+		file.append(data);
+	};
+	place(SEC_TEXT, code.bytes);
+	place(SEC_RODATA, rodata);
+	headers[SEC_BSS].offset = file.size();
+	headers[SEC_BSS].size = bssSize;
+	place(SEC_NOTE, std::vector<uint8_t>());
+	place(SEC_SYMTAB, symtab.bytes);
+	place(SEC_STRTAB, strtab.bytes);
+	place(SEC_RELA, rela.bytes);
+	place(SEC_SHSTRTAB, shstrtab.bytes);
+	file.align(8);
+	uint64_t shoff = file.size();
+	for (const ElfSectionHeader& h : headers){
+		file.u32(h.name);
+		file.u32(h.type);
+		file.u64(h.flags);
+		file.u64(0);
+		file.u64(h.offset);
+		file.u64(h.size);
+		file.u32(h.link);
+		file.u32(h.info);
+		file.u64(h.align);
+		file.u64(h.entsize);
+	}
+
+	ElfBuffer header;
+	//The magic number, then 64-bit, little-endian, version 1 and
+	// the System V ABI
+	const uint8_t ident[8] = { 0x7F, 'E', 'L', 'F', 2, 1, 1, 0 };
+	for (uint8_t b : ident){ header.u8(b); }
+	header.u64(0);
+	header.u16(1); //ET_REL
+	header.u16(62); //EM_X86_64
+	header.u32(1);
+	header.u64(0); //No entry point
+	header.u64(0); //No program headers
+	header.u64(shoff);
+	header.u32(0);
+	header.u16(64);
+	header.u16(0);
+	header.u16(0);
+	header.u16(64);
+	header.u16(NUM_SECTIONS);
+	header.u16(SEC_SHSTRTAB);
+	std::copy(header.bytes.begin(), header.bytes.end(), file.bytes.begin());
+
+	out.write(reinterpret_cast<const char *>(file.bytes.data()),
+		static_cast<std::streamsize>(file.size()));
+}
+
+}
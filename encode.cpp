@@ -0,0 +1,307 @@
+#include "x86.hpp"
+
+namespace lake{
+
+//Encodes one function's instructions. Jumps start out short and
+// are widened until every one of them reaches its label.
+class X86Encoder{
+public:
+	X86Encoder(const X86Symbol& symIn, X86Code& codeIn)
+	: sym(symIn), code(codeIn){ }
+	void encodeFunction();
+private:
+	void byte(uint8_t b){ code.bytes.push_back(b); }
+	void imm32(int64_t v){
+		uint32_t u = static_cast<uint32_t>(v);
+		for (int i = 0; i < 4; i++){
+			byte(static_cast<uint8_t>(u >> (8 * i)));
+		}
+	}
+	void imm64(int64_t v){
+		uint64_t u = static_cast<uint64_t>(v);
+		for (int i = 0; i < 8; i++){
+			byte(static_cast<uint8_t>(u >> (8 * i)));
+		}
+	}
+	//A REX prefix, with W set for 64-bit operands. Byte registers
+	// sil and dil (and up) need one even when it is otherwise empty.
+	void rex(bool w, uint8_t reg, const X86Operand& rm, bool force = false);
+	//The ModRM byte (and SIB and displacement) addressing rm, with
+	// reg (a register or an opcode extension) in the middle field.
+	// immBytes is how many immediate bytes follow, which moves the
+	// end of the instruction that rip-relative addresses count
+	// from.
+	void modrm(uint8_t reg, const X86Operand& rm, int immBytes);
+	//A 64-bit instruction with opcode bytes op and a ModRM operand
+	void rmInstr(std::initializer_list<uint8_t> op, uint8_t reg,
+		const X86Operand& rm, int immBytes = 0);
+	//add, sub, xor or cmp, whose opcodes all follow one pattern
+	void aluInstr(uint8_t base, uint8_t ext, const X86Instr& instr);
+	void encode(const X86Instr& instr, size_t index);
+
+	const X86Symbol& sym;
+	X86Code& code;
+	std::vector<size_t> labelAt;
+	//Whether each instruction (a jump) needs a 32-bit displacement
+	std::vector<bool> wide;
+	std::vector<size_t> instrAt;
+};
+
+void X86Encoder::rex(bool w, uint8_t reg, const X86Operand& rm, bool force){
+	uint8_t prefix = 0x40;
+	if (w){ prefix |= 0x08; }
+	if (reg & 8){ prefix |= 0x04; }
+	if ((rm.isReg() || rm.kind() == X86Operand::MEM)
+		&& (rm.getReg() & 8)){
+		prefix |= 0x01;
+	}
+	if (prefix != 0x40 || force){ byte(prefix); }
+}
+
+void X86Encoder::modrm(uint8_t reg, const X86Operand& rm, int immBytes){
+	uint8_t mid = static_cast<uint8_t>((reg & 7) << 3);
+	if (rm.isReg()){
+		byte(static_cast<uint8_t>(0xC0 | mid | (rm.getReg() & 7)));
+		return;
+	}
+	if (rm.kind() == X86Operand::SYM){
+		byte(static_cast<uint8_t>(0x05 | mid));
+		code.relocs.push_back({code.bytes.size(), rm.getSym(),
+			-4 - immBytes, false});
+		imm32(0);
+		return;
+	}
+	uint8_t base = rm.getReg() & 7;
+	int32_t disp = rm.getDisp();
+	//rbp and r13 can't be addressed without a displacement
+	uint8_t mod = disp == 0 && base != 5 ? 0x00
+		: disp >= -128 && disp <= 127 ? 0x40 : 0x80;
+	byte(static_cast<uint8_t>(mod | mid | base));
+	//rsp and r12 as a base take a SIB byte
+	if (base == 4){ byte(0x24); }
+	if (mod == 0x40){
+		byte(static_cast<uint8_t>(disp));
+	} else if (mod == 0x80){
+		imm32(disp);
+	}
+}
+
+void X86Encoder::rmInstr(std::initializer_list<uint8_t> op, uint8_t reg,
+	const X86Operand& rm, int immBytes){
+	rex(true, reg, rm);
+	for (uint8_t b : op){ byte(b); }
+	modrm(reg, rm, immBytes);
+}
+
+void X86Encoder::aluInstr(uint8_t base, uint8_t ext, const X86Instr& instr){
+	const X86Operand& dst = instr.dst;
+	const X86Operand& src = instr.src;
+	if (src.isImm()){
+		if (!src.isImm32()){
+			throw new InternalError("Immediate too wide to encode");
+		}
+		bool small = src.getImm() >= -128 && src.getImm() <= 127;
+		//rax has a shorter form of its own for wide immediates
+		if (!small && dst.isReg() && dst.getReg() == RAX){
+			byte(0x48);
+			byte(static_cast<uint8_t>(base + 5));
+			imm32(src.getImm());
+			return;
+		}
+		rmInstr({static_cast<uint8_t>(small ? 0x83 : 0x81)}, ext, dst,
+			small ? 1 : 4);
+		if (small){
+			byte(static_cast<uint8_t>(src.getImm()));
+		} else {
+			imm32(src.getImm());
+		}
+	} else if (src.isReg()){
+		rmInstr({static_cast<uint8_t>(base + 1)}, src.getReg(), dst);
+	} else if (dst.isReg()){
+		rmInstr({static_cast<uint8_t>(base + 3)}, dst.getReg(), src);
+	} else {
+		throw new InternalError("Two memory operands");
+	}
+}
+
+void X86Encoder::encode(const X86Instr& instr, size_t index){
+	const X86Operand& dst = instr.dst;
+	const X86Operand& src = instr.src;
+	switch (instr.op){
+	case X86Instr::LABEL:
+		labelAt[instr.target] = code.bytes.size();
+		return;
+	case X86Instr::MOV:
+		if (src.isImm()){
+			if (src.isImm32()){
+				rmInstr({0xC7}, 0, dst, 4);
+				imm32(src.getImm());
+			} else if (dst.isReg()){
+				rex(true, 0, dst);
+				byte(static_cast<uint8_t>(0xB8 | (dst.getReg() & 7)));
+				imm64(src.getImm());
+			} else {
+				throw new InternalError("Immediate too wide to encode");
+			}
+		} else if (src.isReg()){
+			rmInstr({0x89}, src.getReg(), dst);
+		} else if (dst.isReg()){
+			rmInstr({0x8B}, dst.getReg(), src);
+		} else {
+			throw new InternalError("Two memory operands");
+		}
+		return;
+	case X86Instr::LEA:
+		rmInstr({0x8D}, dst.getReg(), src);
+		return;
+	case X86Instr::ADD: aluInstr(0x00, 0, instr); return;
+	case X86Instr::SUB: aluInstr(0x28, 5, instr); return;
+	case X86Instr::XOR: aluInstr(0x30, 6, instr); return;
+	case X86Instr::CMP: aluInstr(0x38, 7, instr); return;
+	case X86Instr::IMUL:
+		rmInstr({0x0F, 0xAF}, dst.getReg(), src);
+		return;
+	case X86Instr::TEST:
+		rmInstr({0x85}, src.getReg(), dst);
+		return;
+	case X86Instr::NEG:
+		rmInstr({0xF7}, 3, dst);
+		return;
+	case X86Instr::CQO:
+		byte(0x48);
+		byte(0x99);
+		return;
+	case X86Instr::IDIV:
+		rmInstr({0xF7}, 7, src);
+		return;
+	case X86Instr::SETCC:
+		rex(false, 0, dst, dst.getReg() >= RSP);
+		byte(0x0F);
+		byte(static_cast<uint8_t>(0x90 | instr.cond));
+		modrm(0, dst, 0);
+		rmInstr({0x0F, 0xB6}, dst.getReg(), dst);
+		return;
+	case X86Instr::JMP: case X86Instr::JCC:
+		//The displacement is filled in once the labels settle
+		if (!wide[index]){
+			byte(instr.op == X86Instr::JMP ? 0xEB
+				: static_cast<uint8_t>(0x70 | instr.cond));
+			byte(0);
+		} else {
+			if (instr.op == X86Instr::JMP){
+				byte(0xE9);
+			} else {
+				byte(0x0F);
+				byte(static_cast<uint8_t>(0x80 | instr.cond));
+			}
+			imm32(0);
+		}
+		return;
+	case X86Instr::CALL: case X86Instr::TAILJMP:
+		byte(instr.op == X86Instr::CALL ? 0xE8 : 0xE9);
+		code.relocs.push_back({code.bytes.size(), instr.target, -4, true});
+		imm32(0);
+		return;
+	case X86Instr::PUSH:
+		if (src.isReg()){
+			rex(false, 0, src);
+			byte(static_cast<uint8_t>(0x50 | (src.getReg() & 7)));
+		} else if (src.isImm() && src.getImm() >= -128
+			&& src.getImm() <= 127){
+			byte(0x6A);
+			byte(static_cast<uint8_t>(src.getImm()));
+		} else if (src.isImm()){
+			byte(0x68);
+			imm32(src.getImm());
+		} else {
+			rex(false, 6, src);
+			byte(0xFF);
+			modrm(6, src, 0);
+		}
+		return;
+	case X86Instr::POP:
+		rex(false, 0, dst);
+		byte(static_cast<uint8_t>(0x58 | (dst.getReg() & 7)));
+		return;
+	case X86Instr::RET:
+		byte(0xC3);
+		return;
+	}
+}
+
+void X86Encoder::encodeFunction(){
+	size_t start = code.bytes.size();
+	size_t numRelocs = code.relocs.size();
+	labelAt.assign(sym.numLabels, start);
+	wide.assign(sym.code.size(), false);
+	instrAt.assign(sym.code.size() + 1, 0);
+	//Widening a jump only moves labels further apart, so this
+	// settles after a few passes, at worst one per jump
+	bool changed = true;
+	while (changed){
+		code.bytes.resize(start);
+		code.relocs.resize(numRelocs);
+		for (size_t i = 0; i < sym.code.size(); i++){
+			instrAt[i] = code.bytes.size();
+			encode(sym.code[i], i);
+		}
+		instrAt[sym.code.size()] = code.bytes.size();
+		changed = false;
+		for (size_t i = 0; i < sym.code.size(); i++){
+			const X86Instr& instr = sym.code[i];
+			bool isJump = instr.op == X86Instr::JMP
+				|| instr.op == X86Instr::JCC;
+			if (!isJump || wide[i]){ continue; }
+			int64_t disp = static_cast<int64_t>(labelAt[instr.target])
+				- static_cast<int64_t>(instrAt[i + 1]);
+			if (disp < -128 || disp > 127){
+				wide[i] = true;
+				changed = true;
+			}
+		}
+	}
+	for (size_t i = 0; i < sym.code.size(); i++){
+		const X86Instr& instr = sym.code[i];
+		bool isJump = instr.op == X86Instr::JMP
+			|| instr.op == X86Instr::JCC;
+		if (!isJump){ continue; }
+		int64_t disp = static_cast<int64_t>(labelAt[instr.target])
+			- static_cast<int64_t>(instrAt[i + 1]);
+		uint32_t u = static_cast<uint32_t>(disp);
+		size_t width = wide[i] ? 4 : 1;
+		for (size_t b = 0; b < width; b++){
+			code.bytes[instrAt[i + 1] - width + b] =
+				static_cast<uint8_t>(u >> (8 * b));
+		}
+	}
+}
+
+X86Code X86Module::encode() const {
+	X86Code res;
+	res.offsets.assign(symbols.size(), 0);
+	for (uint32_t i = 0; i < symbols.size(); i++){
+		const X86Symbol& sym = symbols[i];
+		if (sym.kind != X86Symbol::TEXT){ continue; }
+		res.offsets[i] = res.bytes.size();
+		X86Encoder encoder(sym, res);
+		encoder.encodeFunction();
+	}
+	//Calls between the module's own functions need no linker
+	size_t kept = 0;
+	for (const X86Code::Reloc& reloc : res.relocs){
+		if (symbols[reloc.symbol].kind != X86Symbol::TEXT){
+			res.relocs[kept++] = reloc;
+			continue;
+		}
+		int64_t disp = static_cast<int64_t>(res.offsets[reloc.symbol])
+			+ reloc.addend - static_cast<int64_t>(reloc.offset);
+		uint32_t u = static_cast<uint32_t>(disp);
+		for (size_t b = 0; b < 4; b++){
+			res.bytes[reloc.offset + b] = static_cast<uint8_t>(u >> (8 * b));
+		}
+	}
+	res.relocs.resize(kept);
+	return res;
+}
+
+}
@@ -36,6 +36,16 @@ private:
 	std::string msg;
 };
 
+//Something that stops a Lake program that lakec is running
+// itself, such as division by zero
+class RuntimeError{
+public:
+	RuntimeError(const char * msgIn){ msg = msgIn; }
+	std::string what(){ return msg; }
+private:
+	std::string msg;
+};
+
 class UnsupportedError{ };
 
 class ToDoError{
@@ -0,0 +1,395 @@
+#include "eval.hpp"
+#include "ir.hpp"
+#include "vm.hpp"
+#include "walker.hpp"
+
+namespace lake{
+
+//How deep Lake calls may nest before the C++ stack would run out
+static const size_t MAX_DEPTH = 1 << 14;
+static const size_t STACK_WORDS = 1 << 20;
+
+static int64_t wrap(uint64_t v){ return static_cast<int64_t>(v); }
+static uint64_t bits(int64_t v){ return static_cast<uint64_t>(v); }
+
+namespace {
+//Gives every variable its slot and finds each function's body.
+// Statements are skipped: the declarations in if and while bodies
+// are ignored, as they are by name analysis and lowering.
+class SlotAssigner : public ASTVisitor{
+public:
+	SlotAssigner(Evaluator * evIn) : ev(evIn), fn(nullptr){ }
+	bool pre(ASTNode * node, int ctx) override{
+		if (dynamic_cast<StmtListNode *>(node) != nullptr
+			|| dynamic_cast<TypeNode *>(node) != nullptr){
+			return false;
+		}
+		if (FnDeclNode * decl = dynamic_cast<FnDeclNode *>(node)){
+			SemSymbol * fnSym = decl->getDeclaredID()->getSymbol();
+			if (fnSym == nullptr){
+				throw new InternalError("Running an unchecked function");
+			}
+			fn = &ev->fns[fnSym];
+			*fn = {nullptr, 0, 0};
+			if (fnSym->getName() == "main"){ ev->mainFn = fnSym; }
+		} else if (FnBodyNode * body = dynamic_cast<FnBodyNode *>(node)){
+			fn->body = body;
+		} else if (DeclNode * decl = dynamic_cast<DeclNode *>(node)){
+			SemSymbol * sym = decl->getDeclaredID()->getSymbol();
+			if (sym == nullptr){
+				throw new InternalError("Running an unchecked declaration");
+			}
+			if (fn == nullptr){
+				ev->slots[sym] = {true, ev->memory.size()};
+				ev->memory.push_back(0);
+			} else {
+				ev->slots[sym] = {false, fn->frameSize++};
+				if (dynamic_cast<FormalDeclNode *>(decl) != nullptr){
+					fn->numParams++;
+				}
+			}
+			return false;
+		}
+		return true;
+	}
+	void post(ASTNode * node, int ctx) override{
+		if (dynamic_cast<FnDeclNode *>(node) != nullptr){
+			fn = nullptr;
+		}
+	}
+private:
+	Evaluator * ev;
+	Evaluator::FnInfo * fn;
+};
+}
+
+Evaluator::Evaluator(ProgramNode * root, TypeAnalysis * taIn)
+: returning(false), retVal(0), mainFn(nullptr), memory(1, 0), ta(taIn),
+  stack(STACK_WORDS, 0), base(0), top(0), depth(0),
+  maxDepth(MAX_DEPTH), stepsLeft(SIZE_MAX){
+	SlotAssigner assigner(this);
+	walk(root, assigner);
+}
+
+int64_t Evaluator::run(){
+	if (mainFn == nullptr){
+		throw new InternalError("No main function to run");
+	}
+	ExpListNode noArgs(new std::list<ExpNode *>());
+	return call(mainFn, &noArgs);
+}
+
+int64_t * Evaluator::location(SemSymbol * sym){
+	auto found = slots.find(sym);
+	if (found == slots.end()){
+		throw new InternalError("Running an unresolved name");
+	}
+	const Slot& slot = found->second;
+	if (slot.global){
+		return &memory[slot.index];
+	}
+	return &stack[base + slot.index];
+}
+
+int64_t * Evaluator::memoryAt(int64_t ptr){
+	if (ptr <= 0 || static_cast<uint64_t>(ptr) >= memory.size()){
+		throw new RuntimeError(ptr == 0 ? "Null pointer dereference"
+			: "Bad pointer dereference");
+	}
+	return &memory[static_cast<size_t>(ptr)];
+}
+
+void Evaluator::push(int64_t val){
+	if (top == stack.size()){
+		throw new RuntimeError("Stack overflow");
+	}
+	stack[top++] = val;
+}
+
+const Evaluator::FnInfo& Evaluator::info(SemSymbol * fnSym){
+	auto found = fns.find(fnSym);
+	if (found == fns.end()){
+		throw new InternalError("Call to an unknown function");
+	}
+	return found->second;
+}
+
+//The arguments are pushed as they are evaluated, so they are
+// already in place as the first words of the callee's frame
+int64_t Evaluator::call(SemSymbol * fnSym, ExpListNode * args){
+	const FnInfo& fn = info(fnSym);
+	size_t frame = top;
+	for (ExpNode * arg : *args->getList()){
+		push(arg->eval(this));
+	}
+	return enter(fn, frame);
+}
+
+int64_t Evaluator::enter(const FnInfo& fn, size_t frame){
+	for (size_t i = fn.numParams; i < fn.frameSize; i++){
+		push(0);
+	}
+	if (++depth > maxDepth){
+		throw new RuntimeError("Stack overflow");
+	}
+	step();
+	size_t callerBase = base;
+	base = frame;
+	fn.body->exec(this);
+	int64_t res = returning ? retVal : 0;
+	returning = false;
+	retVal = 0;
+	base = callerBase;
+	top = frame;
+	depth--;
+	return res;
+}
+
+//A call that stops partway leaves the stack as it was then, so
+// it is put back as it was before
+int64_t Evaluator::callBounded(SemSymbol * fnSym,
+	const std::vector<int64_t>& args, size_t& steps, size_t maxDepthIn){
+	const FnInfo& fn = info(fnSym);
+	size_t oldBase = base;
+	size_t oldTop = top;
+	size_t oldDepth = depth;
+	size_t oldMaxDepth = maxDepth;
+	stepsLeft = steps;
+	maxDepth = depth + maxDepthIn;
+	int64_t res = 0;
+	try {
+		for (int64_t arg : args){
+			push(arg);
+		}
+		res = enter(fn, oldTop);
+	} catch (RuntimeError * e){
+		base = oldBase;
+		top = oldTop;
+		depth = oldDepth;
+		maxDepth = oldMaxDepth;
+		steps = stepsLeft;
+		stepsLeft = SIZE_MAX;
+		returning = false;
+		retVal = 0;
+		throw;
+	}
+	maxDepth = oldMaxDepth;
+	steps = stepsLeft;
+	stepsLeft = SIZE_MAX;
+	return res;
+}
+
+int64_t Evaluator::internString(const std::string& str){
+	auto found = stringIds.find(str);
+	if (found != stringIds.end()){ return found->second; }
+	int64_t id = static_cast<int64_t>(strings.size());
+	strings.push_back(str);
+	stringIds[str] = id;
+	return id;
+}
+
+int64_t * ExpNode::evalLoc(Evaluator * ev){
+	throw new InternalError("Storing to an expression with no location");
+}
+
+int64_t DerefNode::eval(Evaluator * ev){
+	return *evalLoc(ev);
+}
+
+int64_t * DerefNode::evalLoc(Evaluator * ev){
+	return ev->memoryAt(myTgt->eval(ev));
+}
+
+int64_t IdNode::eval(Evaluator * ev){
+	return *ev->location(mySymbol);
+}
+
+int64_t * IdNode::evalLoc(Evaluator * ev){
+	return ev->location(mySymbol);
+}
+
+int64_t IntLitNode::eval(Evaluator * ev){
+	return myInt;
+}
+
+int64_t StrLitNode::eval(Evaluator * ev){
+	return ev->internString(unescape(myString));
+}
+
+int64_t TrueNode::eval(Evaluator * ev){
+	return 1;
+}
+
+int64_t FalseNode::eval(Evaluator * ev){
+	return 0;
+}
+
+int64_t AssignNode::eval(Evaluator * ev){
+	int64_t * loc = myTgt->evalLoc(ev);
+	int64_t val = mySrc->eval(ev);
+	*loc = val;
+	return val;
+}
+
+int64_t CallExpNode::eval(Evaluator * ev){
+	if (myFolded){ return myFoldedVal; }
+	return ev->call(myId->getSymbol(), myExpList);
+}
+
+int64_t UnaryMinusNode::eval(Evaluator * ev){
+	return wrap(0 - bits(myExp->eval(ev)));
+}
+
+int64_t NotNode::eval(Evaluator * ev){
+	return myExp->eval(ev) == 0;
+}
+
+int64_t PlusNode::eval(Evaluator * ev){
+	uint64_t res = bits(myExps[0]->eval(ev));
+	for (size_t i = 1; i < myExps.size(); i++){
+		res += bits(myExps[i]->eval(ev));
+	}
+	return wrap(res);
+}
+
+int64_t MinusNode::eval(Evaluator * ev){
+	uint64_t lhs = bits(myExp1->eval(ev));
+	return wrap(lhs - bits(myExp2->eval(ev)));
+}
+
+int64_t TimesNode::eval(Evaluator * ev){
+	uint64_t res = bits(myExps[0]->eval(ev));
+	for (size_t i = 1; i < myExps.size(); i++){
+		res *= bits(myExps[i]->eval(ev));
+	}
+	return wrap(res);
+}
+
+int64_t DivideNode::eval(Evaluator * ev){
+	int64_t lhs = myExp1->eval(ev);
+	return interpDivide(lhs, myExp2->eval(ev));
+}
+
+//The operands after the first false (or true) one are not
+// evaluated
+int64_t AndNode::eval(Evaluator * ev){
+	for (ExpNode * exp : myExps){
+		if (exp->eval(ev) == 0){ return 0; }
+	}
+	return 1;
+}
+
+int64_t OrNode::eval(Evaluator * ev){
+	for (ExpNode * exp : myExps){
+		if (exp->eval(ev) != 0){ return 1; }
+	}
+	return 0;
+}
+
+int64_t EqualsNode::eval(Evaluator * ev){
+	int64_t lhs = myExp1->eval(ev);
+	return lhs == myExp2->eval(ev);
+}
+
+int64_t NotEqualsNode::eval(Evaluator * ev){
+	int64_t lhs = myExp1->eval(ev);
+	return lhs != myExp2->eval(ev);
+}
+
+int64_t LessNode::eval(Evaluator * ev){
+	int64_t lhs = myExp1->eval(ev);
+	return lhs < myExp2->eval(ev);
+}
+
+int64_t GreaterNode::eval(Evaluator * ev){
+	int64_t lhs = myExp1->eval(ev);
+	return lhs > myExp2->eval(ev);
+}
+
+int64_t LessEqNode::eval(Evaluator * ev){
+	int64_t lhs = myExp1->eval(ev);
+	return lhs <= myExp2->eval(ev);
+}
+
+int64_t GreaterEqNode::eval(Evaluator * ev){
+	int64_t lhs = myExp1->eval(ev);
+	return lhs >= myExp2->eval(ev);
+}
+
+void StmtListNode::exec(Evaluator * ev){
+	for (StmtNode * stmt : *myStmts){
+		stmt->exec(ev);
+		if (ev->returning){ return; }
+	}
+}
+
+void FnBodyNode::exec(Evaluator * ev){
+	myStmtList->exec(ev);
+}
+
+void AssignStmtNode::exec(Evaluator * ev){
+	myAssign->eval(ev);
+}
+
+void PostIncStmtNode::exec(Evaluator * ev){
+	int64_t * loc = myExp->evalLoc(ev);
+	*loc = wrap(bits(*loc) + 1);
+}
+
+void PostDecStmtNode::exec(Evaluator * ev){
+	int64_t * loc = myExp->evalLoc(ev);
+	*loc = wrap(bits(*loc) - 1);
+}
+
+void ReadStmtNode::exec(Evaluator * ev){
+	int64_t * loc = myExp->evalLoc(ev);
+	bool isBool = ev->types()->nodeType(myExp)->isBool();
+	*loc = isBool ? interpReadBool() : interpReadInt();
+}
+
+void WriteStmtNode::exec(Evaluator * ev){
+	int64_t val = myExp->eval(ev);
+	const DataType * type = ev->types()->nodeType(myExp);
+	const VarType * varType = type->asVar();
+	if (type->isBool()){
+		interpWriteBool(val);
+	} else if (varType != nullptr && !varType->isPtr()
+		&& varType->getBaseType() == BaseType::STR){
+		interpWriteStr(ev->string(val));
+	} else {
+		interpWriteInt(val);
+	}
+}
+
+void IfStmtNode::exec(Evaluator * ev){
+	if (myExp->eval(ev) != 0){
+		myStmts->exec(ev);
+	}
+}
+
+void IfElseStmtNode::exec(Evaluator * ev){
+	if (myExp->eval(ev) != 0){
+		myStmtsT->exec(ev);
+	} else {
+		myStmtsF->exec(ev);
+	}
+}
+
+void WhileStmtNode::exec(Evaluator * ev){
+	while (myExp->eval(ev) != 0){
+		ev->step();
+		myStmts->exec(ev);
+		if (ev->returning){ return; }
+	}
+}
+
+void CallStmtNode::exec(Evaluator * ev){
+	myCallExp->eval(ev);
+}
+
+void ReturnStmtNode::exec(Evaluator * ev){
+	ev->retVal = myExp == nullptr ? 0 : myExp->eval(ev);
+	ev->returning = true;
+}
+
+}
@@ -0,0 +1,92 @@
+#ifndef LAKE_EVAL_HPP
+#define LAKE_EVAL_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ast.hpp"
+#include "symbol_table.hpp"
+#include "types.hpp"
+
+namespace lake{
+
+//Runs a type-checked program straight off the AST, with each
+// node evaluating its children itself. Unlike the passes, this
+// recurses on the C++ stack (once per nested expression and per
+// Lake call), so it is only meant as a simple baseline to measure
+// the bytecode VM against; runBytecode is what lakec --run uses.
+class Evaluator{
+public:
+	Evaluator(ProgramNode * root, TypeAnalysis * taIn);
+	TypeAnalysis * types(){ return ta; }
+	//Run main, and return what it returns (0 when it is void)
+	int64_t run();
+
+	//Where a variable's value is kept, in the current frame for
+	// locals. Locations stay put until their frame is popped.
+	int64_t * location(SemSymbol * sym);
+	//The memory word a pointer points at
+	int64_t * memoryAt(int64_t ptr);
+	int64_t call(SemSymbol * fnSym, ExpListNode * args);
+	//Call a function on argument values, giving up with a
+	// RuntimeError once it has taken more than steps calls and
+	// loop iterations in all, or nests calls more than maxDepth
+	// deep. steps is left holding what the call did not use. The
+	// evaluator can be used again afterwards either way.
+	int64_t callBounded(SemSymbol * fnSym,
+		const std::vector<int64_t>& args, size_t& steps,
+		size_t maxDepth);
+	//Count a call or loop iteration against the budget
+	void step(){
+		if (stepsLeft == 0){
+			throw new RuntimeError("Out of steps");
+		}
+		stepsLeft--;
+	}
+	int64_t internString(const std::string& str);
+	const std::string& string(int64_t id){
+		return strings[static_cast<size_t>(id)];
+	}
+
+	//Set by a return statement, until the call finishes. Every
+	// enclosing statement stops early while it is set.
+	bool returning;
+	int64_t retVal;
+
+	//Where each variable lives: a memory word for globals, or
+	// a word of its function's frame
+	struct Slot{
+		bool global;
+		size_t index;
+	};
+	struct FnInfo{
+		FnBodyNode * body;
+		size_t numParams;
+		size_t frameSize;
+	};
+	HashMap<SemSymbol *, Slot> slots;
+	HashMap<SemSymbol *, FnInfo> fns;
+	SemSymbol * mainFn;
+	//Word 0 is left unused, so that 0 is the null pointer
+	std::vector<int64_t> memory;
+private:
+	void push(int64_t val);
+	const FnInfo& info(SemSymbol * fnSym);
+	//Run a function whose frame starts at frame, where its
+	// arguments already are
+	int64_t enter(const FnInfo& fn, size_t frame);
+
+	TypeAnalysis * ta;
+	std::vector<int64_t> stack;
+	size_t base;
+	size_t top;
+	size_t depth;
+	size_t maxDepth;
+	size_t stepsLeft;
+	std::vector<std::string> strings;
+	HashMap<std::string, int64_t> stringIds;
+};
+
+}
+
+#endif
@@ -0,0 +1,343 @@
+#include <map>
+#include "opt.hpp"
+#include "ssa.hpp"
+
+namespace lake{
+
+//How far back from a join to look for stores before giving up on
+// what was loaded above it
+static const size_t MAX_JOIN_WALK = 64;
+
+namespace {
+//Which version of memory each load would read. Versions are
+// handed out from one counter, so a version is never reused: a
+// store gives what it stores to a fresh one, and a call (which
+// may store to anything) starts a fresh epoch, which every global,
+// table and @ without a version of their own since then reads.
+struct MemState{
+	uint32_t epoch;
+	uint32_t pointer;
+	HashMap<uint32_t, uint32_t> globals;
+	HashMap<uint32_t, uint32_t> tables;
+	uint32_t global(uint32_t g) const {
+		auto found = globals.find(g);
+		return found == globals.end() ? epoch : found->second;
+	}
+	uint32_t table(uint32_t t) const {
+		auto found = tables.find(t);
+		return found == tables.end() ? epoch : found->second;
+	}
+};
+
+//Numbers values down the dominator tree. A value is its operator
+// and the values of its operands (and, for loads, the version of
+// memory they read), and an instruction that computes a value
+// already computed by an instruction that dominates it becomes a
+// copy of that one's result.
+class GVN{
+public:
+	GVN(IRFunction * fnIn, const std::vector<bool>& pointedAtIn)
+	: fn(fnIn), pointedAt(pointedAtIn), dom(fnIn),
+	  leaders(fnIn->numRegs()), ends(fnIn->blocks.size()),
+	  clobbers(fnIn->blocks.size(), false), versions(0),
+	  replaced(0), loadsReplaced(0){
+		for (Reg r = 0; r < fn->numRegs(); r++){
+			leaders[r] = Operand::reg(r);
+		}
+		for (IRBlock * block : fn->blocks){
+			for (IRInstr * instr = block->first; instr != nullptr;
+				instr = instr->next){
+				if (writesMemory(instr)){ clobbers[block->id] = true; }
+			}
+		}
+		for (uint32_t g = 0; g < pointedAt.size(); g++){
+			if (pointedAt[g]){ reachable.push_back(g); }
+		}
+	}
+	void run();
+	size_t numReplaced() const { return replaced; }
+	size_t numLoadsReplaced() const { return loadsReplaced; }
+private:
+	typedef std::vector<int64_t> Key;
+	static bool writesMemory(const IRInstr * instr){
+		return instr->op == IRInstr::STOREG
+			|| instr->op == IRInstr::STORE
+			|| instr->op == IRInstr::STORET
+			|| instr->op == IRInstr::CALL;
+	}
+	Operand leader(Operand op) const {
+		return op.isReg() ? leaders[op.getReg()] : op;
+	}
+	static void addOperand(Key& key, Operand op){
+		key.push_back(op.kind());
+		key.push_back(op.isReg() ? op.getReg() : op.getImm());
+	}
+	//Registers go before constants, and lower numbers first
+	static bool before(Operand x, Operand y){
+		if (x.kind() != y.kind()){ return x.isReg(); }
+		return x.isReg() ? x.getReg() < y.getReg()
+			: x.getImm() < y.getImm();
+	}
+	MemState entryState(IRBlock * block);
+	Key keyOf(IRInstr * instr, const MemState& mem) const;
+	void update(IRInstr * instr, MemState& mem);
+	void visit(IRBlock * block, MemState& mem,
+		std::vector<Key>& added);
+	uint32_t newVersion(){ return ++versions; }
+
+	IRFunction * fn;
+	const std::vector<bool>& pointedAt;
+	DomTree dom;
+	//The value each register holds: the first register that
+	// computed it, or a constant
+	std::vector<Operand> leaders;
+	//Memory as each block leaves it
+	std::vector<MemState> ends;
+	//Whether each block has a store or a call
+	std::vector<bool> clobbers;
+	//The globals that @ may reach
+	std::vector<uint32_t> reachable;
+	std::map<Key, Operand> values;
+	uint32_t versions;
+	size_t replaced;
+	size_t loadsReplaced;
+};
+}
+
+//A block reached from one place sees memory as that block left
+// it. A join only does if nothing on the way from its immediate
+// dominator can store, and otherwise starts a fresh epoch.
+MemState GVN::entryState(IRBlock * block){
+	IRBlock * idom = dom.idom(block);
+	MemState fresh;
+	fresh.epoch = newVersion();
+	fresh.pointer = fresh.epoch;
+	if (idom == nullptr){ return fresh; }
+	if (block->preds.size() == 1){ return ends[idom->id]; }
+	std::vector<bool> seen(fn->blocks.size(), false);
+	std::vector<IRBlock *> work;
+	size_t walked = 0;
+	for (IRBlock * pred : block->preds){
+		if (!seen[pred->id]){
+			seen[pred->id] = true;
+			work.push_back(pred);
+		}
+	}
+	while (!work.empty()){
+		IRBlock * cur = work.back();
+		work.pop_back();
+		if (cur == idom){ continue; }
+		if (clobbers[cur->id] || ++walked > MAX_JOIN_WALK){
+			return fresh;
+		}
+		for (IRBlock * pred : cur->preds){
+			if (!seen[pred->id]){
+				seen[pred->id] = true;
+				work.push_back(pred);
+			}
+		}
+	}
+	return ends[idom->id];
+}
+
+//The value an instruction computes, or an empty key if it is
+// not one that can be looked up
+GVN::Key GVN::keyOf(IRInstr * instr, const MemState& mem) const {
+	Key key;
+	IRInstr::Op op = instr->op;
+	Operand a = leader(instr->a);
+	Operand b = leader(instr->b);
+	switch (op){
+	case IRInstr::ADD: case IRInstr::MUL:
+	case IRInstr::EQ: case IRInstr::NE:
+		if (before(b, a)){ std::swap(a, b); }
+		break;
+	//a > b is b < a, and a >= b is b <= a
+	case IRInstr::GT:
+		op = IRInstr::LT;
+		std::swap(a, b);
+		break;
+	case IRInstr::GE:
+		op = IRInstr::LE;
+		std::swap(a, b);
+		break;
+	case IRInstr::SUB: case IRInstr::DIV: case IRInstr::LT:
+	case IRInstr::LE: case IRInstr::NEG: case IRInstr::NOT:
+		break;
+	case IRInstr::LOADG:
+		key.push_back(mem.global(instr->index));
+		break;
+	case IRInstr::LOAD:
+		key.push_back(mem.pointer);
+		break;
+	case IRInstr::LOADT:
+		key.push_back(mem.table(instr->index));
+		break;
+	//Phis are only the same if they are in the same block
+	case IRInstr::PHI:
+		key.push_back(instr->block->id);
+		for (uint32_t i = 0; i < instr->numArgs; i++){
+			key.push_back(instr->blocks[i]->id);
+			addOperand(key, leader(instr->args[i]));
+		}
+		break;
+	default:
+		return key;
+	}
+	key.push_back(op);
+	key.push_back(instr->index);
+	addOperand(key, a);
+	addOperand(key, b);
+	return key;
+}
+
+//Give the memory each store writes a fresh version, which loads
+// of the same place then read as the value stored
+void GVN::update(IRInstr * instr, MemState& mem){
+	uint32_t ver = newVersion();
+	Key key;
+	switch (instr->op){
+	case IRInstr::STOREG:
+		mem.globals[instr->index] = ver;
+		if (instr->index < pointedAt.size()
+			&& pointedAt[instr->index]){
+			mem.pointer = ver;
+		}
+		key = {ver, IRInstr::LOADG, instr->index};
+		addOperand(key, Operand());
+		addOperand(key, Operand());
+		values[key] = leader(instr->a);
+		break;
+	case IRInstr::STORE:
+		mem.pointer = ver;
+		for (uint32_t g : reachable){ mem.globals[g] = ver; }
+		key = {ver, IRInstr::LOAD, 0};
+		addOperand(key, leader(instr->a));
+		addOperand(key, Operand());
+		values[key] = leader(instr->b);
+		break;
+	case IRInstr::STORET:
+		mem.tables[instr->index] = ver;
+		key = {ver, IRInstr::LOADT, instr->index};
+		addOperand(key, leader(instr->a));
+		addOperand(key, Operand());
+		values[key] = leader(instr->b);
+		break;
+	case IRInstr::CALL:
+		mem.epoch = ver;
+		mem.pointer = ver;
+		mem.globals.clear();
+		mem.tables.clear();
+		break;
+	default:
+		break;
+	}
+}
+
+void GVN::visit(IRBlock * block, MemState& mem,
+	std::vector<Key>& added){
+	for (IRInstr * instr = block->first; instr != nullptr;
+		instr = instr->next){
+		if (writesMemory(instr)){
+			update(instr, mem);
+			continue;
+		}
+		if (instr->dst == NO_REG){ continue; }
+		if (instr->op == IRInstr::COPY){
+			leaders[instr->dst] = leader(instr->a);
+			continue;
+		}
+		//A phi whose inputs are all the same value (or itself,
+		// around a loop) is that value
+		if (instr->op == IRInstr::PHI){
+			Operand same;
+			bool agree = true;
+			for (uint32_t i = 0; i < instr->numArgs && agree; i++){
+				Operand arg = leader(instr->args[i]);
+				if (arg == Operand::reg(instr->dst)){ continue; }
+				if (same.isNone()){
+					same = arg;
+				} else if (arg != same){
+					agree = false;
+				}
+			}
+			if (agree && !same.isNone()){
+				leaders[instr->dst] = same;
+				replaced++;
+				continue;
+			}
+		}
+		Key key = keyOf(instr, mem);
+		if (key.empty()){ continue; }
+		auto found = values.find(key);
+		if (found == values.end()){
+			values[key] = Operand::reg(instr->dst);
+			added.push_back(key);
+			continue;
+		}
+		if (instr->op == IRInstr::LOADG || instr->op == IRInstr::LOAD
+			|| instr->op == IRInstr::LOADT){
+			loadsReplaced++;
+		} else {
+			replaced++;
+		}
+		leaders[instr->dst] = found->second;
+		//Phis have to stay at the top of the block, so a phi is
+		// left for DCE once nothing reads it
+		if (instr->op != IRInstr::PHI){ instr->makeCopy(found->second); }
+	}
+}
+
+//Values found in a block are forgotten on leaving the part of
+// the dominator tree below it. Store forwarding entries are
+// never looked up again once their version is gone, so they stay.
+void GVN::run(){
+	struct Frame{
+		IRBlock * block;
+		size_t child;
+		std::vector<Key> added;
+	};
+	std::vector<Frame> stack;
+	stack.push_back({fn->blocks[0], 0, {}});
+	MemState mem = entryState(fn->blocks[0]);
+	visit(fn->blocks[0], mem, stack.back().added);
+	ends[0] = mem;
+	while (!stack.empty()){
+		Frame& top = stack.back();
+		const std::vector<IRBlock *>& kids = dom.children(top.block);
+		if (top.child == kids.size()){
+			for (const Key& key : top.added){ values.erase(key); }
+			stack.pop_back();
+			continue;
+		}
+		IRBlock * kid = kids[top.child++];
+		stack.push_back({kid, 0, {}});
+		MemState kidMem = entryState(kid);
+		visit(kid, kidMem, stack.back().added);
+		ends[kid->id] = kidMem;
+	}
+	//Every use reads the value's first register, or its constant
+	for (IRBlock * block : fn->blocks){
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			instr->forEachUse([&](Operand& use){ use = leader(use); });
+		}
+	}
+}
+
+void runGVN(IRFunction * fn, const std::vector<bool>& pointedAt,
+	OptReport& report){
+	if (!fn->ssa){
+		throw new InternalError("GVN needs SSA form");
+	}
+	if (fn->blocks.empty()){ return; }
+	fn->rebuildEdges();
+	GVN gvn(fn, pointedAt);
+	gvn.run();
+	report.add("gvn", "redundant computations replaced",
+		gvn.numReplaced());
+	report.add("gvn", "redundant loads replaced",
+		gvn.numLoadsReplaced());
+}
+
+}
@@ -0,0 +1,297 @@
+#include <algorithm>
+#include "opt.hpp"
+
+namespace lake{
+
+//Callees at most this many instructions long are inlined
+// anywhere, and ones up to the second limit inside loops
+static const size_t INLINE_SIZE = 12;
+static const size_t INLINE_LOOP_SIZE = 40;
+//A caller stops taking in callees once it has grown by this
+// many instructions, or by its own size if that is more
+static const size_t GROWTH_LIMIT = 100;
+
+static size_t numInstrs(const IRFunction * fn){
+	size_t res = 0;
+	for (IRBlock * block : fn->blocks){
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			res++;
+		}
+	}
+	return res;
+}
+
+//How many loops each block is in, taking every backward edge in
+// block order as a loop around the blocks it jumps back over.
+// Edges must be up to date.
+static std::vector<int> loopDepths(IRFunction * fn){
+	size_t numBlocks = fn->blocks.size();
+	std::vector<int> delta(numBlocks + 1, 0);
+	for (IRBlock * block : fn->blocks){
+		for (IRBlock * succ : block->succs){
+			if (succ->id <= block->id){
+				delta[succ->id]++;
+				delta[block->id + 1]--;
+			}
+		}
+	}
+	std::vector<int> res(numBlocks);
+	int depth = 0;
+	for (size_t b = 0; b < numBlocks; b++){
+		depth += delta[b];
+		res[b] = depth;
+	}
+	return res;
+}
+
+//Which functions are part of a cycle of calls (recursive, or
+// mutually recursive), found with Tarjan's algorithm. order is
+// filled with the functions callees first, so that inlining in
+// that order only ever copies callees that are already done.
+// Nothing here recurses on the C++ stack.
+static std::vector<bool> findRecursion(IRProgram * prog,
+	std::vector<uint32_t>& order){
+	size_t n = prog->functions.size();
+	std::vector<std::vector<uint32_t>> callees(n);
+	std::vector<bool> res(n, false);
+	for (uint32_t f = 0; f < n; f++){
+		for (IRBlock * block : prog->functions[f]->blocks){
+			for (IRInstr * instr = block->first; instr != nullptr;
+				instr = instr->next){
+				if (instr->op != IRInstr::CALL){ continue; }
+				callees[f].push_back(instr->index);
+				if (instr->index == f){ res[f] = true; }
+			}
+		}
+	}
+
+	const uint32_t UNSEEN = UINT32_MAX;
+	std::vector<uint32_t> num(n, UNSEEN);
+	std::vector<uint32_t> low(n, 0);
+	std::vector<bool> onStack(n, false);
+	std::vector<uint32_t> stack;
+	//A function being searched, and which of its callees is next
+	std::vector<std::pair<uint32_t, size_t>> work;
+	uint32_t counter = 0;
+	for (uint32_t root = 0; root < n; root++){
+		if (num[root] != UNSEEN){ continue; }
+		work.push_back({root, 0});
+		num[root] = low[root] = counter++;
+		stack.push_back(root);
+		onStack[root] = true;
+		while (!work.empty()){
+			uint32_t f = work.back().first;
+			size_t& next = work.back().second;
+			if (next < callees[f].size()){
+				uint32_t g = callees[f][next++];
+				if (num[g] == UNSEEN){
+					num[g] = low[g] = counter++;
+					stack.push_back(g);
+					onStack[g] = true;
+					work.push_back({g, 0});
+				} else if (onStack[g]){
+					low[f] = std::min(low[f], num[g]);
+				}
+				continue;
+			}
+			work.pop_back();
+			if (!work.empty()){
+				uint32_t parent = work.back().first;
+				low[parent] = std::min(low[parent], low[f]);
+			}
+			if (low[f] != num[f]){ continue; }
+			//f is the root of a component
+			size_t start = stack.size();
+			while (stack[start - 1] != f){ start--; }
+			start--;
+			bool cycle = stack.size() - start > 1;
+			for (size_t i = start; i < stack.size(); i++){
+				onStack[stack[i]] = false;
+				if (cycle){ res[stack[i]] = true; }
+				order.push_back(stack[i]);
+			}
+			stack.resize(start);
+		}
+	}
+	return res;
+}
+
+namespace {
+class Inliner{
+public:
+	Inliner(IRFunction * fnIn) : fn(fnIn){ }
+	//Replace call (which is in fn) with a copy of callee's body
+	void inlineCall(IRInstr * call, const IRFunction * callee);
+private:
+	Reg mapReg(Reg r){
+		if (r == NO_REG){ return NO_REG; }
+		if (regMap[r] == NO_REG){
+			regMap[r] = fn->newReg(calleeNames[r]);
+		}
+		return regMap[r];
+	}
+	Operand mapOperand(Operand op){
+		return op.isReg() ? Operand::reg(mapReg(op.getReg())) : op;
+	}
+	IRInstr * jumpTo(IRBlock * target){
+		IRInstr * jmp = fn->newInstr(IRInstr::JMP);
+		jmp->targets[0] = target;
+		return jmp;
+	}
+
+	IRFunction * fn;
+	std::vector<Reg> regMap;
+	std::vector<std::string> calleeNames;
+};
+}
+
+//The call's block is split in two around it. The copy of the
+// callee goes in between, entered with copies of the arguments
+// into its parameters, and each return becomes a copy into the
+// call's result and a jump to the second half.
+void Inliner::inlineCall(IRInstr * call, const IRFunction * callee){
+	IRBlock * block = call->block;
+	regMap.assign(callee->numRegs(), NO_REG);
+	calleeNames = callee->regNames;
+
+	IRBlock * after = fn->newBlock();
+	while (call->next != nullptr){
+		IRInstr * moved = call->next;
+		block->remove(moved);
+		after->append(moved);
+	}
+
+	std::vector<IRBlock *> copies;
+	HashMap<const IRBlock *, IRBlock *> blockMap;
+	for (IRBlock * calleeBlock : callee->blocks){
+		IRBlock * copy = fn->newBlock();
+		blockMap[calleeBlock] = copy;
+		copies.push_back(copy);
+	}
+	for (size_t i = 0; i < callee->params.size(); i++){
+		IRInstr * param = fn->newInstr(IRInstr::COPY);
+		param->dst = mapReg(callee->params[i]);
+		param->a = call->args[i];
+		block->insertBefore(call, param);
+	}
+	Reg result = call->dst;
+	block->remove(call);
+	block->append(jumpTo(copies[0]));
+
+	for (size_t b = 0; b < callee->blocks.size(); b++){
+		for (IRInstr * instr = callee->blocks[b]->first;
+			instr != nullptr; instr = instr->next){
+			if (instr->op == IRInstr::RET){
+				if (result != NO_REG){
+					IRInstr * copy = fn->newInstr(IRInstr::COPY);
+					copy->dst = result;
+					copy->a = instr->a.isNone() ? Operand::imm(0)
+						: mapOperand(instr->a);
+					copies[b]->append(copy);
+				}
+				copies[b]->append(jumpTo(after));
+				continue;
+			}
+			IRInstr * copy = fn->newInstr(instr->op);
+			copy->dst = mapReg(instr->dst);
+			copy->a = mapOperand(instr->a);
+			copy->b = mapOperand(instr->b);
+			copy->index = instr->index;
+			fn->reserveArgs(copy, instr->numArgs, false);
+			for (uint32_t i = 0; i < instr->numArgs; i++){
+				copy->args[i] = mapOperand(instr->args[i]);
+			}
+			copy->numArgs = instr->numArgs;
+			for (size_t t = 0; t < 2; t++){
+				if (instr->targets[t] != nullptr){
+					copy->targets[t] = blockMap[instr->targets[t]];
+				}
+			}
+			copies[b]->append(copy);
+		}
+		//A block that runs off the end of the callee returns
+		if (copies[b]->terminator() == nullptr){
+			if (result != NO_REG){
+				IRInstr * copy = fn->newInstr(IRInstr::COPY);
+				copy->dst = result;
+				copy->a = Operand::imm(0);
+				copies[b]->append(copy);
+			}
+			copies[b]->append(jumpTo(after));
+		}
+	}
+
+	//Keep the blocks in order: the copies right after the call's
+	// block, then the rest of that block
+	std::vector<IRBlock *> blocks;
+	blocks.reserve(fn->blocks.size() + copies.size() + 1);
+	for (IRBlock * b : fn->blocks){
+		blocks.push_back(b);
+		if (b == block){
+			blocks.insert(blocks.end(), copies.begin(), copies.end());
+			blocks.push_back(after);
+		}
+	}
+	fn->blocks.clear();
+	for (IRBlock * b : blocks){
+		fn->placeBlock(b);
+	}
+}
+
+void inlineCalls(IRProgram * prog, OptReport& report){
+	std::vector<uint32_t> order;
+	std::vector<bool> recursive = findRecursion(prog, order);
+	size_t inlined = 0;
+	size_t added = 0;
+	for (uint32_t f : order){
+		IRFunction * fn = prog->functions[f];
+		if (fn->ssa){
+			throw new InternalError("Inlining needs a function not in SSA form");
+		}
+		fn->rebuildEdges();
+		std::vector<int> depths = loopDepths(fn);
+
+		//The hottest call sites get the budget first, then the
+		// smallest callees
+		struct Site{
+			IRInstr * call;
+			int depth;
+			size_t size;
+		};
+		std::vector<Site> sites;
+		for (IRBlock * block : fn->blocks){
+			for (IRInstr * instr = block->first; instr != nullptr;
+				instr = instr->next){
+				if (instr->op != IRInstr::CALL
+					|| recursive[instr->index]){ continue; }
+				size_t size = numInstrs(prog->functions[instr->index]);
+				int depth = depths[block->id];
+				if (size <= (depth > 0 ? INLINE_LOOP_SIZE : INLINE_SIZE)){
+					sites.push_back({instr, depth, size});
+				}
+			}
+		}
+		std::stable_sort(sites.begin(), sites.end(),
+			[](const Site& x, const Site& y){
+				if (x.depth != y.depth){ return x.depth > y.depth; }
+				return x.size < y.size;
+			});
+
+		size_t budget = std::max(GROWTH_LIMIT, numInstrs(fn));
+		Inliner inliner(fn);
+		for (const Site& site : sites){
+			if (site.size > budget){ continue; }
+			budget -= site.size;
+			inliner.inlineCall(site.call,
+				prog->functions[site.call->index]);
+			inlined++;
+			added += site.size;
+		}
+		fn->rebuildEdges();
+	}
+	report.add("inline", "calls inlined", inlined);
+	report.add("inline", "instructions copied", added);
+}
+
+}
@@ -0,0 +1,468 @@
+#include <cstdlib>
+#include "ir.hpp"
+
+namespace lake{
+
+static const size_t ARENA_CHUNK = 64 * 1024;
+
+Arena::~Arena(){
+	for (auto it = dtors.rbegin(); it != dtors.rend(); ++it){
+		it->second(it->first);
+	}
+	for (char * chunk : chunks){
+		std::free(chunk);
+	}
+}
+
+void * Arena::alloc(size_t size, size_t align){
+	size_t pad = (align - reinterpret_cast<uintptr_t>(cur) % align)
+		% align;
+	if (cur == nullptr || pad + size > left){
+		//Oversized requests get a chunk of their own
+		size_t chunkSize = size + align > ARENA_CHUNK ?
+			size + align : ARENA_CHUNK;
+		cur = static_cast<char *>(std::malloc(chunkSize));
+		if (cur == nullptr){
+			throw new InternalError("Out of memory");
+		}
+		chunks.push_back(cur);
+		left = chunkSize;
+		pad = (align - reinterpret_cast<uintptr_t>(cur) % align)
+			% align;
+	}
+	void * res = cur + pad;
+	cur += pad + size;
+	left -= pad + size;
+	return res;
+}
+
+bool IRInstr::hasSideEffects() const {
+	switch (op){
+	case STOREG: case STORE: case STORET: case CALL:
+	case READ_INT: case READ_BOOL:
+	case WRITE_INT: case WRITE_BOOL: case WRITE_STR:
+	case JMP: case BR: case RET:
+		return true;
+	//Division by zero, or of the smallest int by -1, stops the
+	// program
+	case DIV:
+		if (!b.isImm() || b.getImm() == 0){ return true; }
+		if (b.getImm() != -1){ return false; }
+		return !a.isImm() || a.getImm() == INT64_MIN;
+	default:
+		return false;
+	}
+}
+
+bool IRInstr::isTailCall() const {
+	if (op != CALL){ return false; }
+	const IRInstr * after = next;
+	//Jumps to a block that only returns (as after an if whose
+	// last statement is the call) count as returning
+	for (size_t hops = 0; after != nullptr && after->op == JMP
+		&& hops < block->fn->blocks.size(); hops++){
+		after = after->targets[0]->first;
+	}
+	if (after == nullptr){
+		return dst == NO_REG && !block->fn->returnsValue;
+	}
+	if (after->op != RET){ return false; }
+	if (dst == NO_REG){ return after->a.isNone(); }
+	return after->a == Operand::reg(dst);
+}
+
+bool IRInstr::fold(Op op, int64_t a, int64_t b, int64_t& res){
+	uint64_t ua = static_cast<uint64_t>(a);
+	uint64_t ub = static_cast<uint64_t>(b);
+	switch (op){
+	case COPY: res = a; return true;
+	case ADD: res = static_cast<int64_t>(ua + ub); return true;
+	case SUB: res = static_cast<int64_t>(ua - ub); return true;
+	case MUL: res = static_cast<int64_t>(ua * ub); return true;
+	case DIV:
+		if (b == 0 || (a == INT64_MIN && b == -1)){ return false; }
+		res = a / b;
+		return true;
+	case EQ: res = a == b; return true;
+	case NE: res = a != b; return true;
+	case LT: res = a < b; return true;
+	case GT: res = a > b; return true;
+	case LE: res = a <= b; return true;
+	case GE: res = a >= b; return true;
+	case NEG: res = static_cast<int64_t>(0 - ua); return true;
+	case NOT: res = a == 0; return true;
+	default:
+		return false;
+	}
+}
+
+const char * IRInstr::opName(Op op){
+	switch (op){
+	case COPY: return "copy";
+	case ADD: return "add";
+	case SUB: return "sub";
+	case MUL: return "mul";
+	case DIV: return "div";
+	case EQ: return "eq";
+	case NE: return "ne";
+	case LT: return "lt";
+	case GT: return "gt";
+	case LE: return "le";
+	case GE: return "ge";
+	case NEG: return "neg";
+	case NOT: return "not";
+	case LOADG: return "loadg";
+	case STOREG: return "storeg";
+	case LOAD: return "load";
+	case STORE: return "store";
+	case LOADT: return "loadt";
+	case STORET: return "storet";
+	case CALL: return "call";
+	case READ_INT: return "readint";
+	case READ_BOOL: return "readbool";
+	case WRITE_INT: return "writeint";
+	case WRITE_BOOL: return "writebool";
+	case WRITE_STR: return "writestr";
+	case PHI: return "phi";
+	case JMP: return "jmp";
+	case BR: return "br";
+	case RET: return "ret";
+	}
+	return "???";
+}
+
+void IRBlock::append(IRInstr * instr){
+	instr->block = this;
+	instr->prev = last;
+	instr->next = nullptr;
+	if (last == nullptr){
+		first = instr;
+	} else {
+		last->next = instr;
+	}
+	last = instr;
+}
+
+void IRBlock::insertBefore(IRInstr * before, IRInstr * instr){
+	if (before == nullptr){
+		append(instr);
+		return;
+	}
+	instr->block = this;
+	instr->next = before;
+	instr->prev = before->prev;
+	if (before->prev == nullptr){
+		first = instr;
+	} else {
+		before->prev->next = instr;
+	}
+	before->prev = instr;
+}
+
+void IRBlock::remove(IRInstr * instr){
+	if (instr->prev == nullptr){
+		first = instr->next;
+	} else {
+		instr->prev->next = instr->next;
+	}
+	if (instr->next == nullptr){
+		last = instr->prev;
+	} else {
+		instr->next->prev = instr->prev;
+	}
+	instr->block = nullptr;
+	instr->prev = nullptr;
+	instr->next = nullptr;
+}
+
+void IRBlock::removePhiInputs(const IRBlock * pred){
+	for (IRInstr * phi = first;
+		phi != nullptr && phi->op == IRInstr::PHI; phi = phi->next){
+		uint32_t kept = 0;
+		for (uint32_t i = 0; i < phi->numArgs; i++){
+			if (phi->blocks[i] == pred){ continue; }
+			phi->args[kept] = phi->args[i];
+			phi->blocks[kept] = phi->blocks[i];
+			kept++;
+		}
+		phi->numArgs = kept;
+	}
+}
+
+void IRFunction::reserveArgs(IRInstr * instr, uint32_t n,
+	bool withBlocks){
+	if (n <= instr->capArgs){ return; }
+	Operand * args = arena.array<Operand>(n);
+	IRBlock ** blocks = withBlocks ?
+		arena.array<IRBlock *>(n) : nullptr;
+	for (uint32_t i = 0; i < instr->numArgs; i++){
+		args[i] = instr->args[i];
+		if (withBlocks){ blocks[i] = instr->blocks[i]; }
+	}
+	instr->args = args;
+	instr->blocks = blocks;
+	instr->capArgs = n;
+}
+
+void IRFunction::addArg(IRInstr * instr, Operand arg, IRBlock * from){
+	if (instr->numArgs == instr->capArgs){
+		uint32_t cap = instr->capArgs == 0 ? 2 : instr->capArgs * 2;
+		reserveArgs(instr, cap, instr->op == IRInstr::PHI);
+	}
+	instr->args[instr->numArgs] = arg;
+	if (instr->blocks != nullptr){
+		instr->blocks[instr->numArgs] = from;
+	}
+	instr->numArgs++;
+}
+
+void IRFunction::rebuildEdges(){
+	for (IRBlock * block : blocks){
+		block->preds.clear();
+		block->succs.clear();
+	}
+	for (IRBlock * block : blocks){
+		IRInstr * term = block->terminator();
+		if (term == nullptr){ continue; }
+		size_t numTargets = 0;
+		if (term->op == IRInstr::JMP){ numTargets = 1; }
+		if (term->op == IRInstr::BR){ numTargets = 2; }
+		for (size_t i = 0; i < numTargets; i++){
+			IRBlock * succ = term->targets[i];
+			//Both arms of a branch can go to the same place
+			if (i == 1 && succ == term->targets[0]){ continue; }
+			block->succs.push_back(succ);
+			succ->preds.push_back(block);
+		}
+	}
+}
+
+HashMap<IRInstr *, bool> IRFunction::fusibleCompares(){
+	std::vector<uint32_t> uses(numRegs(), 0);
+	for (IRBlock * block : blocks){
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			instr->forEachUse([&](Operand& use){ uses[use.getReg()]++; });
+		}
+	}
+	HashMap<IRInstr *, bool> res;
+	for (IRBlock * block : blocks){
+		IRInstr * br = block->last;
+		if (br == nullptr || br->op != IRInstr::BR || !br->a.isReg()){
+			continue;
+		}
+		IRInstr * cmp = br->prev;
+		Reg r = br->a.getReg();
+		if (cmp != nullptr && cmp->dst == r && uses[r] == 1
+			&& cmp->op >= IRInstr::EQ && cmp->op <= IRInstr::GE){
+			res[cmp] = true;
+		}
+	}
+	return res;
+}
+
+void IRFunction::removeUnreachableBlocks(){
+	if (blocks.empty()){ return; }
+	std::vector<bool> seen(blocks.size(), false);
+	std::vector<IRBlock *> work;
+	work.push_back(blocks[0]);
+	seen[0] = true;
+	while (!work.empty()){
+		IRBlock * block = work.back();
+		work.pop_back();
+		for (IRBlock * succ : block->succs){
+			if (!seen[succ->id]){
+				seen[succ->id] = true;
+				work.push_back(succ);
+			}
+		}
+	}
+	std::vector<IRBlock *> live;
+	for (IRBlock * block : blocks){
+		if (!seen[block->id]){ continue; }
+		live.push_back(block);
+		for (IRInstr * instr = block->first; 
+			instr != nullptr && instr->op == IRInstr::PHI;
+			instr = instr->next){
+			uint32_t kept = 0;
+			for (uint32_t i = 0; i < instr->numArgs; i++){
+				if (!seen[instr->blocks[i]->id]){ continue; }
+				instr->args[kept] = instr->args[i];
+				instr->blocks[kept] = instr->blocks[i];
+				kept++;
+			}
+			instr->numArgs = kept;
+		}
+	}
+	if (live.size() == blocks.size()){ return; }
+	for (IRBlock * block : blocks){
+		if (!seen[block->id]){ block->id = UINT32_MAX; }
+	}
+	blocks.clear();
+	for (IRBlock * block : live){
+		placeBlock(block);
+	}
+	rebuildEdges();
+}
+
+std::string IRFunction::regString(Reg r) const {
+	if (r == NO_REG){ return "%?"; }
+	if (regNames[r].empty()){ return "%" + std::to_string(r); }
+	return "%" + regNames[r] + "." + std::to_string(r);
+}
+
+std::string IRFunction::operandString(const Operand& op) const {
+	switch (op.kind()){
+	case Operand::NONE: return "_";
+	case Operand::REG: return regString(op.getReg());
+	case Operand::IMM: return std::to_string(op.getImm());
+	}
+	return "???";
+}
+
+static void dumpInstr(std::ostream& out, const IRFunction * fn,
+	const IRProgram * prog, const IRInstr * instr){
+	out << "\t";
+	if (instr->dst != NO_REG){
+		out << fn->regString(instr->dst) << " = ";
+	}
+	out << IRInstr::opName(instr->op);
+	switch (instr->op){
+	case IRInstr::LOADG:
+		out << " " << prog->globals[instr->index];
+		break;
+	case IRInstr::STOREG:
+		out << " " << prog->globals[instr->index]
+			<< ", " << fn->operandString(instr->a);
+		break;
+	case IRInstr::LOADT:
+		out << " " << prog->tables[instr->index].name << "["
+			<< fn->operandString(instr->a) << "]";
+		break;
+	case IRInstr::STORET:
+		out << " " << prog->tables[instr->index].name << "["
+			<< fn->operandString(instr->a) << "], "
+			<< fn->operandString(instr->b);
+		break;
+	case IRInstr::CALL:
+		out << " " << prog->functions[instr->index]->name << "(";
+		for (uint32_t i = 0; i < instr->numArgs; i++){
+			if (i > 0){ out << ", "; }
+			out << fn->operandString(instr->args[i]);
+		}
+		out << ")";
+		break;
+	case IRInstr::PHI:
+		for (uint32_t i = 0; i < instr->numArgs; i++){
+			out << (i > 0 ? ", [" : " [")
+				<< instr->blocks[i]->label() << ": "
+				<< fn->operandString(instr->args[i]) << "]";
+		}
+		break;
+	case IRInstr::JMP:
+		out << " " << instr->targets[0]->label();
+		break;
+	case IRInstr::BR:
+		out << " " << fn->operandString(instr->a) << ", "
+			<< instr->targets[0]->label() << ", "
+			<< instr->targets[1]->label();
+		break;
+	default:
+		if (!instr->a.isNone()){
+			out << " " << fn->operandString(instr->a);
+		}
+		if (!instr->b.isNone()){
+			out << ", " << fn->operandString(instr->b);
+		}
+		break;
+	}
+	out << "\n";
+}
+
+static void dumpFunction(std::ostream& out, const IRProgram * prog,
+	const IRFunction * fn, 
+	std::function<std::string(const IRBlock *)>& note){
+	out << "fn " << fn->name << "(";
+	for (size_t i = 0; i < fn->params.size(); i++){
+		if (i > 0){ out << ", "; }
+		out << fn->regString(fn->params[i]);
+	}
+	out << ")" << (fn->returnsValue ? " -> value" : "") << " {\n";
+	for (const IRBlock * block : fn->blocks){
+		out << block->label() << ":";
+		if (!block->preds.empty()){
+			out << "\t\t; preds";
+			for (const IRBlock * pred : block->preds){
+				out << " " << pred->label();
+			}
+		}
+		if (note){
+			out << (block->preds.empty() ? "\t\t; " : "; ")
+				<< note(block);
+		}
+		out << "\n";
+		for (const IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			dumpInstr(out, fn, prog, instr);
+		}
+	}
+	out << "}\n";
+}
+
+IRProgram::~IRProgram(){
+	for (IRFunction * fn : functions){
+		delete fn;
+	}
+}
+
+uint32_t IRProgram::internString(const std::string& str){
+	auto found = stringIds.find(str);
+	if (found != stringIds.end()){ return found->second; }
+	uint32_t id = static_cast<uint32_t>(strings.size());
+	strings.push_back(str);
+	stringIds[str] = id;
+	return id;
+}
+
+IRFunction * IRProgram::findFunction(const std::string& name){
+	for (IRFunction * fn : functions){
+		if (fn != nullptr && fn->name == name){ return fn; }
+	}
+	return nullptr;
+}
+
+//Strings are dumped with the same escapes the lexer accepts
+static std::string escapeString(const std::string& str){
+	std::string res = "\"";
+	for (char c : str){
+		switch (c){
+		case '\n': res += "\\n"; break;
+		case '\t': res += "\\t"; break;
+		case '"': res += "\\\""; break;
+		case '\\': res += "\\\\"; break;
+		default: res += c;
+		}
+	}
+	return res + "\"";
+}
+
+void IRProgram::dump(std::ostream& out,
+	std::function<std::string(const IRBlock *)> note) const {
+	for (size_t i = 0; i < globals.size(); i++){
+		out << "global " << globals[i] << "\n";
+	}
+	for (const Table& table : tables){
+		out << "table " << table.name << " " << table.words << "\n";
+	}
+	for (size_t i = 0; i < strings.size(); i++){
+		out << "string " << i << " " << escapeString(strings[i])
+			<< "\n";
+	}
+	for (const IRFunction * fn : functions){
+		if (fn == nullptr){ continue; }
+		out << "\n";
+		dumpFunction(out, this, fn, note);
+	}
+}
+
+}
@@ -0,0 +1,449 @@
+#ifndef LAKE_IR_HPP
+#define LAKE_IR_HPP
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "err.hpp"
+#include "types.hpp"
+
+namespace lake{
+
+class ProgramNode;
+class ExpNode;
+class IdNode;
+class SemSymbol;
+class TypeAnalysis;
+class PointsTo;
+
+class IRBlock;
+class IRFunction;
+
+//A bump allocator. All of a function's blocks and instructions
+// are carved out of its arena, and are freed all at once when
+// the function is. Objects that need their destructor run (like
+// blocks, which hold vectors) are remembered and destroyed in
+// reverse order of creation.
+class Arena{
+public:
+	Arena() : cur(nullptr), left(0){ }
+	~Arena();
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+	void * alloc(size_t size, size_t align);
+	template <typename T, typename... Args>
+	T * make(Args&&... args){
+		void * mem = alloc(sizeof(T), alignof(T));
+		T * obj = new (mem) T(std::forward<Args>(args)...);
+		if (!std::is_trivially_destructible<T>::value){
+			dtors.push_back({obj, [](void * p){
+				static_cast<T *>(p)->~T();
+			}});
+		}
+		return obj;
+	}
+	//An uninitialized array of n trivially destructible things
+	template <typename T>
+	T * array(size_t n){
+		static_assert(std::is_trivially_destructible<T>::value,
+			"arena arrays are never destroyed");
+		return static_cast<T *>(alloc(sizeof(T) * n, alignof(T)));
+	}
+private:
+	std::vector<char *> chunks;
+	char * cur;
+	size_t left;
+	std::vector<std::pair<void *, void (*)(void *)>> dtors;
+};
+
+//A virtual register. Every function has an unbounded supply,
+// numbered from 0.
+typedef uint32_t Reg;
+const Reg NO_REG = UINT32_MAX;
+
+//An instruction operand: nothing, a register, or an immediate.
+// Ints, bools (0 or 1) and pointers are all 64-bit words. A
+// string literal's value is its index in the program's string
+// table.
+class Operand{
+public:
+	enum Kind : uint8_t { NONE, REG, IMM };
+	Operand() : myKind(NONE), myVal(0){ }
+	static Operand reg(Reg r){ return Operand(REG, r); }
+	static Operand imm(int64_t v){ return Operand(IMM, v); }
+	Kind kind() const { return myKind; }
+	bool isNone() const { return myKind == NONE; }
+	bool isReg() const { return myKind == REG; }
+	bool isImm() const { return myKind == IMM; }
+	Reg getReg() const { return static_cast<Reg>(myVal); }
+	int64_t getImm() const { return myVal; }
+	bool operator==(const Operand& other) const {
+		return myKind == other.myKind && myVal == other.myVal;
+	}
+	bool operator!=(const Operand& other) const {
+		return !(*this == other);
+	}
+private:
+	Operand(Kind kindIn, int64_t valIn)
+	: myKind(kindIn), myVal(valIn){ }
+	Kind myKind;
+	int64_t myVal;
+};
+
+//A three-address instruction. These are plain data, allocated
+// from the function's arena and linked into their block.
+class IRInstr{
+public:
+	enum Op : uint8_t {
+		//dst = a
+		COPY,
+		//dst = a op b, where comparisons give 0 or 1
+		ADD, SUB, MUL, DIV, EQ, NE, LT, GT, LE, GE,
+		//dst = op a
+		NEG, NOT,
+		//dst = global #index, global #index = a
+		LOADG, STOREG,
+		//dst = @a, @a = b
+		LOAD, STORE,
+		//dst = word a of table #index, word a of table #index = b
+		LOADT, STORET,
+		//dst = function #index(args), dst is NO_REG for void
+		CALL,
+		//dst = a value read from the input
+		READ_INT, READ_BOOL,
+		//Write a as an int, a bool, or string #a
+		WRITE_INT, WRITE_BOOL, WRITE_STR,
+		//dst = args[i] when control came from blocks[i]
+		PHI,
+		//Terminators. Jump to targets[0]; go to targets[0] if
+		// a is nonzero and targets[1] otherwise; return a
+		// (which is NONE in void functions)
+		JMP, BR, RET
+	};
+	IRInstr(Op opIn)
+	: op(opIn), dst(NO_REG), index(0),
+	  args(nullptr), blocks(nullptr), numArgs(0), capArgs(0),
+	  block(nullptr), prev(nullptr), next(nullptr){
+		targets[0] = nullptr;
+		targets[1] = nullptr;
+	}
+	bool isTerminator() const { return op >= JMP; }
+	//Turn this (say, a phi) into dst = from
+	void makeCopy(Operand from){
+		op = COPY;
+		a = from;
+		b = Operand();
+		args = nullptr;
+		blocks = nullptr;
+		numArgs = 0;
+		capArgs = 0;
+	}
+	//Call f on each operand that reads a register
+	template <typename F>
+	void forEachUse(F f){
+		if (a.isReg()){ f(a); }
+		if (b.isReg()){ f(b); }
+		for (uint32_t i = 0; i < numArgs; i++){
+			if (args[i].isReg()){ f(args[i]); }
+		}
+	}
+	//Whether the instruction does anything besides setting dst
+	bool hasSideEffects() const;
+	//Whether this is a call that is the last thing its function
+	// does: it is followed (maybe through jumps) by a return of
+	// its result, or (in a void function) by a bare return or the
+	// end of the code
+	bool isTailCall() const;
+	//Compute op on constants, with ints wrapping around at 64
+	// bits. False when the result is a runtime error (division
+	// by zero, or of the smallest int by -1) or op isn't a pure
+	// arithmetic, comparison or logic op.
+	static bool fold(Op op, int64_t a, int64_t b, int64_t& res);
+	static const char * opName(Op op);
+
+	Op op;
+	Reg dst;
+	Operand a;
+	Operand b;
+	//A global, function, string or table, depending on op
+	uint32_t index;
+	//Call arguments, or phi inputs along with the block each
+	// comes from
+	Operand * args;
+	IRBlock ** blocks;
+	uint32_t numArgs;
+	uint32_t capArgs;
+	IRBlock * targets[2];
+
+	IRBlock * block;
+	IRInstr * prev;
+	IRInstr * next;
+};
+
+//A basic block: a list of instructions, the last of which is
+// the only terminator. The edges are filled in by
+// IRFunction::rebuildEdges from the terminators.
+class IRBlock{
+public:
+	IRBlock(IRFunction * fnIn)
+	: id(UINT32_MAX), fn(fnIn), first(nullptr), last(nullptr){ }
+	IRInstr * terminator(){
+		if (last == nullptr || !last->isTerminator()){
+			return nullptr;
+		}
+		return last;
+	}
+	void append(IRInstr * instr);
+	void insertBefore(IRInstr * before, IRInstr * instr);
+	void remove(IRInstr * instr);
+	bool empty(){ return first == nullptr; }
+	//Drop the inputs of this block's phis that come from pred
+	void removePhiInputs(const IRBlock * pred);
+	std::string label() const { return "b" + std::to_string(id); }
+
+	uint32_t id;
+	IRFunction * fn;
+	IRInstr * first;
+	IRInstr * last;
+	std::vector<IRBlock *> preds;
+	std::vector<IRBlock *> succs;
+};
+
+//One Lake function. blocks[0] is the entry, and the rest are
+// kept in source order. Registers that hold a Lake variable
+// carry its name, registers without one are temporaries.
+class IRFunction{
+public:
+	IRFunction(std::string nameIn, bool returnsValueIn)
+	: name(nameIn), returnsValue(returnsValueIn), ssa(false){ }
+	Reg newReg(std::string regName = ""){
+		regNames.push_back(regName);
+		return static_cast<Reg>(regNames.size() - 1);
+	}
+	size_t numRegs() const { return regNames.size(); }
+	bool isVariable(Reg r) const { return !regNames[r].empty(); }
+	std::string regString(Reg r) const;
+	std::string operandString(const Operand& op) const;
+	//Makes a block, which is not part of the function until
+	// it is placed
+	IRBlock * newBlock(){ return arena.make<IRBlock>(this); }
+	void placeBlock(IRBlock * block){
+		block->id = static_cast<uint32_t>(blocks.size());
+		blocks.push_back(block);
+	}
+	IRInstr * newInstr(IRInstr::Op op){
+		return arena.make<IRInstr>(op);
+	}
+	//Give instr room for n arguments (keeping the ones it has)
+	void reserveArgs(IRInstr * instr, uint32_t n, bool withBlocks);
+	void addArg(IRInstr * instr, Operand arg, IRBlock * from);
+	//Recompute every block's successors, from its terminator,
+	// and predecessors
+	void rebuildEdges();
+	//The comparisons that only the branch right after them uses,
+	// so that code generators can compare and branch in one go
+	// rather than compute 0 or 1 and test it. These are
+	// instructions, not registers: outside SSA form a register
+	// may be set by more than one comparison.
+	HashMap<IRInstr *, bool> fusibleCompares();
+	//Drop the blocks that can't be reached from the entry, and
+	// any phi inputs coming from them. Edges must be up to date.
+	void removeUnreachableBlocks();
+
+	std::string name;
+	bool returnsValue;
+	//Whether the function is currently in SSA form
+	bool ssa;
+	std::vector<Reg> params;
+	std::vector<IRBlock *> blocks;
+	std::vector<std::string> regNames;
+	Arena arena;
+};
+
+//A whole lowered program. Globals are zero-initialized words,
+// identified by their index, as are functions and strings.
+// Tables are zero-initialized arrays of words that only code the
+// compiler adds itself (such as memoization) reads and writes,
+// always at an index it has made sure is in bounds.
+class IRProgram{
+public:
+	IRProgram(){ }
+	~IRProgram();
+	IRProgram(const IRProgram&) = delete;
+	IRProgram& operator=(const IRProgram&) = delete;
+	uint32_t addGlobal(std::string name, bool pointedAtIn){
+		globals.push_back(name);
+		pointedAt.push_back(pointedAtIn);
+		return static_cast<uint32_t>(globals.size() - 1);
+	}
+	uint32_t addTable(std::string name, uint32_t words){
+		tables.push_back({name, words});
+		return static_cast<uint32_t>(tables.size() - 1);
+	}
+	uint32_t addFunction(IRFunction * fn){
+		functions.push_back(fn);
+		return static_cast<uint32_t>(functions.size() - 1);
+	}
+	//Strings are interned, so equal literals get equal indices
+	uint32_t internString(const std::string& str);
+	IRFunction * findFunction(const std::string& name);
+	//note, if given, adds a comment to each block's label
+	void dump(std::ostream& out, 
+		std::function<std::string(const IRBlock *)> note = nullptr)
+		const;
+
+	struct Table{
+		std::string name;
+		uint32_t words;
+	};
+
+	std::vector<std::string> globals;
+	//Whether a pointer may point at each global (see PointsTo),
+	// so that a store through @ may change it
+	std::vector<bool> pointedAt;
+	std::vector<Table> tables;
+	std::vector<IRFunction *> functions;
+	std::vector<std::string> strings;
+private:
+	HashMap<std::string, uint32_t> stringIds;
+};
+
+//The characters of a string literal, which still has its quotes
+// and escapes as in the source
+std::string unescape(const std::string& lit);
+
+//The state of lowering a type-checked tree to IR. As each
+// expression is finished it pushes the operand holding its
+// value, which its parent pops. Control flow statements keep
+// the blocks they still need to finish on a stack of their own.
+// Variables are kept in registers and globals in words of their
+// own, which pt has to show no pointer can reach.
+class Lowering{
+public:
+	Lowering(TypeAnalysis * taIn, const PointsTo * ptIn);
+	~Lowering();
+	TypeAnalysis * types(){ return ta; }
+	//Hand over the finished program
+	IRProgram * finish();
+
+	void beginFunction(SemSymbol * sym, bool returnsValue);
+	void endFunction();
+	bool inFunction(){ return fn != nullptr; }
+	void addGlobal(SemSymbol * sym);
+	Reg addLocal(SemSymbol * sym);
+	void addParam(SemSymbol * sym);
+	uint32_t functionIndex(SemSymbol * sym);
+	uint32_t internString(const std::string& str){
+		return prog->internString(str);
+	}
+
+	void push(Operand op){ values.push_back(op); }
+	Operand pop(){
+		Operand res = values.back();
+		values.pop_back();
+		return res;
+	}
+
+	//A fresh temporary
+	Reg temp(){ return fn->newReg(); }
+	IRBlock * newBlock(){ return fn->newBlock(); }
+	//Continue emitting code into block, which is placed next
+	void setBlock(IRBlock * block);
+	//Append an instruction at the current point. Code after a
+	// terminator (say, after a return) goes in a new block.
+	IRInstr * emit(IRInstr::Op op, Reg dst,
+		Operand a = Operand(), Operand b = Operand());
+	Operand compute(IRInstr::Op op, Operand a,
+		Operand b = Operand());
+	void jump(IRBlock * target);
+	void branch(Operand cond, IRBlock * ifTrue, IRBlock * ifFalse);
+	void ret(Operand val);
+	//Returns the result, or no operand for a void function
+	Operand call(SemSymbol * fnSym, const std::vector<Operand>& args);
+
+	//Locations. The next loc to be lowered is lowered for its
+	// address rather than its value when wantAddress() was
+	// called: nothing for a variable, the pointer for @p.
+	void wantAddress(){ addressNext = true; }
+	bool takeAddress(){
+		bool res = addressNext;
+		addressNext = false;
+		return res;
+	}
+	Operand readVar(IdNode * id);
+	Operand load(ExpNode * loc, Operand addr);
+	//Returns what holds the stored value afterwards
+	Operand store(ExpNode * loc, Operand addr, Operand val);
+
+	//Blocks and registers that a statement or short-circuit
+	// operator needs again once its children are done
+	struct Pending{
+		IRBlock * blockA;
+		IRBlock * blockB;
+		Reg reg;
+	};
+	void pushPending(Pending p){ pending.push_back(p); }
+	Pending& topPending(){ return pending.back(); }
+	void popPending(){ pending.pop_back(); }
+	//Whether each @ being lowered is a loc being stored to
+	std::vector<bool> derefAddress;
+
+	//Conditions. A condition in branch position (that of an if
+	// or while, or an operand of &&, || or ! that is itself in
+	// one) may jump to one of two blocks instead of producing a
+	// value: when cond is next lowered, its lowerPre can take the
+	// branch, and then cond leaves no value and no current block.
+	struct Branch{
+		ExpNode * cond;
+		IRBlock * ifTrue;
+		IRBlock * ifFalse;
+		//The block a chain of && or || goes on to next
+		IRBlock * next;
+	};
+	void wantBranch(ExpNode * cond, IRBlock * ifTrue,
+		IRBlock * ifFalse){
+		wanted = {cond, ifTrue, ifFalse, nullptr};
+	}
+	//Whether cond is to branch, in which case it is the innermost
+	// condition being lowered as a branch until it calls
+	// popBranch, once it has jumped
+	bool takeBranch(ExpNode * cond);
+	bool branching(ExpNode * cond){
+		return !branches.empty() && branches.back().cond == cond;
+	}
+	Branch& topBranch(){ return branches.back(); }
+	void popBranch(){
+		taken = branches.back();
+		branches.pop_back();
+	}
+	//Called once the condition wantBranch asked for is lowered.
+	// If it didn't take the branch, its value is tested instead.
+	// Returns where the condition goes.
+	Branch endBranch();
+private:
+	Operand writeVar(Reg var, Operand val);
+
+	TypeAnalysis * ta;
+	const PointsTo * pt;
+	IRProgram * prog;
+	IRFunction * fn;
+	IRBlock * cur;
+	bool addressNext;
+	std::vector<Operand> values;
+	std::vector<Pending> pending;
+	Branch wanted;
+	std::vector<Branch> branches;
+	//The branch the last condition to take one took
+	Branch taken;
+	HashMap<SemSymbol *, uint32_t> globalIds;
+	HashMap<SemSymbol *, uint32_t> functionIds;
+	HashMap<SemSymbol *, Reg> localRegs;
+};
+
+}
+
+#endif
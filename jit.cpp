@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "vm.hpp"
+#include "x86.hpp"
+
+namespace lake{
+
+//lakert_write_str, which is the only runtime function whose
+// arguments differ from the interpreters' version
+static void jitWriteStr(const char * str, int64_t len){
+	fwrite(str, 1, static_cast<size_t>(len), stdout);
+}
+
+//Where the runtime functions the code calls are in lakec
+static uint64_t runtimeAddress(const std::string& name){
+	if (name == "lakert_read_int"){
+		return reinterpret_cast<uint64_t>(&interpReadInt);
+	} else if (name == "lakert_read_bool"){
+		return reinterpret_cast<uint64_t>(&interpReadBool);
+	} else if (name == "lakert_write_int"){
+		return reinterpret_cast<uint64_t>(&interpWriteInt);
+	} else if (name == "lakert_write_bool"){
+		return reinterpret_cast<uint64_t>(&interpWriteBool);
+	} else if (name == "lakert_write_str"){
+		return reinterpret_cast<uint64_t>(&jitWriteStr);
+	}
+	std::string msg = "No runtime function " + name;
+	throw new InternalError(msg.c_str());
+}
+
+static size_t roundUp(size_t n, size_t to){
+	return (n + to - 1) / to * to;
+}
+
+//The code is followed by a stub for each runtime function, an
+// indirect jump through an address stored right after it: lakec
+// may be mapped too far away for a call's 32-bit displacement.
+// The strings and globals go on the pages after those, so that
+// rip-relative addresses reach them, and only they are writable.
+int64_t X86Module::run() const {
+	X86Code code = encode();
+	const size_t STUB_SIZE = 16;
+	size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+	std::vector<size_t> placedAt(symbols.size(), 0);
+	size_t textSize = code.bytes.size();
+	for (uint32_t i = 0; i < symbols.size(); i++){
+		if (symbols[i].kind == X86Symbol::EXTERN){
+			textSize = roundUp(textSize, STUB_SIZE);
+			placedAt[i] = textSize;
+			textSize += STUB_SIZE;
+		} else if (symbols[i].kind == X86Symbol::TEXT){
+			placedAt[i] = code.offsets[i];
+		}
+	}
+	size_t dataStart = roundUp(textSize, page);
+	size_t dataSize = 0;
+	for (uint32_t i = 0; i < symbols.size(); i++){
+		if (symbols[i].kind == X86Symbol::RODATA){
+			placedAt[i] = dataStart + dataSize;
+			dataSize += symbols[i].data.size();
+		} else if (symbols[i].kind == X86Symbol::BSS){
+			dataSize = roundUp(dataSize, 8);
+			placedAt[i] = dataStart + dataSize;
+			dataSize += symbols[i].size;
+		}
+	}
+	size_t mapSize = dataStart + roundUp(std::max(dataSize,
+		static_cast<size_t>(1)), page);
+
+	void * mem = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (mem == MAP_FAILED){
+		throw new InternalError("Could not map memory for the JIT");
+	}
+	uint8_t * base = static_cast<uint8_t *>(mem);
+	std::memcpy(base, code.bytes.data(), code.bytes.size());
+	for (uint32_t i = 0; i < symbols.size(); i++){
+		const X86Symbol& sym = symbols[i];
+		if (sym.kind == X86Symbol::EXTERN){
+			//jmp *0(%rip), then the address
+			const uint8_t jmp[6] = { 0xFF, 0x25, 0, 0, 0, 0 };
+			uint64_t target = runtimeAddress(sym.name);
+			std::memcpy(base + placedAt[i], jmp, sizeof(jmp));
+			std::memcpy(base + placedAt[i] + sizeof(jmp), &target, 8);
+		} else if (sym.kind == X86Symbol::RODATA){
+			std::memcpy(base + placedAt[i], sym.data.data(),
+				sym.data.size());
+		}
+	}
+	for (const X86Code::Reloc& reloc : code.relocs){
+		int64_t disp = static_cast<int64_t>(placedAt[reloc.symbol])
+			+ reloc.addend - static_cast<int64_t>(reloc.offset);
+		uint32_t u = static_cast<uint32_t>(disp);
+		for (size_t b = 0; b < 4; b++){
+			base[reloc.offset + b] = static_cast<uint8_t>(u >> (8 * b));
+		}
+	}
+	if (mprotect(base, dataStart, PROT_READ | PROT_EXEC) != 0){
+		munmap(mem, mapSize);
+		throw new InternalError("Could not make the JIT code executable");
+	}
+
+	//perf reads these lines: start, size (both in hex) and name
+	uint32_t mainSym = UINT32_MAX;
+	std::string mapPath = "/tmp/perf-" + std::to_string(getpid()) + ".map";
+	FILE * perfMap = fopen(mapPath.c_str(), "a");
+	for (uint32_t i = 0; i < symbols.size(); i++){
+		const X86Symbol& sym = symbols[i];
+		if (sym.kind != X86Symbol::TEXT){ continue; }
+		if (sym.name == "lake_main"){ mainSym = i; }
+		size_t end = i + 1 < symbols.size()
+			&& symbols[i + 1].kind == X86Symbol::TEXT ?
+			code.offsets[i + 1] : code.bytes.size();
+		if (perfMap != nullptr){
+			fprintf(perfMap, "%llx %zx %s\n",
+				static_cast<unsigned long long>(
+				reinterpret_cast<uintptr_t>(base + placedAt[i])),
+				end - placedAt[i], sym.name.c_str());
+		}
+	}
+	if (perfMap != nullptr){ fclose(perfMap); }
+	if (mainSym == UINT32_MAX){
+		munmap(mem, mapSize);
+		throw new InternalError("No main function to run");
+	}
+
+	auto entry = reinterpret_cast<int64_t (*)()>(base + placedAt[mainSym]);
+	int64_t res = entry();
+	munmap(mem, mapSize);
+	return res;
+}
+
+}
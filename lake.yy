@@ -29,6 +29,7 @@
 
 %parse-param { lake::Scanner  &scanner  }
 %parse-param { lake::ProgramNode** root }
+%parse-param { lake::DeclSink * sink }
 
 %code{
    #include <iostream>
@@ -164,7 +165,13 @@ program : declList
 
 declList : declList decl 
            {
-           $1->push_back($2);
+           /* In streaming mode each decl is handed off as soon
+              as it is reduced rather than kept in the tree */
+           if (sink != nullptr){
+              sink->consume($2);
+           } else {
+              $1->push_back($2);
+           }
            $$ = $1;
            }
          | /* epsilon */ 
@@ -202,7 +209,7 @@ formalsList : formalDecl
               }
 
 fnBody : LCURLY varDeclList stmtList RCURLY {
-         $$ = new FnBodyNode($1->_line, $1->_column, 
+         $$ = new FnBodyNode($1->_pos, 
 		new VarDeclListNode($2), new StmtListNode($3));
        }
 
@@ -224,7 +231,7 @@ stmt : assignExp SEMICOLON { $$ = new AssignStmtNode($1); }
      | WRITE exp SEMICOLON { $$ = new WriteStmtNode($2); }
      | IF LPAREN exp RPAREN LCURLY varDeclList stmtList RCURLY 
         { 
-        $$ = new IfStmtNode($1->_line, $1->_column, $3, 
+        $$ = new IfStmtNode($1->_pos, $3, 
 		new VarDeclListNode($6),
 		new StmtListNode($7)
 	);
@@ -241,55 +248,59 @@ stmt : assignExp SEMICOLON { $$ = new AssignStmtNode($1); }
         }
      | WHILE LPAREN exp RPAREN LCURLY varDeclList stmtList RCURLY
        { 
-        $$ = new WhileStmtNode($1->_line, $1->_column, $3, 
+        $$ = new WhileStmtNode($1->_pos, $3, 
 		new VarDeclListNode($6), new StmtListNode($7)); 
        }
      | RETURN exp SEMICOLON 
-	{ $$ = new ReturnStmtNode($1->_line, $1->_column, $2); }
+	{ $$ = new ReturnStmtNode($1->_pos, $2); }
      | RETURN SEMICOLON 
-       { $$ = new ReturnStmtNode($1->_line, $1->_column, nullptr); }
+       { $$ = new ReturnStmtNode($1->_pos, nullptr); }
      | fncall SEMICOLON { $$ = new CallStmtNode($1); }
 
 
 assignExp : loc ASSIGN exp 
-      { $$ = new AssignNode($2->_line, $2->_column, $1, $3); }
+      { $$ = new AssignNode($2->_pos, $1, $3); }
 
 exp : assignExp
 	{ $$ = $1; }
     | exp CROSS exp 
-      { $$ = new PlusNode($2->_line, $2->_column, $1, $3); }
+      { $$ = ChainExpNode::extend<PlusNode>(
+		$2->_pos, $1, $3); }
     | exp DASH exp 
-      { $$ = new MinusNode($2->_line, $2->_column, $1, $3); }
+      { $$ = new MinusNode($2->_pos, $1, $3); }
     | exp STAR exp 
-      { $$ = new TimesNode($2->_line, $2->_column, $1, $3); }
+      { $$ = ChainExpNode::extend<TimesNode>(
+		$2->_pos, $1, $3); }
     | exp SLASH exp 
-      { $$ = new DivideNode($2->_line, $2->_column, $1, $3); }
+      { $$ = new DivideNode($2->_pos, $1, $3); }
     | NOT exp 
-      { $$ = new NotNode($1->_line, $1->_column, $2); }
+      { $$ = new NotNode($1->_pos, $2); }
     | exp AND exp 
-      { $$ = new AndNode($2->_line, $2->_column, $1, $3); }
+      { $$ = ChainExpNode::extend<AndNode>(
+		$2->_pos, $1, $3); }
     | exp OR exp 
-      { $$ = new OrNode($2->_line, $2->_column, $1, $3); }
+      { $$ = ChainExpNode::extend<OrNode>(
+		$2->_pos, $1, $3); }
     | exp EQUALS exp 
-      { $$ = new EqualsNode($2->_line, $2->_column, $1, $3); }
+      { $$ = new EqualsNode($2->_pos, $1, $3); }
     | exp NOTEQUALS exp 
-      { $$ = new NotEqualsNode($2->_line, $2->_column, $1, $3); }
+      { $$ = new NotEqualsNode($2->_pos, $1, $3); }
     | exp LESS exp 
-      { $$ = new LessNode($2->_line, $2->_column, $1, $3); }
+      { $$ = new LessNode($2->_pos, $1, $3); }
     | exp GREATER exp 
-      { $$ = new GreaterNode($2->_line, $2->_column, $1, $3); }
+      { $$ = new GreaterNode($2->_pos, $1, $3); }
     | exp LESSEQ exp 
-      { $$ = new LessEqNode($2->_line, $2->_column, $1, $3); }
+      { $$ = new LessEqNode($2->_pos, $1, $3); }
     | exp GREATEREQ exp 
-      { $$ = new GreaterEqNode($2->_line, $2->_column, $1, $3); }
+      { $$ = new GreaterEqNode($2->_pos, $1, $3); }
     | DASH term { $$ = new UnaryMinusNode($2); }
     | term { $$ = $1; }
 
 term : loc { $$ = $1; }
      | INTLITERAL { $$ = new IntLitNode($1); }
      | STRINGLITERAL { $$ = new StrLitNode($1); }
-     | TRUE { $$ = new TrueNode($1->_line, $1->_column); }
-     | FALSE { $$ = new FalseNode($1->_line, $1->_column); }
+     | TRUE { $$ = new TrueNode($1->_pos); }
+     | FALSE { $$ = new FalseNode($1->_pos); }
      | LPAREN exp RPAREN { $$ = $2; }
      | fncall { $$ = $1; }
 
@@ -320,16 +331,16 @@ type : primtype ptrdepth
 	$$->setPtrDepth($2);
 	}
 
-primtype : INT { $$ = new IntNode($1->_line, $1->_column); }
-     | BOOL { $$ = new BoolNode($1->_line, $1->_column); }
-     | VOID { $$ = new VoidNode($1->_line, $1->_column); }
+primtype : INT { $$ = new IntNode($1->_pos); }
+     | BOOL { $$ = new BoolNode($1->_pos); }
+     | VOID { $$ = new VoidNode($1->_pos); }
 
 
 ptrdepth : DEREF ptrdepth { $$ = $2 + 1; }
 	| /* epsilon */ { $$ = 0; }
 
 loc : id { $$ = $1; }
-    | DEREF loc { $$ = new DerefNode($1->_line, $1->_column, $2); }
+    | DEREF loc { $$ = new DerefNode($1->_pos, $2); }
 
 id : ID { $$ = new IdNode($1); }
 
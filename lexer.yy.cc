@@ -0,0 +1,87 @@
+#include <string>
+#include <limits.h>
+#include <cctype>
+#include "scanner.hpp"
+using TokenKind = lake::Parser::token;
+int lake::Scanner::yylex(lake::Parser::semantic_type * const lval){
+	yylval = lval;
+	std::istream & in = *yyin;
+	while (true){
+		int c = in.peek();
+		if (c == EOF){ return TokenKind::END; }
+		if (c == '\n'){ in.get(); advance(1); newLine(); continue; }
+		if (c == '\r'){ in.get(); advance(1); continue; }
+		if (c == ' ' || c == '\t'){ in.get(); advance(1); continue; }
+		if (c == '#' || (c == '/' && (in.get(), in.peek() == '/' ? (in.unget(), true) : (in.unget(), false)))){
+			while (in.peek() != '\n' && in.peek() != EOF){ in.get(); advance(1); }
+			continue;
+		}
+		break;
+	}
+	int c = in.get();
+	buf.clear(); buf += char(c);
+	auto setText = [&](){ yytext = &buf[0]; yyleng = static_cast<int>(buf.size()); advance(buf.size()); };
+	if (isalpha(c) || c == '_'){
+		while (isalnum(in.peek()) || in.peek() == '_') buf += char(in.get());
+		setText();
+		static const struct { const char * s; int k; } kws[] = {
+			{"bool",TokenKind::BOOL},{"void",TokenKind::VOID},{"int",TokenKind::INT},
+			{"true",TokenKind::TRUE},{"false",TokenKind::FALSE},{"if",TokenKind::IF},
+			{"else",TokenKind::ELSE},{"while",TokenKind::WHILE},{"return",TokenKind::RETURN},
+			{"write",TokenKind::WRITE},{"read",TokenKind::READ}};
+		for (auto & kw : kws){ if (buf == kw.s){ return produceNoArgToken(kw.k); } }
+		yylval->tokenValue = keep(new IDToken(matchPos, buf));
+		return TokenKind::ID;
+	}
+	if (isdigit(c)){
+		while (isdigit(in.peek())) buf += char(in.get());
+		setText();
+		double overflow = std::stod(buf);
+		int intVal = atoi(buf.c_str());
+		if (overflow > INT_MAX){ warn(NO_POS,"Integer literal too large; using max value"); intVal = INT_MAX; }
+		yylval->tokenValue = keep(new IntLitToken(matchPos, intVal));
+		return TokenKind::INTLITERAL;
+	}
+	if (c == '"'){
+		while (in.peek() != '"' && in.peek() != '\n' && in.peek() != EOF){
+			int d = in.get(); buf += char(d);
+			if (d == '\\' && in.peek() != EOF && in.peek() != '\n') buf += char(in.get());
+		}
+		if (in.peek() == '"'){ buf += char(in.get()); }
+		setText();
+		yylval->tokenValue = keep(new StringLitToken(matchPos, buf));
+		return TokenKind::STRINGLITERAL;
+	}
+	int n = in.peek();
+	auto two = [&](char a, char b){ return c == a && n == b; };
+	int kind = -1;
+	if (two('+','+')) kind = TokenKind::CROSSCROSS;
+	else if (two('-','-')) kind = TokenKind::DASHDASH;
+	else if (two('&','&')) kind = TokenKind::AND;
+	else if (two('|','|')) kind = TokenKind::OR;
+	else if (two('=','=')) kind = TokenKind::EQUALS;
+	else if (two('!','=')) kind = TokenKind::NOTEQUALS;
+	else if (two('<','=')) kind = TokenKind::LESSEQ;
+	else if (two('>','=')) kind = TokenKind::GREATEREQ;
+	if (kind != -1){ buf += char(in.get()); setText(); return produceNoArgToken(kind); }
+	setText();
+	switch (c){
+	case '{': return produceNoArgToken(TokenKind::LCURLY);
+	case '}': return produceNoArgToken(TokenKind::RCURLY);
+	case '@': return produceNoArgToken(TokenKind::DEREF);
+	case '(': return produceNoArgToken(TokenKind::LPAREN);
+	case ')': return produceNoArgToken(TokenKind::RPAREN);
+	case ';': return produceNoArgToken(TokenKind::SEMICOLON);
+	case ',': return produceNoArgToken(TokenKind::COMMA);
+	case '+': return produceNoArgToken(TokenKind::CROSS);
+	case '-': return produceNoArgToken(TokenKind::DASH);
+	case '*': return produceNoArgToken(TokenKind::STAR);
+	case '/': return produceNoArgToken(TokenKind::SLASH);
+	case '!': return produceNoArgToken(TokenKind::NOT);
+	case '<': return produceNoArgToken(TokenKind::LESS);
+	case '>': return produceNoArgToken(TokenKind::GREATER);
+	case '=': return produceNoArgToken(TokenKind::ASSIGN);
+	}
+	error(matchPos, std::string("Illegal character ") + buf);
+	return yylex(lval);
+}
@@ -0,0 +1,431 @@
+#include <algorithm>
+#include "opt.hpp"
+#include "ssa.hpp"
+
+namespace lake{
+
+namespace {
+//A natural loop: the header, and every block that can get back
+// to it along one of its back edges without passing through it
+struct Loop{
+	IRBlock * header;
+	IRBlock * preheader;
+	std::vector<IRBlock *> latches;
+	std::vector<IRBlock *> blocks;
+	std::vector<bool> contains;
+};
+}
+
+//Every loop in fn, innermost (smallest) first. Back edges that
+// share a header make up one loop. Edges must be up to date.
+static std::vector<Loop> findLoops(IRFunction * fn, const DomTree& dom){
+	size_t n = fn->blocks.size();
+	std::vector<Loop> loops;
+	for (IRBlock * header : dom.preorder()){
+		Loop loop;
+		for (IRBlock * pred : header->preds){
+			if (dom.reachable(pred) && dom.dominates(header, pred)){
+				loop.latches.push_back(pred);
+			}
+		}
+		if (loop.latches.empty()){ continue; }
+		loop.header = header;
+		loop.preheader = nullptr;
+		loop.contains.assign(n, false);
+		loop.contains[header->id] = true;
+		loop.blocks.push_back(header);
+		std::vector<IRBlock *> work;
+		for (IRBlock * latch : loop.latches){
+			if (!loop.contains[latch->id]){
+				loop.contains[latch->id] = true;
+				loop.blocks.push_back(latch);
+				work.push_back(latch);
+			}
+		}
+		while (!work.empty()){
+			IRBlock * block = work.back();
+			work.pop_back();
+			for (IRBlock * pred : block->preds){
+				if (!dom.reachable(pred) || loop.contains[pred->id]){
+					continue;
+				}
+				loop.contains[pred->id] = true;
+				loop.blocks.push_back(pred);
+				work.push_back(pred);
+			}
+		}
+		loops.push_back(std::move(loop));
+	}
+	std::stable_sort(loops.begin(), loops.end(),
+		[](const Loop& x, const Loop& y){
+			return x.blocks.size() < y.blocks.size();
+		});
+	return loops;
+}
+
+//Give header a preheader: a block that only jumps to it, and
+// that every edge into the loop comes through. Phi inputs from
+// outside the loop move to a phi in the preheader when there is
+// more than one of them. Returns the new block, which is not yet
+// placed.
+static IRBlock * makePreheader(IRFunction * fn, const Loop& loop){
+	IRBlock * header = loop.header;
+	std::vector<IRBlock *> outside;
+	for (IRBlock * pred : header->preds){
+		if (!loop.contains[pred->id]){ outside.push_back(pred); }
+	}
+	if (outside.size() == 1 && outside[0]->succs.size() == 1){
+		return nullptr;
+	}
+	IRBlock * pre = fn->newBlock();
+	for (IRBlock * pred : outside){
+		for (IRBlock *& target : pred->last->targets){
+			if (target == header){ target = pre; }
+		}
+	}
+	for (IRInstr * phi = header->first;
+		phi != nullptr && phi->op == IRInstr::PHI; phi = phi->next){
+		IRInstr * merged = nullptr;
+		if (outside.size() > 1){
+			merged = fn->newInstr(IRInstr::PHI);
+			merged->dst = fn->newReg(fn->regNames[phi->dst]);
+			pre->append(merged);
+		}
+		uint32_t kept = 0;
+		for (uint32_t i = 0; i < phi->numArgs; i++){
+			IRBlock * from = phi->blocks[i];
+			if (!loop.contains[from->id]){
+				if (merged == nullptr){
+					phi->blocks[i] = pre;
+				} else {
+					fn->addArg(merged, phi->args[i], from);
+					continue;
+				}
+			}
+			phi->args[kept] = phi->args[i];
+			phi->blocks[kept] = phi->blocks[i];
+			kept++;
+		}
+		phi->numArgs = kept;
+		if (merged != nullptr){
+			fn->addArg(phi, Operand::reg(merged->dst), pre);
+		}
+	}
+	IRInstr * jmp = fn->newInstr(IRInstr::JMP);
+	jmp->targets[0] = header;
+	pre->append(jmp);
+	return pre;
+}
+
+//What a loop's instructions may change
+struct LoopEffects{
+	bool calls;
+	//Stores to anything, and stores through @ in particular
+	bool stores;
+	bool pointerStores;
+	std::vector<uint32_t> storedGlobals;
+	std::vector<uint32_t> storedTables;
+};
+
+//Whether instr only computes its result from its operands, so
+// that it may run anywhere they are available. Loads qualify
+// when nothing in the loop could change what they read: nothing
+// stores to the global or table (or, for a load through a
+// pointer, to anything), and there are no calls. Stores through
+// a pointer only change the globals pointedAt says they may.
+static bool movable(const IRInstr * instr, const LoopEffects& fx,
+	const std::vector<bool>& pointedAt){
+	switch (instr->op){
+	case IRInstr::PHI:
+		return false;
+	case IRInstr::LOADG:
+		return !fx.calls && std::find(fx.storedGlobals.begin(),
+			fx.storedGlobals.end(), instr->index)
+			== fx.storedGlobals.end()
+			&& !(fx.pointerStores && pointedAt[instr->index]);
+	case IRInstr::LOADT:
+		return !fx.calls && std::find(fx.storedTables.begin(),
+			fx.storedTables.end(), instr->index)
+			== fx.storedTables.end();
+	case IRInstr::LOAD:
+		return !fx.calls && !fx.stores;
+	case IRInstr::DIV:
+		return true;
+	default:
+		return !instr->hasSideEffects();
+	}
+}
+
+//Whether instr could stop the program. Those are only moved when
+// they would have run first thing on entering the loop anyway.
+static bool mayTrap(const IRInstr * instr){
+	return instr->op == IRInstr::LOAD
+		|| (instr->op == IRInstr::DIV && instr->hasSideEffects());
+}
+
+//Move the instructions whose operands don't change in the loop
+// to its preheader. Returns how many moved.
+static size_t hoist(const Loop& loop, const DomTree& dom,
+	const std::vector<IRInstr *>& defs,
+	const std::vector<bool>& pointedAt){
+	LoopEffects fx = {false, false, false, {}, {}};
+	for (IRBlock * block : loop.blocks){
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			if (instr->op == IRInstr::CALL){ fx.calls = true; }
+			if (instr->op == IRInstr::STORE){
+				fx.stores = true;
+				fx.pointerStores = true;
+			}
+			if (instr->op == IRInstr::STOREG){
+				fx.stores = true;
+				fx.storedGlobals.push_back(instr->index);
+			}
+			if (instr->op == IRInstr::STORET){
+				fx.storedTables.push_back(instr->index);
+			}
+		}
+	}
+	auto invariant = [&](const Operand& op){
+		if (!op.isReg()){ return true; }
+		IRInstr * def = defs[op.getReg()];
+		return def == nullptr || !loop.contains[def->block->id];
+	};
+
+	IRInstr * dest = loop.preheader->terminator();
+	size_t moved = 0;
+	//Parents come before children in the dominator tree, so an
+	// operand's definition has always been looked at before it is
+	for (IRBlock * block : dom.preorder()){
+		if (!loop.contains[block->id]){ continue; }
+		//Only the very start of the header is sure to run on
+		// entry, before anything else in the loop can have an
+		// effect
+		bool atEntry = block == loop.header;
+		IRInstr * next;
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = next){
+			next = instr->next;
+			bool canMove = instr->dst != NO_REG
+				&& movable(instr, fx, pointedAt)
+				&& (atEntry || !mayTrap(instr));
+			//Constants are left where they are used
+			if (instr->op == IRInstr::COPY && instr->a.isImm()){
+				canMove = false;
+			}
+			instr->forEachUse([&](Operand& use){
+				if (!invariant(use)){ canMove = false; }
+			});
+			if (canMove){
+				block->remove(instr);
+				loop.preheader->insertBefore(dest, instr);
+				moved++;
+				continue;
+			}
+			if (instr->op != IRInstr::PHI
+				&& (instr->hasSideEffects() || mayTrap(instr))){
+				atEntry = false;
+			}
+		}
+	}
+	return moved;
+}
+
+namespace {
+//A register that goes up (or down) by the same amount each time
+// around a loop: a phi in the header whose input from the latch
+// is the phi plus or minus something invariant
+struct Induction{
+	IRInstr * phi;
+	Operand start;
+	IRInstr * step;
+};
+//A register made to keep the induction variable times factor
+struct Scaled{
+	Reg var;
+	Operand factor;
+	Reg reg;
+};
+}
+
+//Turn multiplications of an induction variable by something
+// invariant into a register of their own, which is stepped
+// along with it by an addition. Only loops with a single latch
+// are looked at. Returns how many multiplications went.
+static size_t reduceStrength(IRFunction * fn, const Loop& loop,
+	std::vector<IRInstr *>& defs){
+	if (loop.latches.size() != 1){ return 0; }
+	IRBlock * header = loop.header;
+	IRBlock * latch = loop.latches[0];
+	auto invariant = [&](const Operand& op){
+		if (!op.isReg()){ return true; }
+		IRInstr * def = defs[op.getReg()];
+		return def == nullptr || !loop.contains[def->block->id];
+	};
+
+	std::vector<Induction> vars;
+	for (IRInstr * phi = header->first;
+		phi != nullptr && phi->op == IRInstr::PHI; phi = phi->next){
+		if (phi->numArgs != 2){ continue; }
+		uint32_t back = phi->blocks[0] == latch ? 0 : 1;
+		if (phi->blocks[back] != latch
+			|| phi->blocks[1 - back] != loop.preheader
+			|| !phi->args[back].isReg()){
+			continue;
+		}
+		IRInstr * step = defs[phi->args[back].getReg()];
+		if (step == nullptr || !loop.contains[step->block->id]){
+			continue;
+		}
+		Operand self = Operand::reg(phi->dst);
+		bool stepsSelf = (step->op == IRInstr::ADD && step->a == self
+			&& invariant(step->b))
+			|| (step->op == IRInstr::ADD && step->b == self
+			&& invariant(step->a))
+			|| (step->op == IRInstr::SUB && step->a == self
+			&& invariant(step->b));
+		if (stepsSelf){
+			vars.push_back({phi, phi->args[1 - back], step});
+		}
+	}
+	if (vars.empty()){ return 0; }
+
+	auto define = [&](IRInstr * instr){
+		defs.resize(fn->numRegs(), nullptr);
+		defs[instr->dst] = instr;
+	};
+	IRInstr * dest = loop.preheader->terminator();
+	//factor times op, computed ahead of the loop
+	auto times = [&](Operand op, Operand factor){
+		int64_t res;
+		if ((op.isImm() && op.getImm() == 0)
+			|| (factor.isImm() && factor.getImm() == 0)){
+			return Operand::imm(0);
+		}
+		if (op.isImm() && op.getImm() == 1){ return factor; }
+		if (factor.isImm() && factor.getImm() == 1){ return op; }
+		if (op.isImm() && factor.isImm()
+			&& IRInstr::fold(IRInstr::MUL, op.getImm(), factor.getImm(),
+			res)){
+			return Operand::imm(res);
+		}
+		IRInstr * mul = fn->newInstr(IRInstr::MUL);
+		mul->dst = fn->newReg();
+		mul->a = op;
+		mul->b = factor;
+		loop.preheader->insertBefore(dest, mul);
+		define(mul);
+		return Operand::reg(mul->dst);
+	};
+
+	std::vector<Scaled> made;
+	size_t reduced = 0;
+	for (IRBlock * block : loop.blocks){
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			if (instr->op != IRInstr::MUL){ continue; }
+			const Induction * var = nullptr;
+			Operand factor;
+			for (const Induction& v : vars){
+				Operand self = Operand::reg(v.phi->dst);
+				if (instr->a == self && invariant(instr->b)){
+					factor = instr->b;
+				} else if (instr->b == self && invariant(instr->a)){
+					factor = instr->a;
+				} else {
+					continue;
+				}
+				var = &v;
+				break;
+			}
+			if (var == nullptr){ continue; }
+
+			Reg reg = NO_REG;
+			for (const Scaled& s : made){
+				if (s.var == var->phi->dst && s.factor == factor){
+					reg = s.reg;
+				}
+			}
+			if (reg == NO_REG){
+				//reg = phi(start * factor, next), and next is
+				// reg stepped by step * factor, right where the
+				// induction variable itself is stepped
+				IRInstr * step = var->step;
+				Operand by = step->a == Operand::reg(var->phi->dst) ?
+					step->b : step->a;
+				IRInstr * phi = fn->newInstr(IRInstr::PHI);
+				reg = phi->dst = fn->newReg();
+				define(phi);
+				IRInstr * next = fn->newInstr(step->op);
+				next->dst = fn->newReg();
+				define(next);
+				next->a = Operand::reg(reg);
+				next->b = times(by, factor);
+				step->block->insertBefore(step->next, next);
+				fn->addArg(phi, times(var->start, factor),
+					loop.preheader);
+				fn->addArg(phi, Operand::reg(next->dst), latch);
+				header->insertBefore(header->first, phi);
+				made.push_back({var->phi->dst, factor, reg});
+			}
+			instr->makeCopy(Operand::reg(reg));
+			reduced++;
+		}
+	}
+	return reduced;
+}
+
+void optimizeLoops(IRFunction * fn, const std::vector<bool>& pointedAt,
+	OptReport& report){
+	if (!fn->ssa){
+		throw new InternalError("Loop optimization needs SSA form");
+	}
+	if (fn->blocks.empty()){ return; }
+	fn->rebuildEdges();
+
+	//Give every loop a preheader first, right before its header
+	// so that the blocks stay in source order, and then find the
+	// loops again in the new CFG
+	std::vector<IRBlock *> before(fn->blocks.size(), nullptr);
+	{
+		DomTree dom(fn);
+		for (const Loop& loop : findLoops(fn, dom)){
+			if (loop.header == fn->blocks[0]){ continue; }
+			before[loop.header->id] = makePreheader(fn, loop);
+		}
+	}
+	std::vector<IRBlock *> blocks = fn->blocks;
+	fn->blocks.clear();
+	for (size_t b = 0; b < blocks.size(); b++){
+		if (before[b] != nullptr){ fn->placeBlock(before[b]); }
+		fn->placeBlock(blocks[b]);
+	}
+	fn->rebuildEdges();
+
+	DomTree dom(fn);
+	std::vector<Loop> loops = findLoops(fn, dom);
+	std::vector<IRInstr *> defs(fn->numRegs(), nullptr);
+	for (IRBlock * block : fn->blocks){
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			if (instr->dst != NO_REG){ defs[instr->dst] = instr; }
+		}
+	}
+	size_t hoisted = 0;
+	size_t reduced = 0;
+	size_t found = 0;
+	for (Loop& loop : loops){
+		if (loop.header == fn->blocks[0]){ continue; }
+		for (IRBlock * pred : loop.header->preds){
+			if (!loop.contains[pred->id]){ loop.preheader = pred; }
+		}
+		found++;
+		hoisted += hoist(loop, dom, defs, pointedAt);
+		reduced += reduceStrength(fn, loop, defs);
+	}
+	report.add("loops", "loops found", found);
+	report.add("loops", "instructions hoisted", hoisted);
+	report.add("loops", "multiplications strength reduced", reduced);
+}
+
+}
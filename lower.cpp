@@ -0,0 +1,730 @@
+#include "ast.hpp"
+#include "ir.hpp"
+#include "pointsto.hpp"
+#include "symbol_table.hpp"
+#include "types.hpp"
+#include "walker.hpp"
+
+namespace lake{
+
+Lowering::Lowering(TypeAnalysis * taIn, const PointsTo * ptIn)
+: ta(taIn), pt(ptIn), prog(new IRProgram()), fn(nullptr), cur(nullptr),
+  addressNext(false), wanted(), taken(){ }
+
+Lowering::~Lowering(){
+	delete prog;
+}
+
+IRProgram * Lowering::finish(){
+	IRProgram * res = prog;
+	prog = nullptr;
+	return res;
+}
+
+void Lowering::beginFunction(SemSymbol * sym, bool returnsValue){
+	if (sym == nullptr){
+		throw new InternalError("Lowering an unchecked function");
+	}
+	fn = new IRFunction(sym->getName(), returnsValue);
+	functionIds[sym] = prog->addFunction(fn);
+	localRegs.clear();
+	setBlock(newBlock());
+}
+
+void Lowering::endFunction(){
+	//Falling off the end of a function returns, with 0 if it
+	// was meant to return something
+	if (cur != nullptr){
+		ret(fn->returnsValue ? Operand::imm(0) : Operand());
+	}
+	if (!values.empty() || !pending.empty() || !branches.empty()){
+		throw new InternalError("Unbalanced lowering");
+	}
+	fn->rebuildEdges();
+	fn = nullptr;
+	cur = nullptr;
+}
+
+void Lowering::addGlobal(SemSymbol * sym){
+	globalIds[sym] = prog->addGlobal(sym->getName(),
+		pt->addressTaken(sym));
+}
+
+Reg Lowering::addLocal(SemSymbol * sym){
+	if (pt->addressTaken(sym)){
+		throw new InternalError("A pointer may reach a local");
+	}
+	Reg var = fn->newReg(sym->getName());
+	localRegs[sym] = var;
+	//Locals start out as 0, like globals do
+	emit(IRInstr::COPY, var, Operand::imm(0));
+	return var;
+}
+
+void Lowering::addParam(SemSymbol * sym){
+	if (pt->addressTaken(sym)){
+		throw new InternalError("A pointer may reach a parameter");
+	}
+	Reg var = fn->newReg(sym->getName());
+	localRegs[sym] = var;
+	fn->params.push_back(var);
+}
+
+uint32_t Lowering::functionIndex(SemSymbol * sym){
+	auto found = functionIds.find(sym);
+	if (found == functionIds.end()){
+		throw new InternalError("Call to an unknown function");
+	}
+	return found->second;
+}
+
+void Lowering::setBlock(IRBlock * block){
+	if (block->id == UINT32_MAX){
+		fn->placeBlock(block);
+	}
+	cur = block;
+}
+
+IRInstr * Lowering::emit(IRInstr::Op op, Reg dst,
+	Operand a, Operand b){
+	if (cur == nullptr){
+		setBlock(newBlock());
+	}
+	IRInstr * instr = fn->newInstr(op);
+	instr->dst = dst;
+	instr->a = a;
+	instr->b = b;
+	cur->append(instr);
+	if (instr->isTerminator()){
+		cur = nullptr;
+	}
+	return instr;
+}
+
+Operand Lowering::compute(IRInstr::Op op, Operand a, Operand b){
+	Reg res = temp();
+	emit(op, res, a, b);
+	return Operand::reg(res);
+}
+
+void Lowering::jump(IRBlock * target){
+	//Nothing reaches the end of unreachable code
+	if (cur == nullptr){ return; }
+	IRInstr * instr = emit(IRInstr::JMP, NO_REG);
+	instr->targets[0] = target;
+}
+
+void Lowering::branch(Operand cond, IRBlock * ifTrue,
+	IRBlock * ifFalse){
+	IRInstr * instr = emit(IRInstr::BR, NO_REG, cond);
+	instr->targets[0] = ifTrue;
+	instr->targets[1] = ifFalse;
+}
+
+bool Lowering::takeBranch(ExpNode * cond){
+	if (wanted.cond != cond){ return false; }
+	branches.push_back(wanted);
+	wanted.cond = nullptr;
+	return true;
+}
+
+Lowering::Branch Lowering::endBranch(){
+	if (wanted.cond == nullptr){ return taken; }
+	Branch res = wanted;
+	wanted.cond = nullptr;
+	branch(pop(), res.ifTrue, res.ifFalse);
+	return res;
+}
+
+void Lowering::ret(Operand val){
+	emit(IRInstr::RET, NO_REG, val);
+}
+
+Operand Lowering::call(SemSymbol * fnSym,
+	const std::vector<Operand>& args){
+	const FnType * fnType = fnSym->getType()->asFn();
+	if (fnType == nullptr){
+		throw new InternalError("Call to a non-function");
+	}
+	bool returnsValue = !fnType->getReturnType()->isVoid();
+	Reg dst = returnsValue ? temp() : NO_REG;
+	IRInstr * instr = emit(IRInstr::CALL, dst);
+	instr->index = functionIndex(fnSym);
+	uint32_t numArgs = static_cast<uint32_t>(args.size());
+	fn->reserveArgs(instr, numArgs, false);
+	for (uint32_t i = 0; i < numArgs; i++){
+		instr->args[i] = args[i];
+	}
+	instr->numArgs = numArgs;
+	return returnsValue ? Operand::reg(dst) : Operand();
+}
+
+Operand Lowering::readVar(IdNode * id){
+	SemSymbol * sym = id->getSymbol();
+	auto local = localRegs.find(sym);
+	if (local != localRegs.end()){
+		return Operand::reg(local->second);
+	}
+	auto global = globalIds.find(sym);
+	if (global == globalIds.end()){
+		throw new InternalError("Lowering an unresolved name");
+	}
+	Reg res = temp();
+	IRInstr * instr = emit(IRInstr::LOADG, res);
+	instr->index = global->second;
+	return Operand::reg(res);
+}
+
+Operand Lowering::load(ExpNode * loc, Operand addr){
+	IdNode * id = dynamic_cast<IdNode *>(loc);
+	if (id != nullptr){
+		return readVar(id);
+	}
+	return compute(IRInstr::LOAD, addr);
+}
+
+Operand Lowering::store(ExpNode * loc, Operand addr, Operand val){
+	IdNode * id = dynamic_cast<IdNode *>(loc);
+	if (id == nullptr){
+		emit(IRInstr::STORE, NO_REG, addr, val);
+		return val;
+	}
+	SemSymbol * sym = id->getSymbol();
+	auto local = localRegs.find(sym);
+	if (local != localRegs.end()){
+		return writeVar(local->second, val);
+	}
+	auto global = globalIds.find(sym);
+	if (global == globalIds.end()){
+		throw new InternalError("Lowering an unresolved name");
+	}
+	IRInstr * instr = emit(IRInstr::STOREG, NO_REG, val);
+	instr->index = global->second;
+	return val;
+}
+
+Operand Lowering::writeVar(Reg var, Operand val){
+	//A variable that is an operand still waiting to be used
+	// (as in x + (x = 1)) must be read before it changes
+	for (Operand& waiting : values){
+		if (waiting == Operand::reg(var)){
+			waiting = compute(IRInstr::COPY, waiting);
+		}
+	}
+	//If val was just computed into a temporary, compute it
+	// into the variable instead
+	if (val.isReg() && !fn->isVariable(val.getReg())
+		&& cur != nullptr && cur->last != nullptr
+		&& cur->last->dst == val.getReg()){
+		cur->last->dst = var;
+		return Operand::reg(var);
+	}
+	emit(IRInstr::COPY, var, val);
+	return val;
+}
+
+namespace {
+//Hands each node's lowering hooks the Lowering object. The
+// walk's context is unused.
+class LowerVisitor : public ASTVisitor{
+public:
+	LowerVisitor(Lowering * lwIn) : lw(lwIn){ }
+	bool pre(ASTNode * node, int) override {
+		return node->lowerPre(lw);
+	}
+	bool between(ASTNode * node, size_t i, int, int&) override {
+		return node->lowerBetween(lw, i);
+	}
+	void post(ASTNode * node, int) override {
+		node->lowerPost(lw);
+	}
+private:
+	Lowering * lw;
+};
+}
+
+//Lowering expects a tree that passed type analysis, with the
+// TypeAnalysis that checked it
+void ASTNode::lower(Lowering * lw){
+	LowerVisitor visitor(lw);
+	walk(this, visitor);
+}
+
+bool VarDeclNode::lowerPre(Lowering * lw){
+	SemSymbol * sym = myID->getSymbol();
+	if (sym == nullptr){
+		throw new InternalError("Lowering an unchecked declaration");
+	}
+	if (lw->inFunction()){
+		lw->addLocal(sym);
+	} else {
+		lw->addGlobal(sym);
+	}
+	return false;
+}
+
+bool FnDeclNode::lowerPre(Lowering * lw){
+	lw->beginFunction(myID->getSymbol(),
+		!myRetAST->getDataType()->isVoid());
+	return true;
+}
+
+bool FnDeclNode::lowerBetween(Lowering * lw, size_t i){
+	//Only the formals and the body generate anything
+	return i >= 2;
+}
+
+void FnDeclNode::lowerPost(Lowering * lw){
+	lw->endFunction();
+}
+
+bool FormalDeclNode::lowerPre(Lowering * lw){
+	SemSymbol * sym = myID->getSymbol();
+	if (sym == nullptr){
+		throw new InternalError("Lowering an unchecked formal");
+	}
+	lw->addParam(sym);
+	return false;
+}
+
+void AssignStmtNode::lowerPost(Lowering * lw){
+	lw->pop();
+}
+
+bool PostIncStmtNode::lowerPre(Lowering * lw){
+	lw->wantAddress();
+	return true;
+}
+
+void PostIncStmtNode::lowerPost(Lowering * lw){
+	Operand addr = lw->pop();
+	Operand old = lw->load(myExp, addr);
+	lw->store(myExp, addr,
+		lw->compute(IRInstr::ADD, old, Operand::imm(1)));
+}
+
+bool PostDecStmtNode::lowerPre(Lowering * lw){
+	lw->wantAddress();
+	return true;
+}
+
+void PostDecStmtNode::lowerPost(Lowering * lw){
+	Operand addr = lw->pop();
+	Operand old = lw->load(myExp, addr);
+	lw->store(myExp, addr,
+		lw->compute(IRInstr::SUB, old, Operand::imm(1)));
+}
+
+bool ReadStmtNode::lowerPre(Lowering * lw){
+	lw->wantAddress();
+	return true;
+}
+
+void ReadStmtNode::lowerPost(Lowering * lw){
+	Operand addr = lw->pop();
+	bool isBool = lw->types()->nodeType(myExp)->isBool();
+	Operand val = lw->compute(
+		isBool ? IRInstr::READ_BOOL : IRInstr::READ_INT,
+		Operand());
+	lw->store(myExp, addr, val);
+}
+
+void WriteStmtNode::lowerPost(Lowering * lw){
+	Operand val = lw->pop();
+	const DataType * type = lw->types()->nodeType(myExp);
+	const VarType * varType = type->asVar();
+	IRInstr::Op op = IRInstr::WRITE_INT;
+	if (type->isBool()){
+		op = IRInstr::WRITE_BOOL;
+	} else if (varType != nullptr && !varType->isPtr()
+		&& varType->getBaseType() == BaseType::STR){
+		op = IRInstr::WRITE_STR;
+	}
+	lw->emit(op, NO_REG, val);
+}
+
+//The declarations inside an if or while body are skipped, as
+// they are by name analysis
+bool IfStmtNode::lowerBetween(Lowering * lw, size_t i){
+	if (i == 0){
+		IRBlock * after = lw->newBlock();
+		lw->wantBranch(myExp, lw->newBlock(), after);
+		lw->pushPending({after, nullptr, NO_REG});
+		return true;
+	}
+	if (i == 1){
+		lw->setBlock(lw->endBranch().ifTrue);
+		return false;
+	}
+	return true;
+}
+
+void IfStmtNode::lowerPost(Lowering * lw){
+	IRBlock * after = lw->topPending().blockA;
+	lw->popPending();
+	lw->jump(after);
+	lw->setBlock(after);
+}
+
+bool IfElseStmtNode::lowerBetween(Lowering * lw, size_t i){
+	if (i == 0){
+		IRBlock * elseBlock = lw->newBlock();
+		lw->wantBranch(myExp, lw->newBlock(), elseBlock);
+		lw->pushPending({elseBlock, lw->newBlock(), NO_REG});
+		return true;
+	}
+	if (i == 1){
+		lw->setBlock(lw->endBranch().ifTrue);
+		return false;
+	}
+	if (i == 3){
+		Lowering::Pending& p = lw->topPending();
+		lw->jump(p.blockB);
+		lw->setBlock(p.blockA);
+		return false;
+	}
+	return true;
+}
+
+void IfElseStmtNode::lowerPost(Lowering * lw){
+	IRBlock * after = lw->topPending().blockB;
+	lw->popPending();
+	lw->jump(after);
+	lw->setBlock(after);
+}
+
+bool WhileStmtNode::lowerPre(Lowering * lw){
+	IRBlock * header = lw->newBlock();
+	lw->jump(header);
+	lw->setBlock(header);
+	lw->pushPending({header, nullptr, NO_REG});
+	return true;
+}
+
+bool WhileStmtNode::lowerBetween(Lowering * lw, size_t i){
+	if (i == 0){
+		IRBlock * after = lw->newBlock();
+		lw->wantBranch(myExp, lw->newBlock(), after);
+		lw->topPending().blockB = after;
+		return true;
+	}
+	if (i == 1){
+		lw->setBlock(lw->endBranch().ifTrue);
+		return false;
+	}
+	return true;
+}
+
+void WhileStmtNode::lowerPost(Lowering * lw){
+	Lowering::Pending p = lw->topPending();
+	lw->popPending();
+	lw->jump(p.blockA);
+	lw->setBlock(p.blockB);
+}
+
+void CallStmtNode::lowerPost(Lowering * lw){
+	lw->pop();
+}
+
+void ReturnStmtNode::lowerPost(Lowering * lw){
+	//A void function may return the "value" of a void call,
+	// which is no operand at all
+	Operand val = myExp == nullptr ? Operand() : lw->pop();
+	lw->ret(val);
+}
+
+bool DerefNode::lowerPre(Lowering * lw){
+	//The pointer itself is always needed as a value
+	lw->derefAddress.push_back(lw->takeAddress());
+	return true;
+}
+
+void DerefNode::lowerPost(Lowering * lw){
+	Operand ptr = lw->pop();
+	bool isAddress = lw->derefAddress.back();
+	lw->derefAddress.pop_back();
+	if (isAddress){
+		lw->push(ptr);
+	} else {
+		lw->push(lw->compute(IRInstr::LOAD, ptr));
+	}
+}
+
+bool IdNode::lowerPre(Lowering * lw){
+	if (lw->takeAddress()){
+		//The parent stores to the variable through this node
+		lw->push(Operand());
+	} else {
+		lw->push(lw->readVar(this));
+	}
+	return false;
+}
+
+bool IntLitNode::lowerPre(Lowering * lw){
+	lw->push(Operand::imm(myInt));
+	return false;
+}
+
+std::string unescape(const std::string& lit){
+	std::string res;
+	size_t end = lit.size();
+	if (end > 1 && lit[end - 1] == '"'){ end--; }
+	for (size_t i = 1; i < end; i++){
+		char c = lit[i];
+		if (c == '\\' && i + 1 < end){
+			i++;
+			switch (lit[i]){
+			case 'n': c = '\n'; break;
+			case 't': c = '\t'; break;
+			default: c = lit[i];
+			}
+		}
+		res += c;
+	}
+	return res;
+}
+
+bool StrLitNode::lowerPre(Lowering * lw){
+	uint32_t id = lw->internString(unescape(myString));
+	lw->push(Operand::imm(id));
+	return false;
+}
+
+//A constant condition just goes where it always goes
+bool TrueNode::lowerPre(Lowering * lw){
+	if (lw->takeBranch(this)){
+		lw->jump(lw->topBranch().ifTrue);
+		lw->popBranch();
+		return false;
+	}
+	lw->push(Operand::imm(1));
+	return false;
+}
+
+bool FalseNode::lowerPre(Lowering * lw){
+	if (lw->takeBranch(this)){
+		lw->jump(lw->topBranch().ifFalse);
+		lw->popBranch();
+		return false;
+	}
+	lw->push(Operand::imm(0));
+	return false;
+}
+
+bool AssignNode::lowerBetween(Lowering * lw, size_t i){
+	if (i == 0){ lw->wantAddress(); }
+	return true;
+}
+
+void AssignNode::lowerPost(Lowering * lw){
+	Operand val = lw->pop();
+	Operand addr = lw->pop();
+	lw->push(lw->store(myTgt, addr, val));
+}
+
+bool CallExpNode::lowerBetween(Lowering * lw, size_t i){
+	//The callee's name is not evaluated, and a folded call's
+	// arguments are not needed
+	return i == 1 && !myFolded;
+}
+
+void CallExpNode::lowerPost(Lowering * lw){
+	if (myFolded){
+		lw->push(Operand::imm(myFoldedVal));
+		return;
+	}
+	std::vector<Operand> args(myExpList->size());
+	for (size_t i = args.size(); i > 0; i--){
+		args[i - 1] = lw->pop();
+	}
+	lw->push(lw->call(myId->getSymbol(), args));
+}
+
+static void unary(Lowering * lw, IRInstr::Op op){
+	lw->push(lw->compute(op, lw->pop()));
+}
+
+static void binary(Lowering * lw, IRInstr::Op op){
+	Operand rhs = lw->pop();
+	Operand lhs = lw->pop();
+	lw->push(lw->compute(op, lhs, rhs));
+}
+
+void UnaryMinusNode::lowerPost(Lowering * lw){
+	unary(lw, IRInstr::NEG);
+}
+
+//!c as a branch is c with its targets swapped
+bool NotNode::lowerPre(Lowering * lw){
+	if (lw->takeBranch(this)){
+		Lowering::Branch& b = lw->topBranch();
+		lw->wantBranch(myExp, b.ifFalse, b.ifTrue);
+	}
+	return true;
+}
+
+void NotNode::lowerPost(Lowering * lw){
+	if (lw->branching(this)){
+		lw->endBranch();
+		lw->popBranch();
+		return;
+	}
+	unary(lw, IRInstr::NOT);
+}
+
+void MinusNode::lowerPost(Lowering * lw){
+	binary(lw, IRInstr::SUB);
+}
+
+void DivideNode::lowerPost(Lowering * lw){
+	binary(lw, IRInstr::DIV);
+}
+
+void EqualsNode::lowerPost(Lowering * lw){
+	binary(lw, IRInstr::EQ);
+}
+
+void NotEqualsNode::lowerPost(Lowering * lw){
+	binary(lw, IRInstr::NE);
+}
+
+void LessNode::lowerPost(Lowering * lw){
+	binary(lw, IRInstr::LT);
+}
+
+void GreaterNode::lowerPost(Lowering * lw){
+	binary(lw, IRInstr::GT);
+}
+
+void LessEqNode::lowerPost(Lowering * lw){
+	binary(lw, IRInstr::LE);
+}
+
+void GreaterEqNode::lowerPost(Lowering * lw){
+	binary(lw, IRInstr::GE);
+}
+
+//As in type analysis, a chain's operators are done left to
+// right, each as soon as its right operand is
+bool ChainExpNode::lowerBetween(Lowering * lw, size_t i){
+	if (i >= 2){ lowerOperator(lw); }
+	return true;
+}
+
+void ChainExpNode::lowerPost(Lowering * lw){
+	lowerOperator(lw);
+}
+
+void ChainExpNode::lowerOperator(Lowering * lw){
+	throw new InternalError("Chain without an operator");
+}
+
+void PlusNode::lowerOperator(Lowering * lw){
+	binary(lw, IRInstr::ADD);
+}
+
+void TimesNode::lowerOperator(Lowering * lw){
+	binary(lw, IRInstr::MUL);
+}
+
+//a and b and c is evaluated into one register: each operand in
+// turn is copied into it, and control goes on to the next one
+// only while the result is still undecided. Every way out meets
+// in the same block.
+static void shortCircuitBetween(Lowering * lw, size_t i, bool isAnd){
+	if (i == 0){ return; }
+	Operand val = lw->pop();
+	if (i == 1){
+		lw->pushPending({lw->newBlock(), nullptr, lw->temp()});
+	}
+	Lowering::Pending p = lw->topPending();
+	lw->emit(IRInstr::COPY, p.reg, val);
+	IRBlock * next = lw->newBlock();
+	if (isAnd){
+		lw->branch(Operand::reg(p.reg), next, p.blockA);
+	} else {
+		lw->branch(Operand::reg(p.reg), p.blockA, next);
+	}
+	lw->setBlock(next);
+}
+
+static void shortCircuitPost(Lowering * lw){
+	Operand val = lw->pop();
+	Lowering::Pending p = lw->topPending();
+	lw->popPending();
+	lw->emit(IRInstr::COPY, p.reg, val);
+	lw->jump(p.blockA);
+	lw->setBlock(p.blockA);
+	lw->push(Operand::reg(p.reg));
+}
+
+//As a branch, a and b and c is a chain of conditions: each
+// operand goes on to the next one while the result is still
+// undecided, and straight to the chain's false block once it is
+// decided. Nothing is computed into a register.
+static void branchChainBetween(Lowering * lw, size_t i, ExpNode * operand,
+	bool last, bool isAnd){
+	if (i > 0){
+		lw->endBranch();
+		lw->setBlock(lw->topBranch().next);
+	}
+	Lowering::Branch& b = lw->topBranch();
+	if (last){
+		lw->wantBranch(operand, b.ifTrue, b.ifFalse);
+		return;
+	}
+	b.next = lw->newBlock();
+	if (isAnd){
+		lw->wantBranch(operand, b.next, b.ifFalse);
+	} else {
+		lw->wantBranch(operand, b.ifTrue, b.next);
+	}
+}
+
+bool AndNode::lowerPre(Lowering * lw){
+	lw->takeBranch(this);
+	return true;
+}
+
+bool AndNode::lowerBetween(Lowering * lw, size_t i){
+	if (lw->branching(this)){
+		branchChainBetween(lw, i, myExps[i], i + 1 == myExps.size(), true);
+	} else {
+		shortCircuitBetween(lw, i, true);
+	}
+	return true;
+}
+
+void AndNode::lowerPost(Lowering * lw){
+	if (lw->branching(this)){
+		lw->endBranch();
+		lw->popBranch();
+	} else {
+		shortCircuitPost(lw);
+	}
+}
+
+bool OrNode::lowerPre(Lowering * lw){
+	lw->takeBranch(this);
+	return true;
+}
+
+bool OrNode::lowerBetween(Lowering * lw, size_t i){
+	if (lw->branching(this)){
+		branchChainBetween(lw, i, myExps[i], i + 1 == myExps.size(), false);
+	} else {
+		shortCircuitBetween(lw, i, false);
+	}
+	return true;
+}
+
+void OrNode::lowerPost(Lowering * lw){
+	if (lw->branching(this)){
+		lw->endBranch();
+		lw->popBranch();
+	} else {
+		shortCircuitPost(lw);
+	}
+}
+
+}
@@ -1,10 +1,23 @@
 #include <iostream>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <thread>
 #include "scanner.hpp"
 #include "symbol_table.hpp"
 #include "types.hpp"
+#include "streaming.hpp"
+#include "ir.hpp"
+#include "ssa.hpp"
+#include "opt.hpp"
+#include "x86.hpp"
+#include "vm.hpp"
+#include "eval.hpp"
+#include "purity.hpp"
+#include "consteval.hpp"
+#include "pointsto.hpp"
+#include "callgraph.hpp"
 
 using namespace lake;
 
@@ -14,6 +27,21 @@ static void usageAndDie(){
 	<< " [-p <unparseFile>]"
 	<< " [-n <nameAnalysisFile>]"
 	<< " [-c]"
+	<< " [-f]"
+	<< " [-s]"
+	<< " [-i <irFile>]"
+	<< " [-S <ssaFile>]"
+	<< " [-O]"
+	<< " [-r <reportFile>]"
+	<< " [-a <asmFile>]"
+	<< " [-o <objFile>]"
+	<< " [-b <bytecodeFile>]"
+	<< " [--run]"
+	<< " [--walk]"
+	<< " [--jit]"
+	<< " [--memo]"
+	<< " [--prune]"
+	<< " [-j <threads>]"
 	<< "\n"
 	;
 	exit(1);
@@ -27,15 +55,41 @@ static ProgramNode * parse(const char * inFile){
 		throw new InternalError(msg.c_str());
 	}
 
+	SourceMap::reset();
 	lake::Scanner scanner(&inStream);
 	ProgramNode * root = NULL;
-	lake::Parser parser(scanner, &root);
+	lake::Parser parser(scanner, &root, nullptr);
 	int errCode = parser.parse();
 	if (errCode != 0){ return NULL; }
 
 	return root;
 }
 
+static bool streamCheck(const char * inFile){
+	std::ifstream inStream(inFile);
+	if (!inStream.good()){
+		std::string msg = "Bad input stream ";
+		msg += inFile;
+		throw new InternalError(msg.c_str());
+	}
+
+	SourceMap::reset();
+	lake::Scanner scanner(&inStream);
+	StreamingAnalysis analysis(&scanner);
+	ProgramNode * root = NULL;
+	lake::Parser parser(scanner, &root, &analysis);
+	int errCode = parser.parse();
+	if (errCode != 0){ 
+		std::cerr << "Parsing failed\n";
+		exit(1);
+	}
+	//Every decl has already been handed to the analysis, so
+	// the program node is just an empty shell
+	deleteAST(root);
+
+	return analysis.finish();
+}
+
 static void writeTokenStream(const char * inPath, const char * outPath){
 	std::ifstream inStream(inPath);
 	if (!inStream.good()){
@@ -48,6 +102,7 @@ static void writeTokenStream(const char * inPath, const char * outPath){
 		throw new InternalError(msg.c_str());
 	}
 
+	SourceMap::reset();
 	Scanner scanner(&inStream);
 	if (strcmp(outPath, "--") == 0){
 		scanner.outputTokens(std::cout);
@@ -76,6 +131,170 @@ static void unparse(ASTNode * astRoot, const char * outFile){
 	}
 }
 
+//Parses, name checks and type checks the program, and stops
+// lakec if any of that fails. Later stages only ever see
+// programs that made it through. With pruned given, functions
+// main can't reach are dropped before type checking, and their
+// names put there.
+static ProgramNode * checkedProgram(const char * inFile, 
+	TypeAnalysis ** taOut, std::vector<std::string> * pruned){
+	ProgramNode * astRoot = parse(inFile);
+	if (astRoot == NULL){
+		std::cerr << "Parsing failed\n";
+		exit(1);
+	}
+	SymbolTable * symTab = new SymbolTable();
+	if (!astRoot->nameAnalysis(symTab)){
+		std::cerr << "Name analysis Failed\n";
+		exit(1);
+	}
+	if (pruned != nullptr){
+		*pruned = pruneUnreachable(astRoot);
+	}
+	TypeAnalysis * typeAnalysis = new TypeAnalysis();
+	astRoot->typeAnalysis(typeAnalysis);
+	if (!typeAnalysis->passed()){
+		std::cerr << "Type checking failed\n";
+		exit(1);
+	}
+	*taOut = typeAnalysis;
+	return astRoot;
+}
+
+//With fold set, calls to pure functions on constants are worked
+// out before lowering. pure, if given, is filled with the pure
+// functions' names. With prune set, only the functions main can
+// reach are compiled. Whole-program analyses use up to threads
+// threads.
+static IRProgram * lowerProgram(const char * inFile, bool fold,
+	bool prune, unsigned threads, std::vector<std::string> * pure,
+	OptReport& report){
+	TypeAnalysis * typeAnalysis = nullptr;
+	std::vector<std::string> pruned;
+	ProgramNode * astRoot = checkedProgram(inFile, &typeAnalysis,
+		prune ? &pruned : nullptr);
+	if (prune){
+		report.add("prune", "unreachable functions removed",
+			pruned.size());
+		for (const std::string& name : pruned){
+			report.note("prune", "removed " + name);
+		}
+	}
+	std::vector<std::string> found;
+	if (fold || pure != nullptr){
+		found = findPureFunctions(astRoot, threads);
+	}
+	if (fold){
+		report.add("consteval", "calls folded",
+			foldConstantCalls(astRoot, typeAnalysis, found));
+	}
+	if (pure != nullptr){
+		*pure = found;
+	}
+	PointsTo pointsTo(astRoot, typeAnalysis);
+	report.add("pointsto", "dereferences", pointsTo.numDerefs());
+	report.add("pointsto", "dereferences that can only be of null",
+		pointsTo.numNullDerefs());
+	Lowering lowering(typeAnalysis, &pointsTo);
+	astRoot->lower(&lowering);
+	return lowering.finish();
+}
+
+static void writeIR(IRProgram * prog, const char * outFile){
+	if (outFile == nullptr){
+		throw new InternalError("Null IR file given");
+	}
+	if (strcmp(outFile, "--") == 0){
+		prog->dump(std::cout);
+	} else {
+		std::ofstream outStream(outFile);
+		prog->dump(outStream);
+		outStream.close();
+	}
+}
+
+//Generate x86-64 code, as assembly and/or as an ELF object, to
+// be linked with runtime/lake_runtime.c. Registers are only
+// allocated when optimizing.
+static void writeMachineCode(IRProgram * prog, const char * asmFile,
+	const char * objFile, bool allocate, OptReport * report){
+	X86Module * mod = genX86(prog, allocate, report);
+	if (asmFile != NULL && strcmp(asmFile, "--") == 0){
+		mod->writeAsm(std::cout);
+	} else if (asmFile != NULL){
+		std::ofstream outStream(asmFile);
+		mod->writeAsm(outStream);
+		outStream.close();
+	}
+	if (objFile != NULL){
+		std::ofstream outStream(objFile, std::ios::binary);
+		mod->writeObject(outStream);
+		outStream.close();
+	}
+	delete mod;
+}
+
+//Compile to bytecode and/or run it in the VM, and return what
+// the program's main returns
+static int64_t runBytecodeVM(IRProgram * prog, const char * bcFile,
+	bool doRun){
+	Bytecode * bc = compileBytecode(prog);
+	if (bcFile != NULL && strcmp(bcFile, "--") == 0){
+		bc->dump(std::cout);
+	} else if (bcFile != NULL){
+		std::ofstream outStream(bcFile);
+		bc->dump(outStream);
+		outStream.close();
+	}
+	int64_t res = doRun ? runBytecode(*bc) : 0;
+	delete bc;
+	return res;
+}
+
+//Say what the optimizer did
+static void writeReport(const OptReport& report, const char * outFile){
+	if (strcmp(outFile, "--") == 0){
+		report.write(std::cout);
+	} else {
+		std::ofstream outStream(outFile);
+		report.write(outStream);
+		outStream.close();
+	}
+}
+
+//Put every function in SSA form and check the result. The dump
+// notes each block's immediate dominator.
+static void writeSSA(IRProgram * prog, const char * outFile){
+	if (outFile == nullptr){
+		throw new InternalError("Null SSA file given");
+	}
+	HashMap<const IRFunction *, DomTree *> doms;
+	for (IRFunction * fn : prog->functions){
+		buildSSA(fn);
+		std::stringstream errs;
+		if (!verifySSA(fn, errs)){
+			std::string msg = "Bad SSA form\n" + errs.str();
+			throw new InternalError(msg.c_str());
+		}
+		doms[fn] = new DomTree(fn);
+	}
+	auto note = [&](const IRBlock * block){
+		IRBlock * idom = doms[block->fn]->idom(block);
+		return idom == nullptr ? std::string("entry") 
+			: "idom " + idom->label();
+	};
+	if (strcmp(outFile, "--") == 0){
+		prog->dump(std::cout, note);
+	} else {
+		std::ofstream outStream(outFile);
+		prog->dump(outStream, note);
+		outStream.close();
+	}
+	for (auto entry : doms){
+		delete entry.second;
+	}
+}
+
 int 
 main( const int argc, const char **argv )
 {
@@ -87,6 +306,22 @@ main( const int argc, const char **argv )
 	const char * unparseFile = NULL;
 	const char * nameAnalysisFile = NULL;
 	bool doTypeChecking = false;
+	bool doFusedChecking = false;
+	bool doStreamChecking = false;
+	const char * irFile = NULL;
+	const char * ssaFile = NULL;
+	bool doOptimize = false;
+	const char * reportFile = NULL;
+	const char * asmFile = NULL;
+	const char * objFile = NULL;
+	const char * bytecodeFile = NULL;
+	bool doRun = false;
+	bool doWalk = false;
+	bool doJit = false;
+	bool doMemo = false;
+	bool doPrune = false;
+	//As many as there are cores, unless -j says otherwise
+	unsigned threads = std::thread::hardware_concurrency();
 	const char * flattenFile = NULL;
 	const char * outputFile = NULL;
 	bool verbose = false;
@@ -107,9 +342,65 @@ main( const int argc, const char **argv )
 				nameAnalysisFile = argv[i];
 				useful = true;
 			} else if (argv[i][1] == 'c'){
-				i++;
 				doTypeChecking = true;
 				useful = true;
+			} else if (argv[i][1] == 'f'){
+				doFusedChecking = true;
+				useful = true;
+			} else if (argv[i][1] == 's'){
+				doStreamChecking = true;
+				useful = true;
+			} else if (argv[i][1] == 'i'){
+				i++;
+				irFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 'S'){
+				i++;
+				ssaFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 'O'){
+				doOptimize = true;
+				useful = true;
+			} else if (argv[i][1] == 'r'){
+				i++;
+				reportFile = argv[i];
+				doOptimize = true;
+				useful = true;
+			} else if (argv[i][1] == 'a'){
+				i++;
+				asmFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 'o'){
+				i++;
+				objFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 'b'){
+				i++;
+				bytecodeFile = argv[i];
+				useful = true;
+			} else if (argv[i][1] == 'j'){
+				//Only changes how many threads the work is spread
+				// over, never what comes out
+				i++;
+				if (i == argc){ usageAndDie(); }
+				threads = static_cast<unsigned>(strtoul(argv[i],
+					nullptr, 10));
+			} else if (strcmp(argv[i], "--run") == 0){
+				doRun = true;
+				useful = true;
+			} else if (strcmp(argv[i], "--walk") == 0){
+				doWalk = true;
+				useful = true;
+			} else if (strcmp(argv[i], "--jit") == 0){
+				doJit = true;
+				useful = true;
+			} else if (strcmp(argv[i], "--memo") == 0){
+				//Only changes how the code is generated
+				doMemo = true;
+			} else if (strcmp(argv[i], "--prune") == 0){
+				//Only changes how much of the program is checked
+				// and compiled
+				doPrune = true;
 			} 
 		} else {
 			if (inFile == NULL){
@@ -183,6 +474,9 @@ main( const int argc, const char **argv )
 				std::cerr << "Name analysis Failed\n";
 				exit(1);
 			}
+			if (doPrune){
+				pruneUnreachable(static_cast<ProgramNode *>(astRoot));
+			}
 
 			TypeAnalysis * typeAnalysis = new TypeAnalysis();
 			static_cast<ProgramNode *>(astRoot)->typeAnalysis(typeAnalysis);
@@ -197,5 +491,116 @@ main( const int argc, const char **argv )
 			exit(1);
 		}
 	}
+	if (doFusedChecking){
+		try {
+			ASTNode * astRoot = parse(inFile);
+			if (astRoot == NULL){
+				std::cerr << "Parsing failed\n";
+				exit(1);
+			}
+			//Same checks as -c, but names are resolved during
+			// the type analysis traversal instead of in a pass
+			// of their own
+			SymbolTable * symTab = new SymbolTable();
+			TypeAnalysis * typeAnalysis = new TypeAnalysis(symTab);
+			static_cast<ProgramNode *>(astRoot)->typeAnalysis(typeAnalysis);
+			if (!typeAnalysis->namesPassed()){
+				std::cerr << "Name analysis Failed\n";
+				exit(1);
+			}
+			typeAnalysis->flushErrors();
+			if (!typeAnalysis->passed()){
+				std::cerr << "Type checking failed\n";
+			}
+		} catch (ToDoError * e){
+			std::cerr << "ToDo: " << e->what() << std::endl;
+			exit(1);
+		} catch (InternalError * e){
+			std::cerr << "Compiler is Broken! " << e->what() << std::endl;
+			exit(1);
+		}
+	}
+	if (doStreamChecking){
+		try {
+			//Same checks as -f, but each top-level decl is
+			// checked and freed as soon as it has been parsed
+			if (!streamCheck(inFile)){
+				exit(1);
+			}
+		} catch (ToDoError * e){
+			std::cerr << "ToDo: " << e->what() << std::endl;
+			exit(1);
+		} catch (InternalError * e){
+			std::cerr << "Compiler is Broken! " << e->what() << std::endl;
+			exit(1);
+		}
+	}
+	if (irFile != NULL || ssaFile != NULL || doOptimize
+		|| reportFile != NULL || asmFile != NULL || objFile != NULL
+		|| bytecodeFile != NULL || doRun || doJit){
+		try {
+			std::vector<std::string> pure;
+			OptReport report;
+			IRProgram * prog = lowerProgram(inFile, doOptimize, doPrune,
+				threads, doMemo ? &pure : nullptr, report);
+			if (doMemo){
+				memoizeFunctions(prog, pure, report);
+			}
+			if (doOptimize){
+				optimize(prog, report);
+			}
+			if (irFile != NULL){
+				writeIR(prog, irFile);
+			}
+			if (ssaFile != NULL){
+				writeSSA(prog, ssaFile);
+			}
+			if (asmFile != NULL || objFile != NULL){
+				writeMachineCode(prog, asmFile, objFile, doOptimize,
+					&report);
+			}
+			if (reportFile != NULL){
+				writeReport(report, reportFile);
+			}
+			if (bytecodeFile != NULL || doRun){
+				retCode = static_cast<int>(
+					runBytecodeVM(prog, bytecodeFile, doRun));
+			}
+			if (doJit){
+				X86Module * mod = genX86(prog, doOptimize, nullptr);
+				retCode = static_cast<int>(mod->run());
+				delete mod;
+			}
+			delete prog;
+		} catch (ToDoError * e){
+			std::cerr << "ToDo: " << e->what() << std::endl;
+			exit(1);
+		} catch (InternalError * e){
+			std::cerr << "Compiler is Broken! " << e->what() << std::endl;
+			exit(1);
+		} catch (RuntimeError * e){
+			fflush(stdout);
+			std::cerr << "Runtime error: " << e->what() << std::endl;
+			exit(1);
+		}
+	}
+	if (doWalk){
+		try {
+			TypeAnalysis * typeAnalysis = nullptr;
+			std::vector<std::string> pruned;
+			ProgramNode * astRoot = checkedProgram(inFile, 
+				&typeAnalysis, doPrune ? &pruned : nullptr);
+			Evaluator evaluator(astRoot, typeAnalysis);
+			retCode = static_cast<int>(evaluator.run());
+		} catch (InternalError * e){
+			std::cerr << "Compiler is Broken! " << e->what() << std::endl;
+			exit(1);
+		} catch (RuntimeError * e){
+			fflush(stdout);
+			std::cerr << "Runtime error: " << e->what() << std::endl;
+			exit(1);
+		}
+	}
+	fflush(stdout);
 	return retCode;
 }
@@ -0,0 +1,209 @@
+#include "opt.hpp"
+
+namespace lake{
+
+//Each memo table has this many entries, one per hash of the
+// arguments, so it never takes more than 48K words whatever the
+// program does. A new result evicts whatever had its entry.
+static const uint32_t MEMO_BITS = 12;
+static const uint32_t MEMO_SLOTS = 1 << MEMO_BITS;
+//Only functions with up to this many parameters are memoized
+static const size_t MAX_KEYS = 4;
+
+//Whether a call could cost more than a lookup: it calls out, or
+// loops. Edges must be up to date.
+static bool worthMemoizing(IRFunction * fn){
+	for (IRBlock * block : fn->blocks){
+		for (IRBlock * succ : block->succs){
+			if (succ->id <= block->id){ return true; }
+		}
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			if (instr->op == IRInstr::CALL){ return true; }
+		}
+	}
+	return false;
+}
+
+namespace {
+//Puts a memo table in front of one function. An entry is k + 2
+// words: whether it is in use, the k arguments it is for, and
+// the result.
+class Memoizer{
+public:
+	Memoizer(IRProgram * progIn, IRFunction * fnIn)
+	: prog(progIn), fn(fnIn), table(0), base(NO_REG){ }
+	void memoize();
+private:
+	Reg compute(IRBlock * block, IRInstr::Op op, Operand a,
+		Operand b){
+		IRInstr * instr = fn->newInstr(op);
+		instr->dst = fn->newReg();
+		instr->a = a;
+		instr->b = b;
+		block->append(instr);
+		return instr->dst;
+	}
+	//The register holding word i of the entry
+	Reg wordAt(IRBlock * block, int64_t i){
+		return compute(block, IRInstr::ADD, Operand::reg(base),
+			Operand::imm(i));
+	}
+	Reg loadWord(IRBlock * block, int64_t i){
+		IRInstr * load = fn->newInstr(IRInstr::LOADT);
+		load->dst = fn->newReg();
+		load->index = table;
+		load->a = i == 0 ? Operand::reg(base)
+			: Operand::reg(wordAt(block, i));
+		block->append(load);
+		return load->dst;
+	}
+	void storeWord(IRBlock * block, IRInstr * before, int64_t i,
+		Operand val){
+		IRInstr * store = fn->newInstr(IRInstr::STORET);
+		store->index = table;
+		if (i == 0){
+			store->a = Operand::reg(base);
+		} else {
+			IRInstr * at = fn->newInstr(IRInstr::ADD);
+			at->dst = fn->newReg();
+			at->a = Operand::reg(base);
+			at->b = Operand::imm(i);
+			block->insertBefore(before, at);
+			store->a = Operand::reg(at->dst);
+		}
+		store->b = val;
+		block->insertBefore(before, store);
+	}
+	void branch(IRBlock * block, Reg cond, IRBlock * ifTrue,
+		IRBlock * ifFalse){
+		IRInstr * br = fn->newInstr(IRInstr::BR);
+		br->a = Operand::reg(cond);
+		br->targets[0] = ifTrue;
+		br->targets[1] = ifFalse;
+		block->append(br);
+	}
+
+	IRProgram * prog;
+	IRFunction * fn;
+	uint32_t table;
+	//The first word of the arguments' entry
+	Reg base;
+	//The arguments, as they were on entry
+	std::vector<Reg> keys;
+};
+}
+
+//The new entry hashes the arguments to find their entry, and
+// returns its result if it is for the same arguments. Otherwise
+// the function runs as before from its old entry, and each of
+// its returns fills in the entry first.
+void Memoizer::memoize(){
+	int64_t k = static_cast<int64_t>(fn->params.size());
+	int64_t width = k + 2;
+	table = prog->addTable("memo_" + fn->name,
+		MEMO_SLOTS * static_cast<uint32_t>(width));
+	IRBlock * top = fn->blocks[0];
+
+	//A function can run off its last block, which returns 0
+	std::vector<IRInstr *> rets;
+	for (IRBlock * block : fn->blocks){
+		if (block->terminator() == nullptr){
+			IRInstr * ret = fn->newInstr(IRInstr::RET);
+			ret->a = Operand::imm(0);
+			block->append(ret);
+		}
+		if (block->last->op == IRInstr::RET){
+			rets.push_back(block->last);
+		}
+	}
+
+	IRBlock * entry = fn->newBlock();
+	for (Reg param : fn->params){
+		IRInstr * copy = fn->newInstr(IRInstr::COPY);
+		copy->dst = fn->newReg();
+		copy->a = Operand::reg(param);
+		entry->append(copy);
+		keys.push_back(copy->dst);
+	}
+	//The entry is the top bits of a multiplicative hash (by
+	// 2^64 over the golden ratio). Division by 2^52 rounds toward
+	// zero, so the 12 bits come out from -2048 to 2047.
+	Reg hash = keys[0];
+	for (size_t i = 1; i < keys.size(); i++){
+		Reg scaled = compute(entry, IRInstr::MUL, Operand::reg(hash),
+			Operand::imm(31));
+		hash = compute(entry, IRInstr::ADD, Operand::reg(scaled),
+			Operand::reg(keys[i]));
+	}
+	Reg mixed = compute(entry, IRInstr::MUL, Operand::reg(hash),
+		Operand::imm(static_cast<int64_t>(UINT64_C(0x9E3779B97F4A7C15))));
+	Reg top12 = compute(entry, IRInstr::DIV, Operand::reg(mixed),
+		Operand::imm(INT64_C(1) << (64 - MEMO_BITS)));
+	Reg slot = compute(entry, IRInstr::ADD, Operand::reg(top12),
+		Operand::imm(MEMO_SLOTS / 2));
+	base = compute(entry, IRInstr::MUL, Operand::reg(slot),
+		Operand::imm(width));
+
+	std::vector<IRBlock *> added = {entry};
+	IRBlock * check = entry;
+	for (int64_t i = 0; i <= k; i++){
+		Reg same;
+		if (i == 0){
+			same = loadWord(check, 0);
+		} else {
+			Reg key = loadWord(check, i);
+			same = compute(check, IRInstr::EQ, Operand::reg(key),
+				Operand::reg(keys[static_cast<size_t>(i - 1)]));
+		}
+		IRBlock * next = fn->newBlock();
+		branch(check, same, next, top);
+		added.push_back(next);
+		check = next;
+	}
+	IRInstr * hit = fn->newInstr(IRInstr::RET);
+	hit->a = Operand::reg(loadWord(check, k + 1));
+	check->append(hit);
+
+	for (IRInstr * ret : rets){
+		IRBlock * block = ret->block;
+		for (int64_t i = 0; i < k; i++){
+			storeWord(block, ret, i + 1,
+				Operand::reg(keys[static_cast<size_t>(i)]));
+		}
+		storeWord(block, ret, k + 1, ret->a);
+		storeWord(block, ret, 0, Operand::imm(1));
+	}
+
+	std::vector<IRBlock *> blocks = fn->blocks;
+	fn->blocks.clear();
+	for (IRBlock * block : added){
+		fn->placeBlock(block);
+	}
+	for (IRBlock * block : blocks){
+		fn->placeBlock(block);
+	}
+	fn->rebuildEdges();
+}
+
+void memoizeFunctions(IRProgram * prog,
+	const std::vector<std::string>& pure, OptReport& report){
+	size_t memoized = 0;
+	for (const std::string& name : pure){
+		IRFunction * fn = prog->findFunction(name);
+		if (fn == nullptr || fn->blocks.empty()){ continue; }
+		if (fn->ssa){
+			throw new InternalError("Memoizing needs a function not in SSA form");
+		}
+		if (!fn->returnsValue || fn->params.empty()
+			|| fn->params.size() > MAX_KEYS){ continue; }
+		fn->rebuildEdges();
+		if (!worthMemoizing(fn)){ continue; }
+		Memoizer memoizer(prog, fn);
+		memoizer.memoize();
+		memoized++;
+	}
+	report.add("memo", "functions memoized", memoized);
+}
+
+}
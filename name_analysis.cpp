@@ -2,6 +2,7 @@
 #include "symbol_table.hpp"
 #include "errName.hpp"
 #include "types.hpp"
+#include "walker.hpp"
 
 namespace lake{
 
@@ -21,93 +22,91 @@ std::string TypeNode::getTypeString(){
 	return this->getDataType()->getString();
 }
 
-bool ProgramNode::nameAnalysis(SymbolTable * symTab){
-	//Enter the global scope
-	symTab->enterScope();
-	bool res = this->myDeclList->nameAnalysis(symTab);
-	//Leave the global scope
-	symTab->leaveScope();
-	return res;
-}
-
-bool VarDeclListNode::nameAnalysis(SymbolTable * symTab){
-	bool res = true;
-	for (auto elt : *myDecls){
-		res = elt->nameAnalysis(symTab) && res;
+namespace {
+//Hands each node's name analysis hooks the shared state of
+// the analysis. The walk's context is unused.
+class NameVisitor : public ASTVisitor{
+public:
+	NameVisitor(NameAnalysis& naIn) : na(naIn){ }
+	bool pre(ASTNode * node, int) override {
+		return node->namePre(na);
 	}
-	return res;
+	bool between(ASTNode * node, size_t i, int, int&) override {
+		return node->nameBetween(na, i);
+	}
+	void post(ASTNode * node, int) override {
+		node->namePost(na);
+	}
+private:
+	NameAnalysis& na;
+};
 }
 
-bool TypeNode::nameAnalysis(SymbolTable * symTab){
-	throw new InternalError("Name analysis should"
-		" never reach type nodes");
+bool ASTNode::nameAnalysis(SymbolTable * symTab){
+	NameAnalysis na(symTab);
+	NameVisitor visitor(na);
+	walk(this, visitor);
+	return na.passed();
 }
 
-bool AssignStmtNode::nameAnalysis(SymbolTable * symTab){
-	return myAssign->nameAnalysis(symTab);
+bool ProgramNode::namePre(NameAnalysis& na){
+	//Enter the global scope
+	na.symbols()->enterScope();
+	return true;
 }
 
-bool PostIncStmtNode::nameAnalysis(SymbolTable * symTab){
-	return myExp->nameAnalysis(symTab);
+void ProgramNode::namePost(NameAnalysis& na){
+	//Leave the global scope
+	na.symbols()->leaveScope();
 }
 
-bool PostDecStmtNode::nameAnalysis(SymbolTable * symTab){
-	return myExp->nameAnalysis(symTab);
+bool TypeNode::namePre(NameAnalysis& na){
+	throw new InternalError("Name analysis should"
+		" never reach type nodes");
 }
 
-bool ReadStmtNode::nameAnalysis(SymbolTable * symTab){
-	return myExp->nameAnalysis(symTab);
+//The declarations inside an if or while body are skipped,
+// only the statements are analyzed, in a scope of their own
+bool IfStmtNode::nameBetween(NameAnalysis& na, size_t i){
+	if (i == 1){
+		na.symbols()->enterScope();
+		return false;
+	}
+	return true;
 }
 
-bool WriteStmtNode::nameAnalysis(SymbolTable * symTab){
-	return myExp->nameAnalysis(symTab);
+void IfStmtNode::namePost(NameAnalysis& na){
+	na.symbols()->leaveScope();
 }
 
-bool IfStmtNode::nameAnalysis(SymbolTable * symTab){
-	bool result = true;
-	result = myExp->nameAnalysis(symTab) && result;
-	symTab->enterScope();
-	result = myStmts->nameAnalysis(symTab) && result;
-	symTab->leaveScope();
-	return result;
+bool IfElseStmtNode::nameBetween(NameAnalysis& na, size_t i){
+	if (i == 1){
+		na.symbols()->enterScope();
+		return false;
+	}
+	if (i == 3){
+		na.symbols()->leaveScope();
+		na.symbols()->enterScope();
+		return false;
+	}
+	return true;
 }
 
-bool IfElseStmtNode::nameAnalysis(SymbolTable * symTab){
-	bool result = true;
-	result = myExp->nameAnalysis(symTab) && result;
-	symTab->enterScope();
-	result = myStmtsT->nameAnalysis(symTab) && result;
-	symTab->leaveScope();
-	symTab->enterScope();
-	result = myStmtsF->nameAnalysis(symTab) && result;
-	symTab->leaveScope();
-	return result;
+void IfElseStmtNode::namePost(NameAnalysis& na){
+	na.symbols()->leaveScope();
 }
 
-bool WhileStmtNode::nameAnalysis(SymbolTable * symTab){
-	bool result = true;
-	symTab->enterScope();
-	result = myExp->nameAnalysis(symTab) && result;
-	result = myStmts->nameAnalysis(symTab) && result;
-	symTab->leaveScope();
-	return result;
-	
+bool WhileStmtNode::namePre(NameAnalysis& na){
+	na.symbols()->enterScope();
+	return true;
 }
 
-bool DeclListNode::nameAnalysis(SymbolTable * symTab){
-	bool result = true;
-	for (auto decl : *myDecls){
-		result = decl->nameAnalysis(symTab) && result;
-	}
-	return result;
+bool WhileStmtNode::nameBetween(NameAnalysis& na, size_t i){
+	return i != 1;
 }
 
-bool StmtListNode::nameAnalysis(SymbolTable * symTab){
-	bool result = true;
-	for (auto elt : *myStmts){
-		result = elt->nameAnalysis(symTab) && result;
-	}
-	return result;
+void WhileStmtNode::namePost(NameAnalysis& na){
+	na.symbols()->leaveScope();
 }
 
 static bool dataDecl(SymbolTable * symTab, DeclNode * decl, TypeNode * typeNode){
@@ -142,15 +141,41 @@ static bool dataDecl(SymbolTable * symTab, DeclNode * decl, TypeNode * typeNode)
 	return true;
 }
 
-bool VarDeclNode::nameAnalysis(SymbolTable * symTab){
-	return dataDecl(symTab, this, this->getTypeNode());
+bool VarDeclNode::namePre(NameAnalysis& na){
+	if (!dataDecl(na.symbols(), this, this->getTypeNode())){
+		na.fail();
+	}
+	return false;
+}
+
+bool FormalDeclNode::namePre(NameAnalysis& na){
+	if (!dataDecl(na.symbols(), this, this->getTypeNode())){
+		na.fail();
+	}
+	return false;
+}
+
+bool FnDeclNode::namePre(NameAnalysis& na){
+	if (!this->nameAnalysisHeader(na.symbols())){
+		na.fail();
+	}
+	return true;
+}
+
+bool FnDeclNode::nameBetween(NameAnalysis& na, size_t i){
+	//Only the body is left once the header is done
+	return i == 3;
 }
 
-bool FormalDeclNode::nameAnalysis(SymbolTable * symTab){
-	return dataDecl(symTab, this, this->getTypeNode());
+void FnDeclNode::namePost(NameAnalysis& na){
+	na.symbols()->leaveScope();
 }
 
-bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
+//Checks the return type, formals and name of the function and
+// leaves the symbol table in the function's own scope, ready
+// for the body to be analyzed. The caller must leave that scope
+// once the body is done.
+bool FnDeclNode::nameAnalysisHeader(SymbolTable * symTab){
 	std::string fnName = this->getDeclaredName();
 	const DataType * retType = myType->getReturnType();
 	const VarType * retVarType = retType->asVar();
@@ -189,80 +214,16 @@ bool FnDeclNode::nameAnalysis(SymbolTable * symTab){
 		getDeclaredID()->attachSymbol(fnSym);
 	}
 
-	bool validBody = myBody->nameAnalysis(symTab);
-
-	symTab->leaveScope();
-	return (validName && validFormals && validBody);
-}
-
-bool FormalsListNode::nameAnalysis(SymbolTable * symTab){
-	bool result = true;
-	for (auto elt : *myFormals){
-		result = elt->nameAnalysis(symTab) && result;
-	}
-	return result;
-}
-
-bool FnBodyNode::nameAnalysis(SymbolTable * symTab){
-	bool result = true;
-	result = myVarDecls->nameAnalysis(symTab) && result;
-	result = myStmtList->nameAnalysis(symTab) && result;
-	return result;
+	return (validName && validFormals);
 }
 
-bool BinaryExpNode::nameAnalysis(SymbolTable * symTab){
-	bool result = true;
-	result = myExp1->nameAnalysis(symTab) && result;
-	myExp2->nameAnalysis(symTab) && result;
-	return result;
-}
-
-bool ExpListNode::nameAnalysis(SymbolTable * symTab){
-	bool result = true;
-	for (auto elt : *myExps){
-		result = elt->nameAnalysis(symTab) && result;
+void IdNode::namePost(NameAnalysis& na){
+	if (!this->resolveName(na.symbols())){
+		na.fail();
 	}
-	return result;
-}
-
-bool CallExpNode::nameAnalysis(SymbolTable* symTab){
-	bool result = true;
-	result = myId->nameAnalysis(symTab) && result;
-	result = myExpList->nameAnalysis(symTab) && result;
-	return result;
-}
-
-bool UnaryMinusNode::nameAnalysis(SymbolTable* symTab){
-	return myExp->nameAnalysis(symTab);
-}
-
-bool NotNode::nameAnalysis(SymbolTable* symTab){
-	return myExp->nameAnalysis(symTab);
-}
-
-bool AssignNode::nameAnalysis(SymbolTable* symTab){
-	bool result = true;
-	result = myTgt->nameAnalysis(symTab) && result;
-	result = mySrc->nameAnalysis(symTab) && result;
-	return result;
-}
-
-bool ReturnStmtNode::nameAnalysis(SymbolTable * symTab){
-	if (myExp == nullptr){
-		return true;
-	}
-	return myExp->nameAnalysis(symTab);
-}
-
-bool CallStmtNode::nameAnalysis(SymbolTable* symTab){
-	return myCallExp->nameAnalysis(symTab);
-}
-
-bool DerefNode::nameAnalysis(SymbolTable * symTab){
-	return myTgt->nameAnalysis(symTab);
 }
 
-bool IdNode::nameAnalysis(SymbolTable* symTab){
+bool IdNode::resolveName(SymbolTable * symTab){
 	std::string myName = this->getString();
 	SemSymbol * sym = symTab->find(myName);
 	if (sym == nullptr){
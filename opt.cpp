@@ -0,0 +1,52 @@
+#include "opt.hpp"
+#include "ssa.hpp"
+
+namespace lake{
+
+void OptReport::add(const std::string& pass, const std::string& what,
+	size_t n){
+	for (Line& line : lines){
+		if (line.counted && line.pass == pass && line.what == what){
+			line.count += n;
+			return;
+		}
+	}
+	lines.push_back({pass, what, n, true});
+}
+
+void OptReport::note(const std::string& pass, const std::string& what){
+	lines.push_back({pass, what, 0, false});
+}
+
+size_t OptReport::get(const std::string& pass, 
+	const std::string& what) const {
+	for (const Line& line : lines){
+		if (line.counted && line.pass == pass && line.what == what){
+			return line.count;
+		}
+	}
+	return 0;
+}
+
+void OptReport::write(std::ostream& out) const {
+	for (const Line& line : lines){
+		out << line.pass << ": ";
+		if (line.counted){ out << line.count << " "; }
+		out << line.what << "\n";
+	}
+}
+
+void optimize(IRProgram * prog, OptReport& report){
+	removeTailRecursion(prog, report);
+	inlineCalls(prog, report);
+	for (IRFunction * fn : prog->functions){
+		buildSSA(fn);
+		runSCCP(fn, report);
+		simplifyCFG(fn, report);
+		runGVN(fn, prog->pointedAt, report);
+		optimizeLoops(fn, prog->pointedAt, report);
+		runDCE(fn, report);
+	}
+}
+
+}
@@ -0,0 +1,112 @@
+#ifndef LAKE_OPT_HPP
+#define LAKE_OPT_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ir.hpp"
+
+namespace lake{
+
+//Counts of what each optimization did, summed over the
+// functions it ran on. Lines are reported in the order the
+// counts were first added to.
+class OptReport{
+public:
+	void add(const std::string& pass, const std::string& what,
+		size_t n);
+	size_t get(const std::string& pass, const std::string& what)
+		const;
+	//A line without a count, such as something a pass removed
+	void note(const std::string& pass, const std::string& what);
+	void write(std::ostream& out) const;
+private:
+	struct Line{
+		std::string pass;
+		std::string what;
+		size_t count;
+		bool counted;
+	};
+	std::vector<Line> lines;
+};
+
+//Sparse conditional constant propagation, after Wegman and
+// Zadeck. Registers that only ever hold one constant are
+// replaced by it, and branches on constants become jumps, which
+// drops the blocks that can no longer be reached. fn must be in
+// SSA form.
+void runSCCP(IRFunction * fn, OptReport& report);
+
+//Dead code elimination. Uses of copies read the copied value
+// instead, and then every instruction without side effects
+// whose result is never needed is deleted. Reads, writes, stores
+// and calls always stay. fn must be in SSA form.
+void runDCE(IRFunction * fn, OptReport& report);
+
+//Clean up the CFG: branches that can only go one way become
+// jumps, unreachable blocks are deleted, a block only ever
+// reached by a jump is merged into the block it follows, and
+// jumps to a block that only jumps on go straight on instead.
+// Phis are kept up to date, so fn may be in SSA form.
+void simplifyCFG(IRFunction * fn, OptReport& report);
+
+//Global value numbering. Instructions that compute the same
+// operator on the same values as one that dominates them become
+// copies of its result, with the operands of +, *, == and !=
+// taken in either order. Loads are numbered by the version of
+// memory they read too, which changes at every call and every
+// store that may reach the same global, table or @ (by
+// pointedAt), so a repeated load is only replaced when nothing
+// could have stored in between, and a load of what was just
+// stored is replaced by the stored value. fn must be in SSA form.
+void runGVN(IRFunction * fn, const std::vector<bool>& pointedAt,
+	OptReport& report);
+
+//Loop optimizations. Each natural loop gets a preheader, and
+// the computations whose operands don't change in the loop are
+// moved there. Loads move too when nothing in the loop can store
+// to what they read: there are no calls, and no stores to the
+// same global or table, or through @ to a global that pointedAt
+// says a pointer may reach, or to anything at all for loads
+// through @. Nothing that could stop the program moves unless it
+// would have run first on entering the loop. Then
+// multiplications of an induction variable by an invariant
+// become a register of their own, stepped by an addition each
+// time around. fn must be in SSA form.
+void optimizeLoops(IRFunction * fn, const std::vector<bool>& pointedAt,
+	OptReport& report);
+
+//Turn each call a function makes to itself as the last thing it
+// does (return f(...), or a call at the end of a void function)
+// into copies of the arguments to the parameters and a jump back
+// to the top of the function, so that the recursion becomes a
+// loop. Every function must not be in SSA form.
+void removeTailRecursion(IRProgram * prog, OptReport& report);
+
+//Inline calls to small functions, in place of the call: the
+// callee's blocks are copied in, with its parameters, locals and
+// temporaries renamed, and each of its returns becomes a jump to
+// the code after the call. Callees of at most a dozen or so
+// instructions are inlined anywhere, and larger ones inside
+// loops, hottest call sites first, until the caller has grown by
+// its own size. Functions that are part of a cycle of calls are
+// never inlined. Every function must not be in SSA form.
+void inlineCalls(IRProgram * prog, OptReport& report);
+
+//Give each of the pure functions named (see findPureFunctions)
+// a memo table, when it takes one to four arguments and calls
+// something or loops. A call looks up its arguments first, and
+// returns what the same arguments gave last time if they are
+// still in the table; otherwise the function runs, and records
+// its result on the way out. Every function must not be in SSA
+// form.
+void memoizeFunctions(IRProgram * prog,
+	const std::vector<std::string>& pure, OptReport& report);
+
+//Run every optimization over every function. Functions are
+// left in SSA form.
+void optimize(IRProgram * prog, OptReport& report);
+
+}
+
+#endif
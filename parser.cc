@@ -0,0 +1,1687 @@
+// A Bison parser, made by GNU Bison 3.8.2.
+
+// Skeleton implementation for Bison LALR(1) parsers in C++
+
+// Copyright (C) 2002-2015, 2018-2021 Free Software Foundation, Inc.
+
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <https://www.gnu.org/licenses/>.
+
+// As a special exception, you may create a larger work that contains
+// part or all of the Bison parser skeleton and distribute that work
+// under terms of your choice, so long as that work isn't itself a
+// parser generator using the skeleton or a modified version thereof
+// as a parser skeleton.  Alternatively, if you modify or redistribute
+// the parser skeleton itself, you may (at your option) remove this
+// special exception, which will cause the skeleton and the resulting
+// Bison output files to be licensed under the GNU General Public
+// License without this special exception.
+
+// This special exception was added by the Free Software Foundation in
+// version 2.2 of Bison.
+
+// DO NOT RELY ON FEATURES THAT ARE NOT DOCUMENTED in the manual,
+// especially those whose name start with YY_ or yy_.  They are
+// private implementation details that can be changed or removed.
+
+
+
+
+
+#include "grammar.hh"
+
+
+// Unqualified %code blocks.
+#line 34 "lake.yy"
+
+   #include <iostream>
+   #include <cstdlib>
+   #include <fstream>
+
+   /* include for interoperation between scanner/parser */
+   #include "scanner.hpp"
+
+#undef yylex
+#define yylex scanner.yylex
+
+#line 58 "parser.cc"
+
+
+#ifndef YY_
+# if defined YYENABLE_NLS && YYENABLE_NLS
+#  if ENABLE_NLS
+#   include <libintl.h> // FIXME: INFRINGES ON USER NAME SPACE.
+#   define YY_(msgid) dgettext ("bison-runtime", msgid)
+#  endif
+# endif
+# ifndef YY_
+#  define YY_(msgid) msgid
+# endif
+#endif
+
+
+// Whether we are compiled with exception support.
+#ifndef YY_EXCEPTIONS
+# if defined __GNUC__ && !defined __EXCEPTIONS
+#  define YY_EXCEPTIONS 0
+# else
+#  define YY_EXCEPTIONS 1
+# endif
+#endif
+
+
+
+// Enable debugging if requested.
+#if YYDEBUG
+
+// A pseudo ostream that takes yydebug_ into account.
+# define YYCDEBUG if (yydebug_) (*yycdebug_)
+
+# define YY_SYMBOL_PRINT(Title, Symbol)         \
+  do {                                          \
+    if (yydebug_)                               \
+    {                                           \
+      *yycdebug_ << Title << ' ';               \
+      yy_print_ (*yycdebug_, Symbol);           \
+      *yycdebug_ << '\n';                       \
+    }                                           \
+  } while (false)
+
+# define YY_REDUCE_PRINT(Rule)          \
+  do {                                  \
+    if (yydebug_)                       \
+      yy_reduce_print_ (Rule);          \
+  } while (false)
+
+# define YY_STACK_PRINT()               \
+  do {                                  \
+    if (yydebug_)                       \
+      yy_stack_print_ ();                \
+  } while (false)
+
+#else // !YYDEBUG
+
+# define YYCDEBUG if (false) std::cerr
+# define YY_SYMBOL_PRINT(Title, Symbol)  YY_USE (Symbol)
+# define YY_REDUCE_PRINT(Rule)           static_cast<void> (0)
+# define YY_STACK_PRINT()                static_cast<void> (0)
+
+#endif // !YYDEBUG
+
+#define yyerrok         (yyerrstatus_ = 0)
+#define yyclearin       (yyla.clear ())
+
+#define YYACCEPT        goto yyacceptlab
+#define YYABORT         goto yyabortlab
+#define YYERROR         goto yyerrorlab
+#define YYRECOVERING()  (!!yyerrstatus_)
+
+#line 5 "lake.yy"
+namespace lake {
+#line 132 "parser.cc"
+
+  /// Build a parser object.
+  Parser::Parser (lake::Scanner  &scanner_yyarg, lake::ProgramNode** root_yyarg, lake::DeclSink * sink_yyarg)
+#if YYDEBUG
+    : yydebug_ (false),
+      yycdebug_ (&std::cerr),
+#else
+    :
+#endif
+      scanner (scanner_yyarg),
+      root (root_yyarg),
+      sink (sink_yyarg)
+  {}
+
+  Parser::~Parser ()
+  {}
+
+  Parser::syntax_error::~syntax_error () YY_NOEXCEPT YY_NOTHROW
+  {}
+
+  /*---------.
+  | symbol.  |
+  `---------*/
+
+  // basic_symbol.
+  template <typename Base>
+  Parser::basic_symbol<Base>::basic_symbol (const basic_symbol& that)
+    : Base (that)
+    , value (that.value)
+  {}
+
+
+  /// Constructor for valueless symbols.
+  template <typename Base>
+  Parser::basic_symbol<Base>::basic_symbol (typename Base::kind_type t)
+    : Base (t)
+    , value ()
+  {}
+
+  template <typename Base>
+  Parser::basic_symbol<Base>::basic_symbol (typename Base::kind_type t, YY_RVREF (value_type) v)
+    : Base (t)
+    , value (YY_MOVE (v))
+  {}
+
+
+  template <typename Base>
+  Parser::symbol_kind_type
+  Parser::basic_symbol<Base>::type_get () const YY_NOEXCEPT
+  {
+    return this->kind ();
+  }
+
+
+  template <typename Base>
+  bool
+  Parser::basic_symbol<Base>::empty () const YY_NOEXCEPT
+  {
+    return this->kind () == symbol_kind::S_YYEMPTY;
+  }
+
+  template <typename Base>
+  void
+  Parser::basic_symbol<Base>::move (basic_symbol& s)
+  {
+    super_type::move (s);
+    value = YY_MOVE (s.value);
+  }
+
+  // by_kind.
+  Parser::by_kind::by_kind () YY_NOEXCEPT
+    : kind_ (symbol_kind::S_YYEMPTY)
+  {}
+
+#if 201103L <= YY_CPLUSPLUS
+  Parser::by_kind::by_kind (by_kind&& that) YY_NOEXCEPT
+    : kind_ (that.kind_)
+  {
+    that.clear ();
+  }
+#endif
+
+  Parser::by_kind::by_kind (const by_kind& that) YY_NOEXCEPT
+    : kind_ (that.kind_)
+  {}
+
+  Parser::by_kind::by_kind (token_kind_type t) YY_NOEXCEPT
+    : kind_ (yytranslate_ (t))
+  {}
+
+
+
+  void
+  Parser::by_kind::clear () YY_NOEXCEPT
+  {
+    kind_ = symbol_kind::S_YYEMPTY;
+  }
+
+  void
+  Parser::by_kind::move (by_kind& that)
+  {
+    kind_ = that.kind_;
+    that.clear ();
+  }
+
+  Parser::symbol_kind_type
+  Parser::by_kind::kind () const YY_NOEXCEPT
+  {
+    return kind_;
+  }
+
+
+  Parser::symbol_kind_type
+  Parser::by_kind::type_get () const YY_NOEXCEPT
+  {
+    return this->kind ();
+  }
+
+
+
+  // by_state.
+  Parser::by_state::by_state () YY_NOEXCEPT
+    : state (empty_state)
+  {}
+
+  Parser::by_state::by_state (const by_state& that) YY_NOEXCEPT
+    : state (that.state)
+  {}
+
+  void
+  Parser::by_state::clear () YY_NOEXCEPT
+  {
+    state = empty_state;
+  }
+
+  void
+  Parser::by_state::move (by_state& that)
+  {
+    state = that.state;
+    that.clear ();
+  }
+
+  Parser::by_state::by_state (state_type s) YY_NOEXCEPT
+    : state (s)
+  {}
+
+  Parser::symbol_kind_type
+  Parser::by_state::kind () const YY_NOEXCEPT
+  {
+    if (state == empty_state)
+      return symbol_kind::S_YYEMPTY;
+    else
+      return YY_CAST (symbol_kind_type, yystos_[+state]);
+  }
+
+  Parser::stack_symbol_type::stack_symbol_type ()
+  {}
+
+  Parser::stack_symbol_type::stack_symbol_type (YY_RVREF (stack_symbol_type) that)
+    : super_type (YY_MOVE (that.state), YY_MOVE (that.value))
+  {
+#if 201103L <= YY_CPLUSPLUS
+    // that is emptied.
+    that.state = empty_state;
+#endif
+  }
+
+  Parser::stack_symbol_type::stack_symbol_type (state_type s, YY_MOVE_REF (symbol_type) that)
+    : super_type (s, YY_MOVE (that.value))
+  {
+    // that is emptied.
+    that.kind_ = symbol_kind::S_YYEMPTY;
+  }
+
+#if YY_CPLUSPLUS < 201103L
+  Parser::stack_symbol_type&
+  Parser::stack_symbol_type::operator= (const stack_symbol_type& that)
+  {
+    state = that.state;
+    value = that.value;
+    return *this;
+  }
+
+  Parser::stack_symbol_type&
+  Parser::stack_symbol_type::operator= (stack_symbol_type& that)
+  {
+    state = that.state;
+    value = that.value;
+    // that is emptied.
+    that.state = empty_state;
+    return *this;
+  }
+#endif
+
+  template <typename Base>
+  void
+  Parser::yy_destroy_ (const char* yymsg, basic_symbol<Base>& yysym) const
+  {
+    if (yymsg)
+      YY_SYMBOL_PRINT (yymsg, yysym);
+
+    // User destructor.
+    YY_USE (yysym.kind ());
+  }
+
+#if YYDEBUG
+  template <typename Base>
+  void
+  Parser::yy_print_ (std::ostream& yyo, const basic_symbol<Base>& yysym) const
+  {
+    std::ostream& yyoutput = yyo;
+    YY_USE (yyoutput);
+    if (yysym.empty ())
+      yyo << "empty symbol";
+    else
+      {
+        symbol_kind_type yykind = yysym.kind ();
+        yyo << (yykind < YYNTOKENS ? "token" : "nterm")
+            << ' ' << yysym.name () << " (";
+        YY_USE (yykind);
+        yyo << ')';
+      }
+  }
+#endif
+
+  void
+  Parser::yypush_ (const char* m, YY_MOVE_REF (stack_symbol_type) sym)
+  {
+    if (m)
+      YY_SYMBOL_PRINT (m, sym);
+    yystack_.push (YY_MOVE (sym));
+  }
+
+  void
+  Parser::yypush_ (const char* m, state_type s, YY_MOVE_REF (symbol_type) sym)
+  {
+#if 201103L <= YY_CPLUSPLUS
+    yypush_ (m, stack_symbol_type (s, std::move (sym)));
+#else
+    stack_symbol_type ss (s, sym);
+    yypush_ (m, ss);
+#endif
+  }
+
+  void
+  Parser::yypop_ (int n) YY_NOEXCEPT
+  {
+    yystack_.pop (n);
+  }
+
+#if YYDEBUG
+  std::ostream&
+  Parser::debug_stream () const
+  {
+    return *yycdebug_;
+  }
+
+  void
+  Parser::set_debug_stream (std::ostream& o)
+  {
+    yycdebug_ = &o;
+  }
+
+
+  Parser::debug_level_type
+  Parser::debug_level () const
+  {
+    return yydebug_;
+  }
+
+  void
+  Parser::set_debug_level (debug_level_type l)
+  {
+    yydebug_ = l;
+  }
+#endif // YYDEBUG
+
+  Parser::state_type
+  Parser::yy_lr_goto_state_ (state_type yystate, int yysym)
+  {
+    int yyr = yypgoto_[yysym - YYNTOKENS] + yystate;
+    if (0 <= yyr && yyr <= yylast_ && yycheck_[yyr] == yystate)
+      return yytable_[yyr];
+    else
+      return yydefgoto_[yysym - YYNTOKENS];
+  }
+
+  bool
+  Parser::yy_pact_value_is_default_ (int yyvalue) YY_NOEXCEPT
+  {
+    return yyvalue == yypact_ninf_;
+  }
+
+  bool
+  Parser::yy_table_value_is_error_ (int yyvalue) YY_NOEXCEPT
+  {
+    return yyvalue == yytable_ninf_;
+  }
+
+  int
+  Parser::operator() ()
+  {
+    return parse ();
+  }
+
+  int
+  Parser::parse ()
+  {
+    int yyn;
+    /// Length of the RHS of the rule being reduced.
+    int yylen = 0;
+
+    // Error handling.
+    int yynerrs_ = 0;
+    int yyerrstatus_ = 0;
+
+    /// The lookahead symbol.
+    symbol_type yyla;
+
+    /// The return value of parse ().
+    int yyresult;
+
+#if YY_EXCEPTIONS
+    try
+#endif // YY_EXCEPTIONS
+      {
+    YYCDEBUG << "Starting parse\n";
+
+
+    /* Initialize the stack.  The initial state will be set in
+       yynewstate, since the latter expects the semantical and the
+       location values to have been already stored, initialize these
+       stacks with a primary value.  */
+    yystack_.clear ();
+    yypush_ (YY_NULLPTR, 0, YY_MOVE (yyla));
+
+  /*-----------------------------------------------.
+  | yynewstate -- push a new symbol on the stack.  |
+  `-----------------------------------------------*/
+  yynewstate:
+    YYCDEBUG << "Entering state " << int (yystack_[0].state) << '\n';
+    YY_STACK_PRINT ();
+
+    // Accept?
+    if (yystack_[0].state == yyfinal_)
+      YYACCEPT;
+
+    goto yybackup;
+
+
+  /*-----------.
+  | yybackup.  |
+  `-----------*/
+  yybackup:
+    // Try to take a decision without lookahead.
+    yyn = yypact_[+yystack_[0].state];
+    if (yy_pact_value_is_default_ (yyn))
+      goto yydefault;
+
+    // Read a lookahead token.
+    if (yyla.empty ())
+      {
+        YYCDEBUG << "Reading a token\n";
+#if YY_EXCEPTIONS
+        try
+#endif // YY_EXCEPTIONS
+          {
+            yyla.kind_ = yytranslate_ (yylex (&yyla.value));
+          }
+#if YY_EXCEPTIONS
+        catch (const syntax_error& yyexc)
+          {
+            YYCDEBUG << "Caught exception: " << yyexc.what() << '\n';
+            error (yyexc);
+            goto yyerrlab1;
+          }
+#endif // YY_EXCEPTIONS
+      }
+    YY_SYMBOL_PRINT ("Next token is", yyla);
+
+    if (yyla.kind () == symbol_kind::S_YYerror)
+    {
+      // The scanner already issued an error message, process directly
+      // to error recovery.  But do not keep the error token as
+      // lookahead, it is too special and may lead us to an endless
+      // loop in error recovery. */
+      yyla.kind_ = symbol_kind::S_YYUNDEF;
+      goto yyerrlab1;
+    }
+
+    /* If the proper action on seeing token YYLA.TYPE is to reduce or
+       to detect an error, take that action.  */
+    yyn += yyla.kind ();
+    if (yyn < 0 || yylast_ < yyn || yycheck_[yyn] != yyla.kind ())
+      {
+        goto yydefault;
+      }
+
+    // Reduce or error.
+    yyn = yytable_[yyn];
+    if (yyn <= 0)
+      {
+        if (yy_table_value_is_error_ (yyn))
+          goto yyerrlab;
+        yyn = -yyn;
+        goto yyreduce;
+      }
+
+    // Count tokens shifted since error; after three, turn off error status.
+    if (yyerrstatus_)
+      --yyerrstatus_;
+
+    // Shift the lookahead token.
+    yypush_ ("Shifting", state_type (yyn), YY_MOVE (yyla));
+    goto yynewstate;
+
+
+  /*-----------------------------------------------------------.
+  | yydefault -- do the default action for the current state.  |
+  `-----------------------------------------------------------*/
+  yydefault:
+    yyn = yydefact_[+yystack_[0].state];
+    if (yyn == 0)
+      goto yyerrlab;
+    goto yyreduce;
+
+
+  /*-----------------------------.
+  | yyreduce -- do a reduction.  |
+  `-----------------------------*/
+  yyreduce:
+    yylen = yyr2_[yyn];
+    {
+      stack_symbol_type yylhs;
+      yylhs.state = yy_lr_goto_state_ (yystack_[yylen].state, yyr1_[yyn]);
+      /* If YYLEN is nonzero, implement the default value of the
+         action: '$$ = $1'.  Otherwise, use the top of the stack.
+
+         Otherwise, the following line sets YYLHS.VALUE to garbage.
+         This behavior is undocumented and Bison users should not rely
+         upon it.  */
+      if (yylen)
+        yylhs.value = yystack_[yylen - 1].value;
+      else
+        yylhs.value = yystack_[0].value;
+
+
+      // Perform the reduction.
+      YY_REDUCE_PRINT (yyn);
+#if YY_EXCEPTIONS
+      try
+#endif // YY_EXCEPTIONS
+        {
+          switch (yyn)
+            {
+  case 2: // program: declList
+#line 161 "lake.yy"
+          {
+          (yylhs.value.programNode) = new ProgramNode(new DeclListNode((yystack_[0].value.declList)));
+          *root = (yylhs.value.programNode);
+          }
+#line 594 "parser.cc"
+    break;
+
+  case 3: // declList: declList decl
+#line 167 "lake.yy"
+           {
+           /* In streaming mode each decl is handed off as soon
+              as it is reduced rather than kept in the tree */
+           if (sink != nullptr){
+              sink->consume((yystack_[0].value.declNode));
+           } else {
+              (yystack_[1].value.declList)->push_back((yystack_[0].value.declNode));
+           }
+           (yylhs.value.declList) = (yystack_[1].value.declList);
+           }
+#line 609 "parser.cc"
+    break;
+
+  case 4: // declList: %empty
+#line 178 "lake.yy"
+           {
+           (yylhs.value.declList) = new std::list<DeclNode *>();
+           }
+#line 617 "parser.cc"
+    break;
+
+  case 5: // decl: varDecl
+#line 182 "lake.yy"
+               { (yylhs.value.declNode) = (yystack_[0].value.varDeclNode); }
+#line 623 "parser.cc"
+    break;
+
+  case 6: // decl: fnDecl
+#line 183 "lake.yy"
+              { (yylhs.value.declNode) = (yystack_[0].value.fnDecl); }
+#line 629 "parser.cc"
+    break;
+
+  case 7: // varDeclList: varDeclList varDecl
+#line 185 "lake.yy"
+                                  { (yylhs.value.varDeclList) = (yystack_[1].value.varDeclList); (yylhs.value.varDeclList)->push_back((yystack_[0].value.varDeclNode)); }
+#line 635 "parser.cc"
+    break;
+
+  case 8: // varDeclList: %empty
+#line 186 "lake.yy"
+                            { (yylhs.value.varDeclList) = new std::list<VarDeclNode *>(); }
+#line 641 "parser.cc"
+    break;
+
+  case 9: // varDecl: type id SEMICOLON
+#line 189 "lake.yy"
+          { (yylhs.value.varDeclNode) = new VarDeclNode((yystack_[2].value.typeNode), (yystack_[1].value.idNode)); }
+#line 647 "parser.cc"
+    break;
+
+  case 10: // fnDecl: type id formals fnBody
+#line 192 "lake.yy"
+         { (yylhs.value.fnDecl) = new FnDeclNode((yystack_[3].value.typeNode), (yystack_[2].value.idNode), (yystack_[1].value.formalsType), (yystack_[0].value.fnBody)); }
+#line 653 "parser.cc"
+    break;
+
+  case 11: // formals: LPAREN RPAREN
+#line 195 "lake.yy"
+          { (yylhs.value.formalsType) = new FormalsListNode(new std::list<FormalDeclNode *>()); }
+#line 659 "parser.cc"
+    break;
+
+  case 12: // formals: LPAREN formalsList RPAREN
+#line 197 "lake.yy"
+          { (yylhs.value.formalsType) = new FormalsListNode((yystack_[1].value.formalsList)); }
+#line 665 "parser.cc"
+    break;
+
+  case 13: // formalsList: formalDecl
+#line 200 "lake.yy"
+              {
+              std::list<FormalDeclNode *> * list = new std::list<FormalDeclNode *>();
+              list->push_back((yystack_[0].value.formalDecl));
+              (yylhs.value.formalsList) = list;
+              }
+#line 675 "parser.cc"
+    break;
+
+  case 14: // formalsList: formalDecl COMMA formalsList
+#line 206 "lake.yy"
+              {
+              (yystack_[0].value.formalsList)->push_front((yystack_[2].value.formalDecl));
+              (yylhs.value.formalsList) = (yystack_[0].value.formalsList);
+              }
+#line 684 "parser.cc"
+    break;
+
+  case 15: // fnBody: LCURLY varDeclList stmtList RCURLY
+#line 211 "lake.yy"
+                                            {
+         (yylhs.value.fnBody) = new FnBodyNode((yystack_[3].value.tokenValue)->_pos, 
+		new VarDeclListNode((yystack_[2].value.varDeclList)), new StmtListNode((yystack_[1].value.stmtList)));
+       }
+#line 693 "parser.cc"
+    break;
+
+  case 16: // formalDecl: type id
+#line 217 "lake.yy"
+             { (yylhs.value.formalDecl) = new FormalDeclNode((yystack_[1].value.typeNode), (yystack_[0].value.idNode)); }
+#line 699 "parser.cc"
+    break;
+
+  case 17: // stmtList: %empty
+#line 220 "lake.yy"
+           { (yylhs.value.stmtList) = new std::list<StmtNode *>(); }
+#line 705 "parser.cc"
+    break;
+
+  case 18: // stmtList: stmtList stmt
+#line 222 "lake.yy"
+           { 
+           (yystack_[1].value.stmtList)->push_back((yystack_[0].value.stmtNode));
+           (yylhs.value.stmtList) = (yystack_[1].value.stmtList);
+           }
+#line 714 "parser.cc"
+    break;
+
+  case 19: // stmt: assignExp SEMICOLON
+#line 227 "lake.yy"
+                           { (yylhs.value.stmtNode) = new AssignStmtNode((yystack_[1].value.assignNode)); }
+#line 720 "parser.cc"
+    break;
+
+  case 20: // stmt: loc CROSSCROSS SEMICOLON
+#line 228 "lake.yy"
+                                { (yylhs.value.stmtNode) = new PostIncStmtNode((yystack_[2].value.exp)); }
+#line 726 "parser.cc"
+    break;
+
+  case 21: // stmt: loc DASHDASH SEMICOLON
+#line 229 "lake.yy"
+                              { (yylhs.value.stmtNode) = new PostDecStmtNode((yystack_[2].value.exp)); }
+#line 732 "parser.cc"
+    break;
+
+  case 22: // stmt: READ loc SEMICOLON
+#line 230 "lake.yy"
+                          { (yylhs.value.stmtNode) = new ReadStmtNode((yystack_[1].value.exp)); }
+#line 738 "parser.cc"
+    break;
+
+  case 23: // stmt: WRITE exp SEMICOLON
+#line 231 "lake.yy"
+                           { (yylhs.value.stmtNode) = new WriteStmtNode((yystack_[1].value.exp)); }
+#line 744 "parser.cc"
+    break;
+
+  case 24: // stmt: IF LPAREN exp RPAREN LCURLY varDeclList stmtList RCURLY
+#line 233 "lake.yy"
+        { 
+        (yylhs.value.stmtNode) = new IfStmtNode((yystack_[7].value.tokenValue)->_pos, (yystack_[5].value.exp), 
+		new VarDeclListNode((yystack_[2].value.varDeclList)),
+		new StmtListNode((yystack_[1].value.stmtList))
+	);
+        }
+#line 755 "parser.cc"
+    break;
+
+  case 25: // stmt: IF LPAREN exp RPAREN LCURLY varDeclList stmtList RCURLY ELSE LCURLY varDeclList stmtList RCURLY
+#line 240 "lake.yy"
+        { 
+        (yylhs.value.stmtNode) = new IfElseStmtNode(
+                (yystack_[10].value.exp), 
+                new VarDeclListNode((yystack_[7].value.varDeclList)), 
+                new StmtListNode((yystack_[6].value.stmtList)), 
+                new VarDeclListNode((yystack_[2].value.varDeclList)),
+                new StmtListNode((yystack_[1].value.stmtList))
+	); 
+        }
+#line 769 "parser.cc"
+    break;
+
+  case 26: // stmt: WHILE LPAREN exp RPAREN LCURLY varDeclList stmtList RCURLY
+#line 250 "lake.yy"
+       { 
+        (yylhs.value.stmtNode) = new WhileStmtNode((yystack_[7].value.tokenValue)->_pos, (yystack_[5].value.exp), 
+		new VarDeclListNode((yystack_[2].value.varDeclList)), new StmtListNode((yystack_[1].value.stmtList))); 
+       }
+#line 778 "parser.cc"
+    break;
+
+  case 27: // stmt: RETURN exp SEMICOLON
+#line 255 "lake.yy"
+        { (yylhs.value.stmtNode) = new ReturnStmtNode((yystack_[2].value.tokenValue)->_pos, (yystack_[1].value.exp)); }
+#line 784 "parser.cc"
+    break;
+
+  case 28: // stmt: RETURN SEMICOLON
+#line 257 "lake.yy"
+       { (yylhs.value.stmtNode) = new ReturnStmtNode((yystack_[1].value.tokenValue)->_pos, nullptr); }
+#line 790 "parser.cc"
+    break;
+
+  case 29: // stmt: fncall SEMICOLON
+#line 258 "lake.yy"
+                        { (yylhs.value.stmtNode) = new CallStmtNode((yystack_[1].value.callNode)); }
+#line 796 "parser.cc"
+    break;
+
+  case 30: // assignExp: loc ASSIGN exp
+#line 262 "lake.yy"
+      { (yylhs.value.assignNode) = new AssignNode((yystack_[1].value.tokenValue)->_pos, (yystack_[2].value.exp), (yystack_[0].value.exp)); }
+#line 802 "parser.cc"
+    break;
+
+  case 31: // exp: assignExp
+#line 265 "lake.yy"
+        { (yylhs.value.exp) = (yystack_[0].value.assignNode); }
+#line 808 "parser.cc"
+    break;
+
+  case 32: // exp: exp CROSS exp
+#line 267 "lake.yy"
+      { (yylhs.value.exp) = ChainExpNode::extend<PlusNode>(
+		(yystack_[1].value.tokenValue)->_pos, (yystack_[2].value.exp), (yystack_[0].value.exp)); }
+#line 815 "parser.cc"
+    break;
+
+  case 33: // exp: exp DASH exp
+#line 270 "lake.yy"
+      { (yylhs.value.exp) = new MinusNode((yystack_[1].value.tokenValue)->_pos, (yystack_[2].value.exp), (yystack_[0].value.exp)); }
+#line 821 "parser.cc"
+    break;
+
+  case 34: // exp: exp STAR exp
+#line 272 "lake.yy"
+      { (yylhs.value.exp) = ChainExpNode::extend<TimesNode>(
+		(yystack_[1].value.tokenValue)->_pos, (yystack_[2].value.exp), (yystack_[0].value.exp)); }
+#line 828 "parser.cc"
+    break;
+
+  case 35: // exp: exp SLASH exp
+#line 275 "lake.yy"
+      { (yylhs.value.exp) = new DivideNode((yystack_[1].value.tokenValue)->_pos, (yystack_[2].value.exp), (yystack_[0].value.exp)); }
+#line 834 "parser.cc"
+    break;
+
+  case 36: // exp: NOT exp
+#line 277 "lake.yy"
+      { (yylhs.value.exp) = new NotNode((yystack_[1].value.tokenValue)->_pos, (yystack_[0].value.exp)); }
+#line 840 "parser.cc"
+    break;
+
+  case 37: // exp: exp AND exp
+#line 279 "lake.yy"
+      { (yylhs.value.exp) = ChainExpNode::extend<AndNode>(
+		(yystack_[1].value.tokenValue)->_pos, (yystack_[2].value.exp), (yystack_[0].value.exp)); }
+#line 847 "parser.cc"
+    break;
+
+  case 38: // exp: exp OR exp
+#line 282 "lake.yy"
+      { (yylhs.value.exp) = ChainExpNode::extend<OrNode>(
+		(yystack_[1].value.tokenValue)->_pos, (yystack_[2].value.exp), (yystack_[0].value.exp)); }
+#line 854 "parser.cc"
+    break;
+
+  case 39: // exp: exp EQUALS exp
+#line 285 "lake.yy"
+      { (yylhs.value.exp) = new EqualsNode((yystack_[1].value.tokenValue)->_pos, (yystack_[2].value.exp), (yystack_[0].value.exp)); }
+#line 860 "parser.cc"
+    break;
+
+  case 40: // exp: exp NOTEQUALS exp
+#line 287 "lake.yy"
+      { (yylhs.value.exp) = new NotEqualsNode((yystack_[1].value.tokenValue)->_pos, (yystack_[2].value.exp), (yystack_[0].value.exp)); }
+#line 866 "parser.cc"
+    break;
+
+  case 41: // exp: exp LESS exp
+#line 289 "lake.yy"
+      { (yylhs.value.exp) = new LessNode((yystack_[1].value.tokenValue)->_pos, (yystack_[2].value.exp), (yystack_[0].value.exp)); }
+#line 872 "parser.cc"
+    break;
+
+  case 42: // exp: exp GREATER exp
+#line 291 "lake.yy"
+      { (yylhs.value.exp) = new GreaterNode((yystack_[1].value.tokenValue)->_pos, (yystack_[2].value.exp), (yystack_[0].value.exp)); }
+#line 878 "parser.cc"
+    break;
+
+  case 43: // exp: exp LESSEQ exp
+#line 293 "lake.yy"
+      { (yylhs.value.exp) = new LessEqNode((yystack_[1].value.tokenValue)->_pos, (yystack_[2].value.exp), (yystack_[0].value.exp)); }
+#line 884 "parser.cc"
+    break;
+
+  case 44: // exp: exp GREATEREQ exp
+#line 295 "lake.yy"
+      { (yylhs.value.exp) = new GreaterEqNode((yystack_[1].value.tokenValue)->_pos, (yystack_[2].value.exp), (yystack_[0].value.exp)); }
+#line 890 "parser.cc"
+    break;
+
+  case 45: // exp: DASH term
+#line 296 "lake.yy"
+                { (yylhs.value.exp) = new UnaryMinusNode((yystack_[0].value.exp)); }
+#line 896 "parser.cc"
+    break;
+
+  case 46: // exp: term
+#line 297 "lake.yy"
+           { (yylhs.value.exp) = (yystack_[0].value.exp); }
+#line 902 "parser.cc"
+    break;
+
+  case 47: // term: loc
+#line 299 "lake.yy"
+           { (yylhs.value.exp) = (yystack_[0].value.exp); }
+#line 908 "parser.cc"
+    break;
+
+  case 48: // term: INTLITERAL
+#line 300 "lake.yy"
+                  { (yylhs.value.exp) = new IntLitNode((yystack_[0].value.intTokenValue)); }
+#line 914 "parser.cc"
+    break;
+
+  case 49: // term: STRINGLITERAL
+#line 301 "lake.yy"
+                     { (yylhs.value.exp) = new StrLitNode((yystack_[0].value.strTokenValue)); }
+#line 920 "parser.cc"
+    break;
+
+  case 50: // term: TRUE
+#line 302 "lake.yy"
+            { (yylhs.value.exp) = new TrueNode((yystack_[0].value.tokenValue)->_pos); }
+#line 926 "parser.cc"
+    break;
+
+  case 51: // term: FALSE
+#line 303 "lake.yy"
+             { (yylhs.value.exp) = new FalseNode((yystack_[0].value.tokenValue)->_pos); }
+#line 932 "parser.cc"
+    break;
+
+  case 52: // term: LPAREN exp RPAREN
+#line 304 "lake.yy"
+                         { (yylhs.value.exp) = (yystack_[1].value.exp); }
+#line 938 "parser.cc"
+    break;
+
+  case 53: // term: fncall
+#line 305 "lake.yy"
+              { (yylhs.value.exp) = (yystack_[0].value.callNode); }
+#line 944 "parser.cc"
+    break;
+
+  case 54: // fncall: id LPAREN RPAREN
+#line 308 "lake.yy"
+        { 
+        (yylhs.value.callNode) = new CallExpNode((yystack_[2].value.idNode), new ExpListNode(new std::list<ExpNode *>()));
+        }
+#line 952 "parser.cc"
+    break;
+
+  case 55: // fncall: id LPAREN actualList RPAREN
+#line 312 "lake.yy"
+        { 
+        (yylhs.value.callNode) = new CallExpNode((yystack_[3].value.idNode), new ExpListNode((yystack_[1].value.expList))); 
+        }
+#line 960 "parser.cc"
+    break;
+
+  case 56: // actualList: exp
+#line 317 "lake.yy"
+        { 
+        std::list<ExpNode *> * list = new std::list<ExpNode *>();
+        list->push_back((yystack_[0].value.exp));
+        (yylhs.value.expList) = list;
+        }
+#line 970 "parser.cc"
+    break;
+
+  case 57: // actualList: actualList COMMA exp
+#line 323 "lake.yy"
+        {
+        (yystack_[2].value.expList)->push_back((yystack_[0].value.exp));
+        (yylhs.value.expList) = (yystack_[2].value.expList);
+        }
+#line 979 "parser.cc"
+    break;
+
+  case 58: // type: primtype ptrdepth
+#line 329 "lake.yy"
+        {
+	(yylhs.value.typeNode) = (yystack_[1].value.typeNode);
+	(yylhs.value.typeNode)->setPtrDepth((yystack_[0].value.counterTrans));
+	}
+#line 988 "parser.cc"
+    break;
+
+  case 59: // primtype: INT
+#line 334 "lake.yy"
+               { (yylhs.value.typeNode) = new IntNode((yystack_[0].value.tokenValue)->_pos); }
+#line 994 "parser.cc"
+    break;
+
+  case 60: // primtype: BOOL
+#line 335 "lake.yy"
+            { (yylhs.value.typeNode) = new BoolNode((yystack_[0].value.tokenValue)->_pos); }
+#line 1000 "parser.cc"
+    break;
+
+  case 61: // primtype: VOID
+#line 336 "lake.yy"
+            { (yylhs.value.typeNode) = new VoidNode((yystack_[0].value.tokenValue)->_pos); }
+#line 1006 "parser.cc"
+    break;
+
+  case 62: // ptrdepth: DEREF ptrdepth
+#line 339 "lake.yy"
+                          { (yylhs.value.counterTrans) = (yystack_[0].value.counterTrans) + 1; }
+#line 1012 "parser.cc"
+    break;
+
+  case 63: // ptrdepth: %empty
+#line 340 "lake.yy"
+                        { (yylhs.value.counterTrans) = 0; }
+#line 1018 "parser.cc"
+    break;
+
+  case 64: // loc: id
+#line 342 "lake.yy"
+         { (yylhs.value.exp) = (yystack_[0].value.idNode); }
+#line 1024 "parser.cc"
+    break;
+
+  case 65: // loc: DEREF loc
+#line 343 "lake.yy"
+                { (yylhs.value.exp) = new DerefNode((yystack_[1].value.tokenValue)->_pos, (yystack_[0].value.exp)); }
+#line 1030 "parser.cc"
+    break;
+
+  case 66: // id: ID
+#line 345 "lake.yy"
+        { (yylhs.value.idNode) = new IdNode((yystack_[0].value.idTokenValue)); }
+#line 1036 "parser.cc"
+    break;
+
+
+#line 1040 "parser.cc"
+
+            default:
+              break;
+            }
+        }
+#if YY_EXCEPTIONS
+      catch (const syntax_error& yyexc)
+        {
+          YYCDEBUG << "Caught exception: " << yyexc.what() << '\n';
+          error (yyexc);
+          YYERROR;
+        }
+#endif // YY_EXCEPTIONS
+      YY_SYMBOL_PRINT ("-> $$ =", yylhs);
+      yypop_ (yylen);
+      yylen = 0;
+
+      // Shift the result of the reduction.
+      yypush_ (YY_NULLPTR, YY_MOVE (yylhs));
+    }
+    goto yynewstate;
+
+
+  /*--------------------------------------.
+  | yyerrlab -- here on detecting error.  |
+  `--------------------------------------*/
+  yyerrlab:
+    // If not already recovering from an error, report this error.
+    if (!yyerrstatus_)
+      {
+        ++yynerrs_;
+        context yyctx (*this, yyla);
+        std::string msg = yysyntax_error_ (yyctx);
+        error (YY_MOVE (msg));
+      }
+
+
+    if (yyerrstatus_ == 3)
+      {
+        /* If just tried and failed to reuse lookahead token after an
+           error, discard it.  */
+
+        // Return failure if at end of input.
+        if (yyla.kind () == symbol_kind::S_YYEOF)
+          YYABORT;
+        else if (!yyla.empty ())
+          {
+            yy_destroy_ ("Error: discarding", yyla);
+            yyla.clear ();
+          }
+      }
+
+    // Else will try to reuse lookahead token after shifting the error token.
+    goto yyerrlab1;
+
+
+  /*---------------------------------------------------.
+  | yyerrorlab -- error raised explicitly by YYERROR.  |
+  `---------------------------------------------------*/
+  yyerrorlab:
+    /* Pacify compilers when the user code never invokes YYERROR and
+       the label yyerrorlab therefore never appears in user code.  */
+    if (false)
+      YYERROR;
+
+    /* Do not reclaim the symbols of the rule whose action triggered
+       this YYERROR.  */
+    yypop_ (yylen);
+    yylen = 0;
+    YY_STACK_PRINT ();
+    goto yyerrlab1;
+
+
+  /*-------------------------------------------------------------.
+  | yyerrlab1 -- common code for both syntax error and YYERROR.  |
+  `-------------------------------------------------------------*/
+  yyerrlab1:
+    yyerrstatus_ = 3;   // Each real token shifted decrements this.
+    // Pop stack until we find a state that shifts the error token.
+    for (;;)
+      {
+        yyn = yypact_[+yystack_[0].state];
+        if (!yy_pact_value_is_default_ (yyn))
+          {
+            yyn += symbol_kind::S_YYerror;
+            if (0 <= yyn && yyn <= yylast_
+                && yycheck_[yyn] == symbol_kind::S_YYerror)
+              {
+                yyn = yytable_[yyn];
+                if (0 < yyn)
+                  break;
+              }
+          }
+
+        // Pop the current state because it cannot handle the error token.
+        if (yystack_.size () == 1)
+          YYABORT;
+
+        yy_destroy_ ("Error: popping", yystack_[0]);
+        yypop_ ();
+        YY_STACK_PRINT ();
+      }
+    {
+      stack_symbol_type error_token;
+
+
+      // Shift the error token.
+      error_token.state = state_type (yyn);
+      yypush_ ("Shifting", YY_MOVE (error_token));
+    }
+    goto yynewstate;
+
+
+  /*-------------------------------------.
+  | yyacceptlab -- YYACCEPT comes here.  |
+  `-------------------------------------*/
+  yyacceptlab:
+    yyresult = 0;
+    goto yyreturn;
+
+
+  /*-----------------------------------.
+  | yyabortlab -- YYABORT comes here.  |
+  `-----------------------------------*/
+  yyabortlab:
+    yyresult = 1;
+    goto yyreturn;
+
+
+  /*-----------------------------------------------------.
+  | yyreturn -- parsing is finished, return the result.  |
+  `-----------------------------------------------------*/
+  yyreturn:
+    if (!yyla.empty ())
+      yy_destroy_ ("Cleanup: discarding lookahead", yyla);
+
+    /* Do not reclaim the symbols of the rule whose action triggered
+       this YYABORT or YYACCEPT.  */
+    yypop_ (yylen);
+    YY_STACK_PRINT ();
+    while (1 < yystack_.size ())
+      {
+        yy_destroy_ ("Cleanup: popping", yystack_[0]);
+        yypop_ ();
+      }
+
+    return yyresult;
+  }
+#if YY_EXCEPTIONS
+    catch (...)
+      {
+        YYCDEBUG << "Exception caught: cleaning lookahead and stack\n";
+        // Do not try to display the values of the reclaimed symbols,
+        // as their printers might throw an exception.
+        if (!yyla.empty ())
+          yy_destroy_ (YY_NULLPTR, yyla);
+
+        while (1 < yystack_.size ())
+          {
+            yy_destroy_ (YY_NULLPTR, yystack_[0]);
+            yypop_ ();
+          }
+        throw;
+      }
+#endif // YY_EXCEPTIONS
+  }
+
+  void
+  Parser::error (const syntax_error& yyexc)
+  {
+    error (yyexc.what ());
+  }
+
+  /* Return YYSTR after stripping away unnecessary quotes and
+     backslashes, so that it's suitable for yyerror.  The heuristic is
+     that double-quoting is unnecessary unless the string contains an
+     apostrophe, a comma, or backslash (other than backslash-backslash).
+     YYSTR is taken from yytname.  */
+  std::string
+  Parser::yytnamerr_ (const char *yystr)
+  {
+    if (*yystr == '"')
+      {
+        std::string yyr;
+        char const *yyp = yystr;
+
+        for (;;)
+          switch (*++yyp)
+            {
+            case '\'':
+            case ',':
+              goto do_not_strip_quotes;
+
+            case '\\':
+              if (*++yyp != '\\')
+                goto do_not_strip_quotes;
+              else
+                goto append;
+
+            append:
+            default:
+              yyr += *yyp;
+              break;
+
+            case '"':
+              return yyr;
+            }
+      do_not_strip_quotes: ;
+      }
+
+    return yystr;
+  }
+
+  std::string
+  Parser::symbol_name (symbol_kind_type yysymbol)
+  {
+    return yytnamerr_ (yytname_[yysymbol]);
+  }
+
+
+
+  // Parser::context.
+  Parser::context::context (const Parser& yyparser, const symbol_type& yyla)
+    : yyparser_ (yyparser)
+    , yyla_ (yyla)
+  {}
+
+  int
+  Parser::context::expected_tokens (symbol_kind_type yyarg[], int yyargn) const
+  {
+    // Actual number of expected tokens
+    int yycount = 0;
+
+    const int yyn = yypact_[+yyparser_.yystack_[0].state];
+    if (!yy_pact_value_is_default_ (yyn))
+      {
+        /* Start YYX at -YYN if negative to avoid negative indexes in
+           YYCHECK.  In other words, skip the first -YYN actions for
+           this state because they are default actions.  */
+        const int yyxbegin = yyn < 0 ? -yyn : 0;
+        // Stay within bounds of both yycheck and yytname.
+        const int yychecklim = yylast_ - yyn + 1;
+        const int yyxend = yychecklim < YYNTOKENS ? yychecklim : YYNTOKENS;
+        for (int yyx = yyxbegin; yyx < yyxend; ++yyx)
+          if (yycheck_[yyx + yyn] == yyx && yyx != symbol_kind::S_YYerror
+              && !yy_table_value_is_error_ (yytable_[yyx + yyn]))
+            {
+              if (!yyarg)
+                ++yycount;
+              else if (yycount == yyargn)
+                return 0;
+              else
+                yyarg[yycount++] = YY_CAST (symbol_kind_type, yyx);
+            }
+      }
+
+    if (yyarg && yycount == 0 && 0 < yyargn)
+      yyarg[0] = symbol_kind::S_YYEMPTY;
+    return yycount;
+  }
+
+
+
+
+
+
+  int
+  Parser::yy_syntax_error_arguments_ (const context& yyctx,
+                                                 symbol_kind_type yyarg[], int yyargn) const
+  {
+    /* There are many possibilities here to consider:
+       - If this state is a consistent state with a default action, then
+         the only way this function was invoked is if the default action
+         is an error action.  In that case, don't check for expected
+         tokens because there are none.
+       - The only way there can be no lookahead present (in yyla) is
+         if this state is a consistent state with a default action.
+         Thus, detecting the absence of a lookahead is sufficient to
+         determine that there is no unexpected or expected token to
+         report.  In that case, just report a simple "syntax error".
+       - Don't assume there isn't a lookahead just because this state is
+         a consistent state with a default action.  There might have
+         been a previous inconsistent state, consistent state with a
+         non-default action, or user semantic action that manipulated
+         yyla.  (However, yyla is currently not documented for users.)
+       - Of course, the expected token list depends on states to have
+         correct lookahead information, and it depends on the parser not
+         to perform extra reductions after fetching a lookahead from the
+         scanner and before detecting a syntax error.  Thus, state merging
+         (from LALR or IELR) and default reductions corrupt the expected
+         token list.  However, the list is correct for canonical LR with
+         one exception: it will still contain any token that will not be
+         accepted due to an error action in a later state.
+    */
+
+    if (!yyctx.lookahead ().empty ())
+      {
+        if (yyarg)
+          yyarg[0] = yyctx.token ();
+        int yyn = yyctx.expected_tokens (yyarg ? yyarg + 1 : yyarg, yyargn - 1);
+        return yyn + 1;
+      }
+    return 0;
+  }
+
+  // Generate an error message.
+  std::string
+  Parser::yysyntax_error_ (const context& yyctx) const
+  {
+    // Its maximum.
+    enum { YYARGS_MAX = 5 };
+    // Arguments of yyformat.
+    symbol_kind_type yyarg[YYARGS_MAX];
+    int yycount = yy_syntax_error_arguments_ (yyctx, yyarg, YYARGS_MAX);
+
+    char const* yyformat = YY_NULLPTR;
+    switch (yycount)
+      {
+#define YYCASE_(N, S)                         \
+        case N:                               \
+          yyformat = S;                       \
+        break
+      default: // Avoid compiler warnings.
+        YYCASE_ (0, YY_("syntax error"));
+        YYCASE_ (1, YY_("syntax error, unexpected %s"));
+        YYCASE_ (2, YY_("syntax error, unexpected %s, expecting %s"));
+        YYCASE_ (3, YY_("syntax error, unexpected %s, expecting %s or %s"));
+        YYCASE_ (4, YY_("syntax error, unexpected %s, expecting %s or %s or %s"));
+        YYCASE_ (5, YY_("syntax error, unexpected %s, expecting %s or %s or %s or %s"));
+#undef YYCASE_
+      }
+
+    std::string yyres;
+    // Argument number.
+    std::ptrdiff_t yyi = 0;
+    for (char const* yyp = yyformat; *yyp; ++yyp)
+      if (yyp[0] == '%' && yyp[1] == 's' && yyi < yycount)
+        {
+          yyres += symbol_name (yyarg[yyi++]);
+          ++yyp;
+        }
+      else
+        yyres += *yyp;
+    return yyres;
+  }
+
+
+  const signed char Parser::yypact_ninf_ = -97;
+
+  const signed char Parser::yytable_ninf_ = -1;
+
+  const short
+  Parser::yypact_[] =
+  {
+     -97,     5,    54,   -97,   -97,   -97,   -97,   -97,   -97,   -97,
+       2,     6,   -97,    -4,     6,   -97,    21,   -97,    20,   -97,
+     -97,    22,    41,     2,   -97,   -97,   -97,    54,   -97,    54,
+     -97,   -97,    56,     2,    53,    66,    48,   -97,   103,    -7,
+      -7,   -97,    50,    52,   -14,    67,    64,   103,   103,   -97,
+     -97,   -97,   -97,   103,   -97,   128,   103,   -97,   223,   -97,
+     -97,    45,   244,    73,   -97,   -97,   -97,   -97,    75,    77,
+     103,    94,   125,   149,   164,   -97,   -97,   -97,   -97,   103,
+     103,   103,   103,   103,   103,   103,   103,   103,   103,   103,
+     103,   -97,   -97,   -97,   -97,   259,   -97,   259,    12,    87,
+      88,   -97,    24,    24,   -97,   -97,   289,   274,   304,   304,
+     304,   304,   304,   304,   -97,   103,   -97,   -97,   259,    54,
+      54,   198,   207,    95,   -97,    90,   -97,    54,   224,   -97
+  };
+
+  const signed char
+  Parser::yydefact_[] =
+  {
+       4,     0,     2,     1,    60,    59,    61,     3,     5,     6,
+       0,    63,    66,     0,    63,    58,     0,     9,     0,    62,
+      11,     0,    13,     0,     8,    10,    12,     0,    16,    17,
+      14,     7,     0,     0,     0,     0,     0,    15,     0,     0,
+       0,    18,     0,     0,     0,    64,     0,     0,     0,    50,
+      51,    48,    49,     0,    28,     0,     0,    31,     0,    46,
+      53,    47,     0,     0,    64,    65,    19,    29,     0,     0,
+       0,     0,     0,     0,     0,    45,    47,    36,    27,     0,
+       0,     0,     0,     0,     0,     0,     0,     0,     0,     0,
+       0,    23,    22,    20,    21,    30,    54,    56,     0,     0,
+       0,    52,    32,    33,    34,    35,    37,    38,    39,    40,
+      41,    42,    43,    44,    55,     0,     8,     8,    57,    17,
+      17,     0,     0,    24,    26,     0,     8,    17,     0,    25
+  };
+
+  const signed char
+  Parser::yypgoto_[] =
+  {
+     -97,   -97,   -97,   -97,   -96,   112,   -97,   -97,    92,   -97,
+     -97,   -44,   -97,   -30,   -37,    60,   -28,   -97,     1,   -97,
+     106,   -32,    -1
+  };
+
+  const signed char
+  Parser::yydefgoto_[] =
+  {
+       0,     1,     2,     7,    29,    31,     9,    18,    21,    25,
+      22,    32,    41,    57,    58,    59,    60,    98,    33,    11,
+      15,    61,    45
+  };
+
+  const short
+  Parser::yytable_[] =
+  {
+      44,    62,    42,    10,    43,     3,    12,    63,    65,    13,
+      72,    73,    68,    69,    16,    12,    74,    23,    17,    77,
+     119,   120,    28,    76,    40,     4,     5,     6,    23,    70,
+     127,   114,    46,    95,    97,   115,    24,    14,    64,    64,
+      20,    26,   102,   103,   104,   105,   106,   107,   108,   109,
+     110,   111,   112,   113,    81,    49,    50,    82,     4,     5,
+       6,    12,    51,    52,    27,    34,    53,    35,    36,    12,
+      54,    47,    66,    37,    67,   121,   122,    55,   118,    40,
+      38,    39,    56,   128,    48,    71,    17,    40,    70,    44,
+      44,    42,    42,    43,    43,    92,    44,    93,    42,    94,
+      43,    49,    50,   116,   117,   125,   126,    12,    51,    52,
+      49,    50,    53,    96,     8,    75,    12,    51,    52,    30,
+      19,    53,     0,    55,     0,    40,     0,     0,    56,     0,
+       0,     0,    55,     0,    40,    49,    50,    56,     0,     0,
+       0,    12,    51,    52,    99,     0,    53,     0,     0,     0,
+       0,     0,     0,    79,    80,    81,     0,     0,    82,    40,
+      83,    84,    85,    86,    87,    88,    89,    90,   100,     0,
+       0,     0,     0,     0,     0,     0,     0,    79,    80,    81,
+       0,     0,    82,   101,    83,    84,    85,    86,    87,    88,
+      89,    90,    79,    80,    81,     0,     0,    82,     0,    83,
+      84,    85,    86,    87,    88,    89,    90,    34,     0,    35,
+      36,    12,     0,     0,     0,   123,    34,     0,    35,    36,
+      12,     0,    38,    39,   124,     0,     0,     0,     0,    40,
+       0,    38,    39,    34,     0,    35,    36,    12,    40,     0,
+       0,   129,     0,     0,     0,    78,     0,     0,    38,    39,
+       0,    79,    80,    81,     0,    40,    82,     0,    83,    84,
+      85,    86,    87,    88,    89,    90,    91,     0,     0,     0,
+       0,     0,    79,    80,    81,     0,     0,    82,     0,    83,
+      84,    85,    86,    87,    88,    89,    90,    79,    80,    81,
+       0,     0,    82,     0,    83,    84,    85,    86,    87,    88,
+      89,    90,    79,    80,    81,     0,     0,    82,     0,    83,
+       0,    85,    86,    87,    88,    89,    90,    79,    80,    81,
+       0,     0,    82,     0,     0,     0,    85,    86,    87,    88,
+      89,    90,    79,    80,    81,     0,     0,    82,     0,     0,
+       0,    -1,    -1,    -1,    -1,    -1,    -1
+  };
+
+  const short
+  Parser::yycheck_[] =
+  {
+      32,    38,    32,     2,    32,     0,    13,    39,    40,    10,
+      47,    48,    26,    27,    18,    13,    53,    16,    22,    56,
+     116,   117,    23,    55,    31,     4,     5,     6,    27,    43,
+     126,    19,    33,    70,    71,    23,    16,    31,    39,    40,
+      19,    19,    79,    80,    81,    82,    83,    84,    85,    86,
+      87,    88,    89,    90,    30,     7,     8,    33,     4,     5,
+       6,    13,    14,    15,    23,     9,    18,    11,    12,    13,
+      22,    18,    22,    17,    22,   119,   120,    29,   115,    31,
+      24,    25,    34,   127,    18,    18,    22,    31,    43,   121,
+     122,   121,   122,   121,   122,    22,   128,    22,   128,    22,
+     128,     7,     8,    16,    16,    10,    16,    13,    14,    15,
+       7,     8,    18,    19,     2,    55,    13,    14,    15,    27,
+      14,    18,    -1,    29,    -1,    31,    -1,    -1,    34,    -1,
+      -1,    -1,    29,    -1,    31,     7,     8,    34,    -1,    -1,
+      -1,    13,    14,    15,    19,    -1,    18,    -1,    -1,    -1,
+      -1,    -1,    -1,    28,    29,    30,    -1,    -1,    33,    31,
+      35,    36,    37,    38,    39,    40,    41,    42,    19,    -1,
+      -1,    -1,    -1,    -1,    -1,    -1,    -1,    28,    29,    30,
+      -1,    -1,    33,    19,    35,    36,    37,    38,    39,    40,
+      41,    42,    28,    29,    30,    -1,    -1,    33,    -1,    35,
+      36,    37,    38,    39,    40,    41,    42,     9,    -1,    11,
+      12,    13,    -1,    -1,    -1,    17,     9,    -1,    11,    12,
+      13,    -1,    24,    25,    17,    -1,    -1,    -1,    -1,    31,
+      -1,    24,    25,     9,    -1,    11,    12,    13,    31,    -1,
+      -1,    17,    -1,    -1,    -1,    22,    -1,    -1,    24,    25,
+      -1,    28,    29,    30,    -1,    31,    33,    -1,    35,    36,
+      37,    38,    39,    40,    41,    42,    22,    -1,    -1,    -1,
+      -1,    -1,    28,    29,    30,    -1,    -1,    33,    -1,    35,
+      36,    37,    38,    39,    40,    41,    42,    28,    29,    30,
+      -1,    -1,    33,    -1,    35,    36,    37,    38,    39,    40,
+      41,    42,    28,    29,    30,    -1,    -1,    33,    -1,    35,
+      -1,    37,    38,    39,    40,    41,    42,    28,    29,    30,
+      -1,    -1,    33,    -1,    -1,    -1,    37,    38,    39,    40,
+      41,    42,    28,    29,    30,    -1,    -1,    33,    -1,    -1,
+      -1,    37,    38,    39,    40,    41,    42
+  };
+
+  const signed char
+  Parser::yystos_[] =
+  {
+       0,    45,    46,     0,     4,     5,     6,    47,    49,    50,
+      62,    63,    13,    66,    31,    64,    18,    22,    51,    64,
+      19,    52,    54,    62,    16,    53,    19,    23,    66,    48,
+      52,    49,    55,    62,     9,    11,    12,    17,    24,    25,
+      31,    56,    57,    60,    65,    66,    66,    18,    18,     7,
+       8,    14,    15,    18,    22,    29,    34,    57,    58,    59,
+      60,    65,    58,    65,    66,    65,    22,    22,    26,    27,
+      43,    18,    58,    58,    58,    59,    65,    58,    22,    28,
+      29,    30,    33,    35,    36,    37,    38,    39,    40,    41,
+      42,    22,    22,    22,    22,    58,    19,    58,    61,    19,
+      19,    19,    58,    58,    58,    58,    58,    58,    58,    58,
+      58,    58,    58,    58,    19,    23,    16,    16,    58,    48,
+      48,    55,    55,    17,    17,    10,    16,    48,    55,    17
+  };
+
+  const signed char
+  Parser::yyr1_[] =
+  {
+       0,    44,    45,    46,    46,    47,    47,    48,    48,    49,
+      50,    51,    51,    52,    52,    53,    54,    55,    55,    56,
+      56,    56,    56,    56,    56,    56,    56,    56,    56,    56,
+      57,    58,    58,    58,    58,    58,    58,    58,    58,    58,
+      58,    58,    58,    58,    58,    58,    58,    59,    59,    59,
+      59,    59,    59,    59,    60,    60,    61,    61,    62,    63,
+      63,    63,    64,    64,    65,    65,    66
+  };
+
+  const signed char
+  Parser::yyr2_[] =
+  {
+       0,     2,     1,     2,     0,     1,     1,     2,     0,     3,
+       4,     2,     3,     1,     3,     4,     2,     0,     2,     2,
+       3,     3,     3,     3,     8,    13,     8,     3,     2,     2,
+       3,     1,     3,     3,     3,     3,     2,     3,     3,     3,
+       3,     3,     3,     3,     3,     2,     1,     1,     1,     1,
+       1,     1,     3,     1,     3,     4,     1,     3,     2,     1,
+       1,     1,     2,     0,     1,     2,     1
+  };
+
+
+#if YYDEBUG || 1
+  // YYTNAME[SYMBOL-NUM] -- String name of the symbol SYMBOL-NUM.
+  // First, the terminals, then, starting at \a YYNTOKENS, nonterminals.
+  const char*
+  const Parser::yytname_[] =
+  {
+  "\"end of file\"", "error", "\"invalid token\"", "CHAR", "BOOL", "INT",
+  "VOID", "TRUE", "FALSE", "IF", "ELSE", "WHILE", "RETURN", "ID",
+  "INTLITERAL", "STRINGLITERAL", "LCURLY", "RCURLY", "LPAREN", "RPAREN",
+  "LBRACE", "RBRACE", "SEMICOLON", "COMMA", "WRITE", "READ", "CROSSCROSS",
+  "DASHDASH", "CROSS", "DASH", "STAR", "DEREF", "REF", "SLASH", "NOT",
+  "AND", "OR", "EQUALS", "NOTEQUALS", "LESS", "GREATER", "LESSEQ",
+  "GREATEREQ", "ASSIGN", "$accept", "program", "declList", "decl",
+  "varDeclList", "varDecl", "fnDecl", "formals", "formalsList", "fnBody",
+  "formalDecl", "stmtList", "stmt", "assignExp", "exp", "term", "fncall",
+  "actualList", "type", "primtype", "ptrdepth", "loc", "id", YY_NULLPTR
+  };
+#endif
+
+
+#if YYDEBUG
+  const short
+  Parser::yyrline_[] =
+  {
+       0,   160,   160,   166,   178,   182,   183,   185,   186,   188,
+     191,   194,   196,   199,   205,   211,   216,   220,   221,   227,
+     228,   229,   230,   231,   232,   239,   249,   254,   256,   258,
+     261,   264,   266,   269,   271,   274,   276,   278,   281,   284,
+     286,   288,   290,   292,   294,   296,   297,   299,   300,   301,
+     302,   303,   304,   305,   307,   311,   316,   322,   328,   334,
+     335,   336,   339,   340,   342,   343,   345
+  };
+
+  void
+  Parser::yy_stack_print_ () const
+  {
+    *yycdebug_ << "Stack now";
+    for (stack_type::const_iterator
+           i = yystack_.begin (),
+           i_end = yystack_.end ();
+         i != i_end; ++i)
+      *yycdebug_ << ' ' << int (i->state);
+    *yycdebug_ << '\n';
+  }
+
+  void
+  Parser::yy_reduce_print_ (int yyrule) const
+  {
+    int yylno = yyrline_[yyrule];
+    int yynrhs = yyr2_[yyrule];
+    // Print the symbols being reduced, and their result.
+    *yycdebug_ << "Reducing stack by rule " << yyrule - 1
+               << " (line " << yylno << "):\n";
+    // The symbols being reduced.
+    for (int yyi = 0; yyi < yynrhs; yyi++)
+      YY_SYMBOL_PRINT ("   $" << yyi + 1 << " =",
+                       yystack_[(yynrhs) - (yyi + 1)]);
+  }
+#endif // YYDEBUG
+
+  Parser::symbol_kind_type
+  Parser::yytranslate_ (int t) YY_NOEXCEPT
+  {
+    // YYTRANSLATE[TOKEN-NUM] -- Symbol number corresponding to
+    // TOKEN-NUM as returned by yylex.
+    static
+    const signed char
+    translate_table[] =
+    {
+       0,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
+       2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
+       5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
+      15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
+      25,    26,    27,    28,    29,    30,    31,    32,    33,    34,
+      35,    36,    37,    38,    39,    40,    41,    42,    43
+    };
+    // Last valid token kind.
+    const int code_max = 298;
+
+    if (t <= 0)
+      return symbol_kind::S_YYEOF;
+    else if (t <= code_max)
+      return static_cast <symbol_kind_type> (translate_table[t]);
+    else
+      return symbol_kind::S_YYUNDEF;
+  }
+
+#line 5 "lake.yy"
+} // lake
+#line 1680 "parser.cc"
+
+#line 347 "lake.yy"
+
+void
+lake::Parser::error(const std::string & err_msg)
+{
+   lake::Err::syntaxReport(err_msg);
+}
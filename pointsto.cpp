@@ -0,0 +1,214 @@
+#include <algorithm>
+#include "pointsto.hpp"
+#include "walker.hpp"
+
+namespace lake{
+
+namespace {
+//Turns each pointer-valued expression into the node holding its
+// value, and each assignment, argument, return and @ involving
+// pointers into constraints between nodes. Expressions are done
+// on the way out, once their children have their nodes.
+class ConstraintBuilder : public ASTVisitor{
+public:
+	ConstraintBuilder(PointsTo * ptIn, TypeAnalysis * taIn)
+	: pt(ptIn), ta(taIn), fn(nullptr){ }
+	bool pre(ASTNode * node, int ctx) override{
+		if (FnDeclNode * decl = dynamic_cast<FnDeclNode *>(node)){
+			fn = decl->getDeclaredID()->getSymbol();
+			formals[fn].clear();
+		} else if (FormalDeclNode * formal
+			= dynamic_cast<FormalDeclNode *>(node)){
+			formals[fn].push_back(formal->getDeclaredID()->getSymbol());
+			return false;
+		} else if (dynamic_cast<DeclNode *>(node) != nullptr){
+			return false;
+		}
+		return true;
+	}
+	void post(ASTNode * node, int ctx) override{
+		if (dynamic_cast<FnDeclNode *>(node) != nullptr){
+			fn = nullptr;
+			return;
+		}
+		std::vector<ASTNode *> children;
+		node->getChildren(children);
+		if (IdNode * id = dynamic_cast<IdNode *>(node)){
+			SemSymbol * sym = id->getSymbol();
+			if (sym != nullptr && sym->getKind() == VAR && isPtr(id)){
+				values[id] = pt->varNode(sym);
+			}
+		} else if (DerefNode * deref = dynamic_cast<DerefNode *>(node)){
+			uint32_t p = valueOf(children[0]);
+			pt->addDeref(deref, p);
+			if (isPtr(deref)){
+				uint32_t loaded = pt->newNode();
+				pt->load(loaded, p);
+				values[deref] = loaded;
+			}
+		} else if (AssignNode * assign = dynamic_cast<AssignNode *>(node)){
+			if (!isPtr(assign)){ return; }
+			uint32_t src = valueOf(children[1]);
+			if (DerefNode * tgt = dynamic_cast<DerefNode *>(children[0])){
+				std::vector<ASTNode *> tgtChildren;
+				tgt->getChildren(tgtChildren);
+				pt->store(valueOf(tgtChildren[0]), src);
+			} else {
+				pt->copy(valueOf(children[0]), src);
+			}
+			values[assign] = src;
+		} else if (CallExpNode * call = dynamic_cast<CallExpNode *>(node)){
+			SemSymbol * callee = call->getCallee()->getSymbol();
+			const std::vector<SemSymbol *>& params = formals[callee];
+			size_t i = 0;
+			for (ExpNode * arg : *call->getArgs()->getList()){
+				if (i < params.size() && params[i] != nullptr
+					&& isPtr(arg)){
+					pt->copy(pt->varNode(params[i]), valueOf(arg));
+				}
+				i++;
+			}
+			if (isPtr(call)){
+				values[call] = pt->resultNode(callee);
+			}
+		} else if (dynamic_cast<ReturnStmtNode *>(node) != nullptr){
+			if (!children.empty() && fn != nullptr && isPtr(children[0])){
+				pt->copy(pt->resultNode(fn), valueOf(children[0]));
+			}
+		}
+	}
+private:
+	bool isPtr(ASTNode * node){
+		const DataType * type = ta->nodeType(node);
+		return type != nullptr && type->isPtr();
+	}
+	//The node of a pointer-valued expression, which is a fresh
+	// one (so, always null) for anything that was not given one
+	uint32_t valueOf(ASTNode * node){
+		auto found = values.find(node);
+		if (found != values.end()){ return found->second; }
+		uint32_t res = pt->newNode();
+		values[node] = res;
+		return res;
+	}
+
+	PointsTo * pt;
+	TypeAnalysis * ta;
+	SemSymbol * fn;
+	HashMap<SemSymbol *, std::vector<SemSymbol *>> formals;
+	HashMap<ASTNode *, uint32_t> values;
+};
+}
+
+PointsTo::PointsTo(ProgramNode * root, TypeAnalysis * ta){
+	ConstraintBuilder builder(this, ta);
+	walk(root, builder);
+	solve();
+}
+
+uint32_t PointsTo::newNode(){
+	pts.emplace_back();
+	edges.emplace_back();
+	loads.emplace_back();
+	stores.emplace_back();
+	vars.push_back(nullptr);
+	return static_cast<uint32_t>(pts.size() - 1);
+}
+
+uint32_t PointsTo::varNode(SemSymbol * var){
+	auto found = varNodes.find(var);
+	if (found != varNodes.end()){ return found->second; }
+	uint32_t res = newNode();
+	vars[res] = var;
+	varNodes[var] = res;
+	return res;
+}
+
+uint32_t PointsTo::resultNode(SemSymbol * fn){
+	auto found = resultNodes.find(fn);
+	if (found != resultNodes.end()){ return found->second; }
+	uint32_t res = newNode();
+	resultNodes[fn] = res;
+	return res;
+}
+
+void PointsTo::copy(uint32_t dst, uint32_t src){
+	edges[src].push_back(dst);
+}
+
+void PointsTo::load(uint32_t dst, uint32_t p){
+	loads[p].push_back(dst);
+}
+
+void PointsTo::store(uint32_t p, uint32_t src){
+	stores[p].push_back(src);
+}
+
+void PointsTo::addEdge(uint32_t from, uint32_t to){
+	std::vector<uint32_t>& out = edges[from];
+	if (std::find(out.begin(), out.end(), to) != out.end()){ return; }
+	out.push_back(to);
+	worklist.push_back(from);
+}
+
+//Sets only grow, so a node is looked at again whenever its set
+// or its edges do, until nothing changes
+void PointsTo::solve(){
+	for (uint32_t n = 0; n < pts.size(); n++){
+		worklist.push_back(n);
+	}
+	while (!worklist.empty()){
+		uint32_t n = worklist.back();
+		worklist.pop_back();
+		//Copies over a pointer's loads and stores, once per
+		// variable it may point at
+		for (uint32_t v : pts[n]){
+			for (uint32_t dst : loads[n]){ addEdge(v, dst); }
+			for (uint32_t src : stores[n]){ addEdge(src, v); }
+		}
+		for (uint32_t m : edges[n]){
+			std::vector<uint32_t> merged;
+			std::set_union(pts[m].begin(), pts[m].end(),
+				pts[n].begin(), pts[n].end(),
+				std::back_inserter(merged));
+			if (merged.size() != pts[m].size()){
+				pts[m].swap(merged);
+				worklist.push_back(m);
+			}
+		}
+	}
+	pointedAt.assign(pts.size(), false);
+	for (const std::vector<uint32_t>& set : pts){
+		for (uint32_t v : set){ pointedAt[v] = true; }
+	}
+}
+
+std::vector<SemSymbol *> PointsTo::targets(DerefNode * deref) const {
+	std::vector<SemSymbol *> res;
+	auto found = derefs.find(deref);
+	if (found == derefs.end()){ return res; }
+	for (uint32_t v : pts[found->second]){
+		res.push_back(vars[v]);
+	}
+	return res;
+}
+
+bool PointsTo::mayAlias(DerefNode * deref, SemSymbol * var) const {
+	std::vector<SemSymbol *> vs = targets(deref);
+	return std::find(vs.begin(), vs.end(), var) != vs.end();
+}
+
+bool PointsTo::addressTaken(SemSymbol * var) const {
+	auto found = varNodes.find(var);
+	return found != varNodes.end() && pointedAt[found->second];
+}
+
+size_t PointsTo::numNullDerefs() const {
+	size_t res = 0;
+	for (auto entry : derefs){
+		if (pts[entry.second].empty()){ res++; }
+	}
+	return res;
+}
+
+}
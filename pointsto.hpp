@@ -0,0 +1,73 @@
+#ifndef LAKE_POINTSTO_HPP
+#define LAKE_POINTSTO_HPP
+
+#include <cstdint>
+#include <vector>
+#include "ast.hpp"
+#include "symbol_table.hpp"
+#include "types.hpp"
+
+namespace lake{
+
+//Which variables each pointer in a type-checked program may
+// point at, found by a flow-insensitive, inclusion-based
+// (Andersen-style) analysis: assignments, arguments and returns
+// of pointers make the left side's set include the right side's,
+// and loads and stores through @ do the same for whatever the
+// pointer's set holds.
+//
+// Lake has no way to take a variable's address, so nothing ever
+// puts a variable into a set to start with, and every set ends
+// up empty: every pointer is null, and no store through @ can
+// change a variable. Lowering relies on that to keep variables
+// in registers and globals in words of their own, and the
+// optimizer relies on it when it moves loads of globals past
+// stores through @ (see IRProgram::pointedAt).
+class PointsTo{
+public:
+	PointsTo(ProgramNode * root, TypeAnalysis * ta);
+	//The variables that @ may read or write
+	std::vector<SemSymbol *> targets(DerefNode * deref) const;
+	bool mayAlias(DerefNode * deref, SemSymbol * var) const;
+	//Whether any pointer at all may point at var
+	bool addressTaken(SemSymbol * var) const;
+	size_t numDerefs() const { return derefs.size(); }
+	//How many @ have an empty set, so that they can only ever
+	// dereference null
+	size_t numNullDerefs() const;
+
+	//The analysis works on nodes, which are variables, function
+	// results and values loaded through @. A variable's node
+	// stands both for the variable and for where it is.
+	uint32_t newNode();
+	uint32_t varNode(SemSymbol * var);
+	uint32_t resultNode(SemSymbol * fn);
+	//dst includes src
+	void copy(uint32_t dst, uint32_t src);
+	//dst includes what @p holds
+	void load(uint32_t dst, uint32_t p);
+	//What @p holds includes src
+	void store(uint32_t p, uint32_t src);
+	void addDeref(DerefNode * deref, uint32_t p){ derefs[deref] = p; }
+private:
+	void solve();
+	void addEdge(uint32_t from, uint32_t to);
+
+	std::vector<SemSymbol *> vars;
+	HashMap<SemSymbol *, uint32_t> varNodes;
+	HashMap<SemSymbol *, uint32_t> resultNodes;
+	//Each node's points-to set, as variable nodes in order
+	std::vector<std::vector<uint32_t>> pts;
+	std::vector<std::vector<uint32_t>> edges;
+	//The loads from and stores through each pointer node, by
+	// the node on their other side
+	std::vector<std::vector<uint32_t>> loads;
+	std::vector<std::vector<uint32_t>> stores;
+	HashMap<DerefNode *, uint32_t> derefs;
+	std::vector<bool> pointedAt;
+	std::vector<uint32_t> worklist;
+};
+
+}
+
+#endif
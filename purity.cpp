@@ -0,0 +1,111 @@
+#include "purity.hpp"
+#include "callgraph.hpp"
+#include "symbol_table.hpp"
+#include "types.hpp"
+#include "walker.hpp"
+
+namespace lake{
+
+//Whether a type is one a memo table can hold as a word
+static bool isScalar(const DataType * type){
+	return type->isInt() || type->isBool();
+}
+
+namespace {
+//Checks one function, from its FnDeclNode down, against what is
+// known so far of the functions it calls
+class PurityCheck : public ASTVisitor{
+public:
+	PurityCheck(const CallGraph& graphIn, const std::vector<char>& pureIn)
+	: graph(graphIn), known(pureIn), pure(false){ }
+	bool pre(ASTNode * node, int ctx) override{
+		//Types are taken from the symbols name analysis made, not
+		// from the declarations' type nodes, which look theirs
+		// up in a table shared by every thread
+		if (FnDeclNode * decl = dynamic_cast<FnDeclNode *>(node)){
+			SemSymbol * sym = decl->getDeclaredID()->getSymbol();
+			if (sym == nullptr){
+				throw new InternalError("Purity of an unchecked function");
+			}
+			const FnType * type = sym->getType()->asFn();
+			pure = isScalar(type->getReturnType());
+			return true;
+		}
+		if (DeclNode * decl = dynamic_cast<DeclNode *>(node)){
+			SemSymbol * sym = decl->getDeclaredID()->getSymbol();
+			if (sym == nullptr){
+				throw new InternalError("Purity of an unchecked declaration");
+			}
+			const DataType * type = sym->getType();
+			if (dynamic_cast<FormalDeclNode *>(decl) != nullptr
+				&& !isScalar(type)){
+				pure = false;
+			} else if (type->isPtr()){
+				pure = false;
+			}
+			own[sym] = true;
+			return false;
+		}
+		if (!pure){ return false; }
+		if (dynamic_cast<ReadStmtNode *>(node) != nullptr
+			|| dynamic_cast<WriteStmtNode *>(node) != nullptr
+			|| dynamic_cast<DerefNode *>(node) != nullptr){
+			pure = false;
+			return false;
+		}
+		if (IdNode * id = dynamic_cast<IdNode *>(node)){
+			SemSymbol * sym = id->getSymbol();
+			if (sym == nullptr){ return false; }
+			if (sym->getKind() == VAR){
+				if (own.find(sym) == own.end()){ pure = false; }
+			} else {
+				uint32_t f = graph.number(sym);
+				if (f == UINT32_MAX || !known[f]){ pure = false; }
+			}
+			return false;
+		}
+		return true;
+	}
+	bool isPure() const { return pure; }
+private:
+	const CallGraph& graph;
+	const std::vector<char>& known;
+	bool pure;
+	//The function's parameters and locals
+	HashMap<SemSymbol *, bool> own;
+};
+}
+
+//The functions of a component are taken to be pure until one is
+// found not to be, which may then spoil the others that call it
+std::vector<std::string> findPureFunctions(ProgramNode * root,
+	unsigned threads){
+	CallGraph graph(root);
+	//Not a vector<bool>, whose entries share words, since
+	// components on different threads set their own at once
+	std::vector<char> pure(graph.size(), 0);
+	forEachBottomUp(graph, threads,
+		[&](uint32_t c, const std::vector<uint32_t>& fns){
+		for (uint32_t f : fns){ pure[f] = 1; }
+		bool changed = true;
+		while (changed){
+			changed = false;
+			for (uint32_t f : fns){
+				if (!pure[f]){ continue; }
+				PurityCheck check(graph, pure);
+				walk(graph.decl(f), check);
+				if (!check.isPure()){
+					pure[f] = 0;
+					changed = true;
+				}
+			}
+		}
+	});
+	std::vector<std::string> names;
+	for (uint32_t f = 0; f < graph.size(); f++){
+		if (pure[f]){ names.push_back(graph.symbol(f)->getName()); }
+	}
+	return names;
+}
+
+}
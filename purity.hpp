@@ -0,0 +1,23 @@
+#ifndef LAKE_PURITY_HPP
+#define LAKE_PURITY_HPP
+
+#include <string>
+#include <vector>
+#include "ast.hpp"
+
+namespace lake{
+
+//The functions of a type-checked program whose result depends
+// on nothing but their arguments, in declaration order. A pure
+// function takes and returns ints or bools, and never reads or
+// writes, touches a global, declares a pointer or goes through
+// one, or calls anything but itself and earlier pure functions.
+// Calling one again with the same arguments is sure to give the
+// same result, and to do nothing else. Functions are checked
+// callees first, on up to threads threads (see forEachBottomUp).
+std::vector<std::string> findPureFunctions(ProgramNode * root,
+	unsigned threads);
+
+}
+
+#endif
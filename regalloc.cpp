@@ -0,0 +1,326 @@
+#include <algorithm>
+#include "x86.hpp"
+
+namespace lake{
+
+//In the order they are handed out
+static const X86Reg CALLER_SAVED[] = { RSI, RDI, R8, R9, R10, R11 };
+static const X86Reg CALLEE_SAVED[] = { RBX, R12, R13, R14, R15 };
+static const X86Reg ARG_REGS[6] = { RDI, RSI, RDX, RCX, R8, R9 };
+
+static bool isCalleeSaved(X86Reg r){
+	return r == RBX || r >= R12;
+}
+
+static bool isAllocatable(X86Reg r){
+	return r != RAX && r != RCX && r != RDX && r != RSP && r != RBP;
+}
+
+//Whether an instruction calls out, clobbering the caller-saved
+// registers
+static bool isCall(const IRInstr * instr){
+	switch (instr->op){
+	case IRInstr::CALL:
+	case IRInstr::READ_INT: case IRInstr::READ_BOOL:
+	case IRInstr::WRITE_INT: case IRInstr::WRITE_BOOL:
+	case IRInstr::WRITE_STR:
+		return true;
+	default:
+		return false;
+	}
+}
+
+X86Alloc naiveAllocation(IRFunction * fn){
+	X86Alloc res;
+	res.homes.resize(fn->numRegs());
+	for (uint32_t r = 0; r < fn->numRegs(); r++){
+		res.homes[r] = {X86Alloc::SLOT, RAX, r};
+	}
+	res.numSlots = static_cast<uint32_t>(fn->numRegs());
+	res.coalesced = 0;
+	res.spilled = 0;
+	return res;
+}
+
+struct Interval{
+	Reg reg;
+	uint32_t from;
+	uint32_t to;
+	double weight;
+	bool crossesCall;
+	bool hasHint;
+	X86Reg hint;
+	//The register hint comes from a copy (rather than a
+	// parameter's argument register)
+	bool hintIsCopy;
+	Reg hintFrom;
+};
+
+//The live interval of every register, as the hull of the
+// positions it is live at. Instructions are numbered 2, 4, ...
+// in block order, so parameters (defined on entry) start at 0.
+static std::vector<Interval> buildIntervals(IRFunction * fn,
+	std::vector<uint32_t>& callPositions){
+	size_t numRegs = fn->numRegs();
+	size_t numBlocks = fn->blocks.size();
+	std::vector<Interval> res(numRegs);
+	for (Reg r = 0; r < numRegs; r++){
+		res[r] = {r, UINT32_MAX, 0, 0, false, false, RAX, false, 0};
+	}
+	auto extend = [&](Reg r, uint32_t pos){
+		res[r].from = std::min(res[r].from, pos);
+		res[r].to = std::max(res[r].to, pos);
+	};
+
+	//Loop depth, taking every backward edge in block order as a
+	// loop around the blocks it jumps back over
+	std::vector<int> depthDelta(numBlocks + 1, 0);
+	for (IRBlock * block : fn->blocks){
+		for (IRBlock * succ : block->succs){
+			if (succ->id <= block->id){
+				depthDelta[succ->id]++;
+				depthDelta[block->id + 1]--;
+			}
+		}
+	}
+	std::vector<double> blockWeight(numBlocks);
+	int depth = 0;
+	for (size_t b = 0; b < numBlocks; b++){
+		depth += depthDelta[b];
+		double w = 1;
+		for (int d = 0; d < depth && d < 6; d++){ w *= 10; }
+		blockWeight[b] = w;
+	}
+
+	//Number the instructions, and find each block's upward
+	// exposed uses and which blocks assign each register
+	std::vector<uint32_t> blockStart(numBlocks);
+	std::vector<uint32_t> blockEnd(numBlocks);
+	std::vector<std::vector<uint32_t>> exposedIn(numRegs);
+	std::vector<std::vector<uint32_t>> defBlocks(numRegs);
+	std::vector<uint32_t> definedIn(numRegs, UINT32_MAX);
+	uint32_t pos = 0;
+	for (IRBlock * block : fn->blocks){
+		uint32_t b = block->id;
+		blockStart[b] = pos + 2;
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			pos += 2;
+			instr->forEachUse([&](Operand& use){
+				Reg r = use.getReg();
+				extend(r, pos);
+				res[r].weight += blockWeight[b];
+				if (definedIn[r] != b){
+					if (exposedIn[r].empty() || exposedIn[r].back() != b){
+						exposedIn[r].push_back(b);
+					}
+				}
+			});
+			if (instr->dst != NO_REG){
+				Reg r = instr->dst;
+				extend(r, pos);
+				res[r].weight += blockWeight[b];
+				if (definedIn[r] != b){
+					definedIn[r] = b;
+					defBlocks[r].push_back(b);
+				}
+				if (instr->op == IRInstr::COPY && instr->a.isReg()){
+					res[r].hasHint = true;
+					res[r].hintIsCopy = true;
+					res[r].hintFrom = instr->a.getReg();
+				}
+			}
+			if (isCall(instr)){ callPositions.push_back(pos); }
+		}
+		blockEnd[b] = pos + 1;
+	}
+	//The prologue moves every parameter into its home at once, so
+	// even one that is never read holds its register until after
+	// the others are in theirs
+	for (size_t i = 0; i < fn->params.size(); i++){
+		Reg r = fn->params[i];
+		extend(r, 0);
+		extend(r, 1);
+		if (i < 6 && isAllocatable(ARG_REGS[i]) && !res[r].hasHint){
+			res[r].hasHint = true;
+			res[r].hint = ARG_REGS[i];
+		}
+	}
+
+	//Walk back from each exposed use to the definitions that
+	// reach it, stretching the interval over every block it is
+	// live through. Stamps keep this linear in the size of the
+	// walk, rather than in registers times blocks.
+	std::vector<uint32_t> defStamp(numBlocks, UINT32_MAX);
+	std::vector<uint32_t> inStamp(numBlocks, UINT32_MAX);
+	std::vector<uint32_t> outStamp(numBlocks, UINT32_MAX);
+	std::vector<uint32_t> work;
+	for (Reg r = 0; r < numRegs; r++){
+		if (exposedIn[r].empty()){ continue; }
+		for (uint32_t b : defBlocks[r]){ defStamp[b] = r; }
+		for (uint32_t b : exposedIn[r]){
+			inStamp[b] = r;
+			extend(r, blockStart[b]);
+			work.push_back(b);
+		}
+		while (!work.empty()){
+			IRBlock * block = fn->blocks[work.back()];
+			work.pop_back();
+			for (IRBlock * pred : block->preds){
+				uint32_t p = pred->id;
+				if (outStamp[p] == r){ continue; }
+				outStamp[p] = r;
+				extend(r, blockEnd[p]);
+				if (defStamp[p] == r || inStamp[p] == r){ continue; }
+				inStamp[p] = r;
+				extend(r, blockStart[p]);
+				work.push_back(p);
+			}
+		}
+		//Live into the entry means read before any assignment
+		if (inStamp[0] == r){ extend(r, 0); }
+	}
+
+	std::sort(callPositions.begin(), callPositions.end());
+	for (Interval& iv : res){
+		if (iv.from > iv.to){ continue; }
+		auto call = std::upper_bound(callPositions.begin(),
+			callPositions.end(), iv.from);
+		iv.crossesCall = call != callPositions.end() && *call < iv.to;
+	}
+	return res;
+}
+
+//What spilling an interval saves per position it covers
+static double spillCost(const Interval * iv){
+	return iv->weight / (iv->to - iv->from + 1);
+}
+
+X86Alloc allocateRegisters(IRFunction * fn){
+	fn->rebuildEdges();
+	std::vector<uint32_t> callPositions;
+	std::vector<Interval> intervals = buildIntervals(fn, callPositions);
+	X86Alloc res;
+	res.homes.assign(fn->numRegs(), {X86Alloc::NONE, RAX, 0});
+	res.numSlots = 0;
+	res.coalesced = 0;
+	res.spilled = 0;
+
+	std::vector<Interval *> order;
+	for (Interval& iv : intervals){
+		if (iv.from <= iv.to){ order.push_back(&iv); }
+	}
+	std::sort(order.begin(), order.end(),
+		[](const Interval * x, const Interval * y){
+			return x->from != y->from ? x->from < y->from : x->reg < y->reg;
+		});
+
+	std::vector<Interval *> active;
+	bool isFree[16];
+	for (bool& f : isFree){ f = true; }
+	std::vector<Interval *> spills;
+	auto assign = [&](Interval * iv, X86Reg r){
+		res.homes[iv->reg] = {X86Alloc::REG, r, 0};
+		isFree[r] = false;
+		active.push_back(iv);
+	};
+	for (Interval * cur : order){
+		//Intervals that end where this one starts hand their
+		// register straight on
+		size_t kept = 0;
+		for (Interval * iv : active){
+			if (iv->to <= cur->from){
+				isFree[res.homes[iv->reg].reg] = true;
+			} else {
+				active[kept++] = iv;
+			}
+		}
+		active.resize(kept);
+
+		X86Reg hint = cur->hint;
+		bool hinted = cur->hasHint;
+		if (hinted && cur->hintIsCopy){
+			const X86Alloc::Home& from = res.homes[cur->hintFrom];
+			hinted = from.kind == X86Alloc::REG;
+			hint = from.reg;
+		}
+		if (hinted && isFree[hint]
+			&& (!cur->crossesCall || isCalleeSaved(hint))){
+			assign(cur, hint);
+			if (cur->hintIsCopy){ res.coalesced++; }
+			continue;
+		}
+		bool done = false;
+		if (!cur->crossesCall){
+			for (X86Reg r : CALLER_SAVED){
+				if (isFree[r]){
+					assign(cur, r);
+					done = true;
+					break;
+				}
+			}
+		}
+		for (X86Reg r : CALLEE_SAVED){
+			if (done){ break; }
+			if (isFree[r]){
+				assign(cur, r);
+				done = true;
+			}
+		}
+		if (done){ continue; }
+
+		//Spill whichever of cur and the intervals holding a
+		// register it could use is the cheapest to keep in memory
+		Interval * victim = cur;
+		for (Interval * iv : active){
+			X86Reg r = res.homes[iv->reg].reg;
+			if (cur->crossesCall && !isCalleeSaved(r)){ continue; }
+			double cost = spillCost(iv);
+			double best = spillCost(victim);
+			if (cost < best || (cost == best && iv->to > victim->to)){
+				victim = iv;
+			}
+		}
+		spills.push_back(victim);
+		res.spilled++;
+		if (victim != cur){
+			X86Reg r = res.homes[victim->reg].reg;
+			active.erase(std::find(active.begin(), active.end(), victim));
+			isFree[r] = true;
+			assign(cur, r);
+		}
+	}
+
+	//Spilled intervals that don't overlap share slots
+	std::sort(spills.begin(), spills.end(),
+		[](const Interval * x, const Interval * y){
+			return x->from != y->from ? x->from < y->from : x->reg < y->reg;
+		});
+	std::vector<std::pair<uint32_t, uint32_t>> slotEnds;
+	for (Interval * iv : spills){
+		uint32_t slot = UINT32_MAX;
+		for (auto& entry : slotEnds){
+			if (entry.first < iv->from){
+				slot = entry.second;
+				entry.first = iv->to;
+				break;
+			}
+		}
+		if (slot == UINT32_MAX){
+			slot = res.numSlots++;
+			slotEnds.push_back({iv->to, slot});
+		}
+		res.homes[iv->reg] = {X86Alloc::SLOT, RAX, slot};
+	}
+
+	bool used[16] = {false};
+	for (const X86Alloc::Home& home : res.homes){
+		if (home.kind == X86Alloc::REG){ used[home.reg] = true; }
+	}
+	for (X86Reg r : CALLEE_SAVED){
+		if (used[r]){ res.saved.push_back(r); }
+	}
+	return res;
+}
+
+}
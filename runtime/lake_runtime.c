@@ -0,0 +1,54 @@
+//The runtime that native Lake programs are linked against.
+// lakec names each Lake function f lake_f, so the program
+// starts at lake_main. Every Lake value is a 64-bit word.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int64_t lake_main(void);
+
+int64_t lakert_read_int(void){
+	long long val = 0;
+	fflush(stdout);
+	if (scanf("%lld", &val) != 1){
+		return 0;
+	}
+	return val;
+}
+
+//A bool is read as true or false, or as an int (nonzero is
+// true)
+int64_t lakert_read_bool(void){
+	char word[32];
+	fflush(stdout);
+	if (scanf("%31s", word) != 1){
+		return 0;
+	}
+	if (strcmp(word, "true") == 0){
+		return 1;
+	}
+	if (strcmp(word, "false") == 0){
+		return 0;
+	}
+	return strtoll(word, NULL, 10) != 0;
+}
+
+void lakert_write_int(int64_t val){
+	printf("%lld", (long long)val);
+}
+
+void lakert_write_bool(int64_t val){
+	fputs(val ? "true" : "false", stdout);
+}
+
+void lakert_write_str(const char * str, int64_t len){
+	fwrite(str, 1, (size_t)len, stdout);
+}
+
+//main's result is the exit status
+int main(void){
+	int64_t res = lake_main();
+	fflush(stdout);
+	return (int)res;
+}
@@ -5,6 +5,7 @@
 #include <FlexLexer.h>
 #endif
 
+#include <deque>
 #include "grammar.hh"
 
 namespace lake{
@@ -14,10 +15,11 @@ public:
    
    Scanner(std::istream *in) : yyFlexLexer(in)
    {
-	lineNum = 1;
-	charNum = 1;
+	offset = 0;
+	matchPos = 0;
    };
    virtual ~Scanner() {
+	for (Token * tok : myTokens){ delete tok; }
    };
 
    //get rid of override virtual function warning
@@ -27,37 +29,74 @@ public:
    virtual
    int yylex( lake::Parser::semantic_type * const lval);
 
-   void warn(int lineNumIn, int charNumIn, std::string msg){
-	std::cerr << lineNumIn << ":" << charNumIn 
+   void warn(Pos pos, std::string msg){
+	std::cerr << SourceMap::line(pos) << ":" << SourceMap::col(pos) 
 		<< " ***WARNING*** " << msg << std::endl;
    }
 
-   void error(int lineNumIn, int charNumIn, std::string msg){
-	std::cerr << lineNumIn << ":" << charNumIn 
+   void error(Pos pos, std::string msg){
+	std::cerr << SourceMap::line(pos) << ":" << SourceMap::col(pos) 
 		<< " ***ERROR*** " << msg << std::endl;
    }
 
+   /* Called on every match (see YY_USER_ACTION in the .l file),
+	including whitespace, newlines and comments, so that
+	matchPos is always the byte offset of the current match.
+	This is the only position bookkeeping done per token.
+   */
+   void advance(size_t len){
+	matchPos = offset < NO_POS ? static_cast<Pos>(offset) : NO_POS;
+	offset += len;
+   }
+
+   /* Called on every newline, once advance has gone past it, so
+	that SourceMap knows where the next line starts
+   */
+   void newLine(){
+	SourceMap::addLineStart(offset < NO_POS ? 
+		static_cast<Pos>(offset) : NO_POS);
+   }
+
    /* Convenience function to create a token with no
 	"arguments" (i.e. a token that need not store
-	the value it represents) and update the 
-	scanner state (i.e. the lineNum and charNum)
+	the value it represents).
 	Most tokens are NoArg so this function avoids a lot 
 	of copy-paste in the .l file.
    */
    int produceNoArgToken(int tagIn){
-        this->yylval->tokenValue = new NoArgToken(
-	  this->lineNum, this->charNum, tagIn);
-        charNum += static_cast<size_t>(yyleng);
+        this->yylval->tokenValue = keep(new NoArgToken(
+	  this->matchPos, tagIn));
         return tagIn;
    }
 
    void outputTokens(std::ostream& outstream);
 
+   /* Tokens are owned by the scanner, since AST nodes copy 
+	out everything they need. Every token made is recorded
+	here so it can be freed.
+   */
+   Token * keep(Token * tok){
+	myTokens.push_back(tok);
+	return tok;
+   }
+
+   /* Free every token but the most recent one, which the parser
+	may still be holding as its lookahead. Only call this
+	between top-level declarations.
+   */
+   void releaseTokens(){
+	while (myTokens.size() > 1){
+		delete myTokens.front();
+		myTokens.pop_front();
+	}
+   }
+
 private:
    /* yyval ptr */
    lake::Parser::semantic_type *yylval = nullptr;
-   size_t lineNum;
-   size_t charNum;
+   size_t offset;
+   Pos matchPos;
+   std::deque<Token *> myTokens;
 };
 
 } /* end namespace */
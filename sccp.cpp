@@ -0,0 +1,282 @@
+#include "opt.hpp"
+
+namespace lake{
+
+//What is known about a register: nothing yet (it may never be
+// assigned), a single constant, or that it can hold more than
+// one value
+struct LatticeVal{
+	enum Kind : uint8_t { TOP, CONST, BOTTOM };
+	Kind kind;
+	int64_t c;
+	bool operator==(const LatticeVal& other) const {
+		return kind == other.kind && (kind != CONST || c == other.c);
+	}
+};
+
+static const LatticeVal TOP_VAL = {LatticeVal::TOP, 0};
+static const LatticeVal BOTTOM_VAL = {LatticeVal::BOTTOM, 0};
+
+static LatticeVal constVal(int64_t c){
+	return {LatticeVal::CONST, c};
+}
+
+static LatticeVal meet(LatticeVal x, LatticeVal y){
+	if (x.kind == LatticeVal::TOP){ return y; }
+	if (y.kind == LatticeVal::TOP){ return x; }
+	if (x == y){ return x; }
+	return BOTTOM_VAL;
+}
+
+class SCCP{
+public:
+	SCCP(IRFunction * fnIn)
+	: fn(fnIn), values(fnIn->numRegs(), TOP_VAL),
+	  users(fnIn->numRegs()),
+	  blockSeen(fnIn->blocks.size(), false),
+	  edgeSeen(fnIn->blocks.size(), 0){
+		for (Reg param : fn->params){
+			values[param] = BOTTOM_VAL;
+		}
+		for (IRBlock * block : fn->blocks){
+			for (IRInstr * instr = block->first; instr != nullptr;
+				instr = instr->next){
+				instr->forEachUse([&](Operand& use){
+					users[use.getReg()].push_back(instr);
+				});
+			}
+		}
+	}
+	void solve();
+	void rewrite(OptReport& report);
+private:
+	LatticeVal valueOf(const Operand& op) const {
+		if (op.isImm()){ return constVal(op.getImm()); }
+		if (op.isReg()){ return values[op.getReg()]; }
+		return BOTTOM_VAL;
+	}
+	//Whether control can flow along the edge from pred to block
+	bool edgeTaken(const IRBlock * pred, const IRBlock * block) const {
+		const IRInstr * term = pred->last;
+		uint8_t seen = edgeSeen[pred->id];
+		return ((seen & 1) && term->targets[0] == block)
+			|| ((seen & 2) && term->targets[1] == block);
+	}
+	void takeEdge(IRBlock * pred, int slot);
+	void visit(IRInstr * instr);
+	LatticeVal evaluate(IRInstr * instr) const;
+
+	IRFunction * fn;
+	std::vector<LatticeVal> values;
+	std::vector<std::vector<IRInstr *>> users;
+	std::vector<bool> blockSeen;
+	//Which of each block's terminator targets have been taken
+	std::vector<uint8_t> edgeSeen;
+	std::vector<IRBlock *> blockWork;
+	std::vector<IRInstr *> instrWork;
+};
+
+void SCCP::takeEdge(IRBlock * pred, int slot){
+	uint8_t bit = static_cast<uint8_t>(1 << slot);
+	if (edgeSeen[pred->id] & bit){ return; }
+	edgeSeen[pred->id] = static_cast<uint8_t>(edgeSeen[pred->id] | bit);
+	IRBlock * target = pred->last->targets[slot];
+	if (!blockSeen[target->id]){
+		blockSeen[target->id] = true;
+		blockWork.push_back(target);
+		return;
+	}
+	//A new way into a block that was already visited can only
+	// change its phis
+	for (IRInstr * phi = target->first;
+		phi != nullptr && phi->op == IRInstr::PHI; phi = phi->next){
+		instrWork.push_back(phi);
+	}
+}
+
+LatticeVal SCCP::evaluate(IRInstr * instr) const {
+	switch (instr->op){
+	case IRInstr::PHI: {
+		LatticeVal res = TOP_VAL;
+		for (uint32_t i = 0; i < instr->numArgs; i++){
+			if (!edgeTaken(instr->blocks[i], instr->block)){ continue; }
+			res = meet(res, valueOf(instr->args[i]));
+		}
+		return res;
+	}
+	case IRInstr::COPY:
+	case IRInstr::NEG: case IRInstr::NOT: {
+		LatticeVal a = valueOf(instr->a);
+		if (a.kind != LatticeVal::CONST){ return a; }
+		int64_t res;
+		if (!IRInstr::fold(instr->op, a.c, 0, res)){
+			return BOTTOM_VAL;
+		}
+		return constVal(res);
+	}
+	case IRInstr::ADD: case IRInstr::SUB: case IRInstr::MUL:
+	case IRInstr::DIV: case IRInstr::EQ: case IRInstr::NE:
+	case IRInstr::LT: case IRInstr::GT: case IRInstr::LE:
+	case IRInstr::GE: {
+		LatticeVal a = valueOf(instr->a);
+		LatticeVal b = valueOf(instr->b);
+		//Anything times zero is zero, whatever else it is
+		if (instr->op == IRInstr::MUL){
+			bool aZero = a.kind == LatticeVal::CONST && a.c == 0;
+			bool bZero = b.kind == LatticeVal::CONST && b.c == 0;
+			if ((aZero && b.kind != LatticeVal::TOP)
+				|| (bZero && a.kind != LatticeVal::TOP)){
+				return constVal(0);
+			}
+		}
+		if (a.kind == LatticeVal::BOTTOM
+			|| b.kind == LatticeVal::BOTTOM){
+			return BOTTOM_VAL;
+		}
+		if (a.kind == LatticeVal::TOP || b.kind == LatticeVal::TOP){
+			return TOP_VAL;
+		}
+		int64_t res;
+		if (!IRInstr::fold(instr->op, a.c, b.c, res)){
+			return BOTTOM_VAL;
+		}
+		return constVal(res);
+	}
+	default:
+		//Loads, calls and reads could give anything
+		return BOTTOM_VAL;
+	}
+}
+
+void SCCP::visit(IRInstr * instr){
+	switch (instr->op){
+	case IRInstr::JMP:
+		takeEdge(instr->block, 0);
+		return;
+	case IRInstr::BR: {
+		LatticeVal cond = valueOf(instr->a);
+		if (cond.kind == LatticeVal::TOP){ return; }
+		if (cond.kind == LatticeVal::CONST){
+			takeEdge(instr->block, cond.c != 0 ? 0 : 1);
+			return;
+		}
+		takeEdge(instr->block, 0);
+		takeEdge(instr->block, 1);
+		return;
+	}
+	default:
+		break;
+	}
+	if (instr->dst == NO_REG){ return; }
+	LatticeVal val = evaluate(instr);
+	if (val == values[instr->dst]){ return; }
+	values[instr->dst] = val;
+	for (IRInstr * user : users[instr->dst]){
+		if (user->block != nullptr && blockSeen[user->block->id]){
+			instrWork.push_back(user);
+		}
+	}
+}
+
+void SCCP::solve(){
+	if (fn->blocks.empty()){ return; }
+	blockSeen[0] = true;
+	blockWork.push_back(fn->blocks[0]);
+	while (!blockWork.empty() || !instrWork.empty()){
+		while (!instrWork.empty()){
+			IRInstr * instr = instrWork.back();
+			instrWork.pop_back();
+			visit(instr);
+		}
+		if (!blockWork.empty()){
+			IRBlock * block = blockWork.back();
+			blockWork.pop_back();
+			for (IRInstr * instr = block->first; instr != nullptr;
+				instr = instr->next){
+				visit(instr);
+			}
+		}
+	}
+}
+
+void SCCP::rewrite(OptReport& report){
+	size_t folded = 0;
+	size_t operands = 0;
+	size_t branches = 0;
+	size_t numBlocks = fn->blocks.size();
+	for (IRBlock * block : fn->blocks){
+		//Unvisited blocks are about to be unreachable
+		if (!blockSeen[block->id]){ continue; }
+		IRInstr * next;
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = next){
+			next = instr->next;
+			//Copies of constants that lowering made don't count
+			// as folding
+			bool wasConst = instr->op == IRInstr::COPY
+				&& instr->a.isImm();
+			instr->forEachUse([&](Operand& use){
+				LatticeVal val = values[use.getReg()];
+				if (val.kind == LatticeVal::CONST){
+					use = Operand::imm(val.c);
+					operands++;
+				}
+			});
+			if (instr->dst != NO_REG
+				&& values[instr->dst].kind == LatticeVal::CONST
+				&& !instr->hasSideEffects()){
+				if (!wasConst){ folded++; }
+				block->remove(instr);
+				continue;
+			}
+			if (instr->op != IRInstr::BR || !instr->a.isImm()){
+				continue;
+			}
+			int taken = instr->a.getImm() != 0 ? 0 : 1;
+			IRBlock * dropped = instr->targets[1 - taken];
+			instr->op = IRInstr::JMP;
+			instr->targets[0] = instr->targets[taken];
+			instr->targets[1] = nullptr;
+			instr->a = Operand();
+			if (dropped != instr->targets[0]){
+				dropped->removePhiInputs(block);
+			}
+			branches++;
+		}
+	}
+	//Every live block now has an executable edge into it, so the
+	// blocks still standing are exactly the ones SCCP reached
+	fn->rebuildEdges();
+	fn->removeUnreachableBlocks();
+	//Phis left with a single input are just copies, which go
+	// below the block's remaining phis
+	for (IRBlock * block : fn->blocks){
+		IRInstr * body = block->first;
+		while (body != nullptr && body->op == IRInstr::PHI){
+			body = body->next;
+		}
+		IRInstr * next;
+		for (IRInstr * phi = block->first; phi != body; phi = next){
+			next = phi->next;
+			if (phi->numArgs != 1){ continue; }
+			phi->makeCopy(phi->args[0]);
+			block->remove(phi);
+			block->insertBefore(body, phi);
+		}
+	}
+	report.add("sccp", "instructions folded", folded);
+	report.add("sccp", "operands made constant", operands);
+	report.add("sccp", "branches folded", branches);
+	report.add("sccp", "blocks removed", numBlocks - fn->blocks.size());
+}
+
+void runSCCP(IRFunction * fn, OptReport& report){
+	if (!fn->ssa){
+		throw new InternalError("SCCP needs SSA form");
+	}
+	SCCP sccp(fn);
+	sccp.solve();
+	sccp.rewrite(report);
+}
+
+}
@@ -0,0 +1,33 @@
+#include <algorithm>
+#include "source_map.hpp"
+
+namespace lake{
+
+std::vector<Pos> SourceMap::myLineStarts = {0};
+
+void SourceMap::reset(){
+	myLineStarts.assign(1, 0);
+}
+
+void SourceMap::addLineStart(Pos pos){
+	if (pos != NO_POS){ myLineStarts.push_back(pos); }
+}
+
+size_t SourceMap::line(Pos pos){
+	if (pos == NO_POS){ return 0; }
+	return lineIndex(pos) + 1;
+}
+
+size_t SourceMap::col(Pos pos){
+	if (pos == NO_POS){ return 0; }
+	return pos - myLineStarts[lineIndex(pos)] + 1;
+}
+
+//The index of the last line starting at or before pos
+size_t SourceMap::lineIndex(Pos pos){
+	auto after = std::upper_bound(myLineStarts.begin(), 
+		myLineStarts.end(), pos);
+	return static_cast<size_t>(after - myLineStarts.begin()) - 1;
+}
+
+}
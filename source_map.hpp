@@ -0,0 +1,38 @@
+#ifndef LAKE_SOURCE_MAP_HPP
+#define LAKE_SOURCE_MAP_HPP
+
+#include <cstdint>
+#include <vector>
+
+namespace lake{
+
+//A place in the source program, as a byte offset from the
+// start of the file. Tokens and AST nodes store only this;
+// the line and column are worked out when a message needs
+// them.
+typedef uint32_t Pos;
+
+//The position of nodes that don't come from any one place in
+// the source. Reported as line 0, column 0.
+const Pos NO_POS = UINT32_MAX;
+
+//Maps positions back to line and column numbers (both counted
+// from 1). The scanner records where each line starts as it
+// reads past the newline before it, so the input is only ever
+// read once (it may be a pipe).
+class SourceMap{
+public:
+	//Forget the lines of the last file, for a new one
+	static void reset();
+	//The line after a newline starts at pos
+	static void addLineStart(Pos pos);
+	static size_t line(Pos pos);
+	static size_t col(Pos pos);
+private:
+	static size_t lineIndex(Pos pos);
+	static std::vector<Pos> myLineStarts;
+};
+
+}
+
+#endif
@@ -0,0 +1,507 @@
+#include <algorithm>
+#include "ssa.hpp"
+
+namespace lake{
+
+DomTree::DomTree(IRFunction * fn){
+	size_t n = fn->blocks.size();
+	preNum.assign(n, 0);
+	idoms.assign(n, nullptr);
+	kids.assign(n, std::vector<IRBlock *>());
+	frontiers.assign(n, std::vector<IRBlock *>());
+	treePre.assign(n, 0);
+	treePost.assign(n, 0);
+	if (n == 0){ return; }
+
+	//Number the blocks depth first. From here on, a block is
+	// its number, and vertex[] goes back the other way.
+	std::vector<IRBlock *> vertex(1, nullptr);
+	std::vector<size_t> parent(n + 1, 0);
+	struct Visit{
+		IRBlock * block;
+		size_t nextSucc;
+	};
+	std::vector<Visit> dfs;
+	auto number = [&](IRBlock * block, size_t parentNum){
+		vertex.push_back(block);
+		preNum[block->id] = vertex.size() - 1;
+		parent[vertex.size() - 1] = parentNum;
+	};
+	number(fn->blocks[0], 0);
+	dfs.push_back({fn->blocks[0], 0});
+	while (!dfs.empty()){
+		Visit& top = dfs.back();
+		if (top.nextSucc == top.block->succs.size()){
+			dfs.pop_back();
+			continue;
+		}
+		IRBlock * from = top.block;
+		IRBlock * succ = from->succs[top.nextSucc++];
+		if (preNum[succ->id] == 0){
+			number(succ, preNum[from->id]);
+			dfs.push_back({succ, 0});
+		}
+	}
+	size_t count = vertex.size() - 1;
+
+	//Semidominators, then immediate dominators, as in Lengauer
+	// and Tarjan's "simple" version. The forest that eval()
+	// searches is path compressed without recursion.
+	std::vector<size_t> semi(count + 1);
+	std::vector<size_t> label(count + 1);
+	std::vector<size_t> ancestor(count + 1, 0);
+	std::vector<size_t> idom(count + 1, 0);
+	std::vector<std::vector<size_t>> bucket(count + 1);
+	std::vector<size_t> path;
+	for (size_t v = 1; v <= count; v++){
+		semi[v] = v;
+		label[v] = v;
+	}
+	auto eval = [&](size_t v){
+		if (ancestor[v] == 0){ return v; }
+		size_t x = v;
+		while (ancestor[ancestor[x]] != 0){
+			path.push_back(x);
+			x = ancestor[x];
+		}
+		while (!path.empty()){
+			size_t y = path.back();
+			path.pop_back();
+			size_t a = ancestor[y];
+			if (semi[label[a]] < semi[label[y]]){
+				label[y] = label[a];
+			}
+			ancestor[y] = ancestor[a];
+		}
+		return label[v];
+	};
+	for (size_t w = count; w >= 2; w--){
+		for (IRBlock * pred : vertex[w]->preds){
+			size_t v = preNum[pred->id];
+			if (v == 0){ continue; }
+			size_t u = eval(v);
+			if (semi[u] < semi[w]){ semi[w] = semi[u]; }
+		}
+		bucket[semi[w]].push_back(w);
+		ancestor[w] = parent[w];
+		for (size_t v : bucket[parent[w]]){
+			size_t u = eval(v);
+			idom[v] = semi[u] < semi[v] ? u : parent[w];
+		}
+		bucket[parent[w]].clear();
+	}
+	for (size_t w = 2; w <= count; w++){
+		if (idom[w] != semi[w]){ idom[w] = idom[idom[w]]; }
+		IRBlock * block = vertex[w];
+		IRBlock * dominator = vertex[idom[w]];
+		idoms[block->id] = dominator;
+		kids[dominator->id].push_back(block);
+	}
+
+	//Number the tree itself, for constant time dominates()
+	size_t clock = 0;
+	dfs.push_back({fn->blocks[0], 0});
+	treePre[fn->blocks[0]->id] = ++clock;
+	treeOrder.push_back(fn->blocks[0]);
+	while (!dfs.empty()){
+		Visit& top = dfs.back();
+		const std::vector<IRBlock *>& below = kids[top.block->id];
+		if (top.nextSucc == below.size()){
+			treePost[top.block->id] = ++clock;
+			dfs.pop_back();
+			continue;
+		}
+		IRBlock * child = below[top.nextSucc++];
+		treePre[child->id] = ++clock;
+		treeOrder.push_back(child);
+		dfs.push_back({child, 0});
+	}
+
+	//A join point is in the frontier of every block that
+	// dominates one of its predecessors but not the join itself
+	for (IRBlock * block : treeOrder){
+		if (block->preds.size() < 2){ continue; }
+		for (IRBlock * pred : block->preds){
+			if (!reachable(pred)){ continue; }
+			IRBlock * runner = pred;
+			while (runner != idoms[block->id]){
+				std::vector<IRBlock *>& df = frontiers[runner->id];
+				//An earlier predecessor's walk got here, and went
+				// on from here to the idom already
+				if (!df.empty() && df.back() == block){ break; }
+				df.push_back(block);
+				runner = idoms[runner->id];
+			}
+		}
+	}
+}
+
+void buildSSA(IRFunction * fn){
+	if (fn->ssa){ return; }
+	fn->ssa = true;
+	fn->removeUnreachableBlocks();
+	if (fn->blocks.empty()){ return; }
+	DomTree dom(fn);
+	IRBlock * entry = fn->blocks[0];
+	size_t numRegs = fn->numRegs();
+	size_t numBlocks = fn->blocks.size();
+
+	//Where each register is assigned, and whether it is ever
+	// read in a block it wasn't assigned in first. Registers
+	// that aren't never need a phi (they are "semi-pruned").
+	std::vector<uint32_t> defCount(numRegs, 0);
+	std::vector<std::vector<IRBlock *>> defBlocks(numRegs);
+	std::vector<bool> crossesBlocks(numRegs, false);
+	std::vector<uint32_t> killedIn(numRegs, UINT32_MAX);
+	for (Reg param : fn->params){
+		defCount[param]++;
+		defBlocks[param].push_back(entry);
+		killedIn[param] = entry->id;
+	}
+	for (IRBlock * block : fn->blocks){
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			instr->forEachUse([&](Operand& use){
+				if (killedIn[use.getReg()] != block->id){
+					crossesBlocks[use.getReg()] = true;
+				}
+			});
+			Reg dst = instr->dst;
+			if (dst == NO_REG){ continue; }
+			defCount[dst]++;
+			if (defBlocks[dst].empty()
+				|| defBlocks[dst].back() != block){
+				defBlocks[dst].push_back(block);
+			}
+			killedIn[dst] = block->id;
+		}
+	}
+
+	//Phis go at the iterated dominance frontier of each
+	// register's assignments. They start out assigning the
+	// original register, and are renamed along with everything
+	// else.
+	HashMap<IRInstr *, Reg> phiVars;
+	std::vector<Reg> hasPhi(numBlocks, NO_REG);
+	std::vector<Reg> queued(numBlocks, NO_REG);
+	std::vector<IRBlock *> work;
+	for (Reg var = 0; var < numRegs; var++){
+		if (defCount[var] < 2 || !crossesBlocks[var]){ continue; }
+		for (IRBlock * block : defBlocks[var]){
+			queued[block->id] = var;
+			work.push_back(block);
+		}
+		while (!work.empty()){
+			IRBlock * block = work.back();
+			work.pop_back();
+			for (IRBlock * join : dom.frontier(block)){
+				if (hasPhi[join->id] == var){ continue; }
+				hasPhi[join->id] = var;
+				IRInstr * phi = fn->newInstr(IRInstr::PHI);
+				phi->dst = var;
+				uint32_t numPreds =
+					static_cast<uint32_t>(join->preds.size());
+				fn->reserveArgs(phi, numPreds, true);
+				for (uint32_t i = 0; i < numPreds; i++){
+					phi->args[i] = Operand();
+					phi->blocks[i] = join->preds[i];
+				}
+				phi->numArgs = numPreds;
+				join->insertBefore(join->first, phi);
+				phiVars[phi] = var;
+				if (queued[join->id] != var){
+					queued[join->id] = var;
+					work.push_back(join);
+				}
+			}
+		}
+	}
+
+	//Rename, walking the dominator tree, with a stack per
+	// register of the names that reach the current point.
+	// pushed records whose stacks to pop when leaving a block.
+	std::vector<bool> renamed(numRegs, false);
+	for (Reg var = 0; var < numRegs; var++){
+		renamed[var] = defCount[var] >= 2;
+	}
+	std::vector<std::vector<Reg>> names(numRegs);
+	std::vector<Reg> pushed;
+	for (Reg param : fn->params){
+		if (renamed[param]){ names[param].push_back(param); }
+	}
+	//A register read where it can't have been assigned yet
+	// reads 0, as uninitialized memory would
+	auto current = [&](Reg var){
+		if (names[var].empty()){ return Operand::imm(0); }
+		return Operand::reg(names[var].back());
+	};
+
+	struct Visit{
+		IRBlock * block;
+		size_t mark;
+		size_t nextChild;
+	};
+	std::vector<Visit> walk;
+	walk.push_back({entry, 0, 0});
+	bool entering = true;
+	while (!walk.empty()){
+		Visit& top = walk.back();
+		IRBlock * block = top.block;
+		if (entering){
+			top.mark = pushed.size();
+			for (IRInstr * instr = block->first; instr != nullptr;
+				instr = instr->next){
+				//A phi's inputs come from its predecessors
+				if (instr->op != IRInstr::PHI){
+					instr->forEachUse([&](Operand& use){
+						Reg r = use.getReg();
+						if (r < numRegs && renamed[r]){
+							use = current(r);
+						}
+					});
+				}
+				Reg dst = instr->dst;
+				if (dst != NO_REG && dst < numRegs && renamed[dst]){
+					std::string name = fn->regNames[dst];
+					Reg fresh = fn->newReg(name);
+					names[dst].push_back(fresh);
+					pushed.push_back(dst);
+					instr->dst = fresh;
+				}
+			}
+			for (IRBlock * succ : block->succs){
+				for (IRInstr * phi = succ->first;
+					phi != nullptr && phi->op == IRInstr::PHI;
+					phi = phi->next){
+					auto var = phiVars.find(phi);
+					if (var == phiVars.end()){ continue; }
+					for (uint32_t i = 0; i < phi->numArgs; i++){
+						if (phi->blocks[i] == block){
+							phi->args[i] = current(var->second);
+						}
+					}
+				}
+			}
+		}
+		const std::vector<IRBlock *>& below = dom.children(block);
+		if (top.nextChild < below.size()){
+			IRBlock * child = below[top.nextChild++];
+			walk.push_back({child, 0, 0});
+			entering = true;
+			continue;
+		}
+		while (pushed.size() > top.mark){
+			names[pushed.back()].pop_back();
+			pushed.pop_back();
+		}
+		walk.pop_back();
+		entering = false;
+	}
+}
+
+void leaveSSA(IRFunction * fn){
+	fn->ssa = false;
+	for (IRBlock * block : fn->blocks){
+		for (IRInstr * phi = block->first;
+			phi != nullptr && phi->op == IRInstr::PHI;
+			phi = phi->next){
+			Reg through = fn->newReg();
+			for (uint32_t i = 0; i < phi->numArgs; i++){
+				IRBlock * pred = phi->blocks[i];
+				IRInstr * copy = fn->newInstr(IRInstr::COPY);
+				copy->dst = through;
+				copy->a = phi->args[i];
+				pred->insertBefore(pred->terminator(), copy);
+			}
+			phi->makeCopy(Operand::reg(through));
+		}
+	}
+}
+
+//The successors a block's terminator says it has
+static std::vector<IRBlock *> targetsOf(IRBlock * block){
+	std::vector<IRBlock *> res;
+	IRInstr * term = block->terminator();
+	if (term == nullptr){ return res; }
+	if (term->op == IRInstr::JMP || term->op == IRInstr::BR){
+		res.push_back(term->targets[0]);
+	}
+	if (term->op == IRInstr::BR && term->targets[1] != term->targets[0]){
+		res.push_back(term->targets[1]);
+	}
+	return res;
+}
+
+bool verifySSA(IRFunction * fn, std::ostream& errs){
+	bool ok = true;
+	auto fail = [&](const IRBlock * block, const std::string& msg){
+		errs << fn->name << ", " << block->label() << ": "
+			<< msg << "\n";
+		ok = false;
+	};
+
+	//The shape of the CFG has to be right before dominators
+	// mean anything
+	for (size_t i = 0; i < fn->blocks.size(); i++){
+		IRBlock * block = fn->blocks[i];
+		if (block->id != i){
+			fail(block, "block numbered out of order");
+			continue;
+		}
+		if (block->terminator() == nullptr){
+			fail(block, "no terminator");
+		}
+		bool inPhis = true;
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			if (instr->block != block){
+				fail(block, "instruction in the wrong block");
+			}
+			if (instr->isTerminator() && instr != block->last){
+				fail(block, "terminator in the middle");
+			}
+			if (instr->op != IRInstr::PHI){
+				inPhis = false;
+			} else if (!inPhis){
+				fail(block, "phi after other instructions");
+			}
+		}
+		if (targetsOf(block) != block->succs){
+			fail(block, "successors don't match the terminator");
+		}
+	}
+
+	//Joins can have any number of predecessors, so they are only
+	// ever counted, once per question, with a stamp per block
+	// rather than a search of the list for each edge. A block has
+	// at most two successors, so those lists can be searched.
+	size_t numBlocks = fn->blocks.size();
+	auto inFunction = [&](const IRBlock * block){
+		return block->id < numBlocks && fn->blocks[block->id] == block;
+	};
+	std::vector<size_t> stamp(numBlocks, 0);
+	std::vector<uint32_t> times(numBlocks, 0);
+	size_t round = 0;
+	auto countPreds = [&](const IRBlock * block){
+		round++;
+		for (IRBlock * pred : block->preds){
+			if (!inFunction(pred)){ continue; }
+			if (stamp[pred->id] != round){
+				stamp[pred->id] = round;
+				times[pred->id] = 0;
+			}
+			times[pred->id]++;
+		}
+	};
+	//How many times pred is among the last counted predecessors
+	auto timesPred = [&](const IRBlock * pred){
+		return inFunction(pred) && stamp[pred->id] == round
+			? times[pred->id] : 0;
+	};
+	std::vector<std::vector<IRBlock *>> jumpsIn(numBlocks);
+	for (IRBlock * block : fn->blocks){
+		if (!inFunction(block)){ continue; }
+		for (IRBlock * succ : block->succs){
+			if (inFunction(succ)){
+				jumpsIn[succ->id].push_back(block);
+			} else {
+				fail(block, "successor " + succ->label()
+					+ " is not in the function");
+			}
+		}
+	}
+	for (IRBlock * block : fn->blocks){
+		if (!inFunction(block)){ continue; }
+		countPreds(block);
+		for (IRBlock * from : jumpsIn[block->id]){
+			if (timesPred(from) != 1){
+				fail(from, "missing from " + block->label()
+					+ "'s predecessors");
+			}
+		}
+		for (IRBlock * pred : block->preds){
+			if (std::count(pred->succs.begin(), pred->succs.end(),
+				block) != 1){
+				fail(block, "predecessor " + pred->label()
+					+ " doesn't go here");
+			}
+		}
+	}
+	if (!ok || fn->blocks.empty()){ return ok; }
+
+	DomTree dom(fn);
+	size_t numRegs = fn->numRegs();
+	std::vector<IRBlock *> defBlock(numRegs, nullptr);
+	std::vector<size_t> defIndex(numRegs, 0);
+	auto define = [&](Reg r, IRBlock * block, size_t index){
+		if (defBlock[r] != nullptr){
+			fail(block, fn->regString(r) + " defined more than once");
+		}
+		defBlock[r] = block;
+		defIndex[r] = index;
+	};
+	for (Reg param : fn->params){
+		define(param, fn->blocks[0], 0);
+	}
+	for (IRBlock * block : fn->blocks){
+		size_t index = 1;
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			if (instr->dst != NO_REG){
+				define(instr->dst, block, index);
+			}
+			index++;
+		}
+	}
+
+	for (IRBlock * block : fn->blocks){
+		if (!dom.reachable(block)){ continue; }
+		countPreds(block);
+		size_t index = 1;
+		for (IRInstr * instr = block->first; instr != nullptr;
+			instr = instr->next){
+			if (instr->op == IRInstr::PHI){
+				if (instr->numArgs != block->preds.size()){
+					fail(block, "phi for " + fn->regString(instr->dst)
+						+ " doesn't have one input per predecessor");
+				}
+				for (uint32_t i = 0; i < instr->numArgs; i++){
+					IRBlock * pred = instr->blocks[i];
+					if (timesPred(pred) != 1){
+						fail(block, "phi input from " + pred->label()
+							+ ", which is not a predecessor");
+						continue;
+					}
+					const Operand& arg = instr->args[i];
+					if (!arg.isReg()){ continue; }
+					IRBlock * def = defBlock[arg.getReg()];
+					if (def == nullptr){
+						fail(block, fn->regString(arg.getReg())
+							+ " is never defined");
+					} else if (!dom.dominates(def, pred)){
+						fail(block, fn->regString(arg.getReg())
+							+ " doesn't reach the end of "
+							+ pred->label());
+					}
+				}
+			} else {
+				instr->forEachUse([&](Operand& use){
+					Reg r = use.getReg();
+					IRBlock * def = defBlock[r];
+					if (def == nullptr){
+						fail(block, fn->regString(r)
+							+ " is never defined");
+					} else if (def == block ? defIndex[r] >= index
+						: !dom.dominates(def, block)){
+						fail(block, fn->regString(r)
+							+ " is used where it may not be defined");
+					}
+				});
+			}
+			index++;
+		}
+	}
+	return ok;
+}
+
+}
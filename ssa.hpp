@@ -0,0 +1,78 @@
+#ifndef LAKE_SSA_HPP
+#define LAKE_SSA_HPP
+
+#include <ostream>
+#include <vector>
+#include "ir.hpp"
+
+namespace lake{
+
+//The dominator tree of a function, along with its dominance
+// frontiers. Blocks are identified by id, so the function's
+// blocks must not change while the tree is in use. Only blocks
+// reachable from the entry are in the tree.
+//
+// Immediate dominators are found with Lengauer and Tarjan's
+// algorithm and frontiers with Cooper, Harvey and Kennedy's, so
+// building the tree takes close to linear time in the size of
+// the CFG. Nothing here recurses, however deep the CFG is.
+class DomTree{
+public:
+	DomTree(IRFunction * fn);
+	bool reachable(const IRBlock * block) const {
+		return preNum[block->id] != 0;
+	}
+	//nullptr for the entry
+	IRBlock * idom(const IRBlock * block) const {
+		return idoms[block->id];
+	}
+	//Whether a dominates b (every block dominates itself)
+	bool dominates(const IRBlock * a, const IRBlock * b) const {
+		return treePre[a->id] <= treePre[b->id]
+			&& treePost[b->id] <= treePost[a->id];
+	}
+	const std::vector<IRBlock *>& children(const IRBlock * block) const {
+		return kids[block->id];
+	}
+	const std::vector<IRBlock *>& frontier(const IRBlock * block) const {
+		return frontiers[block->id];
+	}
+	//The reachable blocks, parents before children
+	const std::vector<IRBlock *>& preorder() const { return treeOrder; }
+private:
+	//Depth first numbering of the CFG, from 1
+	std::vector<size_t> preNum;
+	std::vector<IRBlock *> idoms;
+	std::vector<std::vector<IRBlock *>> kids;
+	std::vector<std::vector<IRBlock *>> frontiers;
+	std::vector<IRBlock *> treeOrder;
+	std::vector<size_t> treePre;
+	std::vector<size_t> treePost;
+};
+
+//Put a function in SSA form. Every register that is assigned in
+// more than one place is split into one register per assignment,
+// with phis (at the iterated dominance frontiers of the
+// assignments) where they meet. Unreachable blocks are removed
+// first. Functions already in SSA form are left alone.
+//
+// Only registers are renamed. Globals and whatever is behind a
+// pointer stay in memory, and are only ever reached through
+// loads and stores.
+void buildSSA(IRFunction * fn);
+
+//Replace each phi with copies in its predecessors, through a
+// fresh register per phi, which is correct even where the
+// copies end up on critical edges or phis swap values
+void leaveSSA(IRFunction * fn);
+
+//Check that fn is well-formed SSA: terminators only at the end
+// of blocks, edges that match them, phis at the tops of blocks
+// with one input per predecessor, a single definition of each
+// register, and definitions that dominate their uses. Problems
+// are described on errs.
+bool verifySSA(IRFunction * fn, std::ostream& errs);
+
+}
+
+#endif
@@ -0,0 +1,47 @@
+#include "streaming.hpp"
+#include "scanner.hpp"
+
+namespace lake{
+
+StreamingAnalysis::StreamingAnalysis(Scanner * scanner)
+: myScanner(scanner), myDeclCount(0){
+	mySymTab = new SymbolTable();
+	//The global scope is the only one that outlives a decl
+	mySymTab->enterScope();
+	//Names are resolved during the type analysis traversal,
+	// which holds type errors back until we know name
+	// analysis passed for the whole program
+	myTypeAnalysis = new TypeAnalysis(mySymTab);
+}
+
+StreamingAnalysis::~StreamingAnalysis(){
+	delete myTypeAnalysis;
+	delete mySymTab;
+}
+
+void StreamingAnalysis::consume(DeclNode * decl){
+	myDeclCount++;
+	decl->typeAnalysis(myTypeAnalysis);
+
+	//Nothing refers to this decl's nodes or local symbols
+	// any more: global symbols only hold on to types, which
+	// are never freed.
+	myTypeAnalysis->forgetNodes();
+	deleteAST(decl);
+	mySymTab->dropRetiredScopes();
+	myScanner->releaseTokens();
+}
+
+bool StreamingAnalysis::finish(){
+	if (!myTypeAnalysis->namesPassed()){
+		std::cerr << "Name analysis Failed\n";
+		return false;
+	}
+	myTypeAnalysis->flushErrors();
+	if (!myTypeAnalysis->passed()){
+		std::cerr << "Type checking failed\n";
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,36 @@
+#ifndef LAKE_STREAMING_HPP
+#define LAKE_STREAMING_HPP
+
+#include "ast.hpp"
+#include "symbol_table.hpp"
+#include "types.hpp"
+
+namespace lake{
+
+class Scanner;
+
+//Name and type analysis of a program one top-level declaration
+// at a time. Lake requires declare-before-use, so a decl can be
+// fully checked as soon as the parser has reduced it, with only
+// the global scope kept from the decls before it. Once checked,
+// the decl's tree, tokens and local scopes are freed, which keeps
+// peak memory proportional to the largest decl rather than to
+// the whole program.
+class StreamingAnalysis : public DeclSink{
+public:
+	StreamingAnalysis(Scanner * scanner);
+	~StreamingAnalysis();
+	void consume(DeclNode * decl) override;
+	//Report the outcome, exactly as the -c mode would
+	bool finish();
+	size_t declCount(){ return myDeclCount; }
+private:
+	Scanner * myScanner;
+	SymbolTable * mySymTab;
+	TypeAnalysis * myTypeAnalysis;
+	size_t myDeclCount;
+};
+
+}
+
+#endif
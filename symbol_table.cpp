@@ -5,10 +5,12 @@ namespace lake{
 
 SymbolTable::SymbolTable(){
 	scopeTableChain = new std::list<ScopeTable *>();
+	retiredScopes = new std::list<ScopeTable *>();
 }
 
 ScopeTable * SymbolTable::enterScope(){
-	ScopeTable * newScope = new ScopeTable();
+	ScopeTable * newScope = new ScopeTable(this, 
+		scopeTableChain->size());
 	scopeTableChain->push_front(newScope);
 	return newScope;
 }
@@ -18,35 +20,77 @@ void SymbolTable::leaveScope(){
 		throw new InternalError("Attempt to pop"
 			"empty symbol table");
 	}
+	//The scope's symbols are the innermost ones with their
+	// names, so each is on top of its name's stack
+	ScopeTable * scope = scopeTableChain->front();
+	for (auto entry : *scope->getSymbols()){
+		auto found = visible.find(entry.first);
+		if (found == visible.end() || found->second.empty()
+			|| found->second.back().symbol != entry.second){
+			throw new InternalError("Symbol left its scope"
+				" out of order");
+		}
+		found->second.pop_back();
+		if (found->second.empty()){ visible.erase(found); }
+	}
+	//The symbols of a scope we leave may still be attached
+	// to IdNodes, so the scope can't be freed just yet
+	retiredScopes->push_back(scope);
 	scopeTableChain->pop_front();
 }
 
+//A function's symbol goes into the scope around it once its
+// formals are in their own scope, so a symbol may have to go
+// under the top of its name's stack
+void SymbolTable::makeVisible(SemSymbol * symbol, size_t depth){
+	std::vector<Visible>& stack = visible[symbol->getName()];
+	auto at = stack.end();
+	while (at != stack.begin() && (at - 1)->depth > depth){ --at; }
+	stack.insert(at, {depth, symbol});
+}
+
+//Frees every scope that has been left. Only safe once nothing
+// refers to the symbols declared in those scopes any more
+// (i.e. the AST that was analyzed in them is gone).
+void SymbolTable::dropRetiredScopes(){
+	for (ScopeTable * scope : *retiredScopes){
+		delete scope;
+	}
+	retiredScopes->clear();
+}
+
 ScopeTable * SymbolTable::getCurrentScope(){
 	return scopeTableChain->front();
 }
 
 
-bool SymbolTable::clash(std::string varName){
+bool SymbolTable::clash(const std::string& varName){
 	bool hasClash = getCurrentScope()->clash(varName);
 	return hasClash;
 }
 
-SemSymbol * SymbolTable::find(std::string varName){
-	for (ScopeTable * scope : *scopeTableChain){
-		SemSymbol * sym = scope->lookup(varName);
-		if (sym != nullptr) { return sym; }
-	}
-	return nullptr;
+SemSymbol * SymbolTable::find(const std::string& varName){
+	auto found = visible.find(varName);
+	if (found == visible.end()){ return nullptr; }
+	return found->second.back().symbol;
 }
 
 bool SymbolTable::insert(SemSymbol * symbol){
 	return scopeTableChain->front()->insert(symbol);
 }
 
-ScopeTable::ScopeTable(){
+ScopeTable::ScopeTable(SymbolTable * owner, size_t depth)
+: myOwner(owner), myDepth(depth){
 	symbols = new HashMap<std::string, SemSymbol *>();
 }
 
+ScopeTable::~ScopeTable(){
+	for (auto entry : *symbols){
+		delete entry.second;
+	}
+	delete symbols;
+}
+
 std::string ScopeTable::toString(){
 	std::string result = "";
 	for (auto entry : *symbols){
@@ -56,7 +100,7 @@ std::string ScopeTable::toString(){
 	return result;
 }
 
-bool ScopeTable::clash(std::string varName){
+bool ScopeTable::clash(const std::string& varName){
 	SemSymbol * found = lookup(varName);
 	if (found != nullptr){
 		return true;
@@ -64,7 +108,7 @@ bool ScopeTable::clash(std::string varName){
 	return false;
 }
 
-SemSymbol * ScopeTable::lookup(std::string name){
+SemSymbol * ScopeTable::lookup(const std::string& name){
 	auto found = symbols->find(name);
 	if (found == symbols->end()){
 		return NULL;
@@ -79,6 +123,7 @@ bool ScopeTable::insert(SemSymbol * symbol){
 		return false;
 	}
 	this->symbols->insert(std::make_pair(symName, symbol));
+	myOwner->makeVisible(symbol, myDepth);
 	return true;
 }
 
@@ -3,6 +3,7 @@
 #include <string>
 #include <unordered_map>
 #include <list>
+#include <vector>
 #include "types.hpp"
 
 //Use an alias template so that we can use
@@ -27,6 +28,7 @@ public:
 	SemSymbol(SymbolKind kindIn, const DataType * typeIn, std::string nameIn) 
 	: myKind(kindIn), myType(typeIn), myName(nameIn){
 	}
+	virtual ~SemSymbol(){ }
 	virtual std::string getTypeString();
 	virtual std::string toString();
 	std::string getName() const { return myName; }
@@ -51,17 +53,31 @@ private:
 // the globals scope will be represented by a ScopeTable,
 // and the contents of each function can be represented by
 // a ScopeTable.
+class SymbolTable;
+
 class ScopeTable {
 	public:
-		ScopeTable();
-		SemSymbol * lookup(std::string name);
+		//depth is how many scopes enclose this one in owner
+		ScopeTable(SymbolTable * owner, size_t depth);
+		~ScopeTable();
+		SemSymbol * lookup(const std::string& name);
 		bool insert(SemSymbol * symbol);
-		bool clash(std::string name);
+		bool clash(const std::string& name);
 		std::string toString();
+		size_t getDepth() const { return myDepth; }
+		HashMap<std::string, SemSymbol *> * getSymbols(){
+			return symbols;
+		}
 	private:
 		HashMap<std::string, SemSymbol *> * symbols;
+		SymbolTable * myOwner;
+		size_t myDepth;
 };
 
+//Besides the chain of scopes, the table keeps, for each name, a
+// stack of the symbols declared with it in the scopes still
+// open, innermost on top, so that finding what a name means
+// costs the same however deeply scopes are nested
 class SymbolTable{
 	public:
 		SymbolTable();
@@ -69,10 +85,33 @@ class SymbolTable{
 		void leaveScope();
 		ScopeTable * getCurrentScope();
 		bool insert(SemSymbol * symbol);
-		SemSymbol * find(std::string varName);
-		bool clash(std::string name);
+		SemSymbol * find(const std::string& varName);
+		bool clash(const std::string& name);
+		void dropRetiredScopes();
+		//Called by a scope once symbol is in it
+		void makeVisible(SemSymbol * symbol, size_t depth);
 	private:
+		struct Visible{
+			size_t depth;
+			SemSymbol * symbol;
+		};
 		std::list<ScopeTable *> * scopeTableChain;
+		std::list<ScopeTable *> * retiredScopes;
+		HashMap<std::string, std::vector<Visible>> visible;
+};
+
+//The state of a name analysis walk: the symbol table being
+// filled in, and whether any name error has been found yet
+class NameAnalysis{
+	public:
+		NameAnalysis(SymbolTable * symTabIn) 
+		: symTab(symTabIn), ok(true){ }
+		SymbolTable * symbols(){ return symTab; }
+		void fail(){ ok = false; }
+		bool passed(){ return ok; }
+	private:
+		SymbolTable * symTab;
+		bool ok;
 };
 
 	
@@ -0,0 +1,70 @@
+#include "opt.hpp"
+
+namespace lake{
+
+void removeTailRecursion(IRProgram * prog, OptReport& report){
+	size_t removed = 0;
+	for (uint32_t f = 0; f < prog->functions.size(); f++){
+		IRFunction * fn = prog->functions[f];
+		if (fn->ssa){
+			throw new InternalError("Tail recursion needs a function not in SSA form");
+		}
+		if (fn->blocks.empty()){ continue; }
+		std::vector<IRInstr *> calls;
+		for (IRBlock * block : fn->blocks){
+			for (IRInstr * instr = block->first; instr != nullptr;
+				instr = instr->next){
+				if (instr->isTailCall() && instr->index == f){
+					calls.push_back(instr);
+				}
+			}
+		}
+		if (calls.empty()){ continue; }
+
+		//The old entry becomes the top of a loop, and a new entry
+		// just jumps there. The locals are zeroed again each time
+		// around, as they would be in a new call.
+		IRBlock * top = fn->blocks[0];
+		IRBlock * entry = fn->newBlock();
+		IRInstr * jmp = fn->newInstr(IRInstr::JMP);
+		jmp->targets[0] = top;
+		entry->append(jmp);
+
+		for (IRInstr * call : calls){
+			IRBlock * block = call->block;
+			//All the arguments are read before any parameter is
+			// written, since they may read the parameters
+			std::vector<Reg> temps;
+			for (uint32_t i = 0; i < call->numArgs; i++){
+				IRInstr * copy = fn->newInstr(IRInstr::COPY);
+				copy->dst = fn->newReg();
+				copy->a = call->args[i];
+				block->insertBefore(call, copy);
+				temps.push_back(copy->dst);
+			}
+			for (size_t i = 0; i < fn->params.size(); i++){
+				IRInstr * copy = fn->newInstr(IRInstr::COPY);
+				copy->dst = fn->params[i];
+				copy->a = Operand::reg(temps[i]);
+				block->insertBefore(call, copy);
+			}
+			if (call->next != nullptr){ block->remove(call->next); }
+			block->remove(call);
+			IRInstr * loop = fn->newInstr(IRInstr::JMP);
+			loop->targets[0] = top;
+			block->append(loop);
+			removed++;
+		}
+
+		std::vector<IRBlock *> blocks = fn->blocks;
+		fn->blocks.clear();
+		fn->placeBlock(entry);
+		for (IRBlock * block : blocks){
+			fn->placeBlock(block);
+		}
+		fn->rebuildEdges();
+	}
+	report.add("tail", "recursive calls made jumps", removed);
+}
+
+}
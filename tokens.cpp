@@ -3,27 +3,26 @@
 using TokenKind = lake::Parser::token;
 
 namespace lake{
-	Token::Token(size_t lineIn, size_t colIn, int kindIn){
+	Token::Token(Pos posIn, int kindIn){
 		this->_kind = kindIn;
-		this->_line = lineIn;
-		this->_column = colIn;
+		this->_pos = posIn;
 	}
 
 	int Token::kind(){
 		return _kind;
 	}
 
-	IDToken::IDToken(size_t ll, size_t cc, std::string value)
-	: Token(ll,cc,TokenKind::ID){
+	IDToken::IDToken(Pos pos, std::string value)
+	: Token(pos,TokenKind::ID){
 		this->_value = value;
 	}
 
-	IntLitToken::IntLitToken(size_t ll, size_t cc, int value)
-	: Token(ll,cc,TokenKind::INTLITERAL){
+	IntLitToken::IntLitToken(Pos pos, int value)
+	: Token(pos,TokenKind::INTLITERAL){
 		this->_value = value;
 	}
-	StringLitToken::StringLitToken(size_t ll, size_t cc, std::string value)
-	: Token(ll,cc,TokenKind::STRINGLITERAL)
+	StringLitToken::StringLitToken(Pos pos, std::string value)
+	: Token(pos,TokenKind::STRINGLITERAL)
 	{
 		this->_value = value;
 	}
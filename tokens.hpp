@@ -2,15 +2,16 @@
 #define TEENC_TOKEN_H
 
 #include <iostream>
+#include "source_map.hpp"
 
 namespace lake{
 
 class Token {
 	public:
-		Token(size_t lineIn, size_t columnIn, int kind);
+		Token(Pos posIn, int kind);
+		virtual ~Token(){ }
 		int kind();
-		size_t _line;
-		size_t _column;
+		Pos _pos;
 
 	protected:
 		int _kind;
@@ -18,14 +19,14 @@ class Token {
 
 class NoArgToken : public Token {
 	public:
-		NoArgToken(size_t liIn, size_t colIn, int tag) 
-		: Token(liIn,colIn,tag) { };
+		NoArgToken(Pos posIn, int tag) 
+		: Token(posIn,tag) { };
 		
 };
 
 class IntLitToken : public Token {
 	public:
-		IntLitToken(size_t line, size_t col, int value);
+		IntLitToken(Pos pos, int value);
 		int value() { return _value; }
 	private:
 		int _value;
@@ -33,7 +34,7 @@ class IntLitToken : public Token {
 
 class IDToken : public Token {
 	public:
-		IDToken(size_t line, size_t col, std::string id);
+		IDToken(Pos pos, std::string id);
 		std::string value() { return _value; }
 	private:
 		std::string _value;
@@ -41,7 +42,7 @@ class IDToken : public Token {
 
 class StringLitToken : public Token {
 	public:
-		StringLitToken(size_t line, size_t col, std::string value);
+		StringLitToken(Pos pos, std::string value);
 		std::string value() { return _value; }
 	private:
 		std::string _value;
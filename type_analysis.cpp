@@ -2,16 +2,60 @@
 #include "symbol_table.hpp"
 #include "err.hpp"
 #include "types.hpp"
+#include "walker.hpp"
 
 namespace lake{
 
-void ProgramNode::typeAnalysis(TypeAnalysis * ta){
+namespace {
+//Hands each node's type analysis hooks the TypeAnalysis
+// object. The walk's context is unused.
+class TypeVisitor : public ASTVisitor{
+public:
+	TypeVisitor(TypeAnalysis * taIn) : ta(taIn){ }
+	bool pre(ASTNode * node, int) override {
+		return node->typePre(ta);
+	}
+	bool between(ASTNode * node, size_t i, int, int&) override {
+		return node->typeBetween(ta, i);
+	}
+	void post(ASTNode * node, int) override {
+		node->typePost(ta);
+	}
+private:
+	TypeAnalysis * ta;
+};
+}
+
+//pass the TypeAnalysis down throughout the entire tree,
+// getting the types for each element in turn and adding
+// them to the ta object's hashMap. Every node's children
+// have their types by the time its typePost runs.
+void ASTNode::typeAnalysis(TypeAnalysis * ta){
+	TypeVisitor visitor(ta);
+	walk(this, visitor);
+}
+
+void ASTNode::typePost(TypeAnalysis * ta){
+	TODO("Override me in the subclass");
+}
 
-	//pass the TypeAnalysis down throughout
-	// the entire tree, getting the types for
-	// each element in turn and adding them
-	// to the ta object's hashMap
-	this->myDeclList->typeAnalysis(ta);
+bool ProgramNode::typePre(TypeAnalysis * ta){
+	//In fused mode, names are resolved as the
+	// type analysis reaches them, so the global
+	// scope has to be entered here instead of
+	// in a separate nameAnalysis pass
+	SymbolTable * symTab = ta->fusedSymbols();
+	if (symTab != nullptr){
+		symTab->enterScope();
+	}
+	return true;
+}
+
+void ProgramNode::typePost(TypeAnalysis * ta){
+	SymbolTable * symTab = ta->fusedSymbols();
+	if (symTab != nullptr){
+		symTab->leaveScope();
+	}
 
 	//The type of the program node will never
 	// be needed. We can just set it to VOID
@@ -37,15 +81,12 @@ void ProgramNode::typeAnalysis(TypeAnalysis * ta){
 	}
 }
 
-void DeclListNode::typeAnalysis(TypeAnalysis * ta){
+void DeclListNode::typePost(TypeAnalysis * ta){
 	ta->nodeType(this, VarType::produce(VOID));
 
 	for (auto decl : *myDecls){
-		//Do typeAnalysis on the single decl
-		decl->typeAnalysis(ta);
-		//Lookup the type that we added
-		// to the ta in the recursive call
-		// above
+		//Lookup the type that the walk added
+		// to the ta for the single decl
 		auto eltType = ta->nodeType(decl);
 		//If the element type was the special
 		// "error" type, set this node to the errorType
@@ -56,17 +97,29 @@ void DeclListNode::typeAnalysis(TypeAnalysis * ta){
 	return;
 }
 
-void FnDeclNode::typeAnalysis(TypeAnalysis * ta){
+bool FnDeclNode::typePre(TypeAnalysis * ta){
+	SymbolTable * symTab = ta->fusedSymbols();
+	if (symTab != nullptr){
+		if (!this->nameAnalysisHeader(symTab)){
+			ta->nameFailed();
+		}
+	}
+
+	//Return statements in the body check against this
+	ta->setFnRetType(myRetAST);
+	return true;
+}
 
-	//HINT: you might want to change the signature for
-	// typeAnalysis on FnBodyNode to take a second
-	// argument which is the type of the current
-	// function. This will help you to know at a
-	// return statement whether the return type matches
-	// the current function
+bool FnDeclNode::typeBetween(TypeAnalysis * ta, size_t i){
+	//Only the body is type checked
+	return i == 3;
+}
 
-	//Note, this function may need extra code
-	myBody->typeAnalysis(ta, myRetAST);
+void FnDeclNode::typePost(TypeAnalysis * ta){
+	SymbolTable * symTab = ta->fusedSymbols();
+	if (symTab != nullptr){
+		symTab->leaveScope();
+	}
 	const DataType* myBodyType = ta->nodeType(myBody);
 	if(myBodyType->asError()){
 		ta->nodeType(this, ErrorType::produce());
@@ -76,13 +129,22 @@ void FnDeclNode::typeAnalysis(TypeAnalysis * ta){
 	}
 }
 
-void FnBodyNode::typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType){
-	//HINT: as above, you may want to pass the
-	// fnDecl's type into the statement list as a
-	// second argument to StmtList::typeAnalysis
+bool FnBodyNode::typePre(TypeAnalysis * ta){
+	SymbolTable * symTab = ta->fusedSymbols();
+	if (symTab != nullptr){
+		if (!myVarDecls->nameAnalysis(symTab)){
+			ta->nameFailed();
+		}
+	}
+	return true;
+}
 
-	//Note, this function may need extra code
-	myStmtList->typeAnalysis(ta, fnRetType);
+bool FnBodyNode::typeBetween(TypeAnalysis * ta, size_t i){
+	//The var decls need no type checking
+	return i == 1;
+}
+
+void FnBodyNode::typePost(TypeAnalysis * ta){
 	const DataType* myStmtListType = ta->nodeType(myStmtList);
 	if(myStmtListType->asError()){
 		ta->nodeType(this, ErrorType::produce());
@@ -92,13 +154,10 @@ void FnBodyNode::typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType){
 	}
 }
 
-void StmtListNode::typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType){
-	//Note, this function may need extra code
+void StmtListNode::typePost(TypeAnalysis * ta){
 	bool valid = true;
 	const DataType* myType;
 	for (auto stmt : *myStmts){
-
-		stmt->typeAnalysis(ta, fnRetType);
 		myType = ta->nodeType(stmt);
 		if(myType->asError())
 		{
@@ -115,13 +174,8 @@ void StmtListNode::typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType){
 	}
 }
 
-void StmtNode::typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType){
-	TODO("Implement me in the subclass");
-}
-
-void AssignStmtNode::typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType){
+void AssignStmtNode::typePost(TypeAnalysis * ta){
 
-	myAssign->typeAnalysis(ta);
 
 	//It can be a bit of a pain to write
 	// "const DataType *" everywhere, so here
@@ -139,8 +193,7 @@ void AssignStmtNode::typeAnalysis(TypeAnalysis * ta, TypeNode* fnRetType){
 	}
 }
 
-void PostIncStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
-	myExp->typeAnalysis(ta);
+void PostIncStmtNode::typePost(TypeAnalysis * ta){
 	const DataType * ExpType = ta->nodeType(myExp);
 
 	bool valid = true;
@@ -168,8 +221,7 @@ void PostIncStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void PostDecStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
-	myExp->typeAnalysis(ta);
+void PostDecStmtNode::typePost(TypeAnalysis * ta){
 	const DataType * ExpType = ta->nodeType(myExp);
 
 	bool valid = true;
@@ -197,8 +249,7 @@ void PostDecStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void ReadStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
-	myExp->typeAnalysis(ta);
+void ReadStmtNode::typePost(TypeAnalysis * ta){
 	const DataType * expType = ta->nodeType(myExp);
 
 	bool valid = true;
@@ -228,8 +279,7 @@ void ReadStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void WriteStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
-	myExp->typeAnalysis(ta);
+void WriteStmtNode::typePost(TypeAnalysis * ta){
 	const DataType * expType = ta->nodeType(myExp);
 
 	bool valid = true;
@@ -259,9 +309,20 @@ void WriteStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void IfStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
-	myExp->typeAnalysis(ta);
-	myStmts->typeAnalysis(ta, fnRetType);
+//The declarations inside an if or while body are skipped,
+// as in name analysis
+bool IfStmtNode::typeBetween(TypeAnalysis * ta, size_t i){
+	if (i == 1){
+		SymbolTable * symTab = ta->fusedSymbols();
+		if (symTab != nullptr){ symTab->enterScope(); }
+		return false;
+	}
+	return true;
+}
+
+void IfStmtNode::typePost(TypeAnalysis * ta){
+	SymbolTable * symTab = ta->fusedSymbols();
+	if (symTab != nullptr){ symTab->leaveScope(); }
 	const DataType * expType = ta->nodeType(myExp);
 	const DataType * stmtType = ta->nodeType(myStmts);
 
@@ -287,10 +348,23 @@ void IfStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void IfElseStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
-	myExp->typeAnalysis(ta);
-	myStmtsT->typeAnalysis(ta, fnRetType);
-	myStmtsF->typeAnalysis(ta, fnRetType);
+bool IfElseStmtNode::typeBetween(TypeAnalysis * ta, size_t i){
+	SymbolTable * symTab = ta->fusedSymbols();
+	if (i == 1){
+		if (symTab != nullptr){ symTab->enterScope(); }
+		return false;
+	}
+	if (i == 3){
+		if (symTab != nullptr){ symTab->leaveScope(); }
+		if (symTab != nullptr){ symTab->enterScope(); }
+		return false;
+	}
+	return true;
+}
+
+void IfElseStmtNode::typePost(TypeAnalysis * ta){
+	SymbolTable * symTab = ta->fusedSymbols();
+	if (symTab != nullptr){ symTab->leaveScope(); }
 	const DataType * expType = ta->nodeType(myExp);
 	const DataType * stmtTypeT = ta->nodeType(myStmtsT);
 	const DataType * stmtTypeF = ta->nodeType(myStmtsF);
@@ -317,9 +391,19 @@ void IfElseStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void WhileStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
-	myExp->typeAnalysis(ta);
-	myStmts->typeAnalysis(ta, fnRetType);
+bool WhileStmtNode::typePre(TypeAnalysis * ta){
+	SymbolTable * symTab = ta->fusedSymbols();
+	if (symTab != nullptr){ symTab->enterScope(); }
+	return true;
+}
+
+bool WhileStmtNode::typeBetween(TypeAnalysis * ta, size_t i){
+	return i != 1;
+}
+
+void WhileStmtNode::typePost(TypeAnalysis * ta){
+	SymbolTable * symTab = ta->fusedSymbols();
+	if (symTab != nullptr){ symTab->leaveScope(); }
 	const DataType * expType = ta->nodeType(myExp);
 	const DataType * stmtType = ta->nodeType(myStmts);
 
@@ -345,7 +429,8 @@ void WhileStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void ReturnStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
+void ReturnStmtNode::typePost(TypeAnalysis * ta){
+	TypeNode * fnRetType = ta->getFnRetType();
 	bool valid = true;
 	// if(myExp == nullptr && fnRetType->getDataType()->isVoid()){
 	// 	//valid
@@ -355,7 +440,6 @@ void ReturnStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
 		valid = false;
 	}
 	else if(myExp != nullptr){
-		myExp->typeAnalysis(ta);
 		const DataType * expType = ta->nodeType(myExp);
 		if(!expType->asError()){
 			//check if we are in void fn
@@ -401,18 +485,15 @@ void ReturnStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
 		ta->nodeType(this, VarType::produce(VOID));
 	}
 }
-void ExpListNode::typeAnalysis(TypeAnalysis* ta){
+void ExpListNode::typePost(TypeAnalysis * ta){
 	std::list<const DataType*> * argsList = new std::list<const DataType*>();
 	for(std::list<ExpNode*>::iterator it=myExps->begin(); it != myExps->end(); ++it){
-
-		(*it)->typeAnalysis(ta);
 		argsList->push_back(ta->nodeType(*it));
 	}
-	TupleType* myTuple = new TupleType(argsList);
+	TupleType* myTuple = ta->argsTuple(argsList);
 	ta->nodeType(this, myTuple);
 }
-void CallStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
-	myCallExp->typeAnalysis(ta);
+void CallStmtNode::typePost(TypeAnalysis * ta){
 	const DataType* callType = ta->nodeType(myCallExp);
 	bool valid = true;
 	if(callType->asError()){
@@ -430,10 +511,8 @@ void CallStmtNode::typeAnalysis(TypeAnalysis* ta, TypeNode* fnRetType){
 		ta->nodeType(this, VarType::produce(VOID));
 	}
 }
-void CallExpNode::typeAnalysis(TypeAnalysis* ta){
+void CallExpNode::typePost(TypeAnalysis * ta){
 	bool valid = true;
-	myId->typeAnalysis(ta);
-	myExpList->typeAnalysis(ta);
 	if(ta->nodeType(myId)->asFn() == nullptr){
 		ta->badCallee(myId->getLine(), myId->getCol());
 		valid = false;
@@ -483,11 +562,28 @@ void CallExpNode::typeAnalysis(TypeAnalysis* ta){
 	}
 
 }
-void PlusNode::typeAnalysis(TypeAnalysis* ta){
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-	const DataType * Exp1Type = ta->nodeType(myExp1);
-	const DataType * Exp2Type = ta->nodeType(myExp2);
+//The operators of a chain are checked left to right, each as
+// soon as its right operand has been analyzed, so diagnostics
+// come out in the order a spine of binary nodes would give
+bool ChainExpNode::typeBetween(TypeAnalysis * ta, size_t i){
+	if (i >= 2){
+		typeOperator(ta, i - 1);
+	}
+	return true;
+}
+
+void ChainExpNode::typePost(TypeAnalysis * ta){
+	typeOperator(ta, myExps.size() - 1);
+}
+
+const DataType * ChainExpNode::leftType(TypeAnalysis * ta, size_t k){
+	if (k == 1){ return ta->nodeType(myExps[0]); }
+	return ta->nodeType(this);
+}
+
+void PlusNode::typeOperator(TypeAnalysis * ta, size_t k){
+	const DataType * Exp1Type = leftType(ta, k);
+	const DataType * Exp2Type = ta->nodeType(myExps[k]);
 	/*
 	check if they are functions, check if they are ints,
 	check if the ptr depth is the same,
@@ -505,13 +601,13 @@ void PlusNode::typeAnalysis(TypeAnalysis* ta){
 	//checking RHS is valid
 	if(!(Exp1Type->isInt() || Exp1Type->isPtr()))
 	{
-		ta->badMathOpd(myExp1->getLine(), myExp1->getCol());
+		ta->badMathOpd(leftLine(k), leftCol(k));
 		valid = false;
 	}
 	//checking LHS is valid
 	if(!(Exp2Type->isInt() || Exp2Type->isPtr()))
 	{
-		ta->badMathOpd(myExp2->getLine(), myExp2->getCol());
+		ta->badMathOpd(myExps[k]->getLine(), myExps[k]->getCol());
 		valid = false;
 	}
 
@@ -533,7 +629,7 @@ void PlusNode::typeAnalysis(TypeAnalysis* ta){
 		//types are not incompatible
 		else
 		{
-			ta->badMathOpr(this->getLine(), this->getCol());
+			ta->badMathOpr(opLine(k), opCol(k));
 			ta->nodeType(this, ErrorType::produce());
 		}
 	}
@@ -544,9 +640,7 @@ void PlusNode::typeAnalysis(TypeAnalysis* ta){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void MinusNode::typeAnalysis(TypeAnalysis* ta){
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
+void MinusNode::typePost(TypeAnalysis * ta){
 	const DataType * Exp1Type = ta->nodeType(myExp1);
 	const DataType * Exp2Type = ta->nodeType(myExp2);
 	/*
@@ -605,11 +699,9 @@ void MinusNode::typeAnalysis(TypeAnalysis* ta){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void TimesNode::typeAnalysis(TypeAnalysis* ta){
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-	const DataType * Exp1Type = ta->nodeType(myExp1);
-	const DataType * Exp2Type = ta->nodeType(myExp2);
+void TimesNode::typeOperator(TypeAnalysis * ta, size_t k){
+	const DataType * Exp1Type = leftType(ta, k);
+	const DataType * Exp2Type = ta->nodeType(myExps[k]);
 	/*
 	check if they are functions, check if they are ints,
 	check if the ptr depth is the same,
@@ -626,14 +718,14 @@ void TimesNode::typeAnalysis(TypeAnalysis* ta){
 	//checking RHS is valid
 	if(!(Exp1Type->isInt() || Exp1Type->isPtr()))
 	{
-		ta->badMathOpd(myExp1->getLine(), myExp1->getCol());
+		ta->badMathOpd(leftLine(k), leftCol(k));
 		valid = false;
 	}
 
 	//checking LHS is valid
 	if(!(Exp2Type->isInt() || Exp2Type->isPtr()))
 	{
-		ta->badMathOpd(myExp2->getLine(), myExp2->getCol());
+		ta->badMathOpd(myExps[k]->getLine(), myExps[k]->getCol());
 		valid = false;
 	}
 
@@ -655,7 +747,7 @@ void TimesNode::typeAnalysis(TypeAnalysis* ta){
 		//types are not incompatible
 		else
 		{
-			ta->badMathOpr(this->getLine(), this->getCol());
+			ta->badMathOpr(opLine(k), opCol(k));
 			ta->nodeType(this, ErrorType::produce());
 		}
 	}
@@ -666,9 +758,7 @@ void TimesNode::typeAnalysis(TypeAnalysis* ta){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void DivideNode::typeAnalysis(TypeAnalysis* ta){
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
+void DivideNode::typePost(TypeAnalysis * ta){
 	const DataType * Exp1Type = ta->nodeType(myExp1);
 	const DataType * Exp2Type = ta->nodeType(myExp2);
 	/*
@@ -727,11 +817,9 @@ void DivideNode::typeAnalysis(TypeAnalysis* ta){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void AndNode::typeAnalysis(TypeAnalysis* ta){
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-	const DataType * Exp1Type = ta->nodeType(myExp1);
-	const DataType * Exp2Type = ta->nodeType(myExp2);
+void AndNode::typeOperator(TypeAnalysis * ta, size_t k){
+	const DataType * Exp1Type = leftType(ta, k);
+	const DataType * Exp2Type = ta->nodeType(myExps[k]);
 	/*
 	check if they are functions, check if they are ints,
 	check if the ptr depth is the same,
@@ -747,13 +835,13 @@ void AndNode::typeAnalysis(TypeAnalysis* ta){
 
 	//checking RHS is valid
 	if(!(Exp1Type->isBool())){
-		ta->badLogicOpd(myExp1->getLine(), myExp1->getCol());
+		ta->badLogicOpd(leftLine(k), leftCol(k));
 	  valid = false;
 	}
 
 	//checking LHS is valid
 	if(!(Exp2Type->isBool())){
-		ta->badLogicOpd(myExp2->getLine(), myExp2->getCol());
+		ta->badLogicOpd(myExps[k]->getLine(), myExps[k]->getCol());
 	  valid = false;
 	}
 
@@ -769,11 +857,9 @@ void AndNode::typeAnalysis(TypeAnalysis* ta){
 	}
 }
 
-void OrNode::typeAnalysis(TypeAnalysis* ta){
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
-	const DataType * Exp1Type = ta->nodeType(myExp1);
-	const DataType * Exp2Type = ta->nodeType(myExp2);
+void OrNode::typeOperator(TypeAnalysis * ta, size_t k){
+	const DataType * Exp1Type = leftType(ta, k);
+	const DataType * Exp2Type = ta->nodeType(myExps[k]);
 	/*
 	check if they are functions, check if they are ints,
 	check if the ptr depth is the same,
@@ -789,13 +875,13 @@ void OrNode::typeAnalysis(TypeAnalysis* ta){
 
 	//checking RHS is valid
 	if(!(Exp1Type->isBool())){
-		ta->badLogicOpd(myExp1->getLine(), myExp1->getCol());
+		ta->badLogicOpd(leftLine(k), leftCol(k));
 	  valid = false;
 	}
 
 	//checking LHS is valid
 	if(!(Exp2Type->isBool())){
-		ta->badLogicOpd(myExp2->getLine(), myExp2->getCol());
+		ta->badLogicOpd(myExps[k]->getLine(), myExps[k]->getCol());
 	  valid = false;
 	}
 
@@ -810,9 +896,7 @@ void OrNode::typeAnalysis(TypeAnalysis* ta){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void EqualsNode::typeAnalysis(TypeAnalysis* ta){
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
+void EqualsNode::typePost(TypeAnalysis * ta){
 	const DataType * Exp1Type = ta->nodeType(myExp1);
 	const DataType * Exp2Type = ta->nodeType(myExp2);
 	/*
@@ -867,9 +951,7 @@ void EqualsNode::typeAnalysis(TypeAnalysis* ta){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void NotEqualsNode::typeAnalysis(TypeAnalysis* ta){
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
+void NotEqualsNode::typePost(TypeAnalysis * ta){
 	const DataType * Exp1Type = ta->nodeType(myExp1);
 	const DataType * Exp2Type = ta->nodeType(myExp2);
 	/*
@@ -925,9 +1007,7 @@ void NotEqualsNode::typeAnalysis(TypeAnalysis* ta){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void LessNode::typeAnalysis(TypeAnalysis* ta){
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
+void LessNode::typePost(TypeAnalysis * ta){
 	const DataType * Exp1Type = ta->nodeType(myExp1);
 	const DataType * Exp2Type = ta->nodeType(myExp2);
 	/*
@@ -979,9 +1059,7 @@ void LessNode::typeAnalysis(TypeAnalysis* ta){
 	  ta->nodeType(this, ErrorType::produce());
 	}
 }
-void GreaterNode::typeAnalysis(TypeAnalysis* ta){
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
+void GreaterNode::typePost(TypeAnalysis * ta){
 	const DataType * Exp1Type = ta->nodeType(myExp1);
 	const DataType * Exp2Type = ta->nodeType(myExp2);
 	/*
@@ -1033,9 +1111,7 @@ void GreaterNode::typeAnalysis(TypeAnalysis* ta){
 	  ta->nodeType(this, ErrorType::produce());
 	}
 }
-void LessEqNode::typeAnalysis(TypeAnalysis* ta){
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
+void LessEqNode::typePost(TypeAnalysis * ta){
 	const DataType * Exp1Type = ta->nodeType(myExp1);
 	const DataType * Exp2Type = ta->nodeType(myExp2);
 	/*
@@ -1087,9 +1163,7 @@ void LessEqNode::typeAnalysis(TypeAnalysis* ta){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void GreaterEqNode::typeAnalysis(TypeAnalysis* ta){
-	myExp1->typeAnalysis(ta);
-	myExp2->typeAnalysis(ta);
+void GreaterEqNode::typePost(TypeAnalysis * ta){
 	const DataType * Exp1Type = ta->nodeType(myExp1);
 	const DataType * Exp2Type = ta->nodeType(myExp2);
 	/*
@@ -1142,8 +1216,7 @@ void GreaterEqNode::typeAnalysis(TypeAnalysis* ta){
 	}
 }
 //negative numbers
-void UnaryMinusNode::typeAnalysis(TypeAnalysis* ta){
-	myExp->typeAnalysis(ta);
+void UnaryMinusNode::typePost(TypeAnalysis * ta){
 	const DataType * ExpType = ta->nodeType(myExp);
 
 	bool valid = true;
@@ -1167,8 +1240,7 @@ void UnaryMinusNode::typeAnalysis(TypeAnalysis* ta){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void NotNode::typeAnalysis(TypeAnalysis* ta){
-	myExp->typeAnalysis(ta);
+void NotNode::typePost(TypeAnalysis * ta){
 	const DataType * ExpType = ta->nodeType(myExp);
 
 	bool valid = true;
@@ -1196,17 +1268,11 @@ void NotNode::typeAnalysis(TypeAnalysis* ta){
 		ta->nodeType(this, ErrorType::produce());
 	}
 }
-void ExpNode::typeAnalysis(TypeAnalysis * ta){
-	TODO("Override me in the subclass");
-}
-
-void AssignNode::typeAnalysis(TypeAnalysis * ta){
+void AssignNode::typePost(TypeAnalysis * ta){
 	//TODO: Note that this function is incomplete.
 	// and needs additional code
 
-	//Do typeAnalysis on the subexpressions
-	myTgt->typeAnalysis(ta);
-	mySrc->typeAnalysis(ta);
+	//The walk already did typeAnalysis on the subexpressions
 
 	const DataType * tgtType = ta->nodeType(myTgt);
 	const DataType * srcType = ta->nodeType(mySrc);
@@ -1263,13 +1329,31 @@ void AssignNode::typeAnalysis(TypeAnalysis * ta){
 			ta->nodeType(this, tgtType);
 		}
 	}
+	else{
+		//An int into a bool or the other way around
+		ta->badAssignOpr(this->getLine(), this->getCol());
+		ta->nodeType(this, ErrorType::produce());
+	}
 }
 
-void DeclNode::typeAnalysis(TypeAnalysis * ta){
-	TODO("Override me in the subclass");
+bool VarDeclNode::typePre(TypeAnalysis * ta){
+	//The type node and id of a declaration are not
+	// expressions, so there is nothing below to check
+	return false;
 }
 
-void VarDeclNode::typeAnalysis(TypeAnalysis * ta){
+void VarDeclNode::typePost(TypeAnalysis * ta){
+	SymbolTable * symTab = ta->fusedSymbols();
+	if (symTab != nullptr){
+		if (!this->nameAnalysis(symTab)){
+			//The declaration was rejected, so there is
+			// no symbol to take the type from
+			ta->nameFailed();
+			ta->nodeType(this, ErrorType::produce());
+			return;
+		}
+	}
+
 	// VarDecls always pass type analysis, since they
 	// are never used in an expression. You may choose
 	// to type them void (like this).
@@ -1282,7 +1366,16 @@ void VarDeclNode::typeAnalysis(TypeAnalysis * ta){
 	ta->nodeType(this, myID->getSymbol()->getType());
 }
 
-void IdNode::typeAnalysis(TypeAnalysis * ta){
+void IdNode::typePost(TypeAnalysis * ta){
+	SymbolTable * symTab = ta->fusedSymbols();
+	if (symTab != nullptr){
+		if (!this->resolveName(symTab)){
+			ta->nameFailed();
+			ta->nodeType(this, ErrorType::produce());
+			return;
+		}
+	}
+
 	// IDs never fail type analysis and always
 	// yield the type of their symbol (which
 	// depends on their definition)
@@ -1290,8 +1383,7 @@ void IdNode::typeAnalysis(TypeAnalysis * ta){
 	// const DataType * tgtType = ta->nodeType(this);
 	// std::cout << tgtType->isPtr() << "\n";
 }
-void DerefNode::typeAnalysis(TypeAnalysis * ta){
-	myTgt->typeAnalysis(ta);
+void DerefNode::typePost(TypeAnalysis * ta){
 	bool valid = true;
 	const DataType * tgtType = ta->nodeType(myTgt);
 	const DataType * tgtCheck;
@@ -1319,15 +1411,18 @@ void DerefNode::typeAnalysis(TypeAnalysis * ta){
 		ta->nodeType(this, tgtCheck);
 	}
 }
-void IntLitNode::typeAnalysis(TypeAnalysis * ta){
+void IntLitNode::typePost(TypeAnalysis * ta){
 	// IntLits never fail their type analysis and always
 	// yield the type INT
 	ta->nodeType(this, VarType::produce(INT));
 }
-void TrueNode::typeAnalysis(TypeAnalysis * ta) {
+void StrLitNode::typePost(TypeAnalysis * ta){
+	ta->nodeType(this, VarType::produce(STR));
+}
+void TrueNode::typePost(TypeAnalysis * ta){
 	ta->nodeType(this, VarType::produce(BOOL));
 }
-void FalseNode::typeAnalysis(TypeAnalysis * ta) {
+void FalseNode::typePost(TypeAnalysis * ta){
 	ta->nodeType(this, VarType::produce(BOOL));
 }
 
@@ -6,7 +6,7 @@ namespace lake{
 
 std::string VarType::getString() const{
 	std::string res = "";
-	switch(myBaseType){
+	switch(getBaseType()){
 	case INT:
 		res += "int";
 		break;
@@ -20,8 +20,9 @@ std::string VarType::getString() const{
 		res += "string";
 		break;
 	}
-	if (myDepth > 0){
-		for (size_t i = 0 ; i < myDepth ; i++){
+	size_t depth = getDepth();
+	if (depth > 0){
+		for (size_t i = 0 ; i < depth ; i++){
 			res += "@";
 		}
 	}
@@ -1,6 +1,7 @@
 #ifndef LAKE_DATA_TYPES
 #define LAKE_DATA_TYPES
 
+#include <cstdint>
 #include <list>
 #include <sstream>
 #include "err.hpp"
@@ -18,6 +19,8 @@ using HashMap = std::unordered_map<K, V>;
 namespace lake{
 
 class ASTNode;
+class SymbolTable;
+class TypeNode;
 
 class VarType;
 class FnType;
@@ -32,18 +35,52 @@ enum BaseType{
 // can get information about which type is implemented
 // concretely using the as<X> functions, or query information
 // using the is<X> functions.
+//
+// Type analysis asks these questions several times per node,
+// so rather than being virtual they are answered from a tag
+// stored in every type: which subclass it is, and for a
+// VarType its base type and pointer depth, all packed into
+// 32 bits.
 class DataType{
 public:
+	virtual ~DataType(){ }
 	virtual std::string getString() const = 0;
-	virtual const VarType * asVar() const { return nullptr; }
-	virtual const FnType * asFn() const { return nullptr; }
-	virtual const TupleType * asTuple() const { return nullptr; }
-	virtual const ErrorType * asError() const { return nullptr; }
-	virtual bool isVoid() const { return false; }
-	virtual bool isPtr() const { return false; }
-	virtual bool isInt() const { return false; }
-	virtual bool isBool() const { return false; }
+	inline const VarType * asVar() const;
+	inline const FnType * asFn() const;
+	inline const TupleType * asTuple() const;
+	inline const ErrorType * asError() const;
+	//Note that a pointer to void is void as well
+	bool isVoid() const { 
+		return (myTag & (KIND_MASK | BASE_MASK)) 
+			== varTag(BaseType::VOID, 0); 
+	}
+	bool isPtr() const { 
+		return (myTag & KIND_MASK) == VAR_KIND 
+			&& (myTag >> DEPTH_SHIFT) != 0;
+	}
+	bool isInt() const { return myTag == varTag(INT, 0); }
+	bool isBool() const { return myTag == varTag(BOOL, 0); }
 protected:
+	enum Kind : uint32_t {
+		VAR_KIND, FN_KIND, TUPLE_KIND, ERROR_KIND
+	};
+	static const uint32_t KIND_MASK = 0x3;
+	static const uint32_t BASE_SHIFT = 2;
+	static const uint32_t BASE_MASK = 0x3 << BASE_SHIFT;
+	static const uint32_t DEPTH_SHIFT = 4;
+	static const size_t MAX_DEPTH = UINT32_MAX >> DEPTH_SHIFT;
+
+	DataType(Kind kind) : myTag(kind){ }
+	static uint32_t varTag(BaseType base, size_t depth){
+		return VAR_KIND 
+			| (static_cast<uint32_t>(base) << BASE_SHIFT)
+			| (static_cast<uint32_t>(depth) << DEPTH_SHIFT);
+	}
+	Kind kind() const { 
+		return static_cast<Kind>(myTag & KIND_MASK); 
+	}
+
+	uint32_t myTag;
 };
 
 //This DataType subclass is the superclass for all Lake types.
@@ -59,12 +96,11 @@ public:
 
 		return error;
 	}
-	virtual const ErrorType * asError() const override { return this; }
 	virtual std::string getString() const override {
 		return "ERROR";
 	}
 private:
-	ErrorType(){
+	ErrorType() : DataType(ERROR_KIND){
 		/* private constructor, can only
 		be called from produce */
 	}
@@ -102,17 +138,17 @@ public:
 		//means that the flyweights variable persists between
 		// multiple calls to this function (it is essentially
 		// a global variable that can only be accessed
-		// in this function).
-		static std::list<VarType *> flyweights;
-		for(VarType * fly : flyweights){
-			if (fly->getDepth() == depth &&
-			    fly->getBaseType() == base){
-				return fly;
-			}
+		// in this function). It is keyed by the type's tag,
+		// which is unique to each base type and depth.
+		static HashMap<uint32_t, VarType *> flyweights;
+		if (depth > MAX_DEPTH){
+			throw new InternalError("Pointer depth too large");
+		}
+		VarType *& fly = flyweights[varTag(base, depth)];
+		if (fly == nullptr){
+			fly = new VarType(base, depth);
 		}
-		VarType * newType = new VarType(base, depth);
-		flyweights.push_back(newType);
-		return newType;
+		return fly;
 	}
 	const VarType * asVar() const {
 		return this;
@@ -120,37 +156,23 @@ public:
 	VarType * asVar(){
 		return this;
 	}
-	bool isInt() const override {
-		if (myDepth > 0){ return false; }
-		if (myBaseType != INT){ return false; }
-		return true;
-	}
-	bool isBool() const override {
-		if (myDepth > 0){ return false; }
-		if (myBaseType != BOOL){ return false; }
-		return true;
-	}
-	bool isPtr() const override {
-		if (myDepth > 0) { return true; }
-		return false;
-	}
 
 	const VarType * getDerefType () const {
 		size_t depth = this->getDepth();
 		if (depth == 0){ return nullptr; }
 		return produce(this->getBaseType(), depth - 1);
 	}
-	virtual bool isVoid() const override {
-		return myBaseType == BaseType::VOID;
+	BaseType getBaseType() const { 
+		return static_cast<BaseType>(
+			(myTag & BASE_MASK) >> BASE_SHIFT); 
 	}
-	virtual BaseType getBaseType() const { return myBaseType; }
-	virtual size_t getDepth() const { return myDepth; }
+	size_t getDepth() const { return myTag >> DEPTH_SHIFT; }
 	virtual std::string getString() const override;
 private:
 	VarType(BaseType base, size_t depth)
-	: myBaseType(base), myDepth(depth){ }
-	BaseType myBaseType;
-	size_t myDepth;
+	: DataType(VAR_KIND){ 
+		myTag = varTag(base, depth);
+	}
 };
 
 // DataType subclass for tuples of types (i.e. lists of more
@@ -159,7 +181,7 @@ private:
 class TupleType : public DataType{
 public:
 	TupleType(std::list<const DataType *> * eltTypesIn)
-	: eltTypes(eltTypesIn){
+	: DataType(TUPLE_KIND), eltTypes(eltTypesIn){
 	}
 	DataType * data;
 	std::string getString() const override{
@@ -172,8 +194,6 @@ public:
 		}
 		return res;
 	}
-	virtual const TupleType * asTuple() const { return this; }
-
 	std::list<const DataType *> * getElts () const {
 		return eltTypes;
 	}
@@ -187,7 +207,7 @@ private:
 class FnType : public DataType{
 public:
 	FnType(const TupleType * formalsIn, const DataType * retTypeIn)
-	: DataType(),
+	: DataType(FN_KIND),
 	  myFormalTypes(formalsIn),
 	  myRetType(retTypeIn)
 	{
@@ -200,8 +220,6 @@ public:
 		result += myRetType->getString();
 		return result;
 	}
-	virtual const FnType * asFn() const override { return this; }
-
 	const DataType * getReturnType() const {
 		return myRetType;
 	}
@@ -213,6 +231,26 @@ private:
 	const DataType * myRetType;
 };
 
+inline const VarType * DataType::asVar() const {
+	if (kind() != VAR_KIND){ return nullptr; }
+	return static_cast<const VarType *>(this);
+}
+
+inline const FnType * DataType::asFn() const {
+	if (kind() != FN_KIND){ return nullptr; }
+	return static_cast<const FnType *>(this);
+}
+
+inline const TupleType * DataType::asTuple() const {
+	if (kind() != TUPLE_KIND){ return nullptr; }
+	return static_cast<const TupleType *>(this);
+}
+
+inline const ErrorType * DataType::asError() const {
+	if (kind() != ERROR_KIND){ return nullptr; }
+	return static_cast<const ErrorType *>(this);
+}
+
 // An instance of this class will be passed over the entire
 // AST. Rather than attaching types to each node, the
 // TypeAnalysis class contains a map from each ASTNode to it's
@@ -223,7 +261,50 @@ class TypeAnalysis {
 public:
 	TypeAnalysis(){
 		hasError = false;
+		namesOk = true;
+		fusedSymTab = nullptr;
+		fnRetType = nullptr;
+		errOut = &std::cerr;
 	}
+
+	//Constructor for the fused mode, where name analysis is
+	// done during the type analysis traversal rather than in
+	// a separate pass over the tree. Type errors are held back
+	// until the end, since they would never have been reported
+	// at all had name analysis failed.
+	TypeAnalysis(SymbolTable * symTab){
+		hasError = false;
+		namesOk = true;
+		fusedSymTab = symTab;
+		fnRetType = nullptr;
+		errOut = &heldErrs;
+	}
+
+	~TypeAnalysis(){
+		forgetNodes();
+	}
+
+	//Drop everything recorded about the nodes analyzed so far.
+	// Used when those nodes are about to be freed.
+	void forgetNodes(){
+		nodeToType.clear();
+		for (TupleType * tuple : argTuples){
+			delete tuple->getElts();
+			delete tuple;
+		}
+		argTuples.clear();
+	}
+
+	//Make the tuple type for an argument list. These types
+	// are only needed while the call is being checked, so
+	// they belong to the analysis rather than living forever
+	// like the declared types do.
+	TupleType * argsTuple(std::list<const DataType *> * elts){
+		TupleType * tuple = new TupleType(elts);
+		argTuples.push_back(tuple);
+		return tuple;
+	}
+
 	//The type analysis has an instance variable to say whether
 	// the analysis failed or not. Setting this variable is much
 	// less of a pain than passing a boolean all the way up to the
@@ -232,6 +313,39 @@ public:
 		return !hasError;
 	}
 
+	//The symbol table to resolve names against in fused mode,
+	// or nullptr if name analysis was already run on its own.
+	SymbolTable * fusedSymbols(){
+		return fusedSymTab;
+	}
+
+	//Name analysis results in fused mode. Name errors are
+	// reported immediately, so only the outcome is kept here.
+	void nameFailed(){
+		namesOk = false;
+	}
+	bool namesPassed(){
+		return namesOk;
+	}
+
+	//The declared return type of the function whose body
+	// is being analyzed, for checking return statements
+	void setFnRetType(TypeNode * retType){
+		fnRetType = retType;
+	}
+	TypeNode * getFnRetType(){
+		return fnRetType;
+	}
+
+	//Report the held back type errors (only has an effect in
+	// fused mode)
+	void flushErrors(){
+		if (errOut == &heldErrs){
+			std::cerr << heldErrs.str();
+			heldErrs.str("");
+		}
+	}
+
 	//Set the type of a node. Note that the function name is
 	// overloaded: this 2-argument nodeType puts a value into the
 	// map with a given type.
@@ -256,146 +370,152 @@ public:
 
 	void badArgMatch(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Type of actual does not match"
 			<< " type of formal\n";
 	}
 	void badMathOpd(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Arithmetic operator applied"
 			<< " to invalid operand\n";
 	}
 	void badMathOpr(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Arithmetic operator applied"
 			<< " to incompatible operands\n";
 	}
 	void badArgCount(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Function call with wrong"
 			<< " number of args\n";
 	}
 	void badCallee(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Attempt to call a "
 			<< "non-function\n";
 	}
 	void badAssignOpr(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Invalid assignment operation"
 			<< "\n";
 	}
 	void badAssignOpd(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Invalid assignment operand"
 			<< "\n";
 	}
 	void badDeref(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Invalid operand for deref"
 			<< "\n";
 	}
 	void badEqOpd(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Invalid equality operand"
 			<< "\n";
 	}
 	void badEqOpr(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Invalid equality operation"
 			<< "\n";
 	}
 	void badLogicOpd(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Logical operator applied to"
 			<< " non-bool operand"
 			<< "\n";
 	}
 	void badNoRet(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Missing return value"
 			<< "\n";
 	}
 	void badRelOpd(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Relational operator applied to"
 			<< " non-numeric operand"
 			<< "\n";
 	}
 	void badReadPtr(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Attempt to read a raw pointer"
 			<< "\n";
 	}
 	void badWriteVoid(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Attempt to write void"
 			<< "\n";
 	}
 
 	void badWhileCond(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Non-bool expression used as"
 			<< " a while condition"
 			<< "\n";
 	}
 	void badIfCond(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Non-bool expression used as"
 			<< " an if condition"
 			<< "\n";
 	}
 	void badRetValue(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Bad return value"
 			<< "\n";
 	}
 	void extraRetValue(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Return with a value in void"
 			<< " function"
 			<< "\n";
 	}
 	void writePtr(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Attempt to write a raw pointer"
 			<< "\n";
 	}
 	void writeFn(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Attempt to write a function"
 			<< "\n";
 	}
 
 	void readFn(size_t line, size_t col){
 		hasError = true;
-		std::cerr << line << "," << col << ": "
+		*errOut << line << "," << col << ": "
 			<< "Attempt to read a function"
 			<< "\n";
 	}
 private:
 	HashMap<const ASTNode *, const DataType *> nodeToType;
 	bool hasError;
+	bool namesOk;
+	SymbolTable * fusedSymTab;
+	TypeNode * fnRetType;
+	std::ostream * errOut;
+	std::ostringstream heldErrs;
+	std::list<TupleType *> argTuples;
 };
 
 }
@@ -1,179 +1,286 @@
 #include "ast.hpp"
 #include "symbol_table.hpp"
+#include "walker.hpp"
 
 namespace lake{
 
-void ProgramNode::unparse(std::ostream& out, int indent){
-	myDeclList->unparse(out, indent);
-}
-
-void DeclListNode::unparse(std::ostream& out, int indent){
-	for (std::list<DeclNode *>::iterator 
-		it=myDecls->begin();
-		it != myDecls->end(); ++it){
-	    DeclNode * elt = *it;
-	    elt->unparse(out, indent);
+namespace {
+//Hands each node's unparse hooks the output stream, with the
+// walk's context being the indentation level
+class UnparseVisitor : public ASTVisitor{
+public:
+	UnparseVisitor(std::ostream& outIn) : out(outIn){ }
+	bool pre(ASTNode * node, int indent) override {
+		return node->unparsePre(out, indent);
+	}
+	bool between(ASTNode * node, size_t i, int indent, 
+		int& childIndent) override {
+		return node->unparseBetween(out, indent, i, childIndent);
 	}
+	void post(ASTNode * node, int indent) override {
+		node->unparsePost(out, indent);
+	}
+private:
+	std::ostream& out;
+};
 }
 
-void VarDeclListNode::unparse(std::ostream& out, int indent){
-	for (VarDeclNode * varDecl : *myDecls){
-		varDecl->unparse(out, indent);
-	}
+void ASTNode::unparse(std::ostream& out, int indent){
+	UnparseVisitor visitor(out);
+	walk(this, visitor, indent);
 }
 
-void FormalsListNode::unparse(std::ostream& out, int indent){
-	bool first = true;
-	for (FormalDeclNode * formal : *myFormals){
-		if (first){ first = false; }
-		else { out << ", "; }
-		formal->unparse(out, indent);
-	}
+bool FormalsListNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	if (i > 0){ out << ", "; }
+	return true;
 }
 
-void FnBodyNode::unparse(std::ostream& out, int indent){
+bool FnBodyNode::unparsePre(std::ostream& out, int indent){
 	this->doIndent(out, indent);
 	out << " {\n";
-	myVarDecls->unparse(out,indent+4);
-	myStmtList->unparse(out,indent+4);
-	out << "}\n";
+	return true;
 }
 
-void ExpListNode::unparse(std::ostream& out, int indent){
-	bool first = true;
-	for (ExpNode * exp : *myExps){
-		if (first) { first = false; }
-		else { out << ","; }
-		exp->unparse(out, indent);
-	}
+bool FnBodyNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	childIndent = indent + 4;
+	return true;
 }
 
-void StmtListNode::unparse(std::ostream& out, int indent){
-	for (std::list<StmtNode *>::iterator it=myStmts->begin();
-		it != myStmts->end(); ++it){
-	    StmtNode * elt = *it;
-	    elt->unparse(out, indent);
-	}
+void FnBodyNode::unparsePost(std::ostream& out, int indent){
+	out << "}\n";
+}
+
+bool ExpListNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	if (i > 0){ out << ","; }
+	return true;
 }
 
-void VarDeclNode::unparse(std::ostream& out, int indent){
+bool VarDeclNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	getTypeNode()->unparse(out, 0);
 	out << " ";
 	out << getDeclaredName();
 	out << ";\n";
+	return false;
 }
 
-void FnDeclNode::unparse(std::ostream& out, int indent){
+bool FnDeclNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	getReturnTypeNode()->unparse(out, 0);
 	out << " ";
 	out << getDeclaredName();
 	out << "(";
-	myFormals->unparse(out, 0);
-	out << ")";
-	myBody->unparse(out, 0);
+	return true;
+}
+
+bool FnDeclNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	//The return type and name are already printed
+	if (i < 2){ return false; }
+	if (i == 3){ out << ")"; }
+	childIndent = 0;
+	return true;
 }
 
-void FormalDeclNode::unparse(std::ostream& out, int indent){
+bool FormalDeclNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	getTypeNode()->unparse(out, 0);
 	out << " " << getDeclaredName();
+	return false;
+}
+
+//Statements that are just an expression with something on
+// either side
+static bool stmtBetween(int& childIndent){
+	childIndent = 0;
+	return true;
 }
 
-void AssignStmtNode::unparse(std::ostream& out, int indent){
+bool AssignStmtNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
-	myAssign->unparse(out,0);
+	return true;
+}
+
+bool AssignStmtNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	return stmtBetween(childIndent);
+}
+
+void AssignStmtNode::unparsePost(std::ostream& out, int indent){
 	out << ";\n";
 }
 
-void PostIncStmtNode::unparse(std::ostream& out, int indent){
+bool PostIncStmtNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
-	myExp->unparse(out,0);
+	return true;
+}
+
+bool PostIncStmtNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	return stmtBetween(childIndent);
+}
+
+void PostIncStmtNode::unparsePost(std::ostream& out, int indent){
 	out << "++;\n";
 }
 
-void PostDecStmtNode::unparse(std::ostream& out, int indent){
+bool PostDecStmtNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
-	myExp->unparse(out,0);
+	return true;
+}
+
+bool PostDecStmtNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	return stmtBetween(childIndent);
+}
+
+void PostDecStmtNode::unparsePost(std::ostream& out, int indent){
 	out << "--;\n";
 }
 
-void ReadStmtNode::unparse(std::ostream& out, int indent){
+bool ReadStmtNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << ">> ";
-	myExp->unparse(out,0);
+	return true;
+}
+
+bool ReadStmtNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	return stmtBetween(childIndent);
+}
+
+void ReadStmtNode::unparsePost(std::ostream& out, int indent){
 	out << ";\n";
 }
 
-void WriteStmtNode::unparse(std::ostream& out, int indent){
+bool WriteStmtNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "<< ";
-	myExp->unparse(out,0);
+	return true;
+}
+
+bool WriteStmtNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	return stmtBetween(childIndent);
+}
+
+void WriteStmtNode::unparsePost(std::ostream& out, int indent){
 	out << ";\n";
 }
 
-void IfStmtNode::unparse(std::ostream& out, int indent){
+bool IfStmtNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "if(";
-	myExp->unparse(out,0);
-	out << ") {\n";
-	myDecls->unparse(out,indent+4);
-	myStmts->unparse(out,indent+4);
+	return true;
+}
+
+bool IfStmtNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	if (i == 0){
+		childIndent = 0;
+		return true;
+	}
+	if (i == 1){ out << ") {\n"; }
+	childIndent = indent + 4;
+	return true;
+}
+
+void IfStmtNode::unparsePost(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "}\n";
 }
 
-void IfElseStmtNode::unparse(std::ostream& out, int indent){
+bool IfElseStmtNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "if(";
-	myExp->unparse(out,0);
-	out << ") {\n";
-	myDeclsT->unparse(out,indent+4);
-	myStmtsT->unparse(out,indent+4);
-	doIndent(out, indent);
-	out << "}\n";
-	doIndent(out, indent);
-	out << "else {\n";
-	myDeclsF->unparse(out,indent+4);
-	myStmtsF->unparse(out,indent+4);
+	return true;
+}
+
+bool IfElseStmtNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	if (i == 0){
+		childIndent = 0;
+		return true;
+	}
+	if (i == 1){ out << ") {\n"; }
+	if (i == 3){
+		doIndent(out, indent);
+		out << "}\n";
+		doIndent(out, indent);
+		out << "else {\n";
+	}
+	childIndent = indent + 4;
+	return true;
+}
+
+void IfElseStmtNode::unparsePost(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "}\n";
 }
 
-void WhileStmtNode::unparse(std::ostream& out, int indent){
+bool WhileStmtNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "while(";
-	myExp->unparse(out,0);
-	out << ") {\n";
-	myDecls->unparse(out,indent+4);
-	myStmts->unparse(out,indent+4);
+	return true;
+}
+
+bool WhileStmtNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	if (i == 0){
+		childIndent = 0;
+		return true;
+	}
+	if (i == 1){ out << ") {\n"; }
+	childIndent = indent + 4;
+	return true;
+}
+
+void WhileStmtNode::unparsePost(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "}\n";
 }
 
-void CallStmtNode::unparse(std::ostream& out, int indent){
+bool CallStmtNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
-	myCallExp->unparse(out,0);
+	return true;
+}
+
+bool CallStmtNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	return stmtBetween(childIndent);
+}
+
+void CallStmtNode::unparsePost(std::ostream& out, int indent){
 	out << ";\n";
 }
 
-void ReturnStmtNode::unparse(std::ostream& out, int indent){
+bool ReturnStmtNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "return ";
-	if(myExp != nullptr) {
-		myExp->unparse(out,0);
-	}
+	return true;
+}
+
+bool ReturnStmtNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	return stmtBetween(childIndent);
+}
+
+void ReturnStmtNode::unparsePost(std::ostream& out, int indent){
 	out << ";\n";
 }
 
-void DerefNode::unparse(std::ostream& out, int indent){
+//Expressions are only ever unparsed at indent 0, which their
+// subexpressions inherit
+bool DerefNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "@";
-	myTgt->unparse(out,0);
+	return true;
 }
 
-void IdNode::unparse(std::ostream& out, int indent){
+bool IdNode::unparsePre(std::ostream& out, int indent){
 	if (indent < 0){ 
 		throw new InternalError("negative indent"); 
 	}
@@ -181,6 +288,7 @@ void IdNode::unparse(std::ostream& out, int indent){
 	if (mySymbol != NULL){
 		out << "(TODO)";
 	}
+	return false;
 }
 
 void TypeNode::printIndirection(std::ostream& out){
@@ -189,83 +297,130 @@ void TypeNode::printIndirection(std::ostream& out){
 	for (int i = 0 ; i < depth; i++){ out << "@"; }
 }
 
-void IntNode::unparse(std::ostream& out, int indent){
+bool IntNode::unparsePre(std::ostream& out, int indent){
 	if (indent < 0){ throw new InternalError("negative indent"); }
 	out << "int";
 	printIndirection(out);
+	return false;
 }
 
-void BoolNode::unparse(std::ostream& out, int indent){
+bool BoolNode::unparsePre(std::ostream& out, int indent){
 	if (indent < 0){ throw new InternalError("negative indent"); }
 	out << "bool";
 	printIndirection(out);
+	return false;
 }
 
-void VoidNode::unparse(std::ostream& out, int indent){
+bool VoidNode::unparsePre(std::ostream& out, int indent){
 	if (indent < 0){ throw new InternalError("negative indent"); }
 	out << "void";
 	printIndirection(out);
+	return false;
 }
 
-void IntLitNode::unparse(std::ostream& out, int indent){
+bool IntLitNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << myInt;
+	return false;
 }
 
-void StrLitNode::unparse(std::ostream& out, int indent){
+bool StrLitNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << myString;
+	return false;
 }
 
-void TrueNode::unparse(std::ostream& out, int indent){
+bool TrueNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "true";
+	return false;
 }
 
-void FalseNode::unparse(std::ostream& out, int indent){
+bool FalseNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "false";
+	return false;
 }
 
-void AssignNode::unparse(std::ostream& out, int indent){
+bool AssignNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
-	myTgt->unparse(out, 0);
-	out << " = ";
-	mySrc->unparse(out, 0);
+	return true;
 }
 
-void CallExpNode::unparse(std::ostream& out, int indent){
+bool AssignNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	if (i == 1){ out << " = "; }
+	return true;
+}
+
+bool CallExpNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
-	myId->unparse(out, 0);
-	out << "(";
-	myExpList->unparse(out, 0);
+	return true;
+}
+
+bool CallExpNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	if (i == 1){ out << "("; }
+	return true;
+}
+
+void CallExpNode::unparsePost(std::ostream& out, int indent){
 	out << ")";
 }
 
-void UnaryMinusNode::unparse(std::ostream& out, int indent){
+bool UnaryMinusNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "(";
 	out << "-";
-	myExp->unparse(out, 0);
+	return true;
+}
+
+void UnaryMinusNode::unparsePost(std::ostream& out, int indent){
 	out << ")";
 }
 
-void NotNode::unparse(std::ostream& out, int indent){
+bool NotNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "(";
 	out << "!";
-	myExp->unparse(out, 0);
+	return true;
+}
+
+void NotNode::unparsePost(std::ostream& out, int indent){
 	out << ")";
 }
 
-void BinaryExpNode::unparse(std::ostream& out, int indent){
+bool BinaryExpNode::unparsePre(std::ostream& out, int indent){
 	doIndent(out, indent);
 	out << "(";
-	myExp1->unparse(out, 0);
-	out << myOp();
-	myExp2->unparse(out, 0);
+	return true;
+}
+
+bool BinaryExpNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	if (i == 1){ out << myOp(); }
+	return true;
+}
+
+void BinaryExpNode::unparsePost(std::ostream& out, int indent){
 	out << ")";
 }
 
+bool ChainExpNode::unparsePre(std::ostream& out, int indent){
+	doIndent(out, indent);
+	for (size_t k = 1; k < myExps.size(); k++){ out << "("; }
+	return true;
+}
+
+bool ChainExpNode::unparseBetween(std::ostream& out, int indent,
+	size_t i, int& childIndent){
+	if (i > 1){ out << ")"; }
+	if (i > 0){ out << myOp(); }
+	return true;
+}
+
+void ChainExpNode::unparsePost(std::ostream& out, int indent){
+	out << ")";
+}
 
 } // End namespace LIL' C
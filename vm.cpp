@@ -0,0 +1,273 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "vm.hpp"
+
+namespace lake{
+
+int64_t interpReadInt(){
+	long long val = 0;
+	fflush(stdout);
+	if (scanf("%lld", &val) != 1){
+		return 0;
+	}
+	return val;
+}
+
+//A bool is read as true or false, or as an int (nonzero is
+// true)
+int64_t interpReadBool(){
+	char word[32];
+	fflush(stdout);
+	if (scanf("%31s", word) != 1){
+		return 0;
+	}
+	if (strcmp(word, "true") == 0){
+		return 1;
+	}
+	if (strcmp(word, "false") == 0){
+		return 0;
+	}
+	return strtoll(word, nullptr, 10) != 0;
+}
+
+void interpWriteInt(int64_t val){
+	printf("%lld", static_cast<long long>(val));
+}
+
+void interpWriteBool(int64_t val){
+	fputs(val ? "true" : "false", stdout);
+}
+
+void interpWriteStr(const std::string& str){
+	fwrite(str.data(), 1, str.size(), stdout);
+}
+
+//The frame stack holds every active call's registers, one frame
+// right after another, as much as a native stack would
+static const size_t STACK_WORDS = 1 << 20;
+
+//Where to pick up again when a call returns
+struct VMReturn{
+	const uint32_t * pc;
+	int64_t * frame;
+	uint32_t frameSize;
+	uint32_t dst;
+};
+
+int64_t interpDivide(int64_t a, int64_t b){
+	if (b == 0){
+		throw new RuntimeError("Division by zero");
+	}
+	if (b == -1 && a == INT64_MIN){
+		throw new RuntimeError("Division overflow");
+	}
+	return a / b;
+}
+
+//Ints wrap around, which C++ only promises for unsigned ones
+static int64_t wrap(uint64_t v){ return static_cast<int64_t>(v); }
+static uint64_t bits(int64_t v){ return static_cast<uint64_t>(v); }
+
+//Dispatch jumps straight from one instruction's handler to the
+// next through a table of label addresses (a GNU extension), so
+// that each handler ends in an indirect jump of its own.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+int64_t runBytecode(const Bytecode& bc){
+	static const void * const dispatch[] = {
+		&&op_MOV, &&op_LOADK,
+		&&op_ADD, &&op_SUB, &&op_MUL, &&op_DIV, &&op_EQ, &&op_NE,
+		&&op_LT, &&op_GT, &&op_LE, &&op_GE,
+		&&op_ADDK, &&op_SUBK, &&op_MULK, &&op_DIVK, &&op_EQK, &&op_NEK,
+		&&op_LTK, &&op_GTK, &&op_LEK, &&op_GEK,
+		&&op_NEG, &&op_NOT, &&op_LOADG, &&op_STOREG, &&op_LOAD,
+		&&op_STORE, &&op_LOADT, &&op_STORET, &&op_CALL, &&op_TAILCALL, &&op_RET, &&op_RET0,
+		&&op_READ_INT, &&op_READ_BOOL, &&op_WRITE_INT, &&op_WRITE_BOOL,
+		&&op_WRITE_STR, &&op_JMP, &&op_JNZ, &&op_JZ,
+		&&op_JEQ, &&op_JNE, &&op_JLT, &&op_JGT, &&op_JLE, &&op_JGE,
+		&&op_JEQK, &&op_JNEK, &&op_JLTK, &&op_JGTK, &&op_JLEK, &&op_JGEK
+	};
+	static_assert(sizeof(dispatch) / sizeof(dispatch[0])
+		== static_cast<size_t>(VMOp::NUM_OPS), "a handler for every op");
+
+	std::vector<int64_t> memory(bc.memorySize, 0);
+	std::vector<int64_t> stack(STACK_WORDS, 0);
+	std::vector<VMReturn> returns;
+	const uint32_t * code = bc.code.data();
+	const VMFunction& main = bc.functions[bc.mainFn];
+	int64_t * stackEnd = stack.data() + stack.size();
+	int64_t * r = stack.data();
+	uint32_t frameSize = main.frameSize;
+	const uint32_t * pc = code + main.entry;
+	int64_t res = 0;
+	if (r + frameSize > stackEnd){
+		throw new RuntimeError("Stack overflow");
+	}
+
+#define NEXT(n) pc += (n); goto *dispatch[*pc]
+#define BINARY(name, expr) \
+	op_##name: { int64_t a = r[pc[2]]; int64_t b = r[pc[3]]; \
+		r[pc[1]] = (expr); NEXT(4); } \
+	op_##name##K: { int64_t a = r[pc[2]]; \
+		int64_t b = static_cast<int32_t>(pc[3]); \
+		r[pc[1]] = (expr); NEXT(4); }
+#define BRANCH(name, test) \
+	op_J##name: if (r[pc[1]] test r[pc[2]]){ \
+		pc = code + pc[3]; NEXT(0); } \
+		NEXT(4); \
+	op_J##name##K: if (r[pc[1]] test static_cast<int32_t>(pc[2])){ \
+		pc = code + pc[3]; NEXT(0); } \
+		NEXT(4);
+
+	NEXT(0);
+	op_MOV:
+		r[pc[1]] = r[pc[2]];
+		NEXT(3);
+	op_LOADK:
+		r[pc[1]] = wrap(static_cast<uint64_t>(pc[3]) << 32 | pc[2]);
+		NEXT(4);
+	BINARY(ADD, wrap(bits(a) + bits(b)))
+	BINARY(SUB, wrap(bits(a) - bits(b)))
+	BINARY(MUL, wrap(bits(a) * bits(b)))
+	BINARY(DIV, interpDivide(a, b))
+	BINARY(EQ, a == b)
+	BINARY(NE, a != b)
+	BINARY(LT, a < b)
+	BINARY(GT, a > b)
+	BINARY(LE, a <= b)
+	BINARY(GE, a >= b)
+	op_NEG:
+		r[pc[1]] = wrap(0 - bits(r[pc[2]]));
+		NEXT(3);
+	op_NOT:
+		r[pc[1]] = r[pc[2]] == 0;
+		NEXT(3);
+	op_LOADG:
+		r[pc[1]] = memory[pc[2]];
+		NEXT(3);
+	op_STOREG:
+		memory[pc[1]] = r[pc[2]];
+		NEXT(3);
+	op_LOAD: {
+		int64_t p = r[pc[2]];
+		if (p <= 0 || static_cast<uint64_t>(p) >= memory.size()){
+			throw new RuntimeError(p == 0 ? "Null pointer dereference"
+				: "Bad pointer dereference");
+		}
+		r[pc[1]] = memory[static_cast<size_t>(p)];
+		NEXT(3);
+	}
+	op_STORE: {
+		int64_t p = r[pc[1]];
+		if (p <= 0 || static_cast<uint64_t>(p) >= memory.size()){
+			throw new RuntimeError(p == 0 ? "Null pointer dereference"
+				: "Bad pointer dereference");
+		}
+		memory[static_cast<size_t>(p)] = r[pc[2]];
+		NEXT(3);
+	}
+	//The compiler only indexes tables in bounds, so these aren't
+	// checked
+	op_LOADT:
+		r[pc[1]] = memory[pc[2] + static_cast<size_t>(r[pc[3]])];
+		NEXT(4);
+	op_STORET:
+		memory[pc[1] + static_cast<size_t>(r[pc[2]])] = r[pc[3]];
+		NEXT(4);
+	op_CALL: {
+		const VMFunction& callee = bc.functions[pc[2]];
+		uint32_t n = pc[3];
+		int64_t * frame = r + frameSize;
+		if (frame + callee.frameSize > stackEnd){
+			throw new RuntimeError("Stack overflow");
+		}
+		for (uint32_t i = 0; i < n; i++){
+			frame[i] = r[pc[4 + i]];
+		}
+		returns.push_back({pc + 4 + n, r, frameSize, pc[1]});
+		r = frame;
+		frameSize = callee.frameSize;
+		pc = code + callee.entry;
+		NEXT(0);
+	}
+	//The arguments go past the end of the frame first, since they
+	// may be read from the words they are headed for
+	op_TAILCALL: {
+		const VMFunction& callee = bc.functions[pc[1]];
+		uint32_t n = pc[2];
+		int64_t * args = r + frameSize;
+		if (args + n > stackEnd || r + callee.frameSize > stackEnd){
+			throw new RuntimeError("Stack overflow");
+		}
+		for (uint32_t i = 0; i < n; i++){
+			args[i] = r[pc[3 + i]];
+		}
+		for (uint32_t i = 0; i < n; i++){
+			r[i] = args[i];
+		}
+		frameSize = callee.frameSize;
+		pc = code + callee.entry;
+		NEXT(0);
+	}
+	op_RET:
+		res = r[pc[1]];
+		goto finishCall;
+	op_RET0:
+		res = 0;
+		goto finishCall;
+	finishCall: {
+		if (returns.empty()){
+			return res;
+		}
+		const VMReturn& ret = returns.back();
+		pc = ret.pc;
+		r = ret.frame;
+		frameSize = ret.frameSize;
+		r[ret.dst] = res;
+		returns.pop_back();
+		NEXT(0);
+	}
+	op_READ_INT:
+		r[pc[1]] = interpReadInt();
+		NEXT(2);
+	op_READ_BOOL:
+		r[pc[1]] = interpReadBool();
+		NEXT(2);
+	op_WRITE_INT:
+		interpWriteInt(r[pc[1]]);
+		NEXT(2);
+	op_WRITE_BOOL:
+		interpWriteBool(r[pc[1]]);
+		NEXT(2);
+	op_WRITE_STR:
+		interpWriteStr(bc.strings[pc[1]]);
+		NEXT(2);
+	op_JMP:
+		pc = code + pc[1];
+		NEXT(0);
+	op_JNZ:
+		if (r[pc[1]] != 0){
+			pc = code + pc[2];
+			NEXT(0);
+		}
+		NEXT(3);
+	op_JZ:
+		if (r[pc[1]] == 0){
+			pc = code + pc[2];
+			NEXT(0);
+		}
+		NEXT(3);
+	BRANCH(EQ, ==)
+	BRANCH(NE, !=)
+	BRANCH(LT, <)
+	BRANCH(GT, >)
+	BRANCH(LE, <=)
+	BRANCH(GE, >=)
+#undef BRANCH
+#undef BINARY
+#undef NEXT
+}
+#pragma GCC diagnostic pop
+
+}
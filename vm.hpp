@@ -0,0 +1,108 @@
+#ifndef LAKE_VM_HPP
+#define LAKE_VM_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ir.hpp"
+
+namespace lake{
+
+//The instructions of the bytecode VM. Each is an opcode word
+// followed by operand words: registers of the current frame,
+// immediates (sign-extended from 32 bits), or code offsets.
+// Ops ending in K take an immediate in place of their last
+// register.
+enum class VMOp : uint32_t {
+	//d s
+	MOV,
+	//d lo hi: d = the 64-bit immediate hi:lo
+	LOADK,
+	//d a b
+	ADD, SUB, MUL, DIV, EQ, NE, LT, GT, LE, GE,
+	//d a k
+	ADDK, SUBK, MULK, DIVK, EQK, NEK, LTK, GTK, LEK, GEK,
+	//d a
+	NEG, NOT,
+	//d g: d = memory word g; g s: memory word g = s
+	LOADG, STOREG,
+	//d p: d = @p; p s: @p = s
+	LOAD, STORE,
+	//d t i: d = memory word t + i; t i s: memory word t + i = s
+	LOADT, STORET,
+	//d f n a1 ... an: d = function f(a1, ..., an)
+	CALL,
+	//f n a1 ... an: return function f(a1, ..., an), in this frame
+	TAILCALL,
+	//s: return s; (none): return 0
+	RET, RET0,
+	//d
+	READ_INT, READ_BOOL,
+	//s
+	WRITE_INT, WRITE_BOOL,
+	//k: write string k
+	WRITE_STR,
+	//t: go to t; s t: go to t if s is nonzero (JNZ) or zero (JZ)
+	JMP, JNZ, JZ,
+	//a b t: go to t if a op b, so that a comparison that only a
+	// branch uses needs no register
+	JEQ, JNE, JLT, JGT, JLE, JGE,
+	//a k t
+	JEQK, JNEK, JLTK, JGTK, JLEK, JGEK,
+	NUM_OPS
+};
+
+//A function's bytecode. Registers are numbered from 0 in its
+// frame, parameters first.
+struct VMFunction{
+	std::string name;
+	//Where the function's code starts
+	uint32_t entry;
+	uint32_t numParams;
+	uint32_t frameSize;
+};
+
+//A compiled program. All functions' code is in one array, and
+// jumps and calls name code offsets into it. Globals are words
+// of a memory that pointers also index; word 0 is never used,
+// so that 0 can be the null pointer. Tables follow the globals.
+class Bytecode{
+public:
+	void dump(std::ostream& out) const;
+
+	std::vector<uint32_t> code;
+	std::vector<VMFunction> functions;
+	std::vector<std::string> strings;
+	std::vector<std::string> globals;
+	std::vector<IRProgram::Table> tables;
+	//Where each table starts in memory
+	std::vector<uint32_t> tableAt;
+	//How many words of memory the program needs
+	size_t memorySize;
+	//The function to start at
+	uint32_t mainFn;
+};
+
+//Compile prog, which may be in SSA form (phis are lowered away
+// first), to bytecode
+Bytecode * compileBytecode(IRProgram * prog);
+
+//Run the program on stdin and stdout, and return what main
+// returns (0 when main is void). Throws a RuntimeError for
+// division by zero or overflow, bad pointers and stack overflow.
+int64_t runBytecode(const Bytecode& bc);
+
+//Input and output for interpreted programs, in the same format
+// as runtime/lake_runtime.c gives native ones
+int64_t interpReadInt();
+int64_t interpReadBool();
+void interpWriteInt(int64_t val);
+void interpWriteBool(int64_t val);
+void interpWriteStr(const std::string& str);
+//a / b, or a RuntimeError where the native code would trap
+int64_t interpDivide(int64_t a, int64_t b);
+
+}
+
+#endif
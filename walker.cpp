@@ -0,0 +1,52 @@
+#include <vector>
+#include "walker.hpp"
+#include "ast.hpp"
+
+namespace lake{
+
+namespace {
+//One node that has been entered but not yet finished. Its
+// children are a slice of a vector shared by all frames, which
+// only ever grows and shrinks at the end, like the frames do.
+struct Frame{
+	ASTNode * node;
+	size_t firstChild;
+	size_t numChildren;
+	size_t nextChild;
+	int ctx;
+};
+}
+
+void walk(ASTNode * root, ASTVisitor& visitor, int ctx){
+	std::vector<Frame> frames;
+	std::vector<ASTNode *> children;
+
+	auto enter = [&](ASTNode * node, int nodeCtx){
+		size_t first = children.size();
+		if (visitor.pre(node, nodeCtx)){
+			node->getChildren(children);
+		}
+		frames.push_back({node, first, children.size() - first, 
+			0, nodeCtx});
+	};
+
+	enter(root, ctx);
+	while (!frames.empty()){
+		Frame& top = frames.back();
+		if (top.nextChild == top.numChildren){
+			visitor.post(top.node, top.ctx);
+			children.resize(top.firstChild);
+			frames.pop_back();
+			continue;
+		}
+		size_t i = top.nextChild++;
+		ASTNode * child = children[top.firstChild + i];
+		int childCtx = top.ctx;
+		//Note that entering the child invalidates top
+		if (visitor.between(top.node, i, top.ctx, childCtx)){
+			enter(child, childCtx);
+		}
+	}
+}
+
+}
@@ -0,0 +1,38 @@
+#ifndef LAKE_WALKER_HPP
+#define LAKE_WALKER_HPP
+
+#include <cstddef>
+
+namespace lake{
+
+class ASTNode;
+
+//A pass over the AST, written as hooks that a walk calls on the
+// way into a node, between its children and on the way out.
+// Generated programs can nest expressions and statements far
+// deeper than the C++ stack allows recursion, so passes don't
+// recurse themselves: walk() keeps its own stack on the heap.
+//
+// Every hook gets the context int its parent handed down (the
+// indentation level, for unparse). Passes that don't need it
+// ignore it.
+class ASTVisitor{
+public:
+	virtual ~ASTVisitor(){ }
+	//Called when a node is reached. Returning false skips all
+	// of the node's children.
+	virtual bool pre(ASTNode * node, int ctx){ return true; }
+	//Called before the i'th child (in getChildren order) would
+	// be visited. Returning false skips that child. childCtx
+	// starts out as ctx and is what the child is given.
+	virtual bool between(ASTNode * node, size_t i, int ctx, 
+		int& childCtx){ return true; }
+	//Called once all of the node's children are done
+	virtual void post(ASTNode * node, int ctx){ }
+};
+
+void walk(ASTNode * root, ASTVisitor& visitor, int ctx = 0);
+
+}
+
+#endif
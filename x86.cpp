@@ -0,0 +1,164 @@
+#include "x86.hpp"
+
+namespace lake{
+
+static const char * const REG_NAMES[16] = {
+	"rax", "rcx", "rdx", "rbx", "rsp", "rbp", "rsi", "rdi",
+	"r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15"
+};
+
+static const char * const BYTE_REG_NAMES[16] = {
+	"al", "cl", "dl", "bl", "spl", "bpl", "sil", "dil",
+	"r8b", "r9b", "r10b", "r11b", "r12b", "r13b", "r14b", "r15b"
+};
+
+static const char * condName(X86Cond cond){
+	switch (cond){
+	case CC_E: return "e";
+	case CC_NE: return "ne";
+	case CC_L: return "l";
+	case CC_GE: return "ge";
+	case CC_LE: return "le";
+	case CC_G: return "g";
+	}
+	return "???";
+}
+
+const char * X86Instr::opName(Op op){
+	switch (op){
+	case LABEL: return "label";
+	case MOV: return "movq";
+	case LEA: return "leaq";
+	case ADD: return "addq";
+	case SUB: return "subq";
+	case IMUL: return "imulq";
+	case XOR: return "xorq";
+	case CMP: return "cmpq";
+	case TEST: return "testq";
+	case NEG: return "negq";
+	case CQO: return "cqto";
+	case IDIV: return "idivq";
+	case SETCC: return "set";
+	case JMP: return "jmp";
+	case JCC: return "j";
+	case CALL: return "call";
+	case TAILJMP: return "jmp";
+	case PUSH: return "pushq";
+	case POP: return "popq";
+	case RET: return "ret";
+	}
+	return "???";
+}
+
+static std::string labelName(uint32_t fnSym, uint32_t label){
+	return ".L" + std::to_string(fnSym) + "_" + std::to_string(label);
+}
+
+static std::string operandText(const X86Module * mod,
+	const X86Operand& op){
+	switch (op.kind()){
+	case X86Operand::NONE: return "";
+	case X86Operand::REG: return std::string("%") + REG_NAMES[op.getReg()];
+	case X86Operand::IMM: return "$" + std::to_string(op.getImm());
+	case X86Operand::MEM:
+		return std::to_string(op.getDisp()) + "(%"
+			+ REG_NAMES[op.getReg()] + ")";
+	case X86Operand::SYM:
+		return mod->symbols[op.getSym()].name + "(%rip)";
+	}
+	return "???";
+}
+
+static void writeInstr(std::ostream& out, const X86Module * mod,
+	uint32_t fnSym, const X86Instr& instr){
+	std::string dst = operandText(mod, instr.dst);
+	std::string src = operandText(mod, instr.src);
+	switch (instr.op){
+	case X86Instr::LABEL:
+		out << labelName(fnSym, instr.target) << ":\n";
+		return;
+	case X86Instr::MOV:
+		if (instr.src.isImm() && !instr.src.isImm32()){
+			out << "\tmovabsq " << src << ", " << dst << "\n";
+			return;
+		}
+		break;
+	case X86Instr::SETCC:
+		out << "\tset" << condName(instr.cond) << " %"
+			<< BYTE_REG_NAMES[instr.dst.getReg()] << "\n"
+			<< "\tmovzbq %" << BYTE_REG_NAMES[instr.dst.getReg()]
+			<< ", " << dst << "\n";
+		return;
+	case X86Instr::JMP:
+		out << "\tjmp " << labelName(fnSym, instr.target) << "\n";
+		return;
+	case X86Instr::JCC:
+		out << "\tj" << condName(instr.cond) << " "
+			<< labelName(fnSym, instr.target) << "\n";
+		return;
+	case X86Instr::CALL:
+		out << "\tcall " << mod->symbols[instr.target].name << "\n";
+		return;
+	case X86Instr::TAILJMP:
+		//The same 32-bit jump lakec -o writes, which as would
+		// otherwise shorten when the target is close by
+		out << "\t{disp32} jmp " << mod->symbols[instr.target].name
+			<< "\n";
+		return;
+	default:
+		break;
+	}
+	out << "\t" << X86Instr::opName(instr.op);
+	if (!src.empty() && !dst.empty()){
+		out << " " << src << ", " << dst;
+	} else if (!src.empty()){
+		out << " " << src;
+	} else if (!dst.empty()){
+		out << " " << dst;
+	}
+	out << "\n";
+}
+
+//Strings are written with the escapes that as understands
+static std::string asciiText(const std::string& str){
+	std::string res = "\"";
+	for (char c : str){
+		switch (c){
+		case '\n': res += "\\n"; break;
+		case '\t': res += "\\t"; break;
+		case '"': res += "\\\""; break;
+		case '\\': res += "\\\\"; break;
+		default: res += c;
+		}
+	}
+	return res + "\"";
+}
+
+void X86Module::writeAsm(std::ostream& out) const {
+	out << "\t.text\n";
+	for (uint32_t i = 0; i < symbols.size(); i++){
+		const X86Symbol& sym = symbols[i];
+		if (sym.kind != X86Symbol::TEXT){ continue; }
+		out << "\n";
+		if (sym.global){ out << "\t.globl " << sym.name << "\n"; }
+		out << "\t.type " << sym.name << ", @function\n"
+			<< sym.name << ":\n";
+		for (const X86Instr& instr : sym.code){
+			writeInstr(out, this, i, instr);
+		}
+		out << "\t.size " << sym.name << ", .-" << sym.name << "\n";
+	}
+	out << "\n\t.section .rodata\n";
+	for (const X86Symbol& sym : symbols){
+		if (sym.kind != X86Symbol::RODATA){ continue; }
+		out << sym.name << ":\n\t.ascii " << asciiText(sym.data) << "\n";
+	}
+	out << "\n\t.bss\n\t.balign 8\n";
+	for (const X86Symbol& sym : symbols){
+		if (sym.kind != X86Symbol::BSS){ continue; }
+		out << sym.name << ":\n\t.zero " << sym.size << "\n";
+	}
+	out << "\n\t.section .note.GNU-stack,\"\",@progbits\n";
+}
+
+}
@@ -0,0 +1,218 @@
+#ifndef LAKE_X86_HPP
+#define LAKE_X86_HPP
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ir.hpp"
+#include "opt.hpp"
+
+namespace lake{
+
+//The general purpose registers, numbered as the hardware
+// encodes them
+enum X86Reg : uint8_t {
+	RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+	R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+//Condition codes, numbered as the hardware encodes them
+enum X86Cond : uint8_t {
+	CC_E = 0x4, CC_NE = 0x5, CC_L = 0xC, CC_GE = 0xD,
+	CC_LE = 0xE, CC_G = 0xF
+};
+
+//An instruction operand: a register, an immediate, a word in
+// memory at a register plus a displacement, or a word in memory
+// at a symbol (addressed relative to the instruction pointer)
+class X86Operand{
+public:
+	enum Kind : uint8_t { NONE, REG, IMM, MEM, SYM };
+	X86Operand() : myKind(NONE), myReg(RAX), myVal(0){ }
+	static X86Operand reg(X86Reg r){ return X86Operand(REG, r, 0); }
+	static X86Operand imm(int64_t v){ return X86Operand(IMM, RAX, v); }
+	static X86Operand mem(X86Reg base, int32_t disp){
+		return X86Operand(MEM, base, disp);
+	}
+	static X86Operand sym(uint32_t symbol){
+		return X86Operand(SYM, RAX, symbol);
+	}
+	Kind kind() const { return myKind; }
+	bool isReg() const { return myKind == REG; }
+	bool isImm() const { return myKind == IMM; }
+	//Whether this is in memory, wherever that memory is
+	bool isMem() const { return myKind == MEM || myKind == SYM; }
+	X86Reg getReg() const { return myReg; }
+	int64_t getImm() const { return myVal; }
+	int32_t getDisp() const { return static_cast<int32_t>(myVal); }
+	uint32_t getSym() const { return static_cast<uint32_t>(myVal); }
+	//Whether an immediate fits the sign-extended 32 bits that
+	// most instructions take
+	bool isImm32() const {
+		return myKind == IMM && myVal >= INT32_MIN && myVal <= INT32_MAX;
+	}
+	bool operator==(const X86Operand& other) const {
+		return myKind == other.myKind && myReg == other.myReg
+			&& myVal == other.myVal;
+	}
+	bool operator!=(const X86Operand& other) const {
+		return !(*this == other);
+	}
+private:
+	X86Operand(Kind kindIn, X86Reg regIn, int64_t valIn)
+	: myKind(kindIn), myReg(regIn), myVal(valIn){ }
+	Kind myKind;
+	X86Reg myReg;
+	int64_t myVal;
+};
+
+//One machine instruction, with 64-bit operands. Two-operand
+// instructions are dst = dst op src, as on the hardware.
+class X86Instr{
+public:
+	enum Op : uint8_t {
+		//Binds label #target here
+		LABEL,
+		MOV, LEA, ADD, SUB, IMUL, XOR, CMP, TEST,
+		NEG,
+		//Sign-extend rax into rdx, then divide rdx:rax by src
+		CQO, IDIV,
+		//dst = 1 if cond holds, else 0 (dst must be a register)
+		SETCC,
+		//Jump to label #target, maybe only if cond holds
+		JMP, JCC,
+		//Call symbol #target; or jump to it, as the last thing a
+		// function does, so that it returns to our caller itself
+		CALL, TAILJMP,
+		PUSH, POP, RET
+	};
+	X86Instr(Op opIn, X86Operand dstIn = X86Operand(),
+		X86Operand srcIn = X86Operand())
+	: op(opIn), cond(CC_E), dst(dstIn), src(srcIn), target(0){ }
+	static const char * opName(Op op);
+
+	Op op;
+	X86Cond cond;
+	X86Operand dst;
+	X86Operand src;
+	uint32_t target;
+};
+
+//A named thing in the output: a function and its code, a zeroed
+// word, a read-only string, or something the runtime provides
+class X86Symbol{
+public:
+	enum Kind : uint8_t { TEXT, BSS, RODATA, EXTERN };
+	X86Symbol(std::string nameIn, Kind kindIn, bool globalIn)
+	: name(nameIn), kind(kindIn), global(globalIn), size(0),
+	  numLabels(0){ }
+
+	std::string name;
+	Kind kind;
+	//Whether the symbol is visible to the linker
+	bool global;
+	//The bytes of a RODATA symbol
+	std::string data;
+	//The size of a BSS symbol
+	size_t size;
+	//The code of a TEXT symbol, whose labels are numbered from 0
+	std::vector<X86Instr> code;
+	uint32_t numLabels;
+};
+
+//A module's functions in machine code, one after another. Each
+// reloc marks a 32-bit field, relative to the end of the field
+// (less addend), that has to point at a symbol outside the code.
+// Calls between functions of the module are already resolved.
+class X86Code{
+public:
+	struct Reloc{
+		size_t offset;
+		uint32_t symbol;
+		int64_t addend;
+		//Whether this is the target of a call (rather than a
+		// rip-relative data address)
+		bool call;
+	};
+	std::vector<uint8_t> bytes;
+	//Where each TEXT symbol starts in bytes
+	std::vector<size_t> offsets;
+	std::vector<Reloc> relocs;
+};
+
+//A whole program in machine instructions, ready to be written
+// out as assembly or as an object file. The functions it calls
+// in the runtime (runtime/lake_runtime.c) are extern symbols,
+// named lakert_*.
+class X86Module{
+public:
+	uint32_t addSymbol(std::string name, X86Symbol::Kind kind,
+		bool global){
+		symbols.push_back(X86Symbol(name, kind, global));
+		return static_cast<uint32_t>(symbols.size() - 1);
+	}
+	//GNU as source for the module
+	void writeAsm(std::ostream& out) const;
+	//The module's functions as machine code
+	X86Code encode() const;
+	//An ELF64 relocatable object for the module, as as would
+	// assemble it from writeAsm's output
+	void writeObject(std::ostream& out) const;
+	//Load the module into executable memory and call lake_main,
+	// with lakec itself providing the runtime. Each function is
+	// listed in /tmp/perf-<pid>.map, so that perf can name it.
+	// Returns what lake_main returns.
+	int64_t run() const;
+
+	std::vector<X86Symbol> symbols;
+};
+
+//Where each IR register of a function lives in the generated
+// code: a machine register, a stack slot, or nowhere (for
+// registers that are never used)
+class X86Alloc{
+public:
+	enum Kind : uint8_t { NONE, REG, SLOT };
+	struct Home{
+		Kind kind;
+		X86Reg reg;
+		uint32_t slot;
+	};
+	std::vector<Home> homes;
+	uint32_t numSlots;
+	//The callee-saved registers the function has to preserve
+	std::vector<X86Reg> saved;
+	//Copies whose source and destination share a register
+	size_t coalesced;
+	size_t spilled;
+};
+
+//Give every register a stack slot of its own
+X86Alloc naiveAllocation(IRFunction * fn);
+
+//Linear scan register allocation, after Poletto and Sarkar.
+// Each register's live interval runs from its first definition
+// to its last use in block order. Intervals are handed rbx, rsi,
+// rdi and r8 to r15 in order of their starts; rax, rcx and rdx
+// stay free as scratch. An interval that is live across a call
+// only gets a callee-saved register. When none is free, the
+// interval with the lowest use density (uses weighted by loop
+// depth, over its length) is spilled to a stack slot. Copies and
+// parameters prefer the register their value is already in.
+// Phis must already be lowered away.
+X86Alloc allocateRegisters(IRFunction * fn);
+
+//Select instructions for every function in prog, which may or
+// may not be in SSA form (phis are lowered away first). Lake
+// function f becomes lake_f, global g becomes lakeg_g and table
+// t becomes laket_t, and lake_main is the entry point the
+// runtime calls.
+// With allocate set, IR registers are assigned machine
+// registers; without it every one gets a stack slot.
+X86Module * genX86(IRProgram * prog, bool allocate,
+	OptReport * report);
+
+}
+
+#endif